@@ -0,0 +1,80 @@
+# --- BEGIN COPYRIGHT BLOCK ---
+# Copyright (C) 2026 Red Hat, Inc.
+# All rights reserved.
+#
+# License: GPL (version 3 or any later version).
+# See LICENSE for details.
+# --- END COPYRIGHT BLOCK ---
+#
+
+# Load benchmark of a local instance, see lib389.benchmark. The sizes are set
+# from the environment:
+#   PERF_USERS        users in the data set (default 1000000)
+#   PERF_SCENARIOS    comma separated scenarios to run (default all)
+#   PERF_THREADS      client threads (default 16)
+#   PERF_DURATION     seconds of each load scenario (default 60)
+#   PERF_RESULT_FILE  where the JSON results are written
+#   PERF_BASELINE     results of a previous run, the test fails if a
+#                     scenario regressed by more than PERF_TOLERANCE (0.05)
+
+import json
+import logging
+import os
+import pytest
+from lib389.benchmark import Benchmark, compare_results
+from lib389.topologies import topology_st
+
+pytestmark = pytest.mark.tier3
+
+log = logging.getLogger(__name__)
+
+PERF_USERS = int(os.environ.get('PERF_USERS', '1000000'))
+PERF_THREADS = int(os.environ.get('PERF_THREADS', '16'))
+PERF_DURATION = int(os.environ.get('PERF_DURATION', '60'))
+PERF_RESULT_FILE = os.environ.get('PERF_RESULT_FILE', '/tmp/ds_benchmark.json')
+PERF_BASELINE = os.environ.get('PERF_BASELINE')
+PERF_TOLERANCE = float(os.environ.get('PERF_TOLERANCE', '0.05'))
+
+
+def test_benchmark(topology_st):
+    """Run the load benchmark and compare it with a baseline
+
+    :id: 5a0f1c2e-7b7d-4c59-9d43-2f6f2f8b1e07
+    :setup: Standalone instance
+    :steps:
+        1. Provision the data set and run the scenarios
+        2. Write the results
+        3. Compare them with the baseline, if any
+    :expectedresults:
+        1. Success
+        2. Success
+        3. No scenario regressed
+    """
+    inst = topology_st.standalone
+    scenarios = os.environ.get('PERF_SCENARIOS')
+    if scenarios:
+        scenarios = [s.strip() for s in scenarios.split(',')]
+        if 'import' not in scenarios:
+            # the other scenarios need the data set
+            scenarios.insert(0, 'import')
+
+    bench = Benchmark(inst, users=PERF_USERS, threads=PERF_THREADS, duration=PERF_DURATION)
+    results = bench.run(scenarios)
+    assert results
+    bench.write_json(PERF_RESULT_FILE)
+    log.info("Benchmark results written to %s", PERF_RESULT_FILE)
+
+    if PERF_BASELINE:
+        with open(PERF_BASELINE, 'r') as f:
+            baseline = json.load(f)
+        regressions = compare_results(baseline, bench.as_dict(), PERF_TOLERANCE)
+        for r in regressions:
+            log.error("Regression: %s", r)
+        assert not regressions
+
+
+if __name__ == '__main__':
+    # Run isolated
+    # -s for DEBUG mode
+    CURRENT_FILE = os.path.realpath(__file__)
+    pytest.main("-s %s" % CURRENT_FILE)
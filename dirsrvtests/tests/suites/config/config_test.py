@@ -8,6 +8,7 @@
 #
 
 import logging
+import signal
 import pytest
 from lib389.tasks import *
 from lib389.topologies import topology_m2, topology_st as topo
@@ -21,6 +22,7 @@ from lib389.cos import CosPointerDefinitions, CosTemplates
 from lib389.backend import Backends
 from lib389.monitor import MonitorLDBM
 from lib389.plugins import ReferentialIntegrityPlugin
+from lib389 import pid_from_file
 
 pytestmark = pytest.mark.tier0
 
@@ -551,6 +553,82 @@ def test_require_internal_index(topo):
         user.delete()
 
 
+def test_dse_search_root_subtree(topo):
+    """A subtree search based on the root DSE finds the DSE entries
+
+    :id: 8261ac62-e338-4a94-9b02-46600fbc0833
+    :setup: Standalone instance
+    :steps:
+        1. Search the subtree of "" for cn=config by objectclass
+        2. Search the subtree of "" for cn=config by cn
+        3. Search the subtree of "" for the plugin entries
+    :expectedresults:
+        1. cn=config is returned
+        2. cn=config is returned
+        3. The same entries as from a search based on cn=plugins,cn=config
+    """
+
+    inst = topo.standalone
+    entries = inst.search_s("", ldap.SCOPE_SUBTREE, "(objectclass=nsslapdConfig)", ['cn'])
+    assert DN_CONFIG in [e.dn.lower() for e in entries]
+
+    entries = inst.search_s("", ldap.SCOPE_SUBTREE, "(cn=config)", ['cn'])
+    assert DN_CONFIG in [e.dn.lower() for e in entries]
+
+    plugins = inst.search_s("cn=plugins,cn=config", ldap.SCOPE_SUBTREE, "(objectclass=nsSlapdPlugin)", ['cn'])
+    entries = inst.search_s("", ldap.SCOPE_SUBTREE, "(objectclass=nsSlapdPlugin)", ['cn'])
+    assert len(plugins) > 0
+    assert sorted(e.dn for e in entries) == sorted(e.dn for e in plugins)
+
+
+def test_dse_journal_bootstrap_after_crash(topo):
+    """The settings read before the DSE is loaded come from the journal after a crash
+
+    :id: 98685a79-f774-440d-b11e-f14645b659eb
+    :setup: Standalone instance
+    :steps:
+        1. Journal the changes of dse.ldif
+        2. Move the errors log and turn off syntax checking
+        3. Kill the server while the changes are only in dse.ldif.journal
+        4. Start the server
+        5. Check the settings
+    :expectedresults:
+        1. Success
+        2. Success, the journal holds the changes
+        3. Success
+        4. Success, nothing is logged to the old errors log
+        5. The journaled values are in effect
+    """
+
+    inst = topo.standalone
+    journal = os.path.join(inst.ds_paths.config_dir, 'dse.ldif.journal')
+    old_errorlog = inst.config.get_attr_val_utf8('nsslapd-errorlog')
+    new_errorlog = old_errorlog + '-journal'
+    old_syntaxcheck = inst.config.get_attr_val_utf8('nsslapd-syntaxcheck')
+
+    inst.config.replace('nsslapd-dse-journal-size', '100')
+    inst.restart()
+    inst.config.replace_many(('nsslapd-errorlog', new_errorlog),
+                             ('nsslapd-syntaxcheck', 'off'))
+    assert os.path.exists(journal)
+
+    os.kill(pid_from_file(inst.ds_paths.pid_file), signal.SIGKILL)
+    time.sleep(2)
+    inst.state = DIRSRV_STATE_OFFLINE
+    old_size = os.path.getsize(old_errorlog)
+
+    inst.start()
+    assert os.path.getsize(old_errorlog) == old_size
+    assert os.path.getsize(new_errorlog) > 0
+    assert inst.config.get_attr_val_utf8('nsslapd-errorlog') == new_errorlog
+    assert inst.config.get_attr_val_utf8('nsslapd-syntaxcheck') == 'off'
+
+    inst.config.replace_many(('nsslapd-errorlog', old_errorlog),
+                             ('nsslapd-syntaxcheck', old_syntaxcheck))
+    inst.config.remove_all('nsslapd-dse-journal-size')
+    inst.restart()
+
+
 if __name__ == '__main__':
     # Run isolated
     # -s for DEBUG mode
@@ -145,6 +145,58 @@ def test_monitor_backend(topo):
         assert False
 
 
+pytestmark = pytest.mark.tier1
+def test_monitor_metrics(topo):
+    """Check the metrics exporter answers a scrape
+
+    :id: 0c1d5f7e-3a43-4f2f-b5a9-6e2f4c1b8d90
+    :setup: Single instance
+    :steps:
+        1. Set nsslapd-metrics-port and restart the instance
+        2. Fetch /metrics
+        3. Check the counters, the backend caches and the work queue
+        4. Fetch another path
+        5. Disable the exporter
+    :expectedresults:
+        1. Success
+        2. Success
+        3. The metrics are in the text exposition format
+        4. Not found
+        5. Success
+    """
+
+    import socket
+    import urllib.error
+    import urllib.request
+
+    inst = topo.standalone
+    with socket.socket() as s:
+        s.bind(('127.0.0.1', 0))
+        port = s.getsockname()[1]
+    inst.config.set('nsslapd-metrics-port', str(port))
+    inst.restart()
+
+    with urllib.request.urlopen(f'http://127.0.0.1:{port}/metrics', timeout=10) as r:
+        assert r.status == 200
+        assert r.headers['Content-Type'].startswith('text/plain')
+        metrics = r.read().decode('utf-8')
+    log.debug(metrics)
+
+    assert '# TYPE ds_in_ops_total counter' in metrics
+    assert '# TYPE ds_work_queue_depth gauge' in metrics
+    be = Backends(inst).list()[0]
+    assert f'ds_entry_cache_tries_total{{backend="{be.rdn}"}}' in metrics
+    if DatabaseConfig(inst).get_db_lib() == 'bdb':
+        assert 'ds_db_cache_hits_total{database="ldbm database"}' in metrics
+
+    with pytest.raises(urllib.error.HTTPError) as e:
+        urllib.request.urlopen(f'http://127.0.0.1:{port}/other', timeout=10)
+    assert e.value.code == 404
+
+    inst.config.set('nsslapd-metrics-port', '0')
+    inst.restart()
+
+
 if __name__ == '__main__':
     # Run isolated
     # -s for DEBUG mode
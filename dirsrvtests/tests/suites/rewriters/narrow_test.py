@@ -0,0 +1,174 @@
+# --- BEGIN COPYRIGHT BLOCK ---
+# Copyright (C) 2020 Red Hat, Inc.
+# All rights reserved.
+#
+# License: GPL (version 3 or any later version).
+# See LICENSE for details.
+# --- END COPYRIGHT BLOCK ---
+#
+"""
+   :Requirement: 389-ds-base: Rewriters
+"""
+import logging
+import pytest
+import ldap
+from lib389._entry import Entry
+from lib389._constants import DEFAULT_SUFFIX
+from lib389.topologies import topology_st as topo
+from lib389.idm.user import UserAccounts
+from lib389.idm.role import ManagedRoles, FilteredRoles, NestedRoles
+from lib389.idm.nscontainer import nsContainers
+from lib389.cos import CosTemplates, CosClassicDefinitions, CosIndirectDefinitions
+from lib389.utils import ds_is_older
+
+log = logging.getLogger(__name__)
+pytestmark = [pytest.mark.tier2,
+              pytest.mark.skipif(ds_is_older('1.4.3'), reason="Not implemented")]
+
+PW = 'password'
+MANAGED = 'cn=managed,%s' % DEFAULT_SUFFIX
+FILTERED = 'cn=filtered,%s' % DEFAULT_SUFFIX
+NESTED = 'cn=nested,%s' % DEFAULT_SUFFIX
+VIRTUAL = 'cn=virtual,%s' % DEFAULT_SUFFIX
+
+FILTERS = [
+    '(nsrole=%s)' % MANAGED,
+    '(nsrole=%s)' % FILTERED,
+    '(nsrole=%s)' % NESTED,
+    '(nsrole=%s)' % VIRTUAL,
+    '(&(objectclass=posixAccount)(nsrole=%s))' % NESTED,
+    '(|(nsrole=%s)(uid=user9))' % MANAGED,
+    '(!(nsrole=%s))' % MANAGED,
+    '(&(objectclass=posixAccount)(!(nsrole=%s)))' % FILTERED,
+    '(postalCode=11111)',
+    '(&(objectclass=posixAccount)(!(postalCode=11111)))',
+    '(roomNumber=42)',
+]
+
+
+@pytest.fixture(scope="module")
+def narrow_setup(topo):
+    """Users in managed, filtered and nested roles, a filtered role on a CoS
+    attribute, a classic and an indirect CoS, and an ACI hiding the real
+    attributes the rewriters narrow on from user0
+    """
+
+    inst = topo.standalone
+    users = UserAccounts(inst, DEFAULT_SUFFIX)
+    for i in range(10):
+        user = users.create(properties={
+            'uid': 'user%d' % i,
+            'cn': 'user%d' % i,
+            'sn': 'user%d' % i,
+            'uidNumber': str(1000 + i),
+            'gidNumber': '2000',
+            'homeDirectory': '/home/user%d' % i,
+            'userPassword': PW,
+        })
+        user.add('objectclass', 'extensibleObject')
+        if i in (0, 1, 2):
+            user.replace('nsRoleDN', MANAGED)
+        if i in (3, 4, 5):
+            user.replace('l', 'sunnyvale')
+        if i in (0, 3, 6):
+            user.replace('employeeType', 'engineer')
+        if i in (1, 4):
+            user.replace('manager', 'uid=user9,ou=people,%s' % DEFAULT_SUFFIX)
+        if i == 9:
+            user.replace('roomNumber', '42')
+
+    ManagedRoles(inst, DEFAULT_SUFFIX).create(properties={'cn': 'managed'})
+    FilteredRoles(inst, DEFAULT_SUFFIX).create(properties={'cn': 'filtered',
+                                                           'nsRoleFilter': '(l=sunnyvale)'})
+    NestedRoles(inst, DEFAULT_SUFFIX).create(properties={'cn': 'nested',
+                                                         'nsRoleDN': [MANAGED, FILTERED]})
+    # postalCode is a CoS attribute, the index knows nothing about it
+    FilteredRoles(inst, DEFAULT_SUFFIX).create(properties={'cn': 'virtual',
+                                                           'nsRoleFilter': '(postalCode=11111)'})
+
+    templates = nsContainers(inst, DEFAULT_SUFFIX).create(properties={'cn': 'templates'})
+    CosTemplates(inst, templates.dn).create(properties={'cn': 'engineer',
+                                                        'postalCode': '11111'})
+    CosClassicDefinitions(inst, DEFAULT_SUFFIX).create(properties={'cn': 'classic',
+                                                                   'cosTemplateDn': templates.dn,
+                                                                   'cosSpecifier': 'employeeType',
+                                                                   'cosAttribute': 'postalCode'})
+    CosIndirectDefinitions(inst, DEFAULT_SUFFIX).create(properties={'cn': 'indirect',
+                                                                    'cosIndirectSpecifier': 'manager',
+                                                                    'cosAttribute': 'roomNumber'})
+
+    inst.modify_s(DEFAULT_SUFFIX, [(ldap.MOD_ADD, 'aci', [
+        ('(targetattr != "nsRoleDN || employeeType || l")(version 3.0; acl "narrow";'
+         ' allow (read, search, compare) userdn = "ldap:///uid=user0,ou=people,%s";)'
+         % DEFAULT_SUFFIX).encode()])])
+    return inst
+
+
+def _results(inst):
+    """DNs returned for each filter, to the directory manager and to user0"""
+
+    results = {}
+    conn = UserAccounts(inst, DEFAULT_SUFFIX).get('user0').bind(PW)
+    for f in FILTERS:
+        for who, c in (('dm', inst), ('user0', conn)):
+            entries = c.search_s(DEFAULT_SUFFIX, ldap.SCOPE_SUBTREE, f, ['dn'])
+            results[(f, who)] = sorted(e.dn.lower() for e in entries)
+    conn.unbind_s()
+    return results
+
+
+def test_narrow_rewriters_results(narrow_setup):
+    """The nsrole and CoS rewriters do not change the search results
+
+    :id: 0d77fd83-eec3-4db8-8b0c-df4fcf2ed632
+    :setup: Standalone instance with roles, CoS and an ACI
+    :steps:
+        1. Run the searches without the rewriters
+        2. Enable the nsrole and cos rewriters and restart
+        3. Run the searches again
+    :expectedresults:
+        1. Success
+        2. Success
+        3. Same results, for the directory manager and for user0 who cannot
+           search the attributes the filters are narrowed on
+    """
+
+    inst = narrow_setup
+    before = _results(inst)
+    assert before[('(nsrole=%s)' % MANAGED, 'dm')]
+    assert before[('(nsrole=%s)' % VIRTUAL, 'dm')]
+
+    for cn, lib, fn in (('nsrole', 'libroles-plugin', 'roles_nsrole_filter_rewriter'),
+                        ('cos', 'libcos-plugin', 'cos_filter_rewriter')):
+        inst.add_s(Entry(('cn=%s,cn=rewriters,cn=config' % cn, {
+            'objectClass': ['top', 'extensibleObject'],
+            'cn': cn,
+            'nsslapd-libpath': lib,
+            'nsslapd-filterrewriter': fn,
+        })))
+    inst.restart()
+
+    after = _results(inst)
+    for key in before:
+        assert after[key] == before[key], key
+
+
+def test_narrow_rewriters_index(narrow_setup):
+    """The narrowed searches are served by the index
+
+    :id: 47aa09a4-dbb9-4e73-af68-39ef42c44557
+    :setup: Standalone instance with roles, CoS and the rewriters
+    :steps:
+        1. Search the managed role members with nsslapd-require-index on
+    :expectedresults:
+        1. Success, the candidates come from the nsRoleDN index
+    """
+
+    inst = narrow_setup
+    backend = 'cn=userroot,cn=ldbm database,cn=plugins,cn=config'
+    inst.modify_s(backend, [(ldap.MOD_REPLACE, 'nsslapd-require-index', b'on')])
+    try:
+        entries = inst.search_s(DEFAULT_SUFFIX, ldap.SCOPE_SUBTREE, '(nsrole=%s)' % MANAGED, ['dn'])
+        assert len(entries) == 3
+    finally:
+        inst.modify_s(backend, [(ldap.MOD_REPLACE, 'nsslapd-require-index', b'off')])
@@ -3484,3 +3484,177 @@ cos_cache_entry_is_cos_related(Slapi_Entry *e)
     }
     return (rc);
 }
+
+/*
+    cos_cache_template_may_match
+    ----------------------------
+    tells whether one of the values of the template attribute pAttr may
+    equal test_this, compared the way the vattr compare does it and with the
+    matching rule of the attribute type
+*/
+static int
+cos_cache_template_may_match(cosAttributes *pAttr, Slapi_Attr *sattr, Slapi_Value *test_this)
+{
+    int result = 0;
+
+    if (cos_cache_cmp_attr(pAttr, test_this, &result) && result) {
+        return 1;
+    }
+    for (cosAttrValue *pVal = pAttr->pAttrValue; pVal; pVal = pVal->list.pNext) {
+        Slapi_Value *val = slapi_value_new_string(pVal->val);
+        int cmp = slapi_attr_value_cmp(sattr, slapi_value_get_berval(val), slapi_value_get_berval(test_this));
+
+        slapi_value_free(&val);
+        if (cmp == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+    cos_cache_attr_ignores_case
+    ---------------------------
+    tells whether the equality matching rule of type ignores case
+*/
+static int
+cos_cache_attr_ignores_case(const char *type)
+{
+    Slapi_Attr *sattr = slapi_attr_new();
+    struct berval upper = {1, "A"};
+    struct berval lower = {1, "a"};
+    int rc;
+
+    slapi_attr_init(sattr, type);
+    rc = (slapi_attr_value_cmp(sattr, &upper, &lower) == 0);
+    slapi_attr_free(&sattr);
+    return rc;
+}
+
+/*
+    cos_cache_rewrite_ava
+    ---------------------
+    slapi_filter_apply callback turning (attr=value), where attr is a CoS
+    attribute, into (&(|(attr=value)(specifier=grade)...)(attr=value)), the
+    grades being those of the classic CoS templates that hold value. The
+    result is the same, but the backend can take the candidates from the
+    indexes of attr and the specifiers instead of evaluating CoS for every
+    entry in the scope. Filters that pointer, indirect or default templates
+    may satisfy are left alone, those match entries by scope only.
+*/
+static int
+cos_cache_rewrite_ava(Slapi_Filter *f, void *arg)
+{
+    cosCache *pCache = (cosCache *)arg;
+    Slapi_Filter *narrow = NULL;
+    Slapi_Attr *sattr = NULL;
+    Slapi_Value *test_this = NULL;
+    struct berval *bval = NULL;
+    char *type = NULL;
+    int attr_index;
+
+    if (slapi_filter_get_choice(f) != LDAP_FILTER_EQUALITY ||
+        slapi_filter_get_ava(f, &type, &bval) != 0 || bval->bv_val == NULL ||
+        pCache->attrCount == 0 || (attr_index = cos_cache_find_attr(pCache, type)) < 0) {
+        return SLAPI_FILTER_SCAN_CONTINUE;
+    }
+
+    /* templates of indirect definitions are not cached */
+    for (cosDefinitions *pDef = pCache->pDefs; pDef; pDef = pDef->list.pNext) {
+        if (pDef->cosType != COSTYPE_INDIRECT) {
+            continue;
+        }
+        for (cosAttrValue *pCosAttr = pDef->pCosAttrs; pCosAttr; pCosAttr = pCosAttr->list.pNext) {
+            if (!slapi_utf8casecmp((unsigned char *)pCosAttr->val, (unsigned char *)type)) {
+                return SLAPI_FILTER_SCAN_CONTINUE;
+            }
+        }
+    }
+
+    sattr = slapi_attr_new();
+    slapi_attr_init(sattr, type);
+    test_this = slapi_value_new_berval(bval);
+    /* entries with a real value */
+    narrow = slapi_filter_dup(f);
+    for (; attr_index < pCache->attrCount &&
+           !slapi_utf8casecmp((unsigned char *)type, (unsigned char *)pCache->ppAttrIndex[attr_index]->pAttrName);
+         attr_index++) {
+        cosAttributes *pAttr = pCache->ppAttrIndex[attr_index];
+        cosTemplates *pTemplate = (cosTemplates *)pAttr->pParent;
+        cosDefinitions *pDef = (cosDefinitions *)pTemplate->pParent;
+
+        if (!cos_cache_template_may_match(pAttr, sattr, test_this)) {
+            continue;
+        }
+        if (pDef->cosType != COSTYPE_CLASSIC || pTemplate->template_default || pTemplate->cosGrade == NULL) {
+            slapi_filter_free(narrow, 1);
+            narrow = NULL;
+            break;
+        }
+        /* entries with a specifier selecting this template */
+        for (cosAttrValue *pSpec = pDef->pCosSpecifier; pSpec; pSpec = pSpec->list.pNext) {
+            char *filter_str;
+            if (!cos_cache_attr_ignores_case(pSpec->val)) {
+                /* grades are compared case insensitively, the index may not */
+                slapi_filter_free(narrow, 1);
+                narrow = NULL;
+                break;
+            }
+            filter_str = slapi_filter_sprintf("(%s=%s%s)", pSpec->val, ESC_NEXT_VAL, pTemplate->cosGrade);
+            narrow = slapi_filter_join(LDAP_FILTER_OR, narrow, slapi_str2filter(filter_str));
+            slapi_ch_free_string(&filter_str);
+        }
+        if (narrow == NULL) {
+            break;
+        }
+    }
+    slapi_value_free(&test_this);
+    slapi_attr_free(&sattr);
+
+    if (narrow != NULL && slapi_filter_narrow(f, narrow) == 0) {
+        slapi_log_err(SLAPI_LOG_PLUGIN, COS_PLUGIN_SUBSYSTEM,
+                      "cos_cache_rewrite_ava - Narrowed (%s=%s)\n", type, bval->bv_val);
+    }
+    return SLAPI_FILTER_SCAN_CONTINUE;
+}
+
+/*
+    cos_filter_rewriter
+    -------------------
+    Search filter rewriter making filters on classic CoS attributes indexed,
+    see cos_cache_rewrite_ava(). It is enabled with
+
+    dn: cn=cos,cn=rewriters,cn=config
+    objectClass: top
+    objectClass: extensibleObject
+    cn: cos
+    nsslapd-libpath: libcos-plugin
+    nsslapd-filterrewriter: cos_filter_rewriter
+
+    The CoS attributes and the specifier attributes should then be indexed.
+    A specifier that is itself a virtual attribute is left as it is.
+    Definitions and templates are read from the CoS cache, which the plugin
+    rebuilds as they are added, modified and deleted.
+*/
+int32_t
+cos_filter_rewriter(Slapi_PBlock *pb)
+{
+    cosCache *pCache = NULL;
+    Slapi_Filter *filter = NULL;
+    int error_code = 0;
+    int rc;
+
+    if (cos_cache_getref((cos_cache **)&pCache) < 1) {
+        return SEARCH_REWRITE_CALLBACK_CONTINUE;
+    }
+    slapi_pblock_get(pb, SLAPI_SEARCH_FILTER, &filter);
+    rc = slapi_filter_apply(filter, cos_cache_rewrite_ava, pCache, &error_code);
+    cos_cache_release((cos_cache *)pCache);
+    if (rc != SLAPI_FILTER_SCAN_NOMORE) {
+        slapi_log_err(SLAPI_LOG_ERR, COS_PLUGIN_SUBSYSTEM,
+                      "cos_filter_rewriter - Could not update the search filter - error %d (%d)\n",
+                      rc, error_code);
+        return SEARCH_REWRITE_CALLBACK_ERROR;
+    }
+    return SEARCH_REWRITE_CALLBACK_CONTINUE;
+}
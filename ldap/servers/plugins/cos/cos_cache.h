@@ -22,5 +22,6 @@ int cos_cache_getref(cos_cache **ppCache);
 int cos_cache_addref(cos_cache *pCache);
 int cos_cache_release(cos_cache *pCache);
 void cos_cache_change_notify(Slapi_PBlock *pb);
+int32_t cos_filter_rewriter(Slapi_PBlock *pb);
 
 #endif /* _COS_CACHE_H */
@@ -25,6 +25,7 @@ typedef struct changelog5Config
     char *maxAge;
     int maxEntries;
     long trimInterval;
+    int compactMaxPages;
     /* configuration of changelog encryption */
     char *encryptionAlgorithm;
     char *symmetricKey;
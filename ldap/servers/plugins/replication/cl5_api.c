@@ -39,6 +39,8 @@
 #define GUARDIAN_FILE "guardian" /* name of the guardian file */
 #define VERSION_FILE "DBVERSION" /* name of the version file  */
 #define V_5 5                    /* changelog entry version */
+#define V_6 6                    /* changelog entry version: compact mods encoding */
+#define CL5_VARINT_MAXLEN 5      /* maximum size of an encoded 32 bit varint */
 #define CHUNK_SIZE 64 * 1024
 #define DBID_SIZE 64
 #define FILE_SEP "_" /* separates parts of the db file name */
@@ -116,6 +118,7 @@ typedef struct cl5config
     time_t maxAge;       /* maximum entry age in seconds                            */
     int maxEntries;      /* maximum number of entries across all changelog files    */
     int trimInterval;    /* trimming interval */
+    int compactMaxPages; /* pages freed per compaction pass after trimming, 0 to disable */
     char *encryptionAlgorithm; /* nsslapd-encryptionalgorithm */
 } CL5Config;
 
@@ -202,10 +205,14 @@ static const char *_cl5OperationType2Str(int type);
 static int _cl5Str2OperationType(const char *str);
 static void _cl5WriteString(const char *str, char **buff);
 static void _cl5ReadString(char **str, char **buff);
+static void _cl5WriteVarint(PRUint32 value, char **buff);
+static PRUint32 _cl5ReadVarint(char **buff);
+static void _cl5WriteAttrType(const char *type, char **buff);
+static int _cl5ReadAttrType(char **type, char **buff);
 static void _cl5WriteMods(LDAPMod **mods, char **buff, void *clcrypt_handle);
 static int _cl5WriteMod(LDAPMod *mod, char **buff, void *clcrypt_handle);
-static int _cl5ReadMods(LDAPMod ***mods, char **buff, void *clcrypt_handle);
-static int _cl5ReadMod(Slapi_Mod *mod, char **buff, void *clcrypt_handle);
+static int _cl5ReadMods(LDAPMod ***mods, char **buff, PRUint8 version, void *clcrypt_handle);
+static int _cl5ReadMod(Slapi_Mod *mod, char **buff, PRUint8 version, void *clcrypt_handle);
 static int _cl5GetModsSize(LDAPMod **mods);
 static int _cl5GetModSize(LDAPMod *mod);
 static void _cl5ReadBerval(struct berval *bv, char **buff);
@@ -227,9 +234,12 @@ static int cldb_IsTrimmingEnabled(cldb_Handle *cldb);
 static int _cl5TrimMain(void *param);
 static void _cl5TrimReplica(Replica *r);
 static void _cl5PurgeRID(cldb_Handle *cldb,  ReplicaId cleaned_rid);
-static int _cl5PurgeGetFirstEntry(cldb_Handle *cldb, CL5Entry *entry, void **iterator, DB_TXN *txnid, int rid, DBT *key);
-static int _cl5PurgeGetNextEntry(CL5Entry *entry, void *iterator, DBT *key);
+static int _cl5PurgeGetFirstEntry(cldb_Handle *cldb, CSN *csn, void **iterator, DB_TXN *txnid, int rid, DBT *key);
+static int _cl5PurgeGetNextEntry(CSN *csn, void *iterator, DBT *key);
 static PRBool _cl5CanTrim(time_t time, long *numToTrim, Replica *replica, CL5Config *dbTrim);
+static int _cl5TrimGetRecord(DBC *cursor, u_int32_t flags, char *keybuf, CSN *csn, time_t *time);
+static long _cl5TrimFindRange(cldb_Handle *cldb, RUV *ruv, long numToTrim, char *lastKey);
+static void _cl5CompactDB(cldb_Handle *cldb, const char *lastKey);
 static int _cl5ReadRUV(cldb_Handle *cldb, PRBool purge);
 static int _cl5WriteRUV(cldb_Handle *cldb, PRBool purge);
 static int _cl5ConstructRUV(cldb_Handle *cldb, PRBool purge);
@@ -796,12 +806,13 @@ cl5GetState()
    Description:    sets changelog trimming parameters; changelog must be open.
    Parameters:  maxEntries - maximum number of entries in the chnagelog (in all files);
                 maxAge - maximum entry age;
-                trimInterval - changelog trimming interval.
+                trimInterval - changelog trimming interval;
+                compactMaxPages - pages freed per compaction pass after trimming.
    Return:        CL5_SUCCESS if successful;
                 CL5_BAD_STATE if changelog is not open
  */
 int
-cl5ConfigTrimming(Replica *replica, int maxEntries, const char *maxAge, int trimInterval)
+cl5ConfigTrimming(Replica *replica, int maxEntries, const char *maxAge, int trimInterval, int compactMaxPages)
 {
     int isTrimmingEnabledBefore = 0;
     int isTrimmingEnabledAfter = 0;
@@ -838,6 +849,10 @@ cl5ConfigTrimming(Replica *replica, int maxEntries, const char *maxAge, int trim
         cldb->clConf.trimInterval = trimInterval;
     }
 
+    if (compactMaxPages != CL5_NUM_IGNORE) {
+        cldb->clConf.compactMaxPages = compactMaxPages;
+    }
+
     isTrimmingEnabledAfter = cldb_IsTrimmingEnabled(cldb);
 
     if (isTrimmingEnabledAfter && !isTrimmingEnabledBefore) {
@@ -1193,6 +1208,23 @@ cl5DestroyReplayIterator(CL5ReplayIterator **iterator)
     _cl5RemoveThread();
 }
 
+/* Name:        cl5GetReplayIteratorStats
+   Description:    returns changelog cache statistics for the session
+   Parameters:  iterator - replay iterator
+                loads - number of changelog db reads done to fill the cache
+                records - number of changes read from the cache
+   Return:        none
+ */
+void
+cl5GetReplayIteratorStats(CL5ReplayIterator *iterator, int *loads, int *records)
+{
+    if (iterator == NULL) {
+        *loads = *records = 0;
+        return;
+    }
+    clcache_get_stats(iterator->clcache, loads, records);
+}
+
 /* Name: cl5GetOperationCount
    Description: returns number of entries in the changelog. The changelog must be
                 open for the value to be meaningful.
@@ -1392,7 +1424,7 @@ cldb_SetReplicaDB(Replica *replica, void *arg)
     slapi_entry_free(config_entry.ce);
 
     /* set trimming parameters */
-    rc = cl5ConfigTrimming(replica, config.maxEntries, config.maxAge, config.trimInterval);
+    rc = cl5ConfigTrimming(replica, config.maxEntries, config.maxAge, config.trimInterval, config.compactMaxPages);
     if (rc != CL5_SUCCESS) {
         slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name_cl,
                       "cldb_SetReplicaDB - failed to configure changelog trimming\n");
@@ -1490,21 +1522,31 @@ _cldb_CheckAndSetEnv(Slapi_Backend *be)
 /* this function assumes that the entry was validated
    using IsValidOperation
 
-   Data in db format:
-   ------------------
-   <1 byte version><1 byte change_type><sizeof time_t time><null terminated csn>
-   <null terminated uniqueid><null terminated targetdn>
-   [<null terminated newrdn><1 byte deleteoldrdn>][<4 byte mod count><mod1><mod2>....]
+   Data in db format (V_6):
+   ------------------------
+   <1 byte version><1 byte change_type><4 byte time><1 byte flags>
+   <null terminated csn><null terminated uniqueid><null terminated targetdn>
+   [<null terminated newrdn><1 byte deleteoldrdn>][<varint mod count><mod1><mod2>....]
 
    mod format:
    -----------
-   <1 byte modop><null terminated attr name><4 byte value count>
-   <4 byte value size><value1><4 byte value size><value2>
+   <1 byte modop><attr type><varint value count>
+   <varint value size><value1><varint value size><value2>
+
+   The attr type is either one byte, the index of the type in s_cl5AttrDict,
+   or the null terminated attr name. No flags are defined yet; they are
+   reserved for per record options such as compression. V_5 records, with
+   4 byte counts and sizes and no flags, are still read.
+
+   Older servers only read V_5 records. Before downgrading, export the
+   changelog with the cl2ldif replica task; once the older server runs,
+   import it with the ldif2cl task, which writes the records back in the
+   format of that server.
 */
 static int
 _cl5Entry2DBData(const CL5Entry *entry, char **data, PRUint32 *len, void *clcrypt_handle)
 {
-    int size = 1 /* version */ + 1 /* operation type */ + sizeof(time_t);
+    int size = 1 /* version */ + 1 /* operation type */ + sizeof(time_t) + 1 /* flags */;
     char *pos;
     PRUint32 t;
     slapi_operation_parameters *op;
@@ -1582,7 +1624,7 @@ _cl5Entry2DBData(const CL5Entry *entry, char **data, PRUint32 *len, void *clcryp
     /* fill in the data buffer */
     pos = *data;
     /* write a byte of version */
-    (*pos) = V_5;
+    (*pos) = V_6;
     pos++;
     /* write change type */
     (*pos) = (unsigned char)op->operation_type;
@@ -1591,6 +1633,9 @@ _cl5Entry2DBData(const CL5Entry *entry, char **data, PRUint32 *len, void *clcryp
     t = PR_htonl((PRUint32)entry->time);
     memcpy(pos, &t, sizeof(t));
     pos += sizeof(t);
+    /* write flags */
+    (*pos) = 0;
+    pos++;
     /* write csn */
     _cl5WriteString(csn_as_string(op->csn, PR_FALSE, s), &pos);
     /* write UniqueID */
@@ -1650,6 +1695,8 @@ _cl5Entry2DBData(const CL5Entry *entry, char **data, PRUint32 *len, void *clcryp
    -----------
    <1 byte modop><null terminated attr name><4 byte value count>
    <4 byte value size><value1><4 byte value size><value2>
+
+   This is the V_5 format, V_6 records are described with _cl5Entry2DBData.
 */
 
 
@@ -1672,7 +1719,7 @@ cl5DBData2Entry(const char *data, PRUint32 len __attribute__((unused)), CL5Entry
 
     /* read byte of version */
     version = (PRUint8)(*pos);
-    if (version != V_5) {
+    if (version != V_5 && version != V_6) {
         slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name_cl,
                       "cl5DBData2Entry - Invalid data version\n");
         return CL5_BAD_FORMAT;
@@ -1692,6 +1739,16 @@ cl5DBData2Entry(const char *data, PRUint32 len __attribute__((unused)), CL5Entry
     entry->time = (time_t)PR_ntohl(thetime);
     pos += sizeof(thetime);
 
+    if (version == V_6) {
+        /* read flags: none are known yet */
+        if (*pos != 0) {
+            slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name_cl,
+                          "cl5DBData2Entry - Unsupported data flags 0x%x\n", (PRUint8)(*pos));
+            return CL5_BAD_FORMAT;
+        }
+        pos++;
+    }
+
     /* read csn */
     _cl5ReadString(&strCSN, &pos);
     if (op->csn == NULL || strcmp(strCSN, csn_as_string(op->csn, PR_FALSE, s)) != 0) {
@@ -1710,7 +1767,7 @@ cl5DBData2Entry(const char *data, PRUint32 len __attribute__((unused)), CL5Entry
         _cl5ReadString(&rawDN, &pos);
         op->target_address.sdn = slapi_sdn_new_dn_passin(rawDN);
         /* convert mods to entry */
-        rc = _cl5ReadMods(&add_mods, &pos, clcrypt_handle);
+        rc = _cl5ReadMods(&add_mods, &pos, version, clcrypt_handle);
         slapi_mods2entry(&(op->p.p_add.target_entry), rawDN, add_mods);
         ldap_mods_free(add_mods, 1);
         break;
@@ -1718,7 +1775,7 @@ cl5DBData2Entry(const char *data, PRUint32 len __attribute__((unused)), CL5Entry
     case SLAPI_OPERATION_MODIFY:
         _cl5ReadString(&rawDN, &pos);
         op->target_address.sdn = slapi_sdn_new_dn_passin(rawDN);
-        rc = _cl5ReadMods(&op->p.p_modify.modify_mods, &pos, clcrypt_handle);
+        rc = _cl5ReadMods(&op->p.p_modify.modify_mods, &pos, version, clcrypt_handle);
         break;
 
     case SLAPI_OPERATION_MODRDN:
@@ -1730,7 +1787,7 @@ cl5DBData2Entry(const char *data, PRUint32 len __attribute__((unused)), CL5Entry
         _cl5ReadString(&rawDN, &pos);
         op->p.p_modrdn.modrdn_newsuperior_address.sdn = slapi_sdn_new_dn_passin(rawDN);
         _cl5ReadString(&op->p.p_modrdn.modrdn_newsuperior_address.uniqueid, &pos);
-        rc = _cl5ReadMods(&op->p.p_modrdn.modrdn_mods, &pos, clcrypt_handle);
+        rc = _cl5ReadMods(&op->p.p_modrdn.modrdn_mods, &pos, version, clcrypt_handle);
         break;
 
     case SLAPI_OPERATION_DELETE:
@@ -1835,39 +1892,161 @@ _cl5ReadString(char **str, char **buff)
     }
 }
 
+/*
+ * Attribute types written as a one byte index in V_6 records. The types
+ * are matched exactly, so that the records are decoded as they were
+ * written, and are the ones the server adds to most of the changes.
+ * An attribute description never starts with a byte below '0', which
+ * leaves room for 47 entries. Only append to this table: the index of a
+ * type must never change once records have been written with it. dbscan
+ * has a copy of this table, to be kept identical.
+ */
+static const char *s_cl5AttrDict[] = {
+    NULL, /* 0 is the end of a string, not an index */
+    "objectclass",
+    "objectClass",
+    "modifiersname",
+    "modifytimestamp",
+    "internalModifiersName",
+    "internalModifiersname",
+    "internalmodifiersname",
+    "internalModifyTimestamp",
+    "internalmodifytimestamp",
+    "creatorsname",
+    "createtimestamp",
+    "internalCreatorsName",
+    "internalCreatorsname",
+    "nsuniqueid",
+    PSEUDO_ATTR_UNHASHEDUSERPASSWORD,
+    "userPassword",
+    "userpassword",
+    "cn",
+    "sn",
+    "uid",
+    "givenName",
+    "mail",
+    "description",
+    "member",
+    "uniqueMember",
+    "memberOf",
+    "telephoneNumber",
+    "passwordRetryCount",
+    "retryCountResetTime",
+    "accountUnlockTime",
+    "passwordExpirationTime",
+    "passwordHistory",
+    "passwordAllowChangeTime",
+    "pwdUpdateTime",
+    "lastLoginTime",
+    "nsAccountLock",
+    "nsds5ReplConflict",
+};
+#define CL5_ATTR_DICT_SIZE (sizeof(s_cl5AttrDict) / sizeof(s_cl5AttrDict[0]))
+#define CL5_ATTR_DICT_MAX '0'
+
+/* little endian base 128: 7 bits per byte, the high bit is set on all the bytes but the last */
+static void
+_cl5WriteVarint(PRUint32 value, char **buff)
+{
+    unsigned char *pos = (unsigned char *)*buff;
+
+    while (value >= 0x80) {
+        *pos++ = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    *pos++ = (unsigned char)value;
+    (*buff) = (char *)pos;
+}
+
+static PRUint32
+_cl5ReadVarint(char **buff)
+{
+    unsigned char *pos = (unsigned char *)*buff;
+    PRUint32 value = 0;
+    int shift;
+
+    for (shift = 0; shift < 7 * CL5_VARINT_MAXLEN; shift += 7) {
+        value |= (PRUint32)(*pos & 0x7f) << shift;
+        if ((*pos++ & 0x80) == 0) {
+            break;
+        }
+    }
+    (*buff) = (char *)pos;
+
+    return value;
+}
+
+static void
+_cl5WriteAttrType(const char *type, char **buff)
+{
+    size_t i;
+
+    for (i = 1; i < CL5_ATTR_DICT_SIZE; i++) {
+        if (strcmp(type, s_cl5AttrDict[i]) == 0) {
+            (**buff) = (char)i;
+            (*buff)++;
+            return;
+        }
+    }
+    _cl5WriteString(type, buff);
+}
+
+static int
+_cl5ReadAttrType(char **type, char **buff)
+{
+    PRUint8 index = (PRUint8)(**buff);
+
+    if (index == 0 || index >= CL5_ATTR_DICT_MAX) {
+        _cl5ReadString(type, buff);
+        return (*type == NULL) ? CL5_BAD_FORMAT : CL5_SUCCESS;
+    }
+    if (index >= CL5_ATTR_DICT_SIZE) {
+        slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name_cl,
+                      "_cl5ReadAttrType - Unknown attribute type index %d\n", index);
+        *type = NULL;
+        return CL5_BAD_FORMAT;
+    }
+    *type = slapi_ch_strdup(s_cl5AttrDict[index]);
+    (*buff)++;
+
+    return CL5_SUCCESS;
+}
+
 /* mods format:
    -----------
-   <4 byte mods count><mod1><mod2>...
+   <varint mods count><mod1><mod2>...
 
    mod format:
    -----------
-   <1 byte modop><null terminated attr name><4 byte count>
-   <4 byte size><value1><4 byte size><value2>...
+   <1 byte modop><attr type><varint count>
+   <varint size><value1><varint size><value2>...
  */
 static void
 _cl5WriteMods(LDAPMod **mods, char **buff, void *clcrypt_handle)
 {
     PRInt32 i;
     char *mod_start;
-    PRInt32 count = 0;
+    char *pos;
+    PRUint32 count = 0;
 
     if (mods == NULL)
         return;
 
-    /* skip mods count */
-    mod_start = (*buff) + sizeof(count);
+    /* the count is only known once the mods are written, which may skip
+     * some of them: reserve room for the largest count and move the mods
+     * next to the actual count afterwards */
+    mod_start = pos = (*buff) + CL5_VARINT_MAXLEN;
 
     /* write mods*/
     for (i = 0; mods[i]; i++) {
-        if (0 <= _cl5WriteMod(mods[i], &mod_start, clcrypt_handle)) {
+        if (0 <= _cl5WriteMod(mods[i], &pos, clcrypt_handle)) {
             count++;
         }
     }
 
-    count = PR_htonl(count);
-    memcpy(*buff, &count, sizeof(count));
-
-    (*buff) = mod_start;
+    _cl5WriteVarint(count, buff);
+    memmove(*buff, mod_start, pos - mod_start);
+    (*buff) += pos - mod_start;
 }
 
 /*
@@ -1881,7 +2060,6 @@ _cl5WriteMod(LDAPMod *mod, char **buff, void *clcrypt_handle)
 {
     char *orig_pos;
     char *pos;
-    PRInt32 count;
     struct berval *bv;
     struct berval *encbv;
     struct berval *bv_to_use;
@@ -1905,12 +2083,10 @@ _cl5WriteMod(LDAPMod *mod, char **buff, void *clcrypt_handle)
     *pos = (PRUint8)slapi_mod_get_operation(&smod);
     pos++;
     /* write attribute name    */
-    _cl5WriteString(slapi_mod_get_type(&smod), &pos);
+    _cl5WriteAttrType(slapi_mod_get_type(&smod), &pos);
 
     /* write value count */
-    count = PR_htonl(slapi_mod_get_num_values(&smod));
-    memcpy(pos, &count, sizeof(count));
-    pos += sizeof(PRInt32);
+    _cl5WriteVarint((PRUint32)slapi_mod_get_num_values(&smod), &pos);
 
     /* if the mod has no values, eg delete attr or replace attr without values
      * do not reset buffer
@@ -1937,7 +2113,9 @@ _cl5WriteMod(LDAPMod *mod, char **buff, void *clcrypt_handle)
             break;
         }
         if (bv_to_use) {
-            _cl5WriteBerval(bv_to_use, &pos);
+            _cl5WriteVarint((PRUint32)bv_to_use->bv_len, &pos);
+            memcpy(pos, bv_to_use->bv_val, bv_to_use->bv_len);
+            pos += bv_to_use->bv_len;
         }
         slapi_ch_bvfree(&encbv);
         bv = slapi_mod_get_next_value(&smod);
@@ -1962,10 +2140,12 @@ _cl5WriteMod(LDAPMod *mod, char **buff, void *clcrypt_handle)
    <1 byte modop><null terminated attr name><4 byte count>
    {<4 byte size><value1><4 byte size><value2>... ||
     <null terminated str1> <null terminated str2>...}
+
+   This is the V_5 format, V_6 mods are described with _cl5WriteMods.
  */
 
 static int
-_cl5ReadMods(LDAPMod ***mods, char **buff, void *clcrypt_handle)
+_cl5ReadMods(LDAPMod ***mods, char **buff, PRUint8 version, void *clcrypt_handle)
 {
     char *pos = *buff;
     int i;
@@ -1974,16 +2154,20 @@ _cl5ReadMods(LDAPMod ***mods, char **buff, void *clcrypt_handle)
     Slapi_Mods smods;
     Slapi_Mod smod;
 
-    /* need to copy first, to skirt around alignment problems on certain
-       architectures */
-    memcpy((char *)&mod_count, *buff, sizeof(mod_count));
-    mod_count = PR_ntohl(mod_count);
-    pos += sizeof(mod_count);
+    if (version == V_5) {
+        /* need to copy first, to skirt around alignment problems on certain
+           architectures */
+        memcpy((char *)&mod_count, *buff, sizeof(mod_count));
+        mod_count = PR_ntohl(mod_count);
+        pos += sizeof(mod_count);
+    } else {
+        mod_count = (PRInt32)_cl5ReadVarint(&pos);
+    }
 
     slapi_mods_init(&smods, mod_count);
 
     for (i = 0; i < mod_count; i++) {
-        rc = _cl5ReadMod(&smod, &pos, clcrypt_handle);
+        rc = _cl5ReadMod(&smod, &pos, version, clcrypt_handle);
         if (rc != CL5_SUCCESS) {
             slapi_mods_done(&smods);
             return rc;
@@ -2001,7 +2185,7 @@ _cl5ReadMods(LDAPMod ***mods, char **buff, void *clcrypt_handle)
 }
 
 static int
-_cl5ReadMod(Slapi_Mod *smod, char **buff, void *clcrypt_handle)
+_cl5ReadMod(Slapi_Mod *smod, char **buff, PRUint8 version, void *clcrypt_handle)
 {
     char *pos = *buff;
     int i;
@@ -2015,13 +2199,21 @@ _cl5ReadMod(Slapi_Mod *smod, char **buff, void *clcrypt_handle)
 
     op = (*pos) & 0x000000FF;
     pos++;
-    _cl5ReadString(&type, &pos);
+    if (version == V_5) {
+        _cl5ReadString(&type, &pos);
 
-    /* need to do the copy first, to skirt around alignment problems on
-       certain architectures */
-    memcpy((char *)&val_count, pos, sizeof(val_count));
-    val_count = PR_ntohl(val_count);
-    pos += sizeof(PRInt32);
+        /* need to do the copy first, to skirt around alignment problems on
+           certain architectures */
+        memcpy((char *)&val_count, pos, sizeof(val_count));
+        val_count = PR_ntohl(val_count);
+        pos += sizeof(PRInt32);
+    } else {
+        rc = _cl5ReadAttrType(&type, &pos);
+        if (rc != CL5_SUCCESS) {
+            return rc;
+        }
+        val_count = (PRInt32)_cl5ReadVarint(&pos);
+    }
 
     slapi_mod_init(smod, val_count);
     slapi_mod_set_operation(smod, op | LDAP_MOD_BVALUES);
@@ -2029,7 +2221,14 @@ _cl5ReadMod(Slapi_Mod *smod, char **buff, void *clcrypt_handle)
     slapi_ch_free((void **)&type);
 
     for (i = 0; i < val_count; i++) {
-        _cl5ReadBerval(&bv, &pos);
+        if (version == V_5) {
+            _cl5ReadBerval(&bv, &pos);
+        } else {
+            /* the value is copied by slapi_mod_add_value, use it in place */
+            bv.bv_len = _cl5ReadVarint(&pos);
+            bv.bv_val = bv.bv_len ? pos : NULL;
+            pos += bv.bv_len;
+        }
         decbv = NULL;
         rc = 0;
         rc = clcrypt_decrypt_value(clcrypt_handle,
@@ -2063,7 +2262,9 @@ _cl5ReadMod(Slapi_Mod *smod, char **buff, void *clcrypt_handle)
             slapi_mod_add_value(smod, bv_to_use);
         }
         slapi_ch_bvfree(&decbv);
-        slapi_ch_free((void **)&bv.bv_val);
+        if (version == V_5) {
+            slapi_ch_free((void **)&bv.bv_val);
+        }
     }
 
     (*buff) = pos;
@@ -2071,6 +2272,7 @@ _cl5ReadMod(Slapi_Mod *smod, char **buff, void *clcrypt_handle)
     return CL5_SUCCESS;
 }
 
+/* upper bound of the size of the mods written by _cl5WriteMods */
 static int
 _cl5GetModsSize(LDAPMod **mods)
 {
@@ -2080,7 +2282,7 @@ _cl5GetModsSize(LDAPMod **mods)
     if (mods == NULL)
         return 0;
 
-    size = sizeof(PRInt32);
+    size = CL5_VARINT_MAXLEN;
     for (i = 0; mods[i]; i++) {
         size += _cl5GetModSize(mods[i]);
     }
@@ -2094,12 +2296,12 @@ _cl5GetModSize(LDAPMod *mod)
     int size;
     int i;
 
-    size = 1 + strlen(mod->mod_type) + 1 + sizeof(mod->mod_op);
+    size = 1 + strlen(mod->mod_type) + 1 + CL5_VARINT_MAXLEN;
     i = 0;
     if (mod->mod_op & LDAP_MOD_BVALUES) /* values are in binary form */
     {
         while (mod->mod_bvalues != NULL && mod->mod_bvalues[i] != NULL) {
-            size += (PRInt32)mod->mod_bvalues[i]->bv_len + sizeof(PRInt32);
+            size += (PRInt32)mod->mod_bvalues[i]->bv_len + CL5_VARINT_MAXLEN;
             i++;
         }
     } else /* string data */
@@ -2369,9 +2571,12 @@ _cl5DoPurging(cleanruv_purge_data *purge_data)
  * If the rid is not set it is the very first iteration of the changelog.
  * If the rid is set, we are doing another pass, and we have a key as our
  * starting point.
+ *
+ * The rid of a change is part of its csn, which is the record key, so the
+ * purge only reads the keys and never fetches or decodes the changes.
  */
 static int
-_cl5PurgeGetFirstEntry(cldb_Handle *cldb, CL5Entry *entry, void **iterator, DB_TXN *txnid, int rid, DBT *key)
+_cl5PurgeGetFirstEntry(cldb_Handle *cldb, CSN *csn, void **iterator, DB_TXN *txnid, int rid, DBT *key)
 {
     DBC *cursor = NULL;
     DBT data = {0};
@@ -2388,24 +2593,16 @@ _cl5PurgeGetFirstEntry(cldb_Handle *cldb, CL5Entry *entry, void **iterator, DB_T
     }
 
     key->flags = DB_DBT_MALLOC;
-    data.flags = DB_DBT_MALLOC;
+    data.flags = DB_DBT_USERMEM | DB_DBT_PARTIAL;
     while ((rc = cursor->c_get(cursor, key, &data, rid ? DB_SET : DB_NEXT)) == 0) {
+        csn_init_by_string(csn, (char *)key->data);
+
         /* skip service entries on the first pass (rid == 0)*/
-        if (!rid && cl5HelperEntry((char *)key->data, NULL)) {
+        if (!rid && cl5HelperEntry(NULL, csn)) {
             slapi_ch_free(&key->data);
-            slapi_ch_free(&(data.data));
             continue;
         }
 
-        /* format entry */
-        rc = cl5DBData2Entry(data.data, data.size, entry, cldb->clcrypt_handle);
-        slapi_ch_free(&(data.data));
-        if (rc != 0) {
-            slapi_log_err(SLAPI_LOG_REPL, repl_plugin_name_cl,
-                          "_cl5PurgeGetFirstEntry - Failed to format entry: %d\n", rc);
-            goto done;
-        }
-
         it = (CL5Iterator *)slapi_ch_malloc(sizeof(CL5Iterator));
         it->cursor = cursor;
         /* TBD do we need to lock the file in the iterator ?? */
@@ -2417,7 +2614,6 @@ _cl5PurgeGetFirstEntry(cldb_Handle *cldb, CL5Entry *entry, void **iterator, DB_T
     }
 
     slapi_ch_free(&key->data);
-    slapi_ch_free(&(data.data));
 
     /* walked of the end of the file */
     if (rc == DB_NOTFOUND) {
@@ -2447,7 +2643,7 @@ done:
  * starting at the current key.
  */
 static int
-_cl5PurgeGetNextEntry(CL5Entry *entry, void *iterator, DBT *key)
+_cl5PurgeGetNextEntry(CSN *csn, void *iterator, DBT *key)
 {
     CL5Iterator *it;
     DBT data = {0};
@@ -2456,31 +2652,16 @@ _cl5PurgeGetNextEntry(CL5Entry *entry, void *iterator, DBT *key)
     it = (CL5Iterator *)iterator;
 
     key->flags = DB_DBT_MALLOC;
-    data.flags = DB_DBT_MALLOC;
+    data.flags = DB_DBT_USERMEM | DB_DBT_PARTIAL;
     while ((rc = it->cursor->c_get(it->cursor, key, &data, DB_NEXT)) == 0) {
-        if (cl5HelperEntry((char *)key->data, NULL)) {
+        csn_init_by_string(csn, (char *)key->data);
+        if (cl5HelperEntry(NULL, csn)) {
             slapi_ch_free(&key->data);
-            slapi_ch_free(&(data.data));
             continue;
         }
 
-        /* format entry */
-        rc = cl5DBData2Entry(data.data, data.size, entry, it->it_cldb->clcrypt_handle);
-        slapi_ch_free(&(data.data));
-        if (rc != 0) {
-            if (rc != CL5_DB_LOCK_ERROR) {
-                /* Not a lock error, free the key */
-                slapi_ch_free(&key->data);
-            }
-            slapi_log_err(rc == CL5_DB_LOCK_ERROR ? SLAPI_LOG_REPL : SLAPI_LOG_ERR,
-                          repl_plugin_name_cl,
-                          "_cl5PurgeGetNextEntry - Failed to format entry: %d\n",
-                          rc);
-        }
-
         return rc;
     }
-    slapi_ch_free(&(data.data));
 
     /* walked of the end of the file or entry is out of range */
     if (rc == 0 || rc == DB_NOTFOUND) {
@@ -2514,9 +2695,7 @@ _cl5PurgeGetNextEntry(CL5Entry *entry, void *iterator, DBT *key)
 static void
 _cl5PurgeRID(cldb_Handle *cldb, ReplicaId cleaned_rid)
 {
-    slapi_operation_parameters op = {0};
-    ReplicaId csn_rid;
-    CL5Entry entry;
+    CSN *csn = csn_new();
     DB_TXN *txnid = NULL;
     DBT key = {0};
     void *iterator = NULL;
@@ -2529,8 +2708,6 @@ _cl5PurgeRID(cldb_Handle *cldb, ReplicaId cleaned_rid)
     int finished = 0;
     int rc = 0;
 
-    entry.op = &op;
-
     /*
      * Keep processing the changelog until we are done, shutting down, or we
      * maxed out on the db lock retries.
@@ -2550,13 +2727,14 @@ _cl5PurgeRID(cldb_Handle *cldb, ReplicaId cleaned_rid)
                           "_cl5PurgeRID - Failed to begin transaction; db error - %d %s.  "
                           "Changelog was not purged of rid(%d)\n",
                           rc, db_strerror(rc), cleaned_rid);
+            csn_free(&csn);
             return;
         }
 
         /*
          * Check every changelog entry for the cleaned rid
          */
-        rc = _cl5PurgeGetFirstEntry(cldb, &entry, &iterator, txnid, first_pass?0:cleaned_rid, &key);
+        rc = _cl5PurgeGetFirstEntry(cldb, csn, &iterator, txnid, first_pass?0:cleaned_rid, &key);
         first_pass = 0;
         while (rc == CL5_SUCCESS && !slapi_is_shutting_down()) {
             /*
@@ -2571,52 +2749,46 @@ _cl5PurgeRID(cldb_Handle *cldb, ReplicaId cleaned_rid)
                  * Break out, and commit these deletes.  Do not free the key,
                  * we need it for the next pass.
                  */
-                cl5_operation_parameters_done(&op);
                 db_lock_retry_count = 0; /* reset the retry count */
                 break;
             }
-            if (op.csn) {
-                csn_rid = csn_get_replicaid(op.csn);
-                if (csn_rid == cleaned_rid) {
-                    rc = _cl5CurrentDeleteEntry(iterator);
-                    if (rc != CL5_SUCCESS) {
-                        /* log error */
-                        cl5_operation_parameters_done(&op);
-                        if (rc == CL5_DB_LOCK_ERROR) {
-                            /*
-                             * Ran out of locks, need to restart the transaction.
-                             * Reduce the the batch count and reset the key to
-                             * the starting point
-                             */
-                            slapi_log_err(SLAPI_LOG_REPL, repl_plugin_name_cl,
-                                          "_cl5PurgeRID - Ran out of db locks deleting entry.  "
-                                          "Reduce the batch value and restart.\n");
-                            batch_count = trimmed - 10;
-                            if (batch_count < 10) {
-                                batch_count = 10;
-                            }
-                            trimmed = 0;
-                            slapi_ch_free(&(key.data));
-                            key.data = starting_key;
-                            starting_key = NULL;
-                            db_lock_retry_count++;
-                            break;
-                        } else {
-                            /* fatal error */
-                            slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name_cl,
-                                          "_cl5PurgeRID - Fatal error (%d)\n", rc);
-                            slapi_ch_free(&(key.data));
-                            finished = 1;
-                            break;
+            if (csn_get_replicaid(csn) == cleaned_rid) {
+                rc = _cl5CurrentDeleteEntry(iterator);
+                if (rc != CL5_SUCCESS) {
+                    /* log error */
+                    if (rc == CL5_DB_LOCK_ERROR) {
+                        /*
+                         * Ran out of locks, need to restart the transaction.
+                         * Reduce the the batch count and reset the key to
+                         * the starting point
+                         */
+                        slapi_log_err(SLAPI_LOG_REPL, repl_plugin_name_cl,
+                                      "_cl5PurgeRID - Ran out of db locks deleting entry.  "
+                                      "Reduce the batch value and restart.\n");
+                        batch_count = trimmed - 10;
+                        if (batch_count < 10) {
+                            batch_count = 10;
                         }
+                        trimmed = 0;
+                        slapi_ch_free(&(key.data));
+                        key.data = starting_key;
+                        starting_key = NULL;
+                        db_lock_retry_count++;
+                        break;
+                    } else {
+                        /* fatal error */
+                        slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name_cl,
+                                      "_cl5PurgeRID - Fatal error (%d)\n", rc);
+                        slapi_ch_free(&(key.data));
+                        finished = 1;
+                        break;
                     }
-                    trimmed++;
                 }
+                trimmed++;
             }
             slapi_ch_free(&(key.data));
-            cl5_operation_parameters_done(&op);
 
-            rc = _cl5PurgeGetNextEntry(&entry, iterator, &key);
+            rc = _cl5PurgeGetNextEntry(csn, iterator, &key);
             if (rc == CL5_DB_LOCK_ERROR) {
                 /*
                  * Ran out of locks, need to restart the transaction.
@@ -2631,7 +2803,6 @@ _cl5PurgeRID(cldb_Handle *cldb, ReplicaId cleaned_rid)
                     batch_count = 10;
                 }
                 trimmed = 0;
-                cl5_operation_parameters_done(&op);
                 slapi_ch_free(&(key.data));
                 key.data = starting_key;
                 starting_key = NULL;
@@ -2686,31 +2857,254 @@ _cl5PurgeRID(cldb_Handle *cldb, ReplicaId cleaned_rid)
         }
     }
     slapi_ch_free_string(&starting_key);
+    csn_free(&csn);
 
     slapi_log_err(SLAPI_LOG_REPL, repl_plugin_name_cl,
                   "_cl5PurgeRID - Removed (%ld entries) that originated from rid (%d)\n",
                   totalTrimmed, cleaned_rid);
+
+    if (totalTrimmed) {
+        /* the purged changes were spread over the whole changelog */
+        _cl5CompactDB(cldb, NULL);
+    }
 }
 
 /* Note that each file contains changes for a single replicated area.
    trimming algorithm:
+   The records are keyed by csn, so the changes are stored in the order in
+   which they were made and the changes that can be trimmed always form a range
+   at the beginning of the file. The range is located first by a read-only scan
+   that only fetches the record keys and headers (_cl5TrimFindRange), then it is
+   removed in transactions of at most CL5_TRIM_MAX_PER_TRANSACTION records,
+   without decoding the changes. Trimming pauses between the transactions so
+   that it does not starve the updates, and compacts the trimmed range when it
+   is done.
 */
-#define CL5_TRIM_MAX_PER_TRANSACTION 10
+#define CL5_TRIM_MAX_PER_TRANSACTION 100
+#define CL5_TRIM_PAUSE PR_MillisecondsToInterval(10)
+/* version, operation type and time: the fixed part of a record, see _cl5Entry2DBData */
+#define CL5_TRIM_HEADER_SIZE (1 + 1 + sizeof(PRUint32))
+
+/*
+ * Read the next record for trimming. The csn is taken from the key, and the
+ * change time from the record header when rectime is not NULL; the change
+ * itself is never read. Service entries are skipped. keybuf must hold
+ * CSN_STRSIZE bytes, and holds the starting key when flags is DB_SET_RANGE.
+ */
+static int
+_cl5TrimGetRecord(DBC *cursor, u_int32_t flags, char *keybuf, CSN *csn, time_t *rectime)
+{
+    char header[CL5_TRIM_HEADER_SIZE];
+    PRUint32 thetime;
+    DBT key = {0}, data = {0};
+    int rc;
+
+    key.data = keybuf;
+    key.ulen = CSN_STRSIZE;
+    key.flags = DB_DBT_USERMEM;
+    if (flags == DB_SET_RANGE) {
+        key.size = strlen(keybuf) + 1;
+    }
+    data.data = header;
+    data.ulen = sizeof(header);
+    data.dlen = rectime ? sizeof(header) : 0;
+    data.flags = DB_DBT_USERMEM | DB_DBT_PARTIAL;
+
+    while ((rc = cursor->c_get(cursor, &key, &data, flags)) == 0) {
+        flags = DB_NEXT;
+        csn_init_by_string(csn, keybuf);
+        if (cl5HelperEntry(NULL, csn)) {
+            continue;
+        }
+        if (rectime) {
+            if (data.size < sizeof(header)) {
+                return CL5_BAD_FORMAT;
+            }
+            /* need to do the copy first, to skirt around alignment problems */
+            memcpy((char *)&thetime, header + 2, sizeof(thetime));
+            *rectime = (time_t)PR_ntohl(thetime);
+        }
+        return 0;
+    }
+
+    return rc;
+}
+
+/*
+ * Locate the range of changes that can be trimmed: returns the number of
+ * changes in the range and sets lastKey to the key of the last one.
+ * A change can be trimmed if it exceeds purge parameters and has been seen
+ * by all consumers.
+ */
+static long
+_cl5TrimFindRange(cldb_Handle *cldb, RUV *ruv, long numToTrim, char *lastKey)
+{
+    DBC *cursor = NULL;
+    CSN *csn = NULL;
+    CSN *maxcsn = NULL;
+    char keybuf[CSN_STRSIZE];
+    char strCSN[CSN_STRSIZE];
+    time_t rectime = 0;
+    time_t now = slapi_current_utc_time();
+    time_t maxAge = cldb->clConf.maxAge;
+    long count = 0;
+    int rc;
+
+    rc = cldb->db->cursor(cldb->db, NULL, &cursor, 0);
+    if (rc != 0) {
+        slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name_cl,
+                      "_cl5TrimFindRange - Failed to create cursor; db error - %d %s\n",
+                      rc, db_strerror(rc));
+        return 0;
+    }
+
+    csn = csn_new();
+    rc = _cl5TrimGetRecord(cursor, DB_FIRST, keybuf, csn, &rectime);
+    while (rc == 0 && !slapi_is_shutting_down()) {
+        /*
+         * Once the changes exceeding maxEntries are counted, only maxAge
+         * applies, as _cl5CanTrim would decide for the remaining changes.
+         */
+        if ((numToTrim > 0 || (maxAge > 0 && now - rectime > maxAge)) &&
+            ruv_covers_csn_strict(ruv, csn)) {
+            if (numToTrim > 0)
+                numToTrim--;
+            PL_strncpyz(lastKey, keybuf, CSN_STRSIZE);
+            count++;
+        } else {
+            /* The changelog DB is time ordered. If we can not trim
+             * a CSN, we will not be allowed to trim the rest of the
+             * CSNs generally. However, the maxcsn of each replica ID
+             * is always kept in the changelog as an anchor for
+             * replaying future changes. We have to skip those anchor
+             * CSNs, otherwise a non-active replica ID could block
+             * the trim forever.
+             */
+            ruv_get_largest_csn_for_replica(ruv, csn_get_replicaid(csn), &maxcsn);
+            if (csn_compare(csn, maxcsn) != 0) {
+                /* csn is not anchor CSN */
+                csn_free(&maxcsn);
+                break;
+            }
+            if (slapi_is_loglevel_set(SLAPI_LOG_REPL)) {
+                slapi_log_err(SLAPI_LOG_REPL, repl_plugin_name_cl,
+                              "_cl5TrimFindRange - Changelog purge skipped anchor csn %s\n",
+                              csn_as_string(maxcsn, PR_FALSE, strCSN));
+            }
+            csn_free(&maxcsn);
+        }
+        rc = _cl5TrimGetRecord(cursor, DB_NEXT, keybuf, csn, &rectime);
+    }
+    if (rc != 0 && rc != DB_NOTFOUND) {
+        slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name_cl,
+                      "_cl5TrimFindRange - Failed to read changelog (%s) after %ld changes; error - %d %s\n",
+                      cldb->ident, count, rc, rc == CL5_BAD_FORMAT ? "bad record format" : db_strerror(rc));
+    }
+
+    cursor->c_close(cursor);
+    csn_free(&csn);
+
+    return count;
+}
+
+/*
+ * Return the pages freed by trimming or purging to the filesystem. The
+ * changelog is compacted up to lastKey, or entirely if lastKey is NULL, by
+ * passes that each free at most compactMaxPages pages in their own
+ * transaction, with a pause between the passes, so that the compaction does
+ * not hold the changelog pages for long. Nothing is done when compactMaxPages
+ * is 0: the changelog is then only compacted every
+ * nsslapd-changelogcompactdb-interval, along with the database.
+ */
+static void
+_cl5CompactDB(cldb_Handle *cldb, const char *lastKey)
+{
+    DB_COMPACT c_data;
+    DB_TXN *txnid = NULL;
+    DBT start = {0}, stop = {0}, end = {0};
+    u_int32_t maxPages = (u_int32_t)cldb->clConf.compactMaxPages;
+    u_int32_t totalFreed = 0;
+    int rc;
+
+    if (cldb->clConf.compactMaxPages <= 0) {
+        return;
+    }
+
+    if (lastKey) {
+        stop.data = (void *)lastKey;
+        stop.size = strlen(lastKey) + 1;
+    }
+
+    while (!slapi_is_shutting_down()) {
+        memset(&c_data, 0, sizeof(c_data));
+        c_data.compact_pages = maxPages;
+        end.flags = DB_DBT_MALLOC;
+
+        rc = TXN_BEGIN(s_cl5Desc.dbEnv, NULL, &txnid, 0);
+        if (rc != 0) {
+            slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name_cl,
+                          "_cl5CompactDB - Failed to begin transaction; db error - %d %s\n",
+                          rc, db_strerror(rc));
+            break;
+        }
+        rc = cldb->db->compact(cldb->db, txnid, start.data ? &start : NULL, lastKey ? &stop : NULL,
+                               &c_data, DB_FREE_SPACE, &end);
+        if (rc != 0) {
+            slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name_cl,
+                          "_cl5CompactDB - Failed to compact changelog (%s); db error - %d %s\n",
+                          cldb->ident, rc, db_strerror(rc));
+            rc = TXN_ABORT(txnid);
+            if (rc != 0) {
+                slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name_cl,
+                              "_cl5CompactDB - Failed to abort transaction; db error - %d %s\n",
+                              rc, db_strerror(rc));
+            }
+            break;
+        }
+        rc = TXN_COMMIT(txnid);
+        if (rc != 0) {
+            slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name_cl,
+                          "_cl5CompactDB - Failed to commit transaction; db error - %d %s\n",
+                          rc, db_strerror(rc));
+            break;
+        }
+        totalFreed += c_data.compact_pages_free;
+
+        /* the next pass starts where this one stopped */
+        slapi_ch_free(&start.data);
+        start.data = end.data;
+        start.size = end.size;
+        end.data = NULL;
+        end.size = 0;
+        if (c_data.compact_pages_free < maxPages || start.size == 0) {
+            /* nothing more to free */
+            break;
+        }
+        DS_Sleep(CL5_TRIM_PAUSE);
+    }
+    slapi_ch_free(&start.data);
+    slapi_ch_free(&end.data);
+
+    slapi_log_err(SLAPI_LOG_REPL, repl_plugin_name_cl,
+                  "_cl5CompactDB - Compacted changelog (%s), %u pages freed\n",
+                  cldb->ident, totalFreed);
+}
 
 static void
 _cl5TrimReplica(Replica *r)
 {
     DB_TXN *txnid;
+    DBC *cursor;
     RUV *ruv = NULL;
-    CL5Entry entry;
-    slapi_operation_parameters op = {0};
-    ReplicaId csn_rid;
-    void *it;
-    int finished = 0, totalTrimmed = 0, count;
+    CSN *csn = NULL;
+    CSN *maxcsn = NULL;
+    char keybuf[CSN_STRSIZE];
+    char lastKey[CSN_STRSIZE];
+    u_int32_t flags = DB_FIRST;
+    int finished = 0, count;
+    long numToTrim, totalTrimmed = 0;
     PRBool abort;
-    char strCSN[CSN_STRSIZE];
     int rc;
-    long numToTrim;
 
     cldb_Handle *cldb = replica_get_file_info(r);
 
@@ -2724,9 +3118,14 @@ _cl5TrimReplica(Replica *r)
         return;
     }
 
-    entry.op = &op;
+    if (_cl5TrimFindRange(cldb, ruv, numToTrim, lastKey) == 0) {
+        ruv_destroy(&ruv);
+        return;
+    }
+
+    csn = csn_new();
     while (!finished && !slapi_is_shutting_down()) {
-        it = NULL;
+        cursor = NULL;
         count = 0;
         txnid = NULL;
         abort = PR_FALSE;
@@ -2738,83 +3137,84 @@ _cl5TrimReplica(Replica *r)
             slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name_cl,
                           "_cl5TrimReplica - Failed to begin transaction; db error - %d %s\n",
                           rc, db_strerror(rc));
-            finished = PR_TRUE;
             break;
         }
 
-        finished = _cl5GetFirstEntry(cldb, &entry, &it, txnid);
-        while (!finished && !slapi_is_shutting_down()) {
-            /*
-             * This change can be trimmed if it exceeds purge
-             * parameters and has been seen by all consumers.
-             */
-            if (op.csn == NULL) {
-                slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name_cl, "_cl5TrimReplica - "
-                                                                  "Operation missing csn, moving on to next entry.\n");
-                cl5_operation_parameters_done(&op);
-                finished = _cl5GetNextEntry(&entry, it);
-                continue;
+        rc = cldb->db->cursor(cldb->db, txnid, &cursor, 0);
+        if (rc != 0) {
+            slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name_cl,
+                          "_cl5TrimReplica - Failed to create cursor; db error - %d %s\n",
+                          rc, db_strerror(rc));
+            cursor = NULL;
+            abort = PR_TRUE;
+            finished = 1;
+        } else {
+            /* restart after the last change removed by the previous transaction */
+            rc = _cl5TrimGetRecord(cursor, flags, keybuf, csn, NULL);
+        }
+        while (cursor && rc == 0) {
+            if (strcmp(keybuf, lastKey) > 0) {
+                /* end of the range */
+                finished = 1;
+                break;
             }
-            csn_rid = csn_get_replicaid(op.csn);
-
-            if ((numToTrim > 0 || _cl5CanTrim(entry.time, &numToTrim, r, &cldb->clConf)) &&
-                ruv_covers_csn_strict(ruv, op.csn)) {
-                rc = _cl5CurrentDeleteEntry(it);
-                if (rc == CL5_SUCCESS) {
-                    rc = _cl5UpdateRUV(cldb, op.csn, PR_FALSE, PR_TRUE);
-                }
-                if (rc == CL5_SUCCESS) {
-                    if (numToTrim > 0)
-                        (numToTrim)--;
-                    count++;
-                } else {
-                    /* The above two functions have logged the error */
-                    abort = PR_TRUE;
-                }
-            } else {
-                /* The changelog DB is time ordered. If we can not trim
-                 * a CSN, we will not be allowed to trim the rest of the
-                 * CSNs generally. However, the maxcsn of each replica ID
-                 * is always kept in the changelog as an anchor for
-                 * replaying future changes. We have to skip those anchor
-                 * CSNs, otherwise a non-active replica ID could block
-                 * the trim forever.
+            /* skip the anchor CSNs, see _cl5TrimFindRange */
+            ruv_get_largest_csn_for_replica(ruv, csn_get_replicaid(csn), &maxcsn);
+            if (csn_compare(csn, maxcsn) != 0 && !ruv_covers_csn_strict(ruv, csn)) {
+                /* The range was computed outside of any transaction: a
+                 * replicated change older than lastKey may have been added
+                 * since then, which the consumers have not seen yet. Stop
+                 * before it, the next trim will start from there.
                  */
-                CSN *maxcsn = NULL;
-                ruv_get_largest_csn_for_replica(ruv, csn_rid, &maxcsn);
-                if (csn_compare(op.csn, maxcsn) != 0) {
-                    /* op.csn is not anchor CSN */
-                    finished = 1;
+                slapi_log_err(SLAPI_LOG_REPL, repl_plugin_name_cl,
+                              "_cl5TrimReplica - Changelog purge stopped at uncovered change %s\n",
+                              keybuf);
+                csn_free(&maxcsn);
+                finished = 1;
+                break;
+            } else if (csn_compare(csn, maxcsn) != 0) {
+                rc = cursor->c_del(cursor, 0);
+                if (rc != 0) {
+                    slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name_cl,
+                                  "_cl5TrimReplica - Failed to delete change %s; db error - %d %s\n",
+                                  keybuf, rc, db_strerror(rc));
+                    abort = PR_TRUE;
                 } else {
-                    if (slapi_is_loglevel_set(SLAPI_LOG_REPL)) {
-                        slapi_log_err(SLAPI_LOG_REPL, repl_plugin_name_cl,
-                                      "_cl5TrimReplica - Changelog purge skipped anchor csn %s\n",
-                                      csn_as_string(maxcsn, PR_FALSE, strCSN));
+                    PR_AtomicDecrement(&cldb->entryCount);
+                    if (_cl5UpdateRUV(cldb, csn, PR_FALSE, PR_TRUE) == CL5_SUCCESS) {
+                        count++;
+                    } else {
+                        /* _cl5UpdateRUV has logged the error */
+                        abort = PR_TRUE;
                     }
-
-                    /* extra read to skip the current record */
-                    cl5_operation_parameters_done(&op);
-                    finished = _cl5GetNextEntry(&entry, it);
                 }
-                if (maxcsn)
-                    csn_free(&maxcsn);
             }
-            cl5_operation_parameters_done(&op);
-            if (finished || abort || count >= CL5_TRIM_MAX_PER_TRANSACTION) {
+            csn_free(&maxcsn);
+            if (abort || count >= CL5_TRIM_MAX_PER_TRANSACTION) {
                 /* If we reach CL5_TRIM_MAX_PER_TRANSACTION,
                  * we close the cursor,
                  * commit the transaction and restart a new transaction
                  */
                 break;
             }
-            finished = _cl5GetNextEntry(&entry, it);
+            rc = _cl5TrimGetRecord(cursor, DB_NEXT, keybuf, csn, NULL);
+        }
+        if (rc == DB_NOTFOUND) {
+            finished = 1;
+        } else if (rc != 0 && !abort) {
+            slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name_cl,
+                          "_cl5TrimReplica - Failed to get change; db error - %d %s\n",
+                          rc, db_strerror(rc));
+            abort = PR_TRUE;
         }
 
         /* MAB: We need to close the cursor BEFORE the txn commits/aborts.
          * If we don't respect this order, we'll screw up the database,
          * placing it in DB_RUNRECOVERY mode
          */
-        cl5DestroyIterator(it);
+        if (cursor) {
+            cursor->c_close(cursor);
+        }
 
         if (abort) {
             finished = 1;
@@ -2836,14 +3236,21 @@ _cl5TrimReplica(Replica *r)
             }
         }
 
+        if (!finished) {
+            /* let the updates have the changelog for a while */
+            flags = DB_SET_RANGE;
+            DS_Sleep(CL5_TRIM_PAUSE);
+        }
     } /* While (!finished) */
 
+    csn_free(&csn);
     if (ruv)
         ruv_destroy(&ruv);
 
     if (totalTrimmed) {
-        slapi_log_err(SLAPI_LOG_REPL, repl_plugin_name_cl, "_cl5TrimReplica - Trimmed %d changes from the changelog\n",
+        slapi_log_err(SLAPI_LOG_REPL, repl_plugin_name_cl, "_cl5TrimReplica - Trimmed %ld changes from the changelog\n",
                       totalTrimmed);
+        _cl5CompactDB(cldb, lastKey);
     }
 }
 
@@ -212,11 +212,12 @@ int cl5GetState(void);
    Description:    sets changelog trimming parameters
    Parameters:  maxEntries - maximum number of entries in the log;
                 maxAge - maximum entry age;
-                trimInterval - interval for changelog trimming.
+                trimInterval - interval for changelog trimming;
+                compactMaxPages - pages freed per compaction pass after trimming.
    Return:        CL5_SUCCESS if successful;
                 CL5_BAD_STATE if changelog has not been open
  */
-int cl5ConfigTrimming(Replica *replica, int maxEntries, const char *maxAge, int trimInterval);
+int cl5ConfigTrimming(Replica *replica, int maxEntries, const char *maxAge, int trimInterval, int compactMaxPages);
 
 void cl5DestroyIterator(void *iterator);
 
@@ -299,6 +300,15 @@ int cl5GetNextOperationToReplay(CL5ReplayIterator *iterator,
  */
 void cl5DestroyReplayIterator(CL5ReplayIterator **iterator);
 
+/* Name:        cl5GetReplayIteratorStats
+   Description:    returns changelog cache statistics for the session
+   Parameters:  iterator - replay iterator
+                loads - number of changelog db reads done to fill the cache
+                records - number of changes read from the cache
+   Return:        none
+ */
+void cl5GetReplayIteratorStats(CL5ReplayIterator *iterator, int *loads, int *records);
+
 /* Name:        cl5GetLdifDir
    Description:    returns the default ldif directory; must be freed by the caller;
    Parameters:  backend used for export/import
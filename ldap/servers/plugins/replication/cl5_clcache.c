@@ -280,6 +280,17 @@ clcache_get_buffer(CLC_Buffer **buf, DB *db, ReplicaId consumer_rid, const RUV *
     return rc;
 }
 
+/*
+ * Returns the number of db loads and of changes read from the
+ * buffer during the current session.
+ */
+void
+clcache_get_stats(CLC_Buffer *buf, int *loads, int *records)
+{
+    *loads = buf ? buf->buf_load_cnt : 0;
+    *records = buf ? buf->buf_record_cnt : 0;
+}
+
 /*
  * Returns a buffer back to the buffer pool.
  */
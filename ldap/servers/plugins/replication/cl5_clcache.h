@@ -25,6 +25,7 @@ void clcache_set_config(void);
 int clcache_get_buffer(CLC_Buffer **buf, DB *db, ReplicaId consumer_rid, const RUV *consumer_ruv, const RUV *local_ruv);
 int clcache_load_buffer(CLC_Buffer *buf, CSN **anchorCSN, int *continue_on_miss);
 void clcache_return_buffer(CLC_Buffer **buf);
+void clcache_get_stats(CLC_Buffer *buf, int *loads, int *records);
 int clcache_get_next_change(CLC_Buffer *buf, void **key, size_t *keylen, void **data, size_t *datalen, CSN **csn);
 void clcache_destroy(void);
 
@@ -140,6 +140,7 @@ changelog5_dup_config(changelog5Config *config)
 
     dup->maxEntries = config->maxEntries;
     dup->trimInterval = config->trimInterval;
+    dup->compactMaxPages = config->compactMaxPages;
 
     return dup;
 }
@@ -247,7 +248,7 @@ cldb_config_modify(Slapi_PBlock *pb, Slapi_Entry *e, Slapi_Entry *entryAfter, in
     slapi_ch_free_string(&config.maxAge);
     config.maxAge = slapi_ch_strdup(CL5_STR_IGNORE);
     config.trimInterval = CL5_NUM_IGNORE;
-
+    config.compactMaxPages = CL5_NUM_IGNORE;
 
     slapi_pblock_get(pb, SLAPI_MODIFY_MODS, &mods);
     for (size_t i = 0; mods && mods[i] != NULL; i++) {
@@ -308,6 +309,25 @@ cldb_config_modify(Slapi_PBlock *pb, Slapi_Entry *e, Slapi_Entry *entryAfter, in
                         *returncode = LDAP_UNWILLING_TO_PERFORM;
                         goto done;
                     }
+                } else if (strcasecmp(config_attr, CONFIG_CHANGELOG_COMPACT_MAXPAGES_ATTRIBUTE) == 0) {
+                    char *endp = NULL;
+                    long maxpages = 0;
+
+                    if (config_attr_value && config_attr_value[0] != '\0') {
+                        errno = 0;
+                        maxpages = strtol(config_attr_value, &endp, 10);
+                    }
+                    if (errno || (endp && *endp != '\0') || maxpages < 0 || maxpages > INT_MAX) {
+                        if (returntext) {
+                            PR_snprintf(returntext, SLAPI_DSE_RETURNTEXT_SIZE,
+                                        "%s: invalid value \"%s\", %s must range from 0 to %d",
+                                        CONFIG_CHANGELOG_COMPACT_MAXPAGES_ATTRIBUTE, config_attr_value,
+                                        CONFIG_CHANGELOG_COMPACT_MAXPAGES_ATTRIBUTE, INT_MAX);
+                        }
+                        *returncode = LDAP_UNWILLING_TO_PERFORM;
+                        goto done;
+                    }
+                    config.compactMaxPages = (int)maxpages;
                 } else if (strcasecmp(config_attr, CONFIG_CHANGELOG_SYMMETRIC_KEY) == 0) {
                     slapi_ch_free_string(&config.symmetricKey);
                     config.symmetricKey = slapi_ch_strdup(config_attr_value);
@@ -331,6 +351,8 @@ cldb_config_modify(Slapi_PBlock *pb, Slapi_Entry *e, Slapi_Entry *entryAfter, in
         config.maxEntries = originalConfig->maxEntries;
     if (config.trimInterval == CL5_NUM_IGNORE)
         config.trimInterval = originalConfig->trimInterval;
+    if (config.compactMaxPages == CL5_NUM_IGNORE)
+        config.compactMaxPages = originalConfig->compactMaxPages;
     if (strcmp(config.maxAge, CL5_STR_IGNORE) == 0) {
         slapi_ch_free_string(&config.maxAge);
         if (originalConfig->maxAge)
@@ -340,8 +362,9 @@ cldb_config_modify(Slapi_PBlock *pb, Slapi_Entry *e, Slapi_Entry *entryAfter, in
     /* one of the changelog parameters is modified */
     if (config.maxEntries != CL5_NUM_IGNORE ||
         config.trimInterval != CL5_NUM_IGNORE ||
+        config.compactMaxPages != CL5_NUM_IGNORE ||
         strcmp(config.maxAge, CL5_STR_IGNORE) != 0) {
-        rc = cl5ConfigTrimming(replica, config.maxEntries, config.maxAge, config.trimInterval);
+        rc = cl5ConfigTrimming(replica, config.maxEntries, config.maxAge, config.trimInterval, config.compactMaxPages);
         if (rc != CL5_SUCCESS) {
             *returncode = 1;
             if (returntext) {
@@ -423,6 +446,17 @@ changelog5_extract_config(Slapi_Entry *entry, changelog5Config *config)
         config->trimInterval = CHANGELOGDB_TRIM_INTERVAL;
     }
 
+    arg = slapi_entry_attr_get_ref(entry, CONFIG_CHANGELOG_COMPACT_MAXPAGES_ATTRIBUTE);
+    if (arg) {
+        config->compactMaxPages = atoi(arg);
+        if (config->compactMaxPages < 0) {
+            slapi_log_err(SLAPI_LOG_NOTICE, repl_plugin_name_cl,
+                          "changelog5_extract_config - %s: invalid value \"%s\", ignoring the change.\n",
+                          CONFIG_CHANGELOG_COMPACT_MAXPAGES_ATTRIBUTE, arg);
+            config->compactMaxPages = 0;
+        }
+    }
+
     max_age = slapi_entry_attr_get_charptr(entry, CONFIG_CHANGELOG_MAXAGE_ATTRIBUTE);
     if (max_age) {
         if (slapi_is_duration_valid(max_age)) {
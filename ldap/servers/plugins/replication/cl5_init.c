@@ -122,6 +122,11 @@ _cl5_upgrade_replica_config(Replica *replica, changelog5Config *config)
     if (config->trimInterval != CHANGELOGDB_TRIM_INTERVAL) {
         slapi_entry_add_string(config_entry, CONFIG_CHANGELOG_TRIM_ATTRIBUTE, gen_duration(config->trimInterval));
     }
+    if (config->compactMaxPages) {
+        char *maxPages = slapi_ch_smprintf("%d", config->compactMaxPages);
+        slapi_entry_add_string(config_entry, CONFIG_CHANGELOG_COMPACT_MAXPAGES_ATTRIBUTE, maxPages);
+        slapi_ch_free_string(&maxPages);
+    }
 
     /* if changelog encryption is enabled then in the upgrade mode all backends will have 
      * an encrypted changelog, store the encryption attrs */
@@ -15,6 +15,12 @@
 #include "csnpl.h"
 #include "llist.h"
 
+/*
+ * The write lock protects the structure of the list (insert, remove, roll
+ * up). Committing a csn only sets the committed flag of its node, so it is
+ * done under the read lock with an atomic store and commits of different
+ * operations do not serialize.
+ */
 struct csnpl
 {
     LList *csnList;        /* pending list */
@@ -24,7 +30,7 @@ struct csnpl
 
 typedef struct _csnpldata
 {
-    PRBool committed;      /* True if CSN committed */
+    int32_t committed;     /* True if CSN committed, accessed atomically */
     CSN *csn;              /* The actual CSN */
     Replica *prim_replica; /* The replica where the prom csn was generated */
     const CSN *prim_csn;   /* The primary CSN of an operation consising of multiple sub ops*/
@@ -271,17 +277,23 @@ csnplCommitAll(CSNPL *csnpl, const CSNPL_CTX *csn_ctx)
     void *iterator;
     char csn_str[CSN_STRSIZE];
 
-    csn_as_string(csn_ctx->prim_csn, PR_FALSE, csn_str);
-    slapi_log_err(SLAPI_LOG_REPL, repl_plugin_name,
-                  "csnplCommitALL: committing all csns for csn %s\n", csn_str);
-    slapi_rwlock_wrlock(csnpl->csnLock);
+    PRBool logit = slapi_is_loglevel_set(SLAPI_LOG_REPL);
+
+    if (logit) {
+        csn_as_string(csn_ctx->prim_csn, PR_FALSE, csn_str);
+        slapi_log_err(SLAPI_LOG_REPL, repl_plugin_name,
+                      "csnplCommitALL: committing all csns for csn %s\n", csn_str);
+    }
+    slapi_rwlock_rdlock(csnpl->csnLock);
     data = (csnpldata *)llistGetFirst(csnpl->csnList, &iterator);
     while (NULL != data) {
-        csn_as_string(data->csn, PR_FALSE, csn_str);
-        slapi_log_err(SLAPI_LOG_REPL, repl_plugin_name,
-                      "csnplCommitALL: processing data csn %s\n", csn_str);
+        if (logit) {
+            csn_as_string(data->csn, PR_FALSE, csn_str);
+            slapi_log_err(SLAPI_LOG_REPL, repl_plugin_name,
+                          "csnplCommitALL: processing data csn %s\n", csn_str);
+        }
         if (csn_primary_or_nested(data, csn_ctx)) {
-            data->committed = PR_TRUE;
+            slapi_atomic_store_32(&data->committed, PR_TRUE, __ATOMIC_RELEASE);
         }
         data = (csnpldata *)llistGetNext(csnpl->csnList, &iterator);
     }
@@ -300,15 +312,20 @@ csnplCommit(CSNPL *csnpl, const CSN *csn)
                       "csnplCommit: invalid argument\n");
         return -1;
     }
-    csn_as_string(csn, PR_FALSE, csn_str);
 
-    slapi_rwlock_wrlock(csnpl->csnLock);
+    slapi_rwlock_rdlock(csnpl->csnLock);
 
 #ifdef DEBUG
     _csnplDumpContentNoLock(csnpl, "csnplCommit");
 #endif
 
-    data = (csnpldata *)llistGet(csnpl->csnList, csn_str);
+    /* csns are usually committed in the order they were inserted:
+     * try the head of the list before looking the csn up by key */
+    data = (csnpldata *)llistGetHead(csnpl->csnList);
+    if (data == NULL || !csn_is_equal(data->csn, csn)) {
+        csn_as_string(csn, PR_FALSE, csn_str);
+        data = (csnpldata *)llistGet(csnpl->csnList, csn_str);
+    }
     if (data == NULL) {
         /*
          * In the scenario "4.x master -> 6.x legacy-consumer -> 6.x consumer"
@@ -319,13 +336,14 @@ csnplCommit(CSNPL *csnpl, const CSN *csn)
          */
         ReplicaId rid = csn_get_replicaid(csn);
         if (rid < MAX_REPLICA_ID) {
+            csn_as_string(csn, PR_FALSE, csn_str);
             slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name,
                           "csnplCommit: can't find csn %s\n", csn_str);
         }
         slapi_rwlock_unlock(csnpl->csnLock);
         return -1;
     } else {
-        data->committed = PR_TRUE;
+        slapi_atomic_store_32(&data->committed, PR_TRUE, __ATOMIC_RELEASE);
     }
 
     slapi_rwlock_unlock(csnpl->csnLock);
@@ -343,7 +361,7 @@ csnplGetMinCSN(CSNPL *csnpl, PRBool *committed)
     if ((data = (csnpldata *)llistGetHead(csnpl->csnList)) != NULL) {
         csn = csn_dup(data->csn);
         if (NULL != committed) {
-            *committed = data->committed;
+            *committed = slapi_atomic_load_32(&data->committed, __ATOMIC_ACQUIRE);
         }
     }
     slapi_rwlock_unlock(csnpl->csnLock);
@@ -373,7 +391,7 @@ csnplRollUp(CSNPL *csnpl, CSN **first_commited)
         *first_commited = NULL;
     }
     data = (csnpldata *)llistGetFirst(csnpl->csnList, &iterator);
-    while (NULL != data && data->committed) {
+    while (NULL != data && slapi_atomic_load_32(&data->committed, __ATOMIC_ACQUIRE)) {
         if (NULL != largest_committed_csn && freeit) {
             csn_free(&largest_committed_csn);
         }
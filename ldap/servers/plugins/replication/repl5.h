@@ -65,6 +65,12 @@
  * new set of start and response extops. */
 #define REPL_START_NSDS90_REPLICATION_REQUEST_OID "2.16.840.1.113730.3.5.12"
 #define REPL_NSDS90_REPLICATION_RESPONSE_OID      "2.16.840.1.113730.3.5.13"
+/* The total update protocol can carry several entries per extended operation.
+ * The request value is a SEQUENCE OF OCTET STRING, each one holding a regular
+ * NSDS50ReplicationEntry payload. The supplier only uses it when the consumer
+ * lists it in its supportedextension, so older consumers keep getting one
+ * entry per operation */
+#define REPL_NSDS_REPLICATION_ENTRY_BATCH_REQUEST_OID "2.16.840.1.113730.3.5.17"
 /* cleanallruv extended ops */
 #define REPL_CLEANRUV_OID              "2.16.840.1.113730.3.6.5"
 #define REPL_ABORT_CLEANRUV_OID        "2.16.840.1.113730.3.6.6"
@@ -151,6 +157,7 @@ extern const char *type_nsds5ReplicaEnabled;
 extern const char *type_nsds5ReplicaStripAttrs;
 extern const char *type_nsds5ReplicaFlowControlWindow;
 extern const char *type_nsds5ReplicaFlowControlPause;
+extern const char *type_nsds5ReplicaTotalUpdateBatchSize;
 extern const char *type_replicaProtocolTimeout;
 extern const char *type_replicaReleaseTimeout;
 extern const char *type_replicaBackoffMin;
@@ -377,6 +384,7 @@ long agmt_get_busywaittime(const Repl_Agmt *ra);
 long agmt_get_pausetime(const Repl_Agmt *ra);
 long agmt_get_flowcontrolwindow(const Repl_Agmt *ra);
 long agmt_get_flowcontrolpause(const Repl_Agmt *ra);
+long agmt_get_totalupdatebatchsize(const Repl_Agmt *ra);
 long agmt_get_ignoremissing(const Repl_Agmt *ra);
 int agmt_start(Repl_Agmt *ra);
 int windows_agmt_start(Repl_Agmt *ra);
@@ -400,6 +408,7 @@ int agmt_set_schedule_from_entry(Repl_Agmt *ra, const Slapi_Entry *e);
 int agmt_set_timeout_from_entry(Repl_Agmt *ra, const Slapi_Entry *e);
 int agmt_set_flowcontrolwindow_from_entry(Repl_Agmt *ra, const Slapi_Entry *e);
 int agmt_set_flowcontrolpause_from_entry(Repl_Agmt *ra, const Slapi_Entry *e);
+int agmt_set_totalupdatebatchsize_from_entry(Repl_Agmt *ra, const Slapi_Entry *e);
 int agmt_set_ignoremissing_from_entry(Repl_Agmt *ra, const Slapi_Entry *e);
 int agmt_set_busywaittime_from_entry(Repl_Agmt *ra, const Slapi_Entry *e);
 int agmt_set_pausetime_from_entry(Repl_Agmt *ra, const Slapi_Entry *e);
@@ -430,6 +439,10 @@ void agmt_set_last_init_end(Repl_Agmt *ra, time_t end_time);
 void agmt_set_last_init_status(Repl_Agmt *ra, int ldaprc, int replrc, int connrc, const char *msg);
 void agmt_inc_last_update_changecount(Repl_Agmt *ra, ReplicaId rid, int skipped);
 void agmt_get_changecount_string(Repl_Agmt *ra, char *buf, int bufsize);
+void agmt_record_op_latency(Repl_Agmt *ra, PRIntervalTime elapsed);
+void agmt_record_cl_read_latency(Repl_Agmt *ra, PRIntervalTime elapsed);
+void agmt_inc_flowcontrol_stalls(Repl_Agmt *ra);
+void agmt_record_update_session(Repl_Agmt *ra, PRUint32 num_changes, PRUint64 bytes, PRIntervalTime elapsed, int clcache_loads, int clcache_records);
 int agmt_set_replicated_attributes_from_entry(Repl_Agmt *ra, const Slapi_Entry *e);
 int agmt_set_replicated_attributes_total_from_entry(Repl_Agmt *ra, const Slapi_Entry *e);
 int agmt_set_replicated_attributes_from_attr(Repl_Agmt *ra, Slapi_Attr *sattr);
@@ -579,7 +592,9 @@ typedef enum {
     CONN_IS_WIN2K3,
     CONN_NOT_WIN2K3,
     CONN_SUPPORTS_DS90_REPL,
-    CONN_DOES_NOT_SUPPORT_DS90_REPL
+    CONN_DOES_NOT_SUPPORT_DS90_REPL,
+    CONN_SUPPORTS_ENTRY_BATCH,
+    CONN_DOES_NOT_SUPPORT_ENTRY_BATCH
 } ConnResult;
 
 char *conn_result2string(int result);
@@ -600,12 +615,14 @@ void conn_cancel_linger(Repl_Connection *conn);
 ConnResult conn_replica_supports_ds5_repl(Repl_Connection *conn);
 ConnResult conn_replica_supports_ds71_repl(Repl_Connection *conn);
 ConnResult conn_replica_supports_ds90_repl(Repl_Connection *conn);
+ConnResult conn_replica_supports_entry_batch(Repl_Connection *conn);
 ConnResult conn_replica_is_readonly(Repl_Connection *conn);
 
 ConnResult conn_read_entry_attribute(Repl_Connection *conn, const char *dn, char *type, struct berval ***returned_bvals);
 ConnResult conn_push_schema(Repl_Connection *conn, CSN **remotecsn);
 void conn_set_timeout(Repl_Connection *conn, long timeout);
 long conn_get_timeout(Repl_Connection *conn);
+PRUint64 conn_get_bytes_sent(Repl_Connection *conn);
 void conn_set_agmt_changed(Repl_Connection *conn);
 ConnResult conn_read_result(Repl_Connection *conn, int *message_id);
 ConnResult conn_read_result_ex(Repl_Connection *conn, char **retoidp, struct berval **retdatap, LDAPControl ***returned_controls, int send_msgid, int *resp_msgid, int noblock);
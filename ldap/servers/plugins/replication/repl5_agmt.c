@@ -60,11 +60,27 @@
 #define DEFAULT_TIMEOUT 120             /* (seconds) default outbound LDAP connection */
 #define DEFAULT_FLOWCONTROL_WINDOW 1000 /* #entries sent without acknowledgment */
 #define DEFAULT_FLOWCONTROL_PAUSE 2000  /* msec of pause when #entries sent witout acknowledgment */
+#define DEFAULT_TOTAL_UPDATE_BATCH_SIZE 64 /* #entries sent per extended operation during a total update */
 #define STATUS_LEN 2048
 #define STATUS_GOOD "green"
 #define STATUS_WARNING "amber"
 #define STATUS_BAD "red"
+#define AGMT_LATENCY_BUCKETS 14
+#define AGMT_LATENCY_STRSIZE 512
 
+/* Upper bounds, in microseconds, of the latency histogram buckets.
+ * The last bucket counts everything slower than one second. */
+static const uint64_t agmt_latency_bounds[AGMT_LATENCY_BUCKETS - 1] = {
+    100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000,
+    100000, 250000, 500000, 1000000};
+
+struct latency_histogram
+{
+    uint64_t buckets[AGMT_LATENCY_BUCKETS];
+    uint64_t count;
+    uint64_t total_usec;
+    uint64_t max_usec;
+};
 
 struct changecounter
 {
@@ -133,10 +149,19 @@ typedef struct repl5agmt
     int64_t flowControlWindow;   /* This is the maximum number of entries sent without acknowledgment */
     int64_t flowControlPause;    /* When nb of not acknowledged entries overpass totalUpdateWindow
                                   * This is the duration (in msec) that the RA will pause before sending the next entry */
+    int64_t totalUpdateBatchSize; /* Maximum number of entries packed in one total update extended operation */
     int64_t ignoreMissingChange; /* if set replication will try to continue even if change cannot be found in changelog */
     Slapi_RWLock *attr_lock;     /* RW lock for all the stripped attrs */
     int64_t WaitForAsyncResults; /* Pass to DS_Sleep(PR_MillisecondsToInterval(WaitForAsyncResults))
                                   * in repl5_inc_waitfor_async_results */
+    PRLock *stats_lock;                       /* protects the replication metrics below */
+    struct latency_histogram op_latency;      /* round trip time of the updates sent to the consumer */
+    struct latency_histogram cl_read_latency; /* time to read the next change to send from the changelog */
+    uint64_t bytes_sent;                      /* estimated size of the updates sent since startup */
+    uint64_t last_update_rate;                /* changes per second of the last session that sent changes */
+    uint64_t clcache_loads;                   /* changelog reads done to fill the changelog cache */
+    uint64_t clcache_records;                 /* changes read from the changelog cache */
+    uint64_t flowcontrol_stalls;              /* pauses done because the consumer did not acknowledge updates */
 } repl5agmt;
 
 /* Forward declarations */
@@ -166,6 +191,7 @@ nsds5ReplicaTimeout - Outbound repl operations timeout
 nsds50ruv - consumer's RUV
 nsds5ReplicaBusyWaitTime - time to wait after getting a REPLICA BUSY from the consumer
 nsds5ReplicaSessionPauseTime - time to pause after sending updates to allow another supplier to send
+nsds5ReplicaTotalUpdateBatchSize - max number of entries sent per extended operation during a total update
 */
 
 
@@ -269,6 +295,12 @@ agmt_new_from_entry(Slapi_Entry *e)
                       slapi_entry_get_dn_const(e));
         goto loser;
     }
+    if ((ra->stats_lock = PR_NewLock()) == NULL) {
+        slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name, "agmt_new_from_entry - Unable to create new stats lock "
+                                                       "for replication agreement \"%s\" - agreement ignored.\n",
+                      slapi_entry_get_dn_const(e));
+        goto loser;
+    }
     ra->protocol_timeout = slapi_counter_new();
 
     /* Find all the stuff we need for the agreement */
@@ -355,6 +387,16 @@ agmt_new_from_entry(Slapi_Entry *e)
         ra->flowControlPause = pause;
     }
 
+    /* total update batch size. */
+    ra->totalUpdateBatchSize = DEFAULT_TOTAL_UPDATE_BATCH_SIZE;
+    if ((val = slapi_entry_attr_get_ref(e, type_nsds5ReplicaTotalUpdateBatchSize))){
+        int64_t batch;
+        if (repl_config_valid_num(type_nsds5ReplicaTotalUpdateBatchSize, (char *)val, 0, INT_MAX, &rc, errormsg, &batch) != 0) {
+            goto loser;
+        }
+        ra->totalUpdateBatchSize = batch;
+    }
+
     /* continue on missing change ? */
     ra->ignoreMissingChange = 0;
     tmpstr = (char *)slapi_entry_attr_get_ref(e, type_replicaIgnoreMissingChange);
@@ -660,6 +702,9 @@ agmt_delete(void **rap)
     /* free the locks */
     PR_DestroyLock(ra->lock);
     slapi_destroy_rwlock(ra->attr_lock);
+    if (ra->stats_lock) {
+        PR_DestroyLock(ra->stats_lock);
+    }
 
     slapi_ch_free((void **)rap);
 }
@@ -1129,6 +1174,16 @@ agmt_get_flowcontrolpause(const Repl_Agmt *ra)
     return return_value;
 }
 long
+agmt_get_totalupdatebatchsize(const Repl_Agmt *ra)
+{
+    long return_value;
+    PR_ASSERT(NULL != ra);
+    PR_Lock(ra->lock);
+    return_value = ra->totalUpdateBatchSize;
+    PR_Unlock(ra->lock);
+    return return_value;
+}
+long
 agmt_get_ignoremissing(const Repl_Agmt *ra)
 {
     long return_value;
@@ -1933,6 +1988,47 @@ agmt_set_flowcontrolpause_from_entry(Repl_Agmt *ra, const Slapi_Entry *e)
     }
     return return_value;
 }
+/*
+ * Set or reset the number of entries sent in one extended operation during
+ * a total update. A value of 0 or 1 sends every entry in its own operation.
+ *
+ * Returns 0 if the batch size is set, or -1 if an error occurred.
+ */
+int
+agmt_set_totalupdatebatchsize_from_entry(Repl_Agmt *ra, const Slapi_Entry *e)
+{
+    Slapi_Attr *sattr = NULL;
+    int return_value = -1;
+
+    PR_ASSERT(NULL != ra);
+    PR_Lock(ra->lock);
+    if (ra->stop_in_progress) {
+        PR_Unlock(ra->lock);
+        return return_value;
+    }
+
+    slapi_entry_attr_find(e, type_nsds5ReplicaTotalUpdateBatchSize, &sattr);
+    if (NULL != sattr) {
+        Slapi_Value *sval = NULL;
+        slapi_attr_first_value(sattr, &sval);
+        if (NULL != sval) {
+            long tmpval = slapi_value_get_long(sval);
+            if (tmpval >= 0) {
+                ra->totalUpdateBatchSize = tmpval;
+                return_value = 0; /* success! */
+            }
+        }
+    } else {
+        /* The attribute was removed, fall back to the default */
+        ra->totalUpdateBatchSize = DEFAULT_TOTAL_UPDATE_BATCH_SIZE;
+        return_value = 0;
+    }
+    PR_Unlock(ra->lock);
+    if (return_value == 0) {
+        prot_notify_agmt_changed(ra->protocol, ra->long_name);
+    }
+    return return_value;
+}
 /* add comment here */
 int
 agmt_set_ignoremissing_from_entry(Repl_Agmt *ra, const Slapi_Entry *e)
@@ -2676,6 +2772,156 @@ agmt_get_changecount_string(Repl_Agmt *ra, char *buf, int bufsize)
     }
 }
 
+static void
+latency_histogram_add(struct latency_histogram *h, PRIntervalTime elapsed)
+{
+    uint64_t usec = PR_IntervalToMicroseconds(elapsed);
+    size_t i;
+
+    for (i = 0; i < AGMT_LATENCY_BUCKETS - 1; i++) {
+        if (usec <= agmt_latency_bounds[i]) {
+            break;
+        }
+    }
+    h->buckets[i]++;
+    h->count++;
+    h->total_usec += usec;
+    if (usec > h->max_usec) {
+        h->max_usec = usec;
+    }
+}
+
+/*
+ * Format a histogram as "count=N avg=N max=N le100=N ... le1000000=N inf=N",
+ * all times in microseconds. The buckets are not cumulative.
+ */
+static void
+latency_histogram_string(const struct latency_histogram *h, char *buf, size_t bufsize)
+{
+    size_t buflen;
+    size_t i;
+
+    buflen = PR_snprintf(buf, bufsize, "count=%" PRIu64 " avg=%" PRIu64 " max=%" PRIu64,
+                         h->count, h->count ? h->total_usec / h->count : 0, h->max_usec);
+    for (i = 0; i < AGMT_LATENCY_BUCKETS && buflen < bufsize; i++) {
+        if (i < AGMT_LATENCY_BUCKETS - 1) {
+            buflen += PR_snprintf(buf + buflen, bufsize - buflen, " le%" PRIu64 "=%" PRIu64,
+                                  agmt_latency_bounds[i], h->buckets[i]);
+        } else {
+            buflen += PR_snprintf(buf + buflen, bufsize - buflen, " inf=%" PRIu64, h->buckets[i]);
+        }
+    }
+}
+
+/*
+ * Record the time between sending an update to the consumer and
+ * receiving its result.
+ */
+void
+agmt_record_op_latency(Repl_Agmt *ra, PRIntervalTime elapsed)
+{
+    PR_ASSERT(NULL != ra);
+    PR_Lock(ra->stats_lock);
+    latency_histogram_add(&ra->op_latency, elapsed);
+    PR_Unlock(ra->stats_lock);
+}
+
+/*
+ * Record the time taken to read the next change to send from the changelog.
+ */
+void
+agmt_record_cl_read_latency(Repl_Agmt *ra, PRIntervalTime elapsed)
+{
+    PR_ASSERT(NULL != ra);
+    PR_Lock(ra->stats_lock);
+    latency_histogram_add(&ra->cl_read_latency, elapsed);
+    PR_Unlock(ra->stats_lock);
+}
+
+void
+agmt_inc_flowcontrol_stalls(Repl_Agmt *ra)
+{
+    PR_ASSERT(NULL != ra);
+    PR_Lock(ra->stats_lock);
+    ra->flowcontrol_stalls++;
+    PR_Unlock(ra->stats_lock);
+}
+
+/*
+ * Record the outcome of an incremental update session: the number of
+ * changes and bytes sent, its duration, and the changelog cache usage.
+ */
+void
+agmt_record_update_session(Repl_Agmt *ra, PRUint32 num_changes, PRUint64 bytes, PRIntervalTime elapsed, int clcache_loads, int clcache_records)
+{
+    uint64_t usec = PR_IntervalToMicroseconds(elapsed);
+
+    PR_ASSERT(NULL != ra);
+    PR_Lock(ra->stats_lock);
+    ra->bytes_sent += bytes;
+    if (num_changes > 0) {
+        ra->last_update_rate = usec ? ((uint64_t)num_changes * PR_USEC_PER_SEC) / usec : num_changes;
+    }
+    if (clcache_loads > 0 && clcache_records > 0) {
+        ra->clcache_loads += clcache_loads;
+        ra->clcache_records += clcache_records;
+    }
+    PR_Unlock(ra->stats_lock);
+}
+
+struct agmt_lag_data
+{
+    const RUV *consumer_ruv;
+    time_t lag;
+};
+
+static int
+agmt_consumer_lag_cb(const ruv_enum_data *element, void *arg)
+{
+    struct agmt_lag_data *data = (struct agmt_lag_data *)arg;
+    ReplicaId rid = csn_get_replicaid(element->csn);
+    CSN *consumer_csn = NULL;
+
+    if (is_cleaned_rid(rid)) {
+        return 0;
+    }
+    /* A replica id unknown to the consumer has no meaningful lag yet */
+    if (ruv_get_largest_csn_for_replica(data->consumer_ruv, rid, &consumer_csn) == RUV_SUCCESS && consumer_csn) {
+        time_t gap = csn_get_time(element->csn) - csn_get_time(consumer_csn);
+        if (gap > data->lag) {
+            data->lag = gap;
+        }
+    }
+    csn_free(&consumer_csn);
+    return 0;
+}
+
+/*
+ * Returns, in seconds, the largest difference between the max csn of a
+ * replica id in the local RUV and the one the consumer last reported.
+ */
+static time_t
+agmt_get_consumer_lag(Repl_Agmt *ra, Replica *replica)
+{
+    struct agmt_lag_data data = {0};
+    Object *consumer_ruv_obj;
+    Object *local_ruv_obj;
+
+    consumer_ruv_obj = agmt_get_consumer_ruv(ra);
+    if (consumer_ruv_obj == NULL) {
+        return 0;
+    }
+    local_ruv_obj = replica_get_ruv(replica);
+    if (local_ruv_obj) {
+        data.consumer_ruv = (const RUV *)object_get_data(consumer_ruv_obj);
+        ruv_enumerate_elements((const RUV *)object_get_data(local_ruv_obj), agmt_consumer_lag_cb, &data);
+        object_release(local_ruv_obj);
+    }
+    object_release(consumer_ruv_obj);
+
+    return data.lag;
+}
+
 static int
 get_agmt_status(Slapi_PBlock *pb __attribute__((unused)),
                 Slapi_Entry *e,
@@ -2701,6 +2947,7 @@ get_agmt_status(Slapi_PBlock *pb __attribute__((unused)),
         slapi_sdn_free(&replarea_sdn);
         if (replica) {
             reapActive = replica_get_tombstone_reap_active(replica);
+            slapi_entry_attr_set_ulong(e, "nsds5replicaLagTime", (uint64_t)agmt_get_consumer_lag(ra, replica));
         }
         slapi_entry_attr_set_int(e, "nsds5replicaReapActive", (int)reapActive);
 
@@ -2760,6 +3007,33 @@ get_agmt_status(Slapi_PBlock *pb __attribute__((unused)),
             slapi_entry_add_string(e, "nsds5replicaLastInitStatus", ra->last_init_status);
             slapi_entry_add_string(e, "nsds5replicaLastInitStatusJSON", ra->last_init_status_json);
         }
+
+        /* replication metrics, take a consistent snapshot */
+        struct latency_histogram op_latency;
+        struct latency_histogram cl_read_latency;
+        uint64_t bytes_sent, update_rate, clcache_loads, clcache_records, stalls;
+        char histogram[AGMT_LATENCY_STRSIZE];
+
+        PR_Lock(ra->stats_lock);
+        op_latency = ra->op_latency;
+        cl_read_latency = ra->cl_read_latency;
+        bytes_sent = ra->bytes_sent;
+        update_rate = ra->last_update_rate;
+        clcache_loads = ra->clcache_loads;
+        clcache_records = ra->clcache_records;
+        stalls = ra->flowcontrol_stalls;
+        PR_Unlock(ra->stats_lock);
+
+        slapi_entry_attr_set_ulong(e, "nsds5replicaUpdateRate", update_rate);
+        slapi_entry_attr_set_ulong(e, "nsds5replicaBytesSentSinceStartup", bytes_sent);
+        latency_histogram_string(&op_latency, histogram, sizeof(histogram));
+        slapi_entry_attr_set_charptr(e, "nsds5replicaOpLatencyHistogram", histogram);
+        latency_histogram_string(&cl_read_latency, histogram, sizeof(histogram));
+        slapi_entry_attr_set_charptr(e, "nsds5replicaChangelogReadLatencyHistogram", histogram);
+        /* every cache load is a miss, the other changes are served from the cache */
+        slapi_entry_attr_set_ulong(e, "nsds5replicaChangelogCacheHitRatio",
+                                   clcache_records > clcache_loads ? ((clcache_records - clcache_loads) * 100) / clcache_records : 0);
+        slapi_entry_attr_set_ulong(e, "nsds5replicaFlowControlStalls", stalls);
     }
 bail:
     return SLAPI_DSE_CALLBACK_OK;
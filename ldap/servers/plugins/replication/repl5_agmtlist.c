@@ -371,6 +371,16 @@ agmtlist_modify_callback(Slapi_PBlock *pb,
                 *returncode = LDAP_OPERATIONS_ERROR;
                 rc = SLAPI_DSE_CALLBACK_ERROR;
             }
+        } else if (slapi_attr_types_equivalent(mods[i]->mod_type,
+                                               type_nsds5ReplicaTotalUpdateBatchSize)) {
+            /* New total update batch size */
+            if (agmt_set_totalupdatebatchsize_from_entry(agmt, e) != 0) {
+                slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name, "agmtlist_modify_callback - "
+                                                               "Failed to update the total update batch size for agreement %s\n",
+                              agmt_get_long_name(agmt));
+                *returncode = LDAP_OPERATIONS_ERROR;
+                rc = SLAPI_DSE_CALLBACK_ERROR;
+            }
         } else if (slapi_attr_types_equivalent(mods[i]->mod_type,
                                                type_replicaIgnoreMissingChange)) {
             /* New replica timeout */
@@ -48,6 +48,7 @@ typedef struct repl_connection
     int supports_ds40_repl; /* 1 if does, 0 if doesn't, -1 if not determined */
     int supports_ds71_repl; /* 1 if does, 0 if doesn't, -1 if not determined */
     int supports_ds90_repl; /* 1 if does, 0 if doesn't, -1 if not determined */
+    int supports_entry_batch; /* 1 if does, 0 if doesn't, -1 if not determined */
     int linger_time;        /* time in seconds to leave an idle connection open */
     PRBool linger_active;
     Slapi_Eq_Context *linger_event;
@@ -59,6 +60,7 @@ typedef struct repl_connection
     int flag_agmt_changed;
     char *plain;
     void *tot_init_callback; /* Used during total update to do flow control */
+    PRUint64 bytes_sent;     /* Estimated size of the operations sent on this connection */
 } repl_connection;
 
 /* #define DEFAULT_LINGER_TIME (5 * 60) */ /* 5 minutes */
@@ -72,6 +74,7 @@ void supplier_learn_new_definitions(struct berval **objectclasses, struct berval
 
 static LDAPControl manageDSAITControl = {LDAP_CONTROL_MANAGEDSAIT, {0, ""}, '\0'};
 static int attribute_string_value_present(LDAP *ld, LDAPMessage *entry, const char *type, const char *value);
+static PRUint64 operation_size(const char *dn, LDAPMod **attrs, const char *newrdn, const char *newparent, LDAPControl *update_control, struct berval *extop_payload);
 static int bind_and_check_pwp(Repl_Connection *conn, char *binddn, char *password);
 
 static int s_debug_timeout = 0;
@@ -160,6 +163,10 @@ conn_result2string(int result)
         return "consumer supports all DS90 extop";
     case CONN_DOES_NOT_SUPPORT_DS90_REPL:
         return "consumer does not support all DS90 extop";
+    case CONN_SUPPORTS_ENTRY_BATCH:
+        return "consumer supports batched total update entries";
+    case CONN_DOES_NOT_SUPPORT_ENTRY_BATCH:
+        return "consumer does not support batched total update entries";
     default:
         return NULL;
     }
@@ -192,6 +199,7 @@ conn_new(Repl_Agmt *agmt)
     rpc->supports_ds50_repl = -1;
     rpc->supports_ds71_repl = -1;
     rpc->supports_ds90_repl = -1;
+    rpc->supports_entry_batch = -1;
 
     rpc->linger_active = PR_FALSE;
     rpc->delete_after_linger = PR_FALSE;
@@ -598,7 +606,9 @@ check_flow_control_tot_init(Repl_Connection *conn, int optype, const char *extop
     int rcv_msgid;
     int once;
 
-    if ((sent_msgid != 0) && (optype == CONN_EXTENDED_OPERATION) && (strcmp(extop_oid, REPL_NSDS50_REPLICATION_ENTRY_REQUEST_OID) == 0)) {
+    if ((sent_msgid != 0) && (optype == CONN_EXTENDED_OPERATION) &&
+        ((strcmp(extop_oid, REPL_NSDS50_REPLICATION_ENTRY_REQUEST_OID) == 0) ||
+         (strcmp(extop_oid, REPL_NSDS_REPLICATION_ENTRY_BATCH_REQUEST_OID) == 0))) {
         /* We are sending entries part of the total update of a consumer
          * Wait a bit if the consumer needs to catchup from the current sent entries
          */
@@ -793,6 +803,7 @@ perform_operation(Repl_Connection *conn, int optype, const char *dn, LDAPMod **a
              * queue the operation details in the outstanding operation list.
              */
             return_value = CONN_OPERATION_SUCCESS;
+            conn->bytes_sent += operation_size(dn, attrs, newrdn, newparent, update_control, extop_payload);
         } else {
             slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name,
                           "perform_operation - %s: Failed to send %s operation: LDAP error %d (%s)\n",
@@ -824,6 +835,40 @@ perform_operation(Repl_Connection *conn, int optype, const char *dn, LDAPMod **a
     return return_value;
 }
 
+/*
+ * Estimate the payload size of an operation: the dn, the attribute
+ * types and values, and the replication control. The BER framing is
+ * not counted.
+ */
+static PRUint64
+operation_size(const char *dn, LDAPMod **attrs, const char *newrdn, const char *newparent, LDAPControl *update_control, struct berval *extop_payload)
+{
+    PRUint64 size = 0;
+
+    if (dn) {
+        size += strlen(dn);
+    }
+    if (newrdn) {
+        size += strlen(newrdn);
+    }
+    if (newparent) {
+        size += strlen(newparent);
+    }
+    for (size_t i = 0; attrs && attrs[i]; i++) {
+        size += strlen(attrs[i]->mod_type);
+        for (size_t j = 0; attrs[i]->mod_bvalues && attrs[i]->mod_bvalues[j]; j++) {
+            size += attrs[i]->mod_bvalues[j]->bv_len;
+        }
+    }
+    if (update_control) {
+        size += update_control->ldctl_value.bv_len;
+    }
+    if (extop_payload) {
+        size += extop_payload->bv_len;
+    }
+    return size;
+}
+
 /*
  * Send an LDAP add operation.
  */
@@ -1213,6 +1258,7 @@ close_connection_internal(Repl_Connection *conn)
     conn->supports_ds50_repl = -1;
     conn->supports_ds71_repl = -1;
     conn->supports_ds90_repl = -1;
+    conn->supports_entry_batch = -1;
     /* do this last, to minimize the chance that another thread
        might read conn->state as not disconnected and attempt
        to use conn->ld */
@@ -1422,6 +1468,67 @@ conn_replica_supports_ds90_repl(Repl_Connection *conn)
     return return_value;
 }
 
+/*
+ * Determine if the remote replica accepts several entries per total update
+ * extended operation.
+ * Return codes:
+ * CONN_SUPPORTS_ENTRY_BATCH - the remote replica supports batched entries
+ * CONN_DOES_NOT_SUPPORT_ENTRY_BATCH - the remote replica only accepts one
+ * entry per operation.
+ * CONN_OPERATION_FAILED - it could not be determined if the remote
+ * replica supports batched entries.
+ * CONN_NOT_CONNECTED - no connection was active.
+ */
+ConnResult
+conn_replica_supports_entry_batch(Repl_Connection *conn)
+{
+    ConnResult return_value;
+    int ldap_rc;
+
+    PR_Lock(conn->lock);
+    if (conn_connected(conn)) {
+        if (conn->supports_entry_batch == -1) {
+            LDAPMessage *res = NULL;
+            LDAPMessage *entry = NULL;
+            char *attrs[] = {"supportedextension", NULL};
+
+            conn->status = STATUS_SEARCHING;
+            ldap_rc = ldap_search_ext_s(conn->ld, "", LDAP_SCOPE_BASE,
+                                        "(objectclass=*)", attrs, 0 /* attrsonly */,
+                                        NULL /* server controls */, NULL /* client controls */,
+                                        &conn->timeout, LDAP_NO_LIMIT, &res);
+            if (LDAP_SUCCESS == ldap_rc) {
+                conn->supports_entry_batch = 0;
+                entry = ldap_first_entry(conn->ld, res);
+                if (!attribute_string_value_present(conn->ld, entry, "supportedextension", REPL_NSDS_REPLICATION_ENTRY_BATCH_REQUEST_OID)) {
+                    return_value = CONN_DOES_NOT_SUPPORT_ENTRY_BATCH;
+                } else {
+                    conn->supports_entry_batch = 1;
+                    return_value = CONN_SUPPORTS_ENTRY_BATCH;
+                }
+            } else {
+                if (IS_DISCONNECT_ERROR(ldap_rc)) {
+                    conn->last_ldap_error = ldap_rc; /* specific reason */
+                    close_connection_internal(conn);
+                    return_value = CONN_NOT_CONNECTED;
+                } else {
+                    return_value = CONN_OPERATION_FAILED;
+                }
+            }
+            if (NULL != res)
+                ldap_msgfree(res);
+        } else {
+            return_value = conn->supports_entry_batch ? CONN_SUPPORTS_ENTRY_BATCH : CONN_DOES_NOT_SUPPORT_ENTRY_BATCH;
+        }
+    } else {
+        /* Not connected */
+        return_value = CONN_NOT_CONNECTED;
+    }
+    PR_Unlock(conn->lock);
+
+    return return_value;
+}
+
 /* Determine if the replica is read-only */
 ConnResult
 conn_replica_is_readonly(Repl_Connection *conn)
@@ -1778,6 +1885,17 @@ conn_get_timeout(Repl_Connection *conn)
     return retval;
 }
 
+PRUint64
+conn_get_bytes_sent(Repl_Connection *conn)
+{
+    PRUint64 retval = 0;
+    PR_ASSERT(NULL != conn);
+    PR_Lock(conn->lock);
+    retval = conn->bytes_sent;
+    PR_Unlock(conn->lock);
+    return retval;
+}
+
 LDAP *
 conn_get_ldap(Repl_Connection *conn)
 {
@@ -64,6 +64,7 @@ typedef struct repl5_inc_operation
     char csn_str[CSN_STRSIZE];
     char uniqueid[UIDSTR_SIZE + 1];
     ReplicaId replica_id;
+    PRIntervalTime send_time; /* Used to measure the round trip time of the operation */
     struct repl5_inc_operation *next;
 } repl5_inc_operation;
 
@@ -318,6 +319,7 @@ repl5_inc_result_threadmain(void *param)
             /* Get the stored operation details from the queue, unless we timed out... */
             op = repl5_inc_pop_operation(rd);
             if (op) {
+                agmt_record_op_latency(rd->prp->agmt, PR_IntervalNow() - op->send_time);
                 csn_str = op->csn_str;
                 replica_id = op->replica_id;
                 uniqueid = op->uniqueid;
@@ -462,6 +464,7 @@ repl5_inc_flow_control_results(Repl_Agmt *agmt, result_data *rd)
         ((rd->last_message_id_sent - rd->last_message_id_received) >= agmt_get_flowcontrolwindow(agmt))) {
         rd->flowcontrol_detection++;
         PR_Unlock(rd->lock);
+        agmt_inc_flowcontrol_stalls(agmt);
         DS_Sleep(PR_MillisecondsToInterval(agmt_get_flowcontrolpause(agmt)));
     } else {
         PR_Unlock(rd->lock);
@@ -1677,6 +1680,12 @@ send_updates(Private_Repl_Protocol *prp, RUV *remote_update_vector, PRUint32 *nu
         int skipped_updates = 0;
         int fractional_repl;
         int finished = 0;
+        PRIntervalTime session_start = PR_IntervalNow();
+        PRIntervalTime read_start;
+        PRIntervalTime send_time;
+        PRUint64 bytes_start = conn_get_bytes_sent(prp->conn);
+        int clcache_loads = 0;
+        int clcache_records = 0;
 #define FRACTIONAL_SKIPPED_THRESHOLD 100
 
         /* Start the results reading thread */
@@ -1698,7 +1707,9 @@ send_updates(Private_Repl_Protocol *prp, RUV *remote_update_vector, PRUint32 *nu
         do {
             cl5_operation_parameters_done(entry.op);
             memset((void *)entry.op, 0, sizeof(op));
+            read_start = PR_IntervalNow();
             rc = cl5GetNextOperationToReplay(changelog_iterator, &entry);
+            agmt_record_cl_read_latency(prp->agmt, PR_IntervalNow() - read_start);
             switch (rc) {
             case CL5_SUCCESS:
                 /* check that we don't return dummy entries */
@@ -1709,6 +1720,7 @@ send_updates(Private_Repl_Protocol *prp, RUV *remote_update_vector, PRUint32 *nu
                                   agmt_get_long_name(prp->agmt), csn_as_string(entry.op->csn, PR_FALSE, csn_str));
                     continue;
                 }
+                send_time = PR_IntervalNow();
                 replay_crc = replay_update(prp, entry.op, &message_id);
                 if (message_id) {
                     rd->last_message_id_sent = message_id;
@@ -1801,6 +1813,7 @@ send_updates(Private_Repl_Protocol *prp, RUV *remote_update_vector, PRUint32 *nu
                         sop->ldap_message_id = message_id;
                         sop->operation_type = entry.op->operation_type;
                         sop->replica_id = replica_id;
+                        sop->send_time = send_time;
                         PL_strncpyz(sop->uniqueid, uniqueid, sizeof(sop->uniqueid));
                         repl5_int_push_operation(rd, sop);
                         repl5_inc_flow_control_results(prp->agmt, rd);
@@ -1963,6 +1976,12 @@ send_updates(Private_Repl_Protocol *prp, RUV *remote_update_vector, PRUint32 *nu
         PR_Unlock(rd->lock);
         repl5_inc_rd_destroy(&rd);
 
+        cl5GetReplayIteratorStats(changelog_iterator, &clcache_loads, &clcache_records);
+        agmt_record_update_session(prp->agmt, *num_changes_sent,
+                                   conn_get_bytes_sent(prp->conn) - bytes_start,
+                                   PR_IntervalNow() - session_start,
+                                   clcache_loads, clcache_records);
+
         cl5_operation_parameters_done(entry.op);
         cl5DestroyReplayIterator(&changelog_iterator);
     }
@@ -75,6 +75,7 @@ extern Private_Repl_Protocol *Windows_Tot_Protocol_new(Repl_Protocol *rp);
 void release_replica(Private_Repl_Protocol *prp);
 int acquire_replica(Private_Repl_Protocol *prp, char *prot_oid, RUV **ruv);
 BerElement *entry2bere(const Slapi_Entry *e, char **excluded_attrs);
+BerElement *entry_batch2bere(struct berval **payloads, int count);
 CSN *get_current_csn(Slapi_DN *replarea_sdn);
 char *protocol_response2string(int response);
 int repl5_strip_fractional_mods(Repl_Agmt *agmt, LDAPMod **);
@@ -605,17 +605,24 @@ set_max_csn_nolock_ext(RUV *ruv, const CSN *max_csn, const char *replica_purl, P
         if (replica_purl && replica->replica_purl == NULL)
             replica->replica_purl = slapi_ch_strdup(replica_purl);
         if (!must_be_greater || (csn_compare(replica->csn, max_csn) < 0)) {
-            csn_free(&replica->csn);
-            replica->csn = csn_dup(max_csn);
+            /* called for every update, while holding the write lock:
+             * reuse the csn rather than reallocating it */
+            if (replica->csn) {
+                csn_init_by_csn(replica->csn, max_csn);
+            } else {
+                replica->csn = csn_dup(max_csn);
+            }
             replica->last_modified = slapi_current_utc_time();
         } else {
-            char csn1[CSN_STRSIZE + 1];
-            char csn2[CSN_STRSIZE + 1];
-            slapi_log_err(SLAPI_LOG_REPL, repl_plugin_name,
-                          "set_max_csn_nolock_ext: new CSN [%s] for replica ID [%d] "
-                          "is less than the existing max CSN [%s] - ignoring\n",
-                          csn_as_string(max_csn, PR_FALSE, csn1), rid,
-                          csn_as_string(replica->csn, PR_FALSE, csn2));
+            if (slapi_is_loglevel_set(SLAPI_LOG_REPL)) {
+                char csn1[CSN_STRSIZE + 1];
+                char csn2[CSN_STRSIZE + 1];
+                slapi_log_err(SLAPI_LOG_REPL, repl_plugin_name,
+                              "set_max_csn_nolock_ext: new CSN [%s] for replica ID [%d] "
+                              "is less than the existing max CSN [%s] - ignoring\n",
+                              csn_as_string(max_csn, PR_FALSE, csn1), rid,
+                              csn_as_string(replica->csn, PR_FALSE, csn2));
+            }
             return_value = RUV_COVERS_CSN;
         }
     }
@@ -1491,7 +1498,11 @@ ruv_dump(const RUV *ruv, char *ruv_name, PRFileDesc *prFile)
 }
 
 /* this function notifies the ruv that there are operations in progress so that
-   they can be added to the pending list for the appropriate client. */
+   they can be added to the pending list for the appropriate client.
+   The pending list has its own lock and the max csns only change under the
+   write lock (ruv_update_ruv), so the ruv is only read locked here unless
+   the element of the replica has to be created: concurrent updates do not
+   serialize on the ruv lock. */
 int
 ruv_add_csn_inprogress(void *repl, RUV *ruv, const CSN *csn)
 {
@@ -1504,7 +1515,7 @@ ruv_add_csn_inprogress(void *repl, RUV *ruv, const CSN *csn)
     PR_ASSERT(ruv && csn);
 
     /* locate ruvElement */
-    slapi_rwlock_wrlock(ruv->lock);
+    slapi_rwlock_rdlock(ruv->lock);
 
     if (is_cleaned_rid(rid)) {
         /* return success because we want to consume the update, but not perform it */
@@ -1512,6 +1523,12 @@ ruv_add_csn_inprogress(void *repl, RUV *ruv, const CSN *csn)
         goto done;
     }
     replica = ruvGetReplica(ruv, rid);
+    if (replica == NULL) {
+        /* first csn of this replica: add its element under the write lock */
+        slapi_rwlock_unlock(ruv->lock);
+        slapi_rwlock_wrlock(ruv->lock);
+        replica = ruvGetReplica(ruv, rid);
+    }
     if (replica == NULL) {
         replica = ruvAddReplicaNoCSN(ruv, rid, NULL /*purl*/);
         if (replica == NULL) {
@@ -1589,8 +1606,9 @@ ruv_cancel_csn_inprogress(void *repl, RUV *ruv, const CSN *csn, ReplicaId local_
     PR_ASSERT(ruv && csn);
 
     prim_csn = get_thread_primary_csn();
-    /* locate ruvElement */
-    slapi_rwlock_wrlock(ruv->lock);
+    /* locate ruvElement: the pending lists have their own lock,
+     * the ruv elements are not modified here */
+    slapi_rwlock_rdlock(ruv->lock);
     repl_ruv = ruvGetReplica(ruv, csn_get_replicaid(csn));
     if (repl_ruv == NULL) {
         /* ONREPL - log error */
@@ -53,6 +53,10 @@ typedef struct callback_data
     int last_message_id_sent;
     int last_message_id_received;
     int flowcontrol_detection;
+    struct berval **batch; /* Encoded entries waiting to be sent in one extended operation */
+    int batch_size;        /* Maximum number of entries per operation, 0 when not batching */
+    int batch_count;       /* Number of entries currently held in batch */
+    size_t batch_bytes;    /* Encoded size of the entries currently held in batch */
 } callback_data;
 
 /*
@@ -61,9 +65,19 @@ typedef struct callback_data
  */
 #define SLEEP_ON_BUSY_WINDOW (10)
 
+/*
+ * Limits of a batch of entries sent in one extended operation. The byte
+ * limit keeps a batch well below the consumer default nsslapd-maxbersize
+ * (2MB); an entry bigger than that is still sent, alone in its batch.
+ */
+#define TOTAL_UPDATE_BATCH_MAX_ENTRIES (10000)
+#define TOTAL_UPDATE_BATCH_MAX_BYTES (512 * 1024)
+
 /* Helper functions */
 static void get_result(int rc, void *cb_data);
 static int send_entry(Slapi_Entry *e, void *callback_data);
+static int send_entry_batch(callback_data *cb_data);
+static void free_entry_batch(callback_data *cb_data);
 static void repl5_tot_delete(Private_Repl_Protocol **prp);
 
 #define LOST_CONN_ERR(xx) ((xx == -2) || (xx == LDAP_SERVER_DOWN) || (xx == LDAP_CONNECT_ERROR))
@@ -355,6 +369,7 @@ repl5_tot_run(Private_Repl_Protocol *prp)
     char **instances = NULL;
     Slapi_Backend *be = NULL;
     int is_entryrdn = 0;
+    long batch_size = 0;
 
     PR_ASSERT(NULL != prp);
 
@@ -425,6 +440,21 @@ retry:
         agmt_set_last_init_status(prp->agmt, 0, 0, 0, "Total schema update succeeded");
     }
 
+    /* Pack several entries per extended operation when the consumer accepts it.
+     * This saves one LDAP round trip, and one result to read, per entry. */
+    batch_size = agmt_get_totalupdatebatchsize(prp->agmt);
+    if (batch_size > 1 && !prp->repl50consumer &&
+        conn_replica_supports_entry_batch(prp->conn) == CONN_SUPPORTS_ENTRY_BATCH) {
+        if (batch_size > TOTAL_UPDATE_BATCH_MAX_ENTRIES) {
+            batch_size = TOTAL_UPDATE_BATCH_MAX_ENTRIES;
+        }
+        cb_data.batch_size = (int)batch_size;
+        cb_data.batch = (struct berval **)slapi_ch_calloc(batch_size, sizeof(struct berval *));
+        slapi_log_err(SLAPI_LOG_REPL, repl_plugin_name, "repl5_tot_run - %s - "
+                                                        "Sending up to %d entries per operation\n",
+                      agmt_get_long_name(prp->agmt), cb_data.batch_size);
+    }
+
     /* ONREPL - big assumption here is that entries a returned in the id order
        and that the order implies that perent entry is always ahead of the
        child entry in the list. Otherwise, the consumer would not be
@@ -575,6 +605,11 @@ retry:
                                       send_entry /* entry callback */,
                                       NULL /* referral callback*/);
 
+    /* Push the entries still waiting in the last, partial, batch */
+    if (cb_data.rc == CONN_OPERATION_SUCCESS) {
+        send_entry_batch(&cb_data);
+    }
+
     /*
      * After completing the sending operation (or optionally failing), we need to clean up
      * the async propagation stuff:
@@ -633,6 +668,7 @@ done:
                       type_nsds5ReplicaFlowControlWindow);
     }
     conn_set_tot_update_cb(prp->conn, NULL);
+    free_entry_batch(&cb_data);
     if (cb_data.lock) {
         PR_DestroyLock(cb_data.lock);
     }
@@ -794,6 +830,137 @@ repl5_tot_flowcontrol_detection(Repl_Connection *conn, int increment)
     }
 }
 
+/*
+ * Send one total update extended operation (a single entry or a batch of
+ * entries) to the consumer, waiting and retrying while it reports busy.
+ * Returns a ConnResult.
+ */
+static int
+send_total_update_extop(callback_data *cb_data, const char *extop_oid, struct berval *bv)
+{
+    Private_Repl_Protocol *prp = cb_data->prp;
+    time_t *sleep_on_busyp = &cb_data->sleep_on_busy;
+    time_t *last_busyp = &cb_data->last_busy;
+    int message_id = 0;
+    int rc;
+
+    do {
+        /* push the entry to the consumer */
+        rc = conn_send_extended_operation(prp->conn, extop_oid,
+                                          bv /* payload */, NULL /* update_control */, &message_id);
+
+        if (message_id) {
+            cb_data->last_message_id_sent = message_id;
+        }
+
+        /* If we are talking to a 5.0 type consumer, we need to wait here and retrieve the
+         * response. Reason is that it can return LDAP_BUSY, indicating that its queue has
+         * filled up. This completely breaks pipelineing, and so we need to fall back to
+         * sync transmission for those consumers, in case they pull the LDAP_BUSY stunt on us :( */
+
+        if (prp->repl50consumer) {
+            /* Get the response here */
+            rc = repl5_tot_get_next_result(cb_data);
+        }
+
+        if (rc == CONN_BUSY) {
+            time_t now = slapi_current_utc_time();
+            if ((now - *last_busyp) < (*sleep_on_busyp + 10)) {
+                *sleep_on_busyp += 5;
+            } else {
+                *sleep_on_busyp = 5;
+            }
+            *last_busyp = now;
+
+            slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name,
+                          "send_total_update_extop - Replica \"%s\" is busy. Waiting %lds while"
+                          " it finishes processing its current import queue\n",
+                          agmt_get_long_name(prp->agmt), *sleep_on_busyp);
+            DS_Sleep(PR_SecondsToInterval(*sleep_on_busyp));
+        }
+    } while (rc == CONN_BUSY);
+
+    return rc;
+}
+
+/*
+ * Record the outcome of a total update extended operation in the
+ * callback data. Returns 0 if we can keep sending entries, -1 otherwise.
+ */
+static int
+set_send_result(callback_data *cb_data, int rc)
+{
+    /* if the connection has been closed, we need to stop
+       sending entries and set a special rc value to let
+       the result reading thread know the connection has been
+       closed - do not attempt to read any more results */
+    if (CONN_NOT_CONNECTED == rc) {
+        cb_data->rc = -2;
+        return -1;
+    }
+    cb_data->rc = rc;
+    return (CONN_OPERATION_SUCCESS == rc) ? 0 : -1;
+}
+
+/*
+ * Send the entries accumulated in the batch in a single
+ * NSDSReplicationEntryBatch extended operation, and empty the batch.
+ */
+static int
+send_entry_batch(callback_data *cb_data)
+{
+    BerElement *bere;
+    struct berval *bv = NULL;
+    int rc;
+    int i;
+
+    if (cb_data->batch_count == 0) {
+        return 0;
+    }
+
+    bere = entry_batch2bere(cb_data->batch, cb_data->batch_count);
+    for (i = 0; i < cb_data->batch_count; i++) {
+        ber_bvfree(cb_data->batch[i]);
+        cb_data->batch[i] = NULL;
+    }
+    cb_data->batch_count = 0;
+    cb_data->batch_bytes = 0;
+
+    if (bere == NULL) {
+        slapi_log_err(SLAPI_LOG_REPL, repl_plugin_name, "%s: send_entry_batch: Encoding Error\n",
+                      agmt_get_long_name(cb_data->prp->agmt));
+        cb_data->rc = -1;
+        return -1;
+    }
+    rc = ber_flatten(bere, &bv);
+    ber_free(bere, 1);
+    if (rc != 0) {
+        cb_data->rc = -1;
+        return -1;
+    }
+
+    rc = send_total_update_extop(cb_data, REPL_NSDS_REPLICATION_ENTRY_BATCH_REQUEST_OID, bv);
+    ber_bvfree(bv);
+
+    return set_send_result(cb_data, rc);
+}
+
+static void
+free_entry_batch(callback_data *cb_data)
+{
+    int i;
+
+    if (cb_data->batch == NULL) {
+        return;
+    }
+    for (i = 0; i < cb_data->batch_count; i++) {
+        ber_bvfree(cb_data->batch[i]);
+    }
+    slapi_ch_free((void **)&cb_data->batch);
+    cb_data->batch_count = 0;
+    cb_data->batch_bytes = 0;
+}
+
 static int
 send_entry(Slapi_Entry *e, void *cb_data)
 {
@@ -802,34 +969,30 @@ send_entry(Slapi_Entry *e, void *cb_data)
     BerElement *bere;
     struct berval *bv;
     unsigned long *num_entriesp;
-    time_t *sleep_on_busyp;
-    time_t *last_busyp;
-    int message_id = 0;
+    callback_data *cb = (callback_data *)cb_data;
     int retval = 0;
     char **frac_excluded_attrs = NULL;
 
     PR_ASSERT(cb_data);
 
-    prp = ((callback_data *)cb_data)->prp;
-    num_entriesp = &((callback_data *)cb_data)->num_entries;
-    sleep_on_busyp = &((callback_data *)cb_data)->sleep_on_busy;
-    last_busyp = &((callback_data *)cb_data)->last_busy;
+    prp = cb->prp;
+    num_entriesp = &cb->num_entries;
     PR_ASSERT(prp);
 
     if (prp->terminate) {
         conn_disconnect(prp->conn);
-        ((callback_data *)cb_data)->rc = -1;
+        cb->rc = -1;
         return -1;
     }
 
     /* see if the result reader thread encountered
        a fatal error */
-    PR_Lock(((callback_data *)cb_data)->lock);
-    rc = ((callback_data *)cb_data)->abort;
-    PR_Unlock(((callback_data *)cb_data)->lock);
+    PR_Lock(cb->lock);
+    rc = cb->abort;
+    PR_Unlock(cb->lock);
     if (rc) {
         conn_disconnect(prp->conn);
-        ((callback_data *)cb_data)->rc = -1;
+        cb->rc = -1;
         return -1;
     }
     /* skip ruv tombstone - need to  do this because it might be
@@ -856,73 +1019,44 @@ send_entry(Slapi_Entry *e, void *cb_data)
     if (bere == NULL) {
         slapi_log_err(SLAPI_LOG_REPL, repl_plugin_name, "%s: send_entry: Encoding Error\n",
                       agmt_get_long_name(prp->agmt));
-        ((callback_data *)cb_data)->rc = -1;
+        cb->rc = -1;
         retval = -1;
-        goto error;
+        goto done;
     }
 
     rc = ber_flatten(bere, &bv);
     ber_free(bere, 1);
     if (rc != 0) {
-        ((callback_data *)cb_data)->rc = -1;
+        cb->rc = -1;
         retval = -1;
-        goto error;
+        goto done;
     }
 
-    do {
-        /* push the entry to the consumer */
-        rc = conn_send_extended_operation(prp->conn, REPL_NSDS50_REPLICATION_ENTRY_REQUEST_OID,
-                                          bv /* payload */, NULL /* update_control */, &message_id);
-
-        if (message_id) {
-            ((callback_data *)cb_data)->last_message_id_sent = message_id;
+    if (cb->batch_size > 1) {
+        /* Keep the entry for the next batch, flushing the current one
+         * first if this entry would make it too big */
+        if (cb->batch_count > 0 && (cb->batch_bytes + bv->bv_len) > TOTAL_UPDATE_BATCH_MAX_BYTES) {
+            retval = send_entry_batch(cb);
+            if (retval) {
+                ber_bvfree(bv);
+                goto done;
+            }
         }
-
-        /* If we are talking to a 5.0 type consumer, we need to wait here and retrieve the
-         * response. Reason is that it can return LDAP_BUSY, indicating that its queue has
-         * filled up. This completely breaks pipelineing, and so we need to fall back to
-         * sync transmission for those consumers, in case they pull the LDAP_BUSY stunt on us :( */
-
-        if (prp->repl50consumer) {
-            /* Get the response here */
-            rc = repl5_tot_get_next_result((callback_data *)cb_data);
+        cb->batch[cb->batch_count++] = bv;
+        cb->batch_bytes += bv->bv_len;
+        (*num_entriesp)++;
+        if (cb->batch_count >= cb->batch_size) {
+            retval = send_entry_batch(cb);
         }
+        goto done;
+    }
 
-        if (rc == CONN_BUSY) {
-            time_t now = slapi_current_utc_time();
-            if ((now - *last_busyp) < (*sleep_on_busyp + 10)) {
-                *sleep_on_busyp += 5;
-            } else {
-                *sleep_on_busyp = 5;
-            }
-            *last_busyp = now;
-
-            slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name,
-                          "send_entry - Replica \"%s\" is busy. Waiting %lds while"
-                          " it finishes processing its current import queue\n",
-                          agmt_get_long_name(prp->agmt), *sleep_on_busyp);
-            DS_Sleep(PR_SecondsToInterval(*sleep_on_busyp));
-        }
-    } while (rc == CONN_BUSY);
+    rc = send_total_update_extop(cb, REPL_NSDS50_REPLICATION_ENTRY_REQUEST_OID, bv);
 
     ber_bvfree(bv);
     (*num_entriesp)++;
 
-    /* if the connection has been closed, we need to stop
-       sending entries and set a special rc value to let
-       the result reading thread know the connection has been
-       closed - do not attempt to read any more results */
-    if (CONN_NOT_CONNECTED == rc) {
-        ((callback_data *)cb_data)->rc = -2;
-        retval = -1;
-    } else {
-        ((callback_data *)cb_data)->rc = rc;
-        if (CONN_OPERATION_SUCCESS == rc) {
-            retval = 0;
-        } else {
-            retval = -1;
-        }
-    }
-error:
+    retval = set_send_result(cb, rc);
+done:
     return retval;
 }
@@ -44,6 +44,12 @@
           }
         CSN OCTET STRING,
     }
+
+ The requestValue of the NSDSReplicationEntryBatch looks like this:
+
+     requestValue ::= SEQUENCE OF OCTET STRING
+
+ where each OCTET STRING holds the requestValue of an NSDS50ReplicationEntry.
 */
 
 #include "repl5.h"
@@ -65,6 +71,7 @@ static int my_ber_printf_value(BerElement *ber, const char *type, const Slapi_Va
 static int my_ber_printf_attr(BerElement *ber, Slapi_Attr *attr, PRBool deleted);
 static int my_ber_scanf_attr(BerElement *ber, Slapi_Attr **attr, PRBool *deleted);
 static int my_ber_scanf_value(BerElement *ber, Slapi_Value **value, PRBool *deleted);
+static int decode_total_update_entry(struct berval *payload, Slapi_Entry **ep);
 
 /*
  * Get a Slapi_Entry ready to send over the wire as part of
@@ -204,6 +211,48 @@ free_and_return:
     return ber;
 }
 
+/*
+ * Pack several entries, already converted by entry2bere() and flattened,
+ * into the payload of a single NSDSReplicationEntryBatch extended operation.
+ * The payloads are not consumed.
+ */
+BerElement *
+entry_batch2bere(struct berval **payloads, int count)
+{
+    BerElement *ber = NULL;
+    int i;
+
+    PR_ASSERT(NULL != payloads);
+
+    if ((ber = ber_alloc()) == NULL) {
+        goto loser;
+    }
+    BER_DEBUG("{");
+    if (ber_printf(ber, "{") == -1) /* Begin sequence of entries */
+    {
+        goto loser;
+    }
+    for (i = 0; i < count; i++) {
+        BER_DEBUG("o(entry)");
+        if (ber_printf(ber, "o", payloads[i]->bv_val, payloads[i]->bv_len) == -1) {
+            goto loser;
+        }
+    }
+    BER_DEBUG("}");
+    if (ber_printf(ber, "}") == -1) /* End sequence of entries */
+    {
+        goto loser;
+    }
+    BER_DEBUG("\n");
+    return ber;
+
+loser:
+    if (NULL != ber) {
+        ber_free(ber, 1);
+    }
+    return NULL;
+}
+
 
 /*
  * Helper function - convert a CSN to a string and ber_printf() it.
@@ -616,40 +665,31 @@ loser:
 }
 
 /*
- * Extract the payload from a total update extended operation,
- * decode it, and produce a Slapi_Entry structure representing a new
- * entry to be added to the local database.
+ * Decode the payload of a single total update entry and produce a
+ * Slapi_Entry structure representing a new entry to be added to the
+ * local database.
  */
 static int
-decode_total_update_extop(Slapi_PBlock *pb, Slapi_Entry **ep)
+decode_total_update_entry(struct berval *payload, Slapi_Entry **ep)
 {
     BerElement *tmp_bere = NULL;
     Slapi_Entry *e = NULL;
     Slapi_Attr *attr = NULL;
     char *str = NULL;
-    struct berval *extop_value = NULL;
-    char *extop_oid = NULL;
     ber_len_t len;
     char *lasto;
     ber_tag_t tag;
     int rc;
     PRBool deleted;
 
-    PR_ASSERT(NULL != pb);
     PR_ASSERT(NULL != ep);
 
-    slapi_pblock_get(pb, SLAPI_EXT_OP_REQ_OID, &extop_oid);
-    slapi_pblock_get(pb, SLAPI_EXT_OP_REQ_VALUE, &extop_value);
-
-    if ((NULL == extop_oid) ||
-        ((strcmp(extop_oid, REPL_NSDS50_REPLICATION_ENTRY_REQUEST_OID) != 0) &&
-         (strcmp(extop_oid, REPL_NSDS71_REPLICATION_ENTRY_REQUEST_OID) != 0)) ||
-        !BV_HAS_DATA(extop_value)) {
+    if (!BV_HAS_DATA(payload)) {
         /* Bogus */
         goto loser;
     }
 
-    if ((tmp_bere = ber_init(extop_value)) == NULL) {
+    if ((tmp_bere = ber_init(payload)) == NULL) {
         goto loser;
     }
 
@@ -733,7 +773,7 @@ loser:
         slapi_entry_free(e);
     }
     *ep = NULL;
-    slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name, "decode_total_update_extop - Could not decode extended "
+    slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name, "decode_total_update_entry - Could not decode extended "
                                                    "operation containing entry for total update.\n");
 
 free_and_return:
@@ -744,9 +784,111 @@ free_and_return:
     return rc;
 }
 
+/*
+ * Extract the payload from a total update extended operation,
+ * decode it, and produce a Slapi_Entry structure representing a new
+ * entry to be added to the local database.
+ */
+static int
+decode_total_update_extop(Slapi_PBlock *pb, Slapi_Entry **ep)
+{
+    struct berval *extop_value = NULL;
+    char *extop_oid = NULL;
+
+    PR_ASSERT(NULL != pb);
+    PR_ASSERT(NULL != ep);
+
+    slapi_pblock_get(pb, SLAPI_EXT_OP_REQ_OID, &extop_oid);
+    slapi_pblock_get(pb, SLAPI_EXT_OP_REQ_VALUE, &extop_value);
+
+    if ((NULL == extop_oid) ||
+        ((strcmp(extop_oid, REPL_NSDS50_REPLICATION_ENTRY_REQUEST_OID) != 0) &&
+         (strcmp(extop_oid, REPL_NSDS71_REPLICATION_ENTRY_REQUEST_OID) != 0))) {
+        /* Bogus */
+        *ep = NULL;
+        return -1;
+    }
+
+    return decode_total_update_entry(extop_value, ep);
+}
+
+/*
+ * Decode every entry of an NSDSReplicationEntryBatch extended operation and
+ * hand them, in order, to the bulk import. Stops on the first failure, a
+ * batch that does not decode to its end is a protocol error.
+ */
+static int
+import_total_update_batch(Slapi_PBlock *pb, PRUint64 connid, int opid)
+{
+    BerElement *tmp_bere = NULL;
+    struct berval *extop_value = NULL;
+    struct berval payload = {0};
+    Slapi_Entry *e = NULL;
+    ber_len_t len;
+    char *lasto;
+    ber_tag_t tag;
+    int count = 0;
+    int rc = -1;
+
+    slapi_pblock_get(pb, SLAPI_EXT_OP_REQ_VALUE, &extop_value);
+    if (!BV_HAS_DATA(extop_value) || (tmp_bere = ber_init(extop_value)) == NULL) {
+        goto done;
+    }
+
+    for (tag = ber_first_element(tmp_bere, &len, &lasto);
+         tag != LBER_ERROR && tag != LBER_END_OF_SEQORSET;
+         tag = ber_next_element(tmp_bere, &len, lasto)) {
+
+        if (ber_scanf(tmp_bere, "o", &payload) == LBER_ERROR) {
+            rc = LDAP_PROTOCOL_ERROR;
+            goto done;
+        }
+        rc = decode_total_update_entry(&payload, &e);
+        slapi_ch_free_string(&payload.bv_val);
+        if (rc != 0) {
+            slapi_log_err(SLAPI_LOG_REPL, repl_plugin_name,
+                          "import_total_update_batch - "
+                          "Could not decode entry %d of the total update batch conn=%" PRIu64 " op=%d\n",
+                          count, connid, opid);
+            goto done;
+        }
+
+        rc = slapi_import_entry(pb, e);
+        if (rc != LDAP_SUCCESS) {
+            /* We still own the entry if the import failed */
+            slapi_log_err(SLAPI_LOG_REPL, repl_plugin_name,
+                          "import_total_update_batch - "
+                          "Error %d: could not import entry dn %s for total update operation conn=%" PRIu64 " op=%d\n",
+                          rc, slapi_entry_get_dn_const(e), connid, opid);
+            slapi_entry_free(e);
+            rc = -1;
+            goto done;
+        }
+        e = NULL;
+        count++;
+    }
+    if (tag == LBER_ERROR) {
+        /* truncated or malformed: the entries after the last one decoded
+         * would silently be missing on this consumer */
+        slapi_log_err(SLAPI_LOG_REPL, repl_plugin_name,
+                      "import_total_update_batch - "
+                      "Malformed total update batch after %d entries conn=%" PRIu64 " op=%d\n",
+                      count, connid, opid);
+        rc = LDAP_PROTOCOL_ERROR;
+        goto done;
+    }
+    rc = 0;
+
+done:
+    if (NULL != tmp_bere) {
+        ber_free(tmp_bere, 1);
+    }
+    return rc;
+}
+
 /*
  * This plugin entry point is called whenever an NSDS50ReplicationEntry
- * extended operation is received.
+ * or NSDSReplicationEntryBatch extended operation is received.
  */
 int
 multimaster_extop_NSDS50ReplicationEntry(Slapi_PBlock *pb)
@@ -756,9 +898,24 @@ multimaster_extop_NSDS50ReplicationEntry(Slapi_PBlock *pb)
     Slapi_Connection *conn = NULL;
     PRUint64 connid = 0;
     int opid = 0;
+    char *extop_oid = NULL;
 
     slapi_pblock_get(pb, SLAPI_CONN_ID, &connid);
     slapi_pblock_get(pb, SLAPI_OPERATION_ID, &opid);
+    slapi_pblock_get(pb, SLAPI_EXT_OP_REQ_OID, &extop_oid);
+
+    if (extop_oid && strcmp(extop_oid, REPL_NSDS_REPLICATION_ENTRY_BATCH_REQUEST_OID) == 0) {
+        rc = import_total_update_batch(pb, connid, opid);
+        if (LDAP_SUCCESS != rc) {
+            /* just disconnect from the supplier. bulk import is stopped when
+               connection object is destroyed */
+            slapi_pblock_get(pb, SLAPI_CONNECTION, &conn);
+            if (conn) {
+                slapi_disconnect_server(conn);
+            }
+        }
+        return rc;
+    }
 
     /* Decode the extended operation */
     rc = decode_total_update_extop(pb, &e);
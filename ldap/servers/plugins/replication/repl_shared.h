@@ -32,6 +32,7 @@
 #define CONFIG_CHANGELOG_MAXAGE_ATTRIBUTE "nsslapd-changelogmaxage"
 #define CONFIG_CHANGELOG_COMPACTDB_ATTRIBUTE "nsslapd-changelogcompactdb-interval"
 #define CONFIG_CHANGELOG_TRIM_ATTRIBUTE "nsslapd-changelogtrim-interval"
+#define CONFIG_CHANGELOG_COMPACT_MAXPAGES_ATTRIBUTE "nsslapd-changelogcompactdb-maxpages"
 /* Changelog Internal Configuration Parameters -> Changelog Cache related */
 #define CONFIG_CHANGELOG_ENCRYPTION_ALGORITHM "nsslapd-encryptionalgorithm"
 #define CONFIG_CHANGELOG_SYMMETRIC_KEY "nsSymmetricKey"
@@ -2122,3 +2122,153 @@ roles_cache_dump(caddr_t data, caddr_t arg __attribute__((unused)))
 
     return 0;
 }
+
+/* roles_cache_collect_nested
+   --------------------------
+   avl_apply callback gathering the DNs of the roles of a nested role
+ */
+static int
+roles_cache_collect_nested(caddr_t data, caddr_t arg)
+{
+    role_object_nested *nested_role = (role_object_nested *)data;
+    char ***ndns = (char ***)arg;
+
+    charray_add(ndns, slapi_ch_strdup(slapi_sdn_get_ndn(nested_role->dn)));
+    return 0;
+}
+
+/* roles_cache_role_filter
+   -----------------------
+   Build a filter matching at least the members of the role role_dn, out of
+   attributes that can be indexed: nsRoleDN for a managed role, nsRoleFilter
+   for a filtered role, and the or of those of its roles for a nested role.
+   The scope of the roles is not part of it, so it may match more entries.
+   Returns NULL if the role is unknown or too deeply nested.
+ */
+static Slapi_Filter *
+roles_cache_role_filter(Slapi_DN *role_dn, int depth)
+{
+    roles_cache_def *roles_cache = NULL;
+    role_object *this_role = NULL;
+    Slapi_Filter *filter = NULL;
+    char **nested_ndns = NULL;
+    char *filter_str = NULL;
+    int rc;
+
+    if (depth > MAX_NESTED_ROLES) {
+        return NULL;
+    }
+
+    slapi_rwlock_rdlock(global_lock);
+    rc = roles_cache_find_roles_in_suffix(role_dn, &roles_cache);
+    slapi_rwlock_unlock(global_lock);
+    if (rc != 0) {
+        return NULL;
+    }
+
+    /* do not hold the cache lock while following nested roles, they may be in the same cache */
+    slapi_rwlock_rdlock(roles_cache->cache_lock);
+    this_role = (role_object *)avl_find(roles_cache->avl_tree, role_dn, (IFP)roles_cache_find_node);
+    if (this_role != NULL) {
+        switch (this_role->type) {
+        case ROLE_TYPE_MANAGED:
+            filter_str = slapi_filter_sprintf("(%s=%s%s)", ROLE_MANAGED_ATTR_NAME, ESC_NEXT_VAL,
+                                              slapi_sdn_get_dn(this_role->dn));
+            filter = slapi_str2filter(filter_str);
+            slapi_ch_free_string(&filter_str);
+            break;
+        case ROLE_TYPE_FILTERED:
+            filter = slapi_filter_dup(this_role->filter);
+            break;
+        case ROLE_TYPE_NESTED:
+            avl_apply(this_role->avl_tree, (IFP)roles_cache_collect_nested, &nested_ndns, -1, AVL_INORDER);
+            break;
+        }
+    }
+    slapi_rwlock_unlock(roles_cache->cache_lock);
+
+    for (size_t i = 0; nested_ndns && nested_ndns[i]; i++) {
+        Slapi_DN *nested_dn = slapi_sdn_new_ndn_byref(nested_ndns[i]);
+        Slapi_Filter *nested_filter = roles_cache_role_filter(nested_dn, depth + 1);
+
+        slapi_sdn_free(&nested_dn);
+        if (nested_filter == NULL) {
+            /* cannot tell who the members are */
+            slapi_filter_free(filter, 1);
+            filter = NULL;
+            break;
+        }
+        filter = slapi_filter_join(LDAP_FILTER_OR, filter, nested_filter);
+    }
+    charray_free(nested_ndns);
+
+    return filter;
+}
+
+/* roles_cache_rewrite_nsrole
+   --------------------------
+   slapi_filter_apply callback turning (nsrole=<role dn>) into
+   (&(<filter of the role>)(nsrole=<role dn>)). The result is the same, but
+   the backend can take the candidates from the index of the first part
+   instead of computing nsrole for every entry in the scope.
+ */
+static int
+roles_cache_rewrite_nsrole(Slapi_Filter *f, void *arg __attribute__((unused)))
+{
+    Slapi_Filter *role_filter;
+    struct berval *bval = NULL;
+    char *type = NULL;
+    Slapi_DN *role_dn;
+
+    if (slapi_filter_get_choice(f) != LDAP_FILTER_EQUALITY ||
+        slapi_filter_get_ava(f, &type, &bval) != 0 ||
+        strcasecmp(type, NSROLEATTR) != 0 || bval->bv_val == NULL) {
+        return SLAPI_FILTER_SCAN_CONTINUE;
+    }
+
+    role_dn = slapi_sdn_new_dn_byval(bval->bv_val);
+    role_filter = roles_cache_role_filter(role_dn, 0);
+    if (role_filter != NULL && slapi_filter_narrow(f, role_filter) == 0) {
+        slapi_log_err(SLAPI_LOG_PLUGIN, ROLES_PLUGIN_SUBSYSTEM,
+                      "roles_cache_rewrite_nsrole - Narrowed (%s=%s)\n",
+                      NSROLEATTR, slapi_sdn_get_dn(role_dn));
+    }
+    slapi_sdn_free(&role_dn);
+
+    return SLAPI_FILTER_SCAN_CONTINUE;
+}
+
+/* roles_nsrole_filter_rewriter
+   ----------------------------
+   Search filter rewriter making nsrole filters indexed, see
+   roles_cache_rewrite_nsrole(). It is enabled with
+
+   dn: cn=nsrole,cn=rewriters,cn=config
+   objectClass: top
+   objectClass: extensibleObject
+   cn: nsrole
+   nsslapd-libpath: libroles-plugin
+   nsslapd-filterrewriter: roles_nsrole_filter_rewriter
+
+   nsRoleDN and the attributes of the nsRoleFilter of the filtered roles
+   should then be indexed. A role whose filter uses a virtual attribute,
+   such as nsrole or a CoS attribute, is left as it is. Role definitions are read from the roles cache,
+   which the plugin keeps current as roles are added, modified and deleted.
+ */
+int32_t
+roles_nsrole_filter_rewriter(Slapi_PBlock *pb)
+{
+    Slapi_Filter *filter = NULL;
+    int error_code = 0;
+    int rc;
+
+    slapi_pblock_get(pb, SLAPI_SEARCH_FILTER, &filter);
+    rc = slapi_filter_apply(filter, roles_cache_rewrite_nsrole, NULL, &error_code);
+    if (rc != SLAPI_FILTER_SCAN_NOMORE) {
+        slapi_log_err(SLAPI_LOG_ERR, ROLES_PLUGIN_SUBSYSTEM,
+                      "roles_nsrole_filter_rewriter - Could not update the search filter - error %d (%d)\n",
+                      rc, error_code);
+        return SEARCH_REWRITE_CALLBACK_ERROR;
+    }
+    return SEARCH_REWRITE_CALLBACK_CONTINUE;
+}
@@ -49,6 +49,7 @@ int roles_cache_listroles(Slapi_Entry *entry, int return_value, Slapi_ValueSet *
 int roles_cache_listroles_ext(vattr_context *c, Slapi_Entry *entry, int return_value, Slapi_ValueSet **valueset_out);
 
 int roles_check(Slapi_Entry *entry_to_check, Slapi_DN *role_dn, int *present);
+int32_t roles_nsrole_filter_rewriter(Slapi_PBlock *pb);
 
 /* From roles_plugin.c */
 int roles_init(Slapi_PBlock *pb);
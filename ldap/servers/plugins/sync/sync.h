@@ -30,7 +30,7 @@
 #define SYNC_BETXN_PREOP_DESC "content-sync-betxn-preop-subplugin"
 #define SYNC_BE_POSTOP_DESC "content-sync-be-post-subplugin"
 
-#define OP_FLAG_SYNC_PERSIST 0x01
+#define OP_FLAG_SYNC_PERSIST OP_FLAG_PS /* no entry of a persistent search is queued by flush_ber */
 
 #define E_SYNC_REFRESH_REQUIRED 0x1000
 
@@ -308,6 +308,13 @@ utf8string_validate(
     }
 
     for (p = begin; p <= end; p++) {
+        /* ASCII is always valid, skip it a word at a time */
+        while (end - p >= 7 && !swar_has_nonascii(swar_load(p))) {
+            p += 8;
+        }
+        if (p > end) {
+            break;
+        }
         if ((rc = utf8char_validate(p, end, &p)) != 0) {
             goto exit;
         }
@@ -72,6 +72,7 @@ value_normalize_ext(
 {
     char *head = s;
     char *d;
+    char *end;
     int prevspace, curspace;
 
     if (NULL == alt) {
@@ -144,7 +145,28 @@ value_normalize_ext(
         return;
     }
     prevspace = 0;
+    end = s + strlen(s);
     while (*s) {
+        /*
+         * Eight ASCII bytes without spaces, controls or telephone hyphens
+         * are copied (and lower cased) as is, the UTF-8 tables below are
+         * only needed for the rest.
+         */
+        if (end - s >= 8) {
+            uint64_t w = swar_load(s);
+            if (!swar_has_nonascii(w) && !swar_has_less(w, 0x0E) && !swar_has_byte(w, ' ') &&
+                !((syntax & SYNTAX_TEL) && swar_has_byte(w, '-'))) {
+                if (syntax & SYNTAX_CIS) {
+                    w = swar_ascii_tolower(w);
+                }
+                memcpy(d, &w, sizeof(w));
+                s += 8;
+                d += 8;
+                prevspace = 0;
+                continue;
+            }
+        }
+
         curspace = utf8isspace_fast(s);
 
         /* ignore spaces and '-' in telephone numbers */
@@ -0,0 +1,185 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/*
+ * arena.c
+ *
+ * A bump allocator for memory that all goes away at once, used for the
+ * transient allocations of an operation (see slapi_operation_arena_alloc()).
+ * Nothing is freed individually: arena_reset() releases everything, keeping
+ * the first chunk so that an operation taken from the operation stack does
+ * not go to malloc at all for the usual few KB it needs.
+ *
+ * An arena is used by the thread processing its operation only, it has no
+ * lock.
+ */
+
+#include "slap.h"
+
+#define ARENA_CHUNK_SIZE 8192
+#define ARENA_ALIGN 16
+#define ARENA_ALIGN_UP(n) (((n) + ARENA_ALIGN - 1) & ~((size_t)ARENA_ALIGN - 1))
+
+typedef struct arena_chunk
+{
+    struct arena_chunk *ac_next; /* next extra chunk */
+    size_t ac_size;              /* usable bytes in ac_data */
+    size_t ac_used;
+    char ac_data[] __attribute__((aligned(ARENA_ALIGN)));
+} arena_chunk;
+
+struct slapi_arena
+{
+    arena_chunk *a_first;        /* kept across resets */
+    arena_chunk *a_current;      /* chunk small allocations are cut from */
+    arena_chunk *a_extra;        /* chunks malloc'd since the last reset */
+    uint64_t a_bytes;            /* bytes handed out since the last reset */
+    uint64_t a_chunks_allocated; /* length of a_extra */
+};
+
+static arena_chunk *
+arena_chunk_new(size_t size)
+{
+    arena_chunk *chunk = (arena_chunk *)slapi_ch_malloc(sizeof(arena_chunk) + size);
+
+    chunk->ac_next = NULL;
+    chunk->ac_size = size;
+    chunk->ac_used = 0;
+    return chunk;
+}
+
+Slapi_Arena *
+arena_new(void)
+{
+    Slapi_Arena *arena = (Slapi_Arena *)slapi_ch_calloc(1, sizeof(Slapi_Arena));
+
+    arena->a_first = arena->a_current = arena_chunk_new(ARENA_CHUNK_SIZE);
+    return arena;
+}
+
+void *
+arena_alloc(Slapi_Arena *arena, size_t size)
+{
+    arena_chunk *chunk = arena->a_current;
+    void *p;
+
+    size = ARENA_ALIGN_UP(size ? size : 1);
+    if (chunk->ac_size - chunk->ac_used < size) {
+        if (size > ARENA_CHUNK_SIZE / 4) {
+            /* big requests get a chunk of their own, the current chunk
+             * keeps serving the small ones */
+            chunk = arena_chunk_new(size);
+        } else {
+            chunk = arena->a_current = arena_chunk_new(ARENA_CHUNK_SIZE);
+        }
+        chunk->ac_next = arena->a_extra;
+        arena->a_extra = chunk;
+        arena->a_chunks_allocated++;
+    }
+    p = chunk->ac_data + chunk->ac_used;
+    chunk->ac_used += size;
+    arena->a_bytes += size;
+    return p;
+}
+
+void *
+arena_calloc(Slapi_Arena *arena, size_t nelem, size_t size)
+{
+    void *p;
+
+    if (size && nelem > SIZE_MAX / size) {
+        slapi_log_err(SLAPI_LOG_ERR, "arena_calloc",
+                      "Allocation of %zu elements of %zu bytes overflows\n", nelem, size);
+        exit(1);
+    }
+    p = arena_alloc(arena, nelem * size);
+    memset(p, 0, nelem * size);
+    return p;
+}
+
+char *
+arena_strdup(Slapi_Arena *arena, const char *s)
+{
+    size_t len;
+    char *p;
+
+    if (s == NULL) {
+        return NULL;
+    }
+    len = strlen(s) + 1;
+    p = (char *)arena_alloc(arena, len);
+    memcpy(p, s, len);
+    return p;
+}
+
+char *
+arena_vsmprintf(Slapi_Arena *arena, const char *fmt, va_list ap)
+{
+    va_list ap2;
+    char *p;
+    int len;
+
+    va_copy(ap2, ap);
+    len = vsnprintf(NULL, 0, fmt, ap2);
+    va_end(ap2);
+    if (len < 0) {
+        return NULL;
+    }
+    p = (char *)arena_alloc(arena, (size_t)len + 1);
+    vsnprintf(p, (size_t)len + 1, fmt, ap);
+    return p;
+}
+
+/* bytes handed out since the last reset */
+uint64_t
+arena_get_bytes(const Slapi_Arena *arena)
+{
+    return arena ? arena->a_bytes : 0;
+}
+
+/* chunks that had to be malloc'd since the last reset */
+uint64_t
+arena_get_chunks(const Slapi_Arena *arena)
+{
+    return arena ? arena->a_chunks_allocated : 0;
+}
+
+/*
+ * Release all the allocations, keeping the first chunk for the next user.
+ */
+void
+arena_reset(Slapi_Arena *arena)
+{
+    if (arena == NULL) {
+        return;
+    }
+    while (arena->a_extra) {
+        arena_chunk *chunk = arena->a_extra;
+        arena->a_extra = chunk->ac_next;
+        slapi_ch_free((void **)&chunk);
+    }
+    arena->a_current = arena->a_first;
+    arena->a_first->ac_used = 0;
+    arena->a_bytes = 0;
+    arena->a_chunks_allocated = 0;
+}
+
+void
+arena_destroy(Slapi_Arena **arena)
+{
+    if (arena == NULL || *arena == NULL) {
+        return;
+    }
+    arena_reset(*arena);
+    slapi_ch_free((void **)&(*arena)->a_first);
+    slapi_ch_free((void **)arena);
+}
@@ -449,6 +449,19 @@ struct index_idlistsizeinfo
     Slapi_ValueSet *ai_values; /* index keys to apply the max id list size to */
 };
 
+/* index statistics slots, see index_stats.c */
+#define INDEX_STATS_EQUALITY 0
+#define INDEX_STATS_PRESENCE 1
+#define INDEX_STATS_APPROX   2
+#define INDEX_STATS_SUB      3
+#define INDEX_STATS_MAX      4
+
+typedef struct index_stats
+{
+    Slapi_Counter *is_keys; /* number of distinct keys, 0 until the index statistics task computes it */
+    Slapi_Counter *is_ids;  /* number of key/id pairs */
+} index_stats;
+
 /* for the cache of attribute information (which are indexed, etc.) */
 struct attrinfo
 {
@@ -499,6 +512,7 @@ struct attrinfo
                              */
     Slapi_Attr ai_sattr;                 /* interface to syntax and matching rule plugins */
     DataList *ai_idlistinfo;             /* fine grained id list */
+    index_stats ai_stats[INDEX_STATS_MAX]; /* key cardinality, used by the filter planner */
 };
 
 #define MAXDBCACHE 20
@@ -785,6 +799,7 @@ typedef struct _back_search_result_set
     int sr_flags;                 /* Magic flags, defined below */
     int sr_current_sizelimit;     /* Current sizelimit */
     Slapi_Filter *sr_norm_filter; /* search filter pre-normalized */
+    Slapi_FilterProgram *sr_filter_program; /* sr_norm_filter compiled for the filter test */
 } back_search_result_set;
 #define SR_FLAG_CAN_SKIP_FILTER_TEST 1 /* If set in sr_flags, means that we can safely skip the filter test */
 
@@ -1215,6 +1215,7 @@ entrycache_replace(struct cache *cache, struct backentry *olde, struct backentry
     /* adjust cache meta info */
     newe->ep_refcnt++;
     newe->ep_size = entry_size;
+    slapi_entry_set_flag(newe->ep_entry, SLAPI_ENTRY_CACHE_ENCODING);
     if (newe->ep_size > olde->ep_size) {
         slapi_counter_add(cache->c_cursize, newe->ep_size - olde->ep_size);
     } else if (newe->ep_size < olde->ep_size) {
@@ -1559,6 +1560,7 @@ entrycache_add_int(struct cache *cache, struct backentry *e, int state, struct b
     if (!already_in) {
         e->ep_refcnt = 1;
         e->ep_size = entry_size;
+        slapi_entry_set_flag(e->ep_entry, SLAPI_ENTRY_CACHE_ENCODING);
         slapi_counter_add(cache->c_cursize, e->ep_size);
         cache->c_curentries++;
         /* don't add to lru since refcnt = 1 */
@@ -2564,6 +2564,9 @@ bdb_rm_db_file(backend *be, struct attrinfo *a, PRBool use_lock, int no_force_ch
         bdb_force_checkpoint(li);
     }
 
+    /* the statistics describe the keys of the file removed */
+    index_stats_reset(a);
+
     if (0 == dblayer_get_index_file(be, a, &db, 0 /* Don't create an index file
                                                    if it does not exist. */)) {
         if (use_lock)
@@ -4308,6 +4311,13 @@ dblayer_delete_instance_dir(backend *be)
         return ret;
     } else {
         ldbm_instance *inst = (ldbm_instance *)be->be_instance_info;
+        struct attrinfo *a;
+
+        /* the statistics describe the indexes removed */
+        for (a = (struct attrinfo *)avl_getfirst(inst->inst_attrs); a;
+             a = (struct attrinfo *)avl_getnext()) {
+            index_stats_reset(a);
+        }
         return _dblayer_delete_instance_dir(inst, 0);
     }
 }
@@ -6174,6 +6184,14 @@ bdb_back_ctrl(Slapi_Backend *be, int cmd, void *info)
         slapi_pblock_destroy(pb);
         break;
     }
+    case BACK_INFO_METRICS: {
+        rc = bdb_monitor_metrics(be, (back_info_metrics *)info);
+        break;
+    }
+    case BACK_INFO_DBENV_METRICS: {
+        rc = bdb_monitor_dbenv_metrics(be, (back_info_dbenv_metrics *)info);
+        break;
+    }
     default:
         break;
     }
@@ -168,3 +168,5 @@ int bdb_monitor_search(Slapi_PBlock *pb, Slapi_Entry *e, Slapi_Entry *entryAfter
 int bdb_dbmonitor_search(Slapi_PBlock *pb, Slapi_Entry *e, Slapi_Entry *entryAfter, int *returncode, char *returntext, void *arg);
 int bdb_instance_register_monitor(ldbm_instance *inst);
 void bdb_instance_unregister_monitor(ldbm_instance *inst);
+int bdb_monitor_metrics(Slapi_Backend *be, back_info_metrics *metrics);
+int bdb_monitor_dbenv_metrics(Slapi_Backend *be, back_info_dbenv_metrics *metrics);
@@ -308,3 +308,60 @@ bdb_dbmonitor_search(Slapi_PBlock *pb __attribute__((unused)),
     *returncode = LDAP_SUCCESS;
     return SLAPI_DSE_CALLBACK_OK;
 }
+
+/*
+ * The numbers of the monitor entries above, for the metrics exporter that
+ * renders them without building an entry (BACK_INFO_METRICS).
+ */
+int
+bdb_monitor_metrics(Slapi_Backend *be, back_info_metrics *metrics)
+{
+    ldbm_instance *inst = (ldbm_instance *)be->be_instance_info;
+    back_info_cache_metrics *cm;
+
+    if (inst == NULL || be->be_state != BE_STATE_STARTED) {
+        return -1;
+    }
+
+    cm = &metrics->entry_cache;
+    cache_get_stats(&(inst->inst_cache), &cm->hits, &cm->tries,
+                    &cm->count, &cm->maxcount, &cm->size, &cm->maxsize);
+    metrics->has_dn_cache = entryrdn_get_switch() ? PR_TRUE : PR_FALSE;
+    if (metrics->has_dn_cache) {
+        cm = &metrics->dn_cache;
+        cache_get_stats(&(inst->inst_dncache), &cm->hits, &cm->tries,
+                        &cm->count, &cm->maxcount, &cm->size, &cm->maxsize);
+    }
+    return 0;
+}
+
+/* The database cache statistics, shared by all the backends (BACK_INFO_DBENV_METRICS) */
+int
+bdb_monitor_dbenv_metrics(Slapi_Backend *be, back_info_dbenv_metrics *metrics)
+{
+    struct ldbminfo *li = (struct ldbminfo *)be->be_database->plg_private;
+    DB_MPOOL_STAT *mpstat = NULL;
+    DB_MPOOL_FSTAT **mpfstat = NULL;
+
+    if (li == NULL || li->li_dblayer_private == NULL ||
+        li->li_dblayer_private->dblayer_env == NULL) {
+        return -1;
+    }
+    /* we have to ask for file stats in order to get correct global stats */
+    if (bdb_memp_stat(li, &mpstat, &mpfstat) != 0) {
+        return -1;
+    }
+
+    metrics->cache_hits = mpstat->st_cache_hit;
+    metrics->cache_misses = mpstat->st_cache_miss;
+    metrics->pages = mpstat->st_pages;
+    metrics->pages_dirty = mpstat->st_page_dirty;
+    metrics->page_in = mpstat->st_page_in;
+    metrics->page_out = mpstat->st_page_out;
+    metrics->ro_evict = mpstat->st_ro_evict;
+    metrics->rw_evict = mpstat->st_rw_evict;
+
+    slapi_ch_free((void **)&mpstat);
+    slapi_ch_free((void **)&mpfstat);
+    return 0;
+}
@@ -493,6 +493,9 @@ dblayer_instance_close(backend *be)
                       inst->inst_name);
     }
 
+    /* keep the statistics maintained since the start for the next one */
+    index_stats_save(inst);
+
     return_value = dblayer_close_indexes(be);
     return_value |= dblayer_close_changelog(be);
 
@@ -60,9 +60,17 @@ filter_candidates_ext(
     struct ldbminfo *li = (struct ldbminfo *)be->be_database->plg_private;
     IDList *result;
     int ftype;
+    Operation *op = NULL;
+    Op_Profile *profile = NULL;
+    struct timespec start;
 
     slapi_log_err(SLAPI_LOG_TRACE, "filter_candidates_ext", "=> \n");
 
+    slapi_pblock_get(pb, SLAPI_OPERATION, &op);
+    if ((profile = operation_get_profile(op))) {
+        clock_gettime(CLOCK_MONOTONIC, &start);
+    }
+
     if (!allidslimit) {
         allidslimit = compute_allids_limit(pb, li);
     }
@@ -144,6 +152,11 @@ filter_candidates_ext(
         break;
     }
 
+    if (profile && ftype != LDAP_FILTER_AND && ftype != LDAP_FILTER_OR) {
+        operation_profile_add_lookup(profile, f, IDL_NIDS(result), result && idl_is_allids(result),
+                                     operation_profile_usec(&start));
+    }
+
     slapi_log_err(SLAPI_LOG_TRACE, "filter_candidates_ext", "<= %lu\n",
                   (u_long)IDL_NIDS(result));
     return (result);
@@ -678,6 +691,204 @@ filter_is_subtype(Slapi_Filter *f)
     return issubtype;
 }
 
+/*
+ * Cost based ordering of the components of AND and OR filters.
+ *
+ * The number of candidates of each component is estimated from the
+ * index statistics (see index_stats.c). AND components are read from
+ * the most to the least selective one, so that the intersection
+ * shortcut triggers as early as possible, and a component is not read
+ * at all when reading it costs more than the entries it could remove
+ * from the candidate list: the filter test takes care of them.
+ * OR components are read from the least selective one, so that an
+ * allids component shortcuts the union before the others are read.
+ *
+ * Components are only reordered when all the estimates are known.
+ */
+
+/* number of ids read from an index that cost as much as testing one entry */
+#define FILTER_PLAN_ID_COST_RATIO 100
+
+typedef struct filter_plan_item
+{
+    Slapi_Filter *f;
+    uint64_t estimate; /* number of candidates */
+    uint64_t cost;     /* number of ids read from the indexes */
+} filter_plan_item;
+
+static int
+filter_plan_estimate(backend *be, Slapi_Filter *f, uint64_t allids, uint64_t *estimate, uint64_t *cost)
+{
+    struct attrinfo *ai = NULL;
+    uint64_t keys = 0;
+    uint64_t ids = 0;
+    char *type = NULL;
+    int indexmask = 0;
+    int slot = -1;
+    int choice = slapi_filter_get_choice(f);
+
+    switch (choice) {
+    case LDAP_FILTER_AND:
+    case LDAP_FILTER_OR: {
+        uint64_t e, c;
+
+        *estimate = (choice == LDAP_FILTER_AND) ? allids : 0;
+        *cost = 0;
+        for (Slapi_Filter *fi = slapi_filter_list_first(f); fi; fi = slapi_filter_list_next(f, fi)) {
+            if (!filter_plan_estimate(be, fi, allids, &e, &c)) {
+                return 0;
+            }
+            if (choice == LDAP_FILTER_AND) {
+                *estimate = (e < *estimate) ? e : *estimate;
+            } else {
+                *estimate = (*estimate + e < allids) ? *estimate + e : allids;
+            }
+            *cost += c;
+        }
+        return 1;
+    }
+    case LDAP_FILTER_NOT:
+        /* only (!(attr=value)) is read from the index, see list_candidates */
+        if (LDAP_FILTER_EQUALITY == slapi_filter_get_choice(slapi_filter_list_first(f)) &&
+            filter_plan_estimate(be, slapi_filter_list_first(f), allids, estimate, cost)) {
+            *estimate = (*estimate < allids) ? allids - *estimate : 0;
+        } else {
+            *estimate = allids;
+            *cost = 0;
+        }
+        return 1;
+    case LDAP_FILTER_EQUALITY:
+    case LDAP_FILTER_GE:
+    case LDAP_FILTER_LE:
+        indexmask = INDEX_EQUALITY;
+        slot = INDEX_STATS_EQUALITY;
+        break;
+    case LDAP_FILTER_APPROX:
+        indexmask = INDEX_APPROX;
+        slot = INDEX_STATS_APPROX;
+        break;
+    case LDAP_FILTER_SUBSTRINGS:
+        indexmask = INDEX_SUB;
+        slot = INDEX_STATS_SUB;
+        break;
+    case LDAP_FILTER_PRESENT:
+        indexmask = INDEX_PRESENCE;
+        slot = INDEX_STATS_PRESENCE;
+        break;
+    default:
+        /* extensible filters are not estimated */
+        return 0;
+    }
+
+    if (slapi_filter_get_attribute_type(f, &type) != 0 || type == NULL) {
+        return 0;
+    }
+    ainfo_get(be, type, &ai);
+    if (ai == NULL || (ai->ai_indexmask & INDEX_OFFLINE)) {
+        return 0;
+    }
+    if (!(ai->ai_indexmask & indexmask) || strchr(type, ';')) {
+        /* unindexed, the lookup returns allids without reading anything */
+        *estimate = allids;
+        *cost = 0;
+        return 1;
+    }
+    index_stats_get(ai, slot, &keys, &ids);
+    if (keys == 0) {
+        /* the statistics have not been computed yet */
+        return 0;
+    }
+    switch (choice) {
+    case LDAP_FILTER_PRESENT:
+        *estimate = ids;
+        break;
+    case LDAP_FILTER_GE:
+    case LDAP_FILTER_LE:
+        /* a range reads half of the index on average */
+        *estimate = ids / 2;
+        break;
+    default:
+        *estimate = (ids + keys - 1) / keys;
+        break;
+    }
+    *estimate = (*estimate < allids) ? *estimate : allids;
+    *cost = *estimate;
+    return 1;
+}
+
+/*
+ * Build the list of the components of flist, in the order they should
+ * be read. Returns 1 if the components have been ordered by their
+ * estimates, 0 if they are in the filter order.
+ */
+static int
+filter_plan_build(backend *be, Slapi_Filter *flist, int ftype, uint64_t allids, filter_plan_item **planp, size_t *countp)
+{
+    filter_plan_item *plan = NULL;
+    size_t count = 0;
+    int known = (ftype == LDAP_FILTER_AND || ftype == LDAP_FILTER_OR) && idl_get_idl_new();
+    Slapi_Filter *f;
+
+    for (f = slapi_filter_list_first(flist); f != NULL; f = slapi_filter_list_next(flist, f)) {
+        count++;
+    }
+    plan = (filter_plan_item *)slapi_ch_calloc(count ? count : 1, sizeof(filter_plan_item));
+    count = 0;
+    for (f = slapi_filter_list_first(flist); f != NULL; f = slapi_filter_list_next(flist, f)) {
+        plan[count].f = f;
+        if (known) {
+            known = filter_plan_estimate(be, f, allids, &plan[count].estimate, &plan[count].cost);
+        }
+        count++;
+    }
+
+    if (known && count > 1) {
+        /* stable insertion sort, ascending for AND and descending for OR */
+        for (size_t i = 1; i < count; i++) {
+            filter_plan_item item = plan[i];
+            size_t j = i;
+            while (j > 0 && ((ftype == LDAP_FILTER_AND) ? (plan[j - 1].estimate > item.estimate)
+                                                        : (plan[j - 1].estimate < item.estimate))) {
+                plan[j] = plan[j - 1];
+                j--;
+            }
+            plan[j] = item;
+        }
+        if (slapi_is_loglevel_set(SLAPI_LOG_FILTER)) {
+            char buf[BUFSIZ];
+            for (size_t i = 0; i < count; i++) {
+                slapi_log_err(SLAPI_LOG_FILTER, "filter_plan_build",
+                              "%s %lu: %s estimate=%" PRIu64 " cost=%" PRIu64 "\n",
+                              (ftype == LDAP_FILTER_AND) ? "AND" : "OR", (u_long)i,
+                              slapi_filter_to_string(plan[i].f, buf, sizeof(buf)),
+                              plan[i].estimate, plan[i].cost);
+            }
+        }
+    }
+
+    *planp = plan;
+    *countp = count;
+    return known && count > 1;
+}
+
+/*
+ * Whether a component of an AND is not worth reading: the ids it
+ * costs to read are compared to the entries it is expected to remove
+ * from the current candidates, assuming the components are independent.
+ */
+static int
+filter_plan_skip(IDListSet *idl_set, filter_plan_item *item, uint64_t allids)
+{
+    int64_t candidates = idl_set_minimum_size(idl_set);
+    uint64_t removed;
+
+    if (candidates < 0 || allids == 0 || item->cost == 0) {
+        return 0;
+    }
+    removed = (uint64_t)candidates - ((uint64_t)candidates * item->estimate) / allids;
+    return item->cost > removed * FILTER_PLAN_ID_COST_RATIO;
+}
+
 static IDList *
 list_candidates(
     Slapi_PBlock *pb,
@@ -690,7 +901,7 @@ list_candidates(
 {
     IDList *idl;
     IDList *tmp;
-    Slapi_Filter *f, *nextf, *f_head;
+    Slapi_Filter *f, *nextf;
     int range = 0;
     int isnot;
     int f_count = 0, le_count = 0, ge_count = 0, is_bounded_range = 1;
@@ -701,6 +912,11 @@ list_candidates(
     struct berval *vpairs[2] = {NULL, NULL};
     int is_and = 0;
     IDListSet *idl_set = NULL;
+    filter_plan_item *plan = NULL;
+    size_t plan_count = 0;
+    int planned = 0;
+    int skipped = 0;
+    uint64_t allids = 0;
 
     slapi_log_err(SLAPI_LOG_TRACE, "list_candidates", "=> 0x%x\n", ftype);
 
@@ -798,11 +1014,23 @@ list_candidates(
         idl_set = idl_set_create();
     }
 
+    allids = (uint64_t)((ldbm_instance *)be->be_instance_info)->inst_nextid;
+    planned = filter_plan_build(be, flist, ftype, allids, &plan, &plan_count);
+
     idl = NULL;
     nextf = NULL;
     isnot = 0;
-    for (f_head = f = slapi_filter_list_first(flist); f != NULL;
-         f = slapi_filter_list_next(flist, f)) {
+    for (size_t i = 0; i < plan_count; i++) {
+        f = plan[i].f;
+
+        if (planned && ftype == LDAP_FILTER_AND && i > 0 &&
+            filter_plan_skip(idl_set, &plan[i], allids)) {
+            slapi_log_err(SLAPI_LOG_FILTER, "list_candidates",
+                          "Skipping AND component %lu, estimate=%" PRIu64 " cost=%" PRIu64 "\n",
+                          (u_long)i, plan[i].estimate, plan[i].cost);
+            skipped = 1;
+            continue;
+        }
 
         /* Look for NOT foo type filter elements where foo is simple equality */
         isnot = (LDAP_FILTER_NOT == slapi_filter_get_choice(f)) &&
@@ -814,7 +1042,7 @@ list_candidates(
              * If this is the first filter, make sure we have something to
              * subtract from.
              */
-            if (f == f_head) {
+            if (i == 0) {
                 idl = idl_allids(be);
                 idl_set_insert_idl(idl_set, idl);
             }
@@ -910,6 +1138,12 @@ list_candidates(
      */
 apply_set_op:
 
+    if (skipped) {
+        /* the candidates are a superset of the matching entries */
+        slapi_be_set_flag(be, SLAPI_BE_FLAG_DONT_BYPASS_FILTERTEST);
+        slapi_pblock_set_flag_operation_notes(pb, SLAPI_OP_NOTE_INDEX_SKIPPED);
+    }
+
     if (ftype == LDAP_FILTER_OR) {
         /* If one of the idl_set is allids, this shortcuts :) */
         idl = idl_set_union(idl_set, be);
@@ -924,13 +1158,24 @@ apply_set_op:
             }
         }
     } else if (ftype == LDAP_FILTER_AND) {
+        Operation *op = NULL;
+        Op_Profile *profile = NULL;
+
+        slapi_pblock_get(pb, SLAPI_OPERATION, &op);
+        if ((profile = operation_get_profile(op))) {
+            profile->opp_intersect_in += idl_set->total_size;
+        }
         idl = idl_set_intersect(idl_set, be);
+        if (profile) {
+            profile->opp_intersect_out += IDL_NIDS(idl);
+        }
     }
 
     slapi_log_err(SLAPI_LOG_TRACE, "list_candidates", "<= %lu\n",
                   (u_long)IDL_NIDS(idl));
 out:
     idl_set_destroy(idl_set);
+    slapi_ch_free((void **)&plan);
     if (is_and) {
         /*
          * Sets IS_AND back to 0 only when this function set 1.
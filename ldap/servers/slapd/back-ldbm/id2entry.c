@@ -247,8 +247,12 @@ id2entry_delete(backend *be, struct backentry *e, back_txn *txn)
     return (rc);
 }
 
+/*
+ * Like id2entry, cache_hit (if not NULL) is set to 1 when the entry
+ * was found in the entry cache, 0 when it was read from id2entry.
+ */
 struct backentry *
-id2entry(backend *be, ID id, back_txn *txn, int *err)
+id2entry_ext(backend *be, ID id, back_txn *txn, int *err, int *cache_hit)
 {
     ldbm_instance *inst = (ldbm_instance *)be->be_instance_info;
     DB *db = NULL;
@@ -262,10 +266,16 @@ id2entry(backend *be, ID id, back_txn *txn, int *err)
     slapi_log_err(SLAPI_LOG_TRACE, ID2ENTRY,
                   "=> id2entry(%lu)\n", (u_long)id);
 
+    if (cache_hit) {
+        *cache_hit = 0;
+    }
     if ((e = cache_find_id(&inst->inst_cache, id)) != NULL) {
         slapi_log_err(SLAPI_LOG_TRACE, ID2ENTRY,
                       "<= id2entry %p, dn \"%s\" (cache)\n",
                       e, backentry_get_ndn(e));
+        if (cache_hit) {
+            *cache_hit = 1;
+        }
         goto bail;
     }
 
@@ -461,3 +471,9 @@ bail:
                   "<= id2entry( %lu ) %p (disk)\n", (u_long)id, e);
     return (e);
 }
+
+struct backentry *
+id2entry(backend *be, ID id, back_txn *txn, int *err)
+{
+    return id2entry_ext(be, id, txn, err, NULL);
+}
@@ -681,15 +681,15 @@ idl_new_insert_key(
     DBT *key,
     ID id,
     DB_TXN *txn,
-    struct attrinfo *a __attribute__((unused)),
+    struct attrinfo *a,
     int *disposition)
 {
     int ret = 0;
     DBT data;
-
-#if defined(DB_ALLIDS_ON_WRITE)
     DBC *cursor = NULL;
     db_recno_t count;
+
+#if defined(DB_ALLIDS_ON_WRITE)
     ID tmpid = 0;
     /* Make a cursor */
     ret = db->cursor(db, txn, &cursor, 0);
@@ -737,6 +737,9 @@ idl_new_insert_key(
                           (char *)key->data);
             goto error;
         }
+        if (count == 1) {
+            index_stats_update_keys(a, key, 1);
+        }
         if ((size_t)count > idl_new_get_allidslimit(a, 0)) {
             slapi_log_err(SLAPI_LOG_TRACE, "idl_new_insert_key", "allidslimit exceeded for key %s\n",
                           (char *)key->data);
@@ -767,7 +770,13 @@ idl_new_insert_key(
         *disposition = IDL_INSERT_NORMAL;
     }
 
-    ret = db->put(db, txn, key, &data, DB_NODUPDATA);
+    /* insert through a cursor, so that a new key can be counted */
+    ret = db->cursor(db, txn, &cursor, 0);
+    if (0 != ret) {
+        ldbm_nasty("idl_new_insert_key", filename, 61, ret);
+        return ret;
+    }
+    ret = cursor->c_put(cursor, key, &data, DB_NODUPDATA);
     if (0 != ret) {
         if (DB_KEYEXIST == ret) {
             /* this is okay */
@@ -775,6 +784,18 @@ idl_new_insert_key(
         } else {
             ldbm_nasty("idl_new_insert_key", filename, 60, ret);
         }
+    } else if (cursor->c_count(cursor, &count, 0) == 0 && count == 1) {
+        index_stats_update_keys(a, key, 1);
+    }
+    {
+        int ret2 = cursor->c_close(cursor);
+        if (ret2) {
+            ldbm_nasty("idl_new_insert_key", filename, 62, ret2);
+            if (!ret) {
+                /* a DEADLOCK must be bubbled up to the higher layers for retries */
+                ret = ret2;
+            }
+        }
     }
 #endif
 
@@ -787,11 +808,12 @@ idl_new_insert_key(
         DBT * key,
         ID id,
         DB_TXN * txn,
-        struct attrinfo * a __attribute__((unused)))
+        struct attrinfo * a)
     {
         int ret = 0;
         DBC *cursor = NULL;
         DBT data = {0};
+        db_recno_t count = 0;
 
         /* Make a cursor */
         ret = db->cursor(db, txn, &cursor, 0);
@@ -819,7 +841,14 @@ idl_new_insert_key(
             goto error;
         }
         /* We found it, so delete it */
+        if (cursor->c_count(cursor, &count, 0) != 0) {
+            count = 0;
+        }
         ret = cursor->c_del(cursor, 0);
+        if (0 == ret && count == 1) {
+            /* that was the last id of the key */
+            index_stats_update_keys(a, key, 0);
+        }
     error:
         /* Close the cursor */
         if (NULL != cursor) {
@@ -245,6 +245,20 @@ idl_set_intersection_shortcut(IDListSet *idl_set)
     return 0;
 }
 
+/*
+ * The size of the smallest list inserted so far, which is the upper
+ * bound of an intersection. Returns -1 if no list (or only allids) has
+ * been inserted.
+ */
+int64_t
+idl_set_minimum_size(IDListSet *idl_set)
+{
+    if (idl_set->minimum == NULL) {
+        return -1;
+    }
+    return (int64_t)idl_set->minimum->b_nids;
+}
+
 IDList *
 idl_set_union(IDListSet *idl_set, backend *be)
 {
@@ -1857,6 +1857,8 @@ addordel_values_sv(
 
         if (rc != 0) {
             ldbm_nasty("addordel_values_sv", errmsg, 1120, rc);
+        } else {
+            index_stats_update(a, indextype, flags & BE_INDEX_ADD, 1);
         }
         if (NULL != key.dptr && prefix != key.dptr) {
             slapi_ch_free((void **)&key.dptr);
@@ -1956,6 +1958,8 @@ addordel_values_sv(
 
     if (rc != 0) {
         ldbm_nasty("addordel_values_sv", errmsg, 1140, rc);
+    } else {
+        index_stats_update(a, indextype, flags & BE_INDEX_ADD, i);
     }
     slapi_log_err(SLAPI_LOG_TRACE, "addordel_values_sv", "%s_values %d\n",
                   (flags & BE_INDEX_ADD) ? "add" : "del", rc);
@@ -0,0 +1,605 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2020 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/*
+ * index_stats.c - index key cardinality statistics
+ *
+ * For every index type of an attribute we keep the number of distinct
+ * keys and the number of key/id pairs. The filter planner (see
+ * list_candidates) uses them to estimate how many candidates a filter
+ * component returns, and orders the components of AND and OR filters
+ * accordingly.
+ *
+ * Both values are maintained as the index is updated: the number of
+ * key/id pairs by index_addordel_values_sv, the number of keys by
+ * idl_new_insert_key and idl_new_delete_key, which see a key appear or
+ * disappear. They are estimates: adding a pair that already exists, or an
+ * aborted transaction, are still counted. The number of keys is only
+ * maintained once it is known, 0 meaning unknown: it is computed, with the
+ * number of pairs, by the "index statistics" task, which walks the index
+ * files:
+ *
+ *  dn: cn=stats,cn=index statistics,cn=tasks,cn=config
+ *  objectclass: top
+ *  objectclass: extensibleObject
+ *  cn: stats
+ *  nsInstance: userRoot
+ *
+ * nsInstance is optional and may be repeated. If it is absent the
+ * statistics of all the backends are refreshed.
+ *
+ * The statistics are saved in the INDEX_STATS_FILE of the instance
+ * directory when the task completes and when the instance is closed, and
+ * loaded when the instance starts, so that they survive a restart:
+ *
+ *  <attribute type> <slot> <keys> <ids>
+ */
+
+#include "back-ldbm.h"
+
+#define INDEX_STATS_TASK_INSTANCE "nsInstance"
+#define INDEX_STATS_FILE "index_stats"
+#define INDEX_STATS_LINE_MAX 1024
+
+extern const char *indextype_PRESENCE;
+extern const char *indextype_EQUALITY;
+extern const char *indextype_APPROX;
+extern const char *indextype_SUB;
+
+struct index_stats_task_data
+{
+    struct ldbminfo *li;
+    char **instances;
+};
+
+static void index_stats_task_destructor(Slapi_Task *task);
+
+void
+index_stats_init(struct attrinfo *a)
+{
+    for (size_t i = 0; i < INDEX_STATS_MAX; i++) {
+        a->ai_stats[i].is_keys = slapi_counter_new();
+        a->ai_stats[i].is_ids = slapi_counter_new();
+    }
+}
+
+/*
+ * Forget the statistics of an index whose file is removed, e.g. by an
+ * import or a reindex.
+ */
+void
+index_stats_reset(struct attrinfo *a)
+{
+    for (size_t i = 0; i < INDEX_STATS_MAX; i++) {
+        slapi_counter_set_value(a->ai_stats[i].is_keys, 0);
+        slapi_counter_set_value(a->ai_stats[i].is_ids, 0);
+    }
+}
+
+void
+index_stats_destroy(struct attrinfo *a)
+{
+    for (size_t i = 0; i < INDEX_STATS_MAX; i++) {
+        slapi_counter_destroy(&a->ai_stats[i].is_keys);
+        slapi_counter_destroy(&a->ai_stats[i].is_ids);
+    }
+}
+
+/*
+ * Returns the statistics slot of an index type, or -1 if the type
+ * (matching rule indexes) is not tracked.
+ */
+int
+index_stats_slot(const char *indextype)
+{
+    if (indextype == NULL) {
+        return -1;
+    } else if (strcmp(indextype, indextype_EQUALITY) == 0) {
+        return INDEX_STATS_EQUALITY;
+    } else if (strcmp(indextype, indextype_PRESENCE) == 0) {
+        return INDEX_STATS_PRESENCE;
+    } else if (strcmp(indextype, indextype_APPROX) == 0) {
+        return INDEX_STATS_APPROX;
+    } else if (strcmp(indextype, indextype_SUB) == 0) {
+        return INDEX_STATS_SUB;
+    }
+    return -1;
+}
+
+static int
+index_stats_slot_from_prefix(char prefix)
+{
+    switch (prefix) {
+    case EQ_PREFIX:
+        return INDEX_STATS_EQUALITY;
+    case PRES_PREFIX:
+        return INDEX_STATS_PRESENCE;
+    case APPROX_PREFIX:
+        return INDEX_STATS_APPROX;
+    case SUB_PREFIX:
+        return INDEX_STATS_SUB;
+    default:
+        return -1;
+    }
+}
+
+/*
+ * Account for count key/id pairs added to or deleted from an index.
+ */
+void
+index_stats_update(struct attrinfo *a, const char *indextype, int add, uint64_t count)
+{
+    int slot = index_stats_slot(indextype);
+    Slapi_Counter *ids;
+
+    if (slot < 0 || count == 0) {
+        return;
+    }
+    ids = a->ai_stats[slot].is_ids;
+    if (add) {
+        slapi_counter_add(ids, count);
+    } else if (slapi_counter_get_value(ids) >= count) {
+        slapi_counter_subtract(ids, count);
+    } else {
+        slapi_counter_set_value(ids, 0);
+    }
+}
+
+/*
+ * Account for a key added to (first id of the key) or deleted from (last
+ * id of the key) an index. Nothing is counted while the number of keys is
+ * unknown, it would be taken for the whole count.
+ */
+void
+index_stats_update_keys(struct attrinfo *a, const DBT *key, int add)
+{
+    Slapi_Counter *keys;
+    int slot;
+
+    if (a == NULL || key->size == 0 ||
+        (slot = index_stats_slot_from_prefix(*(char *)key->data)) < 0) {
+        return;
+    }
+    keys = a->ai_stats[slot].is_keys;
+    if (slapi_counter_get_value(keys) == 0) {
+        return;
+    }
+    if (add) {
+        slapi_counter_increment(keys);
+    } else {
+        slapi_counter_decrement(keys);
+    }
+}
+
+/*
+ * Get the statistics of an index type. keys is 0 if the statistics
+ * have not been computed yet.
+ */
+void
+index_stats_get(struct attrinfo *a, int slot, uint64_t *keys, uint64_t *ids)
+{
+    *keys = slapi_counter_get_value(a->ai_stats[slot].is_keys);
+    *ids = slapi_counter_get_value(a->ai_stats[slot].is_ids);
+}
+
+/*
+ * Walk the index file of an attribute and recompute its statistics.
+ * Only the new idl format, where each id is a duplicate of the key,
+ * can be counted this way.
+ */
+static int
+index_stats_refresh_attr(backend *be, struct attrinfo *a)
+{
+    uint64_t keys[INDEX_STATS_MAX] = {0};
+    uint64_t ids[INDEX_STATS_MAX] = {0};
+    DB *db = NULL;
+    DBC *cursor = NULL;
+    DBT key = {0};
+    DBT data = {0};
+    db_recno_t count;
+    int rc;
+
+    rc = dblayer_get_index_file(be, a, &db, 0);
+    if (rc != 0) {
+        /* the index has not been created yet */
+        return 0;
+    }
+    rc = db->cursor(db, NULL, &cursor, 0);
+    if (rc != 0) {
+        slapi_log_err(SLAPI_LOG_ERR, "index_stats_refresh_attr",
+                      "%s: Failed to create a cursor on the %s index, error %d\n",
+                      be->be_name, a->ai_type, rc);
+        dblayer_release_index_file(be, a, db);
+        return rc;
+    }
+
+    key.flags = DB_DBT_REALLOC;
+    /* only the keys are needed */
+    data.flags = DB_DBT_PARTIAL | DB_DBT_USERMEM;
+
+    for (rc = cursor->c_get(cursor, &key, &data, DB_FIRST);
+         rc == 0;
+         rc = cursor->c_get(cursor, &key, &data, DB_NEXT_NODUP)) {
+        int slot;
+
+        if (slapi_is_shutting_down()) {
+            rc = -1;
+            break;
+        }
+        if (key.size == 0 || (slot = index_stats_slot_from_prefix(*(char *)key.data)) < 0) {
+            continue;
+        }
+        if ((rc = cursor->c_count(cursor, &count, 0)) != 0) {
+            break;
+        }
+        keys[slot]++;
+        ids[slot] += count;
+    }
+    slapi_ch_free(&key.data);
+    cursor->c_close(cursor);
+    dblayer_release_index_file(be, a, db);
+
+    if (rc != DB_NOTFOUND) {
+        slapi_log_err(SLAPI_LOG_ERR, "index_stats_refresh_attr",
+                      "%s: Failed to read the %s index, error %d\n",
+                      be->be_name, a->ai_type, rc);
+        return rc;
+    }
+
+    for (size_t i = 0; i < INDEX_STATS_MAX; i++) {
+        slapi_counter_set_value(a->ai_stats[i].is_keys, keys[i]);
+        slapi_counter_set_value(a->ai_stats[i].is_ids, ids[i]);
+    }
+    slapi_log_err(SLAPI_LOG_BACKLDBM, "index_stats_refresh_attr",
+                  "%s: %s eq=%" PRIu64 "/%" PRIu64 " pres=%" PRIu64 " sub=%" PRIu64 "/%" PRIu64 " approx=%" PRIu64 "/%" PRIu64 "\n",
+                  be->be_name, a->ai_type,
+                  ids[INDEX_STATS_EQUALITY], keys[INDEX_STATS_EQUALITY],
+                  ids[INDEX_STATS_PRESENCE],
+                  ids[INDEX_STATS_SUB], keys[INDEX_STATS_SUB],
+                  ids[INDEX_STATS_APPROX], keys[INDEX_STATS_APPROX]);
+    return 0;
+}
+
+struct index_stats_walk
+{
+    backend *be;
+    struct attrinfo **attrs;
+    size_t count;
+    size_t max;
+};
+
+static int
+index_stats_collect_attr(caddr_t data, caddr_t arg)
+{
+    struct attrinfo *a = (struct attrinfo *)data;
+    struct index_stats_walk *walk = (struct index_stats_walk *)arg;
+
+    if (!(a->ai_indexmask & (INDEX_PRESENCE | INDEX_EQUALITY | INDEX_APPROX | INDEX_SUB)) ||
+        (a->ai_indexmask & INDEX_OFFLINE) ||
+        strcasecmp(a->ai_type, LDBM_ENTRYRDN_STR) == 0) {
+        return 0;
+    }
+    if (walk->count == walk->max) {
+        walk->max = walk->max ? walk->max * 2 : 32;
+        walk->attrs = (struct attrinfo **)slapi_ch_realloc((char *)walk->attrs,
+                                                           walk->max * sizeof(struct attrinfo *));
+    }
+    walk->attrs[walk->count++] = a;
+    return 0;
+}
+
+static char *
+index_stats_filename(ldbm_instance *inst)
+{
+    char inst_dir[MAXPATHLEN];
+    char *inst_dirp;
+    char *filename = NULL;
+
+    inst_dirp = dblayer_get_full_inst_dir(inst->inst_li, inst, inst_dir, MAXPATHLEN);
+    if (inst_dirp && *inst_dirp) {
+        filename = slapi_ch_smprintf("%s/%s", inst_dirp, INDEX_STATS_FILE);
+    }
+    if (inst_dirp != inst_dir) {
+        slapi_ch_free_string(&inst_dirp);
+    }
+    return filename;
+}
+
+/*
+ * Save the statistics of all the indexes of a backend instance. The file
+ * is written aside and renamed, so that a crash leaves the previous one.
+ */
+int
+index_stats_save(ldbm_instance *inst)
+{
+    struct index_stats_walk walk = {0};
+    char line[INDEX_STATS_LINE_MAX];
+    char *filename;
+    char *tmpname;
+    PRFileDesc *prfd;
+    int rc = 0;
+
+    if (!idl_get_idl_new() || (filename = index_stats_filename(inst)) == NULL) {
+        return 0;
+    }
+    tmpname = slapi_ch_smprintf("%s.tmp", filename);
+
+    prfd = PR_Open(tmpname, PR_WRONLY | PR_CREATE_FILE | PR_TRUNCATE, SLAPD_DEFAULT_FILE_MODE);
+    if (prfd == NULL) {
+        slapi_log_err(SLAPI_LOG_ERR, "index_stats_save",
+                      "Could not open file \"%s\" for writing " SLAPI_COMPONENT_NAME_NSPR " %d (%s)\n",
+                      tmpname, PR_GetError(), slapd_pr_strerror(PR_GetError()));
+        rc = -1;
+        goto done;
+    }
+
+    walk.be = inst->inst_be;
+    avl_apply(inst->inst_attrs, (IFP)index_stats_collect_attr, (caddr_t)&walk, -1, AVL_INORDER);
+    for (size_t i = 0; i < walk.count && rc == 0; i++) {
+        for (int slot = 0; slot < INDEX_STATS_MAX; slot++) {
+            uint64_t keys, ids;
+            PRInt32 len;
+
+            index_stats_get(walk.attrs[i], slot, &keys, &ids);
+            if (keys == 0) {
+                /* unknown */
+                continue;
+            }
+            len = (PRInt32)PR_snprintf(line, sizeof(line), "%s %d %" PRIu64 " %" PRIu64 "\n",
+                                       walk.attrs[i]->ai_type, slot, keys, ids);
+            if (slapi_write_buffer(prfd, line, len) != len) {
+                slapi_log_err(SLAPI_LOG_ERR, "index_stats_save",
+                              "Could not write to file \"%s\"\n", tmpname);
+                rc = -1;
+                break;
+            }
+        }
+    }
+    slapi_ch_free((void **)&walk.attrs);
+    (void)PR_Close(prfd);
+
+    if (rc == 0 && rename(tmpname, filename) != 0) {
+        slapi_log_err(SLAPI_LOG_ERR, "index_stats_save",
+                      "Could not rename \"%s\" to \"%s\", error %d\n", tmpname, filename, errno);
+        rc = -1;
+    }
+    if (rc != 0) {
+        (void)PR_Delete(tmpname);
+    }
+done:
+    slapi_ch_free_string(&tmpname);
+    slapi_ch_free_string(&filename);
+    return rc;
+}
+
+/*
+ * Load the statistics saved by index_stats_save. A missing file is not an
+ * error: the statistics are then unknown until the task runs. The lines of
+ * the indexes that are no longer configured are ignored.
+ */
+int
+index_stats_load(ldbm_instance *inst)
+{
+    PRFileInfo64 info;
+    PRFileDesc *prfd;
+    char *filename;
+    char *buf = NULL;
+    char *line;
+    char *iter = NULL;
+    size_t loaded = 0;
+    int rc = 0;
+
+    if (!idl_get_idl_new() || (filename = index_stats_filename(inst)) == NULL) {
+        return 0;
+    }
+    if (PR_GetFileInfo64(filename, &info) != PR_SUCCESS ||
+        (prfd = PR_Open(filename, PR_RDONLY, SLAPD_DEFAULT_FILE_MODE)) == NULL) {
+        slapi_ch_free_string(&filename);
+        return 0;
+    }
+
+    buf = slapi_ch_malloc(info.size + 1);
+    if (slapi_read_buffer(prfd, buf, (PRInt32)info.size) != (PRInt32)info.size) {
+        slapi_log_err(SLAPI_LOG_ERR, "index_stats_load",
+                      "Could not read file \"%s\"\n", filename);
+        rc = -1;
+        goto done;
+    }
+    buf[info.size] = '\0';
+
+    for (line = ldap_utf8strtok_r(buf, "\n", &iter); line; line = ldap_utf8strtok_r(NULL, "\n", &iter)) {
+        struct attrinfo *a = NULL;
+        char *sep = strchr(line, ' ');
+        uint64_t keys, ids;
+        int slot;
+
+        if (sep == NULL) {
+            continue;
+        }
+        *sep++ = '\0';
+        if (sscanf(sep, "%d %" SCNu64 " %" SCNu64, &slot, &keys, &ids) != 3 ||
+            slot < 0 || slot >= INDEX_STATS_MAX) {
+            continue;
+        }
+        ainfo_get(inst->inst_be, line, &a);
+        if (a == NULL || strcasecmp(a->ai_type, line) != 0) {
+            continue;
+        }
+        slapi_counter_set_value(a->ai_stats[slot].is_keys, keys);
+        slapi_counter_set_value(a->ai_stats[slot].is_ids, ids);
+        loaded++;
+    }
+    slapi_log_err(SLAPI_LOG_BACKLDBM, "index_stats_load",
+                  "%s: Loaded the statistics of %lu indexes\n", inst->inst_name, (u_long)loaded);
+done:
+    (void)PR_Close(prfd);
+    slapi_ch_free_string(&buf);
+    slapi_ch_free_string(&filename);
+    return rc;
+}
+
+/*
+ * Recompute the statistics of all the indexes of a backend instance.
+ */
+int
+index_stats_refresh(ldbm_instance *inst, Slapi_Task *task)
+{
+    struct index_stats_walk walk = {0};
+    int rc = 0;
+
+    if (!idl_get_idl_new()) {
+        if (task) {
+            slapi_task_log_notice(task, "%s: Index statistics require the new idl format\n",
+                                  inst->inst_name);
+        }
+        return 0;
+    }
+
+    walk.be = inst->inst_be;
+    /* collect the indexes first, reading them can take a while */
+    avl_apply(inst->inst_attrs, (IFP)index_stats_collect_attr, (caddr_t)&walk, -1, AVL_INORDER);
+
+    for (size_t i = 0; i < walk.count && rc == 0; i++) {
+        rc = index_stats_refresh_attr(inst->inst_be, walk.attrs[i]);
+    }
+    slapi_ch_free((void **)&walk.attrs);
+    if (rc == 0) {
+        rc = index_stats_save(inst);
+    }
+
+    if (task) {
+        slapi_task_log_notice(task, "%s: %s the statistics of %lu indexes\n",
+                              inst->inst_name, rc ? "Failed to refresh" : "Refreshed", (u_long)walk.count);
+    }
+    return rc;
+}
+
+static void
+index_stats_task_thread(void *arg)
+{
+    Slapi_Task *task = (Slapi_Task *)arg;
+    struct index_stats_task_data *td = (struct index_stats_task_data *)slapi_task_get_data(task);
+    int count = 0;
+    int rc = 0;
+
+    while (td->instances && td->instances[count]) {
+        count++;
+    }
+    slapi_task_inc_refcount(task);
+    slapi_task_begin(task, count);
+    slapi_task_log_notice(task, "Beginning index statistics task...\n");
+
+    for (size_t i = 0; td->instances && td->instances[i] && rc == 0; i++) {
+        ldbm_instance *inst = ldbm_instance_find_by_name(td->li, td->instances[i]);
+
+        if (inst == NULL) {
+            slapi_task_log_notice(task, "Unknown backend %s\n", td->instances[i]);
+            rc = -1;
+            break;
+        }
+        /* do not race with an import or a reindex of the backend */
+        if (instance_set_busy(inst) != 0) {
+            slapi_task_log_notice(task, "Backend %s is busy with another task\n", inst->inst_name);
+            rc = -1;
+            break;
+        }
+        rc = index_stats_refresh(inst, task);
+        instance_set_not_busy(inst);
+        slapi_task_inc_progress(task);
+    }
+
+    slapi_task_log_notice(task, "Index statistics task %s.\n", rc ? "failed" : "finished");
+    slapi_task_finish(task, rc);
+    slapi_task_dec_refcount(task);
+}
+
+/*
+ * Add callback of the "index statistics" task entry.
+ */
+int
+ldbm_index_stats_task_add(Slapi_PBlock *pb __attribute__((unused)),
+                          Slapi_Entry *e,
+                          Slapi_Entry *eAfter __attribute__((unused)),
+                          int *returncode,
+                          char *returntext,
+                          void *arg)
+{
+    struct index_stats_task_data *td = NULL;
+    struct ldbminfo *li = NULL;
+    Slapi_Task *task = NULL;
+    PRThread *thread = NULL;
+    char **instances = NULL;
+
+    *returncode = LDAP_SUCCESS;
+    slapi_pblock_get((Slapi_PBlock *)arg, SLAPI_PLUGIN_PRIVATE, &li);
+    if (li == NULL) {
+        *returncode = LDAP_OPERATIONS_ERROR;
+        return SLAPI_DSE_CALLBACK_ERROR;
+    }
+
+    if ((instances = slapi_entry_attr_get_charray(e, INDEX_STATS_TASK_INSTANCE))) {
+        for (size_t i = 0; instances[i]; i++) {
+            if (ldbm_instance_find_by_name(li, instances[i]) == NULL) {
+                PR_snprintf(returntext, SLAPI_DSE_RETURNTEXT_SIZE,
+                            "Unknown backend (%s)", instances[i]);
+                slapi_ch_array_free(instances);
+                *returncode = LDAP_UNWILLING_TO_PERFORM;
+                return SLAPI_DSE_CALLBACK_ERROR;
+            }
+        }
+    } else {
+        Object *inst_obj;
+
+        for (inst_obj = objset_first_obj(li->li_instance_set); inst_obj;
+             inst_obj = objset_next_obj(li->li_instance_set, inst_obj)) {
+            ldbm_instance *inst = (ldbm_instance *)object_get_data(inst_obj);
+            slapi_ch_array_add(&instances, slapi_ch_strdup(inst->inst_name));
+        }
+    }
+
+    td = (struct index_stats_task_data *)slapi_ch_calloc(1, sizeof(struct index_stats_task_data));
+    td->li = li;
+    td->instances = instances;
+
+    task = slapi_new_task(slapi_entry_get_ndn(e));
+    slapi_task_set_destructor_fn(task, index_stats_task_destructor);
+    slapi_task_set_data(task, td);
+
+    thread = PR_CreateThread(PR_USER_THREAD, index_stats_task_thread,
+                             (void *)task, PR_PRIORITY_NORMAL, PR_GLOBAL_THREAD,
+                             PR_UNJOINABLE_THREAD, SLAPD_DEFAULT_THREAD_STACKSIZE);
+    if (thread == NULL) {
+        slapi_log_err(SLAPI_LOG_ERR, "ldbm_index_stats_task_add",
+                      "Unable to create index statistics thread!\n");
+        *returncode = LDAP_OPERATIONS_ERROR;
+        slapi_task_finish(task, *returncode);
+        return SLAPI_DSE_CALLBACK_ERROR;
+    }
+
+    return SLAPI_DSE_CALLBACK_OK;
+}
+
+static void
+index_stats_task_destructor(Slapi_Task *task)
+{
+    if (task) {
+        struct index_stats_task_data *td = (struct index_stats_task_data *)slapi_task_get_data(task);
+        while (slapi_task_get_refcount(task) > 0) {
+            /* Yield to wait for the task thread to finish */
+            DS_Sleep(PR_MillisecondsToInterval(100));
+        }
+        if (td) {
+            slapi_ch_array_free(td->instances);
+            slapi_ch_free((void **)&td);
+        }
+    }
+}
@@ -35,6 +35,7 @@ struct attrinfo *
 attrinfo_new()
 {
     struct attrinfo *p = (struct attrinfo *)slapi_ch_calloc(1, sizeof(struct attrinfo));
+    index_stats_init(p);
     return p;
 }
 
@@ -58,6 +59,7 @@ attrinfo_delete(struct attrinfo **pp)
         slapi_ch_free((void **)&((*pp)->ai_attrcrypt));
         attr_done(&((*pp)->ai_sattr));
         attrinfo_delete_idlistinfo(&(*pp)->ai_idlistinfo);
+        index_stats_destroy(*pp);
         if ((*pp)->ai_dblayer) {
             /* attriinfo is deleted.  Cleaning up the backpointer at the same time. */
             ((dblayer_handle *)((*pp)->ai_dblayer))->dblayer_handle_ai_backpointer = NULL;
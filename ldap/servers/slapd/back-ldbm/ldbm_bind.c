@@ -75,6 +75,7 @@ ldbm_back_bind(Slapi_PBlock *pb)
     switch (method) {
     case LDAP_AUTH_SIMPLE: {
         Slapi_Value cv;
+        int pwrc;
         if (slapi_entry_attr_find(e->ep_entry, "userpassword", &attr) != 0) {
             slapi_send_ldap_result(pb, LDAP_INAPPROPRIATE_AUTH, NULL,
                                    NULL, 0, NULL);
@@ -84,7 +85,19 @@ ldbm_back_bind(Slapi_PBlock *pb)
         }
         bvals = attr_get_present_values(attr);
         slapi_value_init_berval(&cv, cred);
-        if (slapi_pw_find_sv(bvals, &cv) != 0) {
+        if (pw_verify_cache_check(slapi_entry_get_ndn(e->ep_entry), bvals, &cv)) {
+            pwrc = 0;
+        } else if ((pwrc = pw_crypto_find_sv(bvals, &cv)) == 0) {
+            pw_verify_cache_add(slapi_entry_get_ndn(e->ep_entry), bvals, &cv);
+        }
+        if (pwrc == PW_CRYPTO_BUSY) {
+            /* not an invalid credential, the password retry count is left alone */
+            slapi_send_ldap_result(pb, LDAP_BUSY, NULL, "Too many concurrent password verifications", 0, NULL);
+            CACHE_RETURN(&inst->inst_cache, &e);
+            value_done(&cv);
+            rc = SLAPI_BIND_FAIL;
+            goto bail;
+        } else if (pwrc != 0) {
             slapi_pblock_set(pb, SLAPI_PB_RESULT_TEXT, "Invalid credentials");
             slapi_send_ldap_result(pb, LDAP_INVALID_CREDENTIALS, NULL, NULL, 0, NULL);
             CACHE_RETURN(&inst->inst_cache, &e);
@@ -277,6 +277,19 @@ ldbm_search_compile_filter(Slapi_Filter *f, void *arg __attribute__((unused)))
     return rc;
 }
 
+/*
+ * Test an entry against the search filter, using the program compiled
+ * from sr_norm_filter when there is one.
+ */
+static int
+ldbm_search_filter_test(Slapi_PBlock *pb, back_search_result_set *sr, Slapi_Entry *e, Slapi_Filter *filter, int verify_access, int only_check_access)
+{
+    if (sr->sr_filter_program && filter == sr->sr_norm_filter) {
+        return slapi_vattr_filter_test_program(pb, e, sr->sr_filter_program, verify_access, only_check_access);
+    }
+    return slapi_vattr_filter_test_ext(pb, e, filter, verify_access, only_check_access);
+}
+
 static int
 ldbm_search_free_compiled_filter(Slapi_Filter *f, void *arg __attribute__((unused)))
 {
@@ -315,6 +328,7 @@ ldbm_back_search(Slapi_PBlock *pb)
     int scope;
     LDAPControl **controls = NULL;
     Slapi_Operation *operation;
+    Op_Profile *profile = NULL;
     entry_address *addr;
     int estimate = 0; /* estimated search result set size */
 
@@ -906,6 +920,15 @@ ldbm_back_search(Slapi_PBlock *pb)
     sr->sr_candidates = candidates;
     sr->sr_virtuallistview = virtual_list_view;
 
+    if ((profile = operation_get_profile(operation))) {
+        /* a search can span several backends */
+        if (candidates && ALLIDS(candidates)) {
+            profile->opp_candidates_allids = 1;
+        } else {
+            profile->opp_candidates += IDL_NIDS(candidates);
+        }
+    }
+
     /* Set the estimated search result count for simple paged results */
     if (sr->sr_candidates && !ALLIDS(sr->sr_candidates)) {
         estimate = IDL_NIDS(sr->sr_candidates);
@@ -940,6 +963,7 @@ ldbm_back_search(Slapi_PBlock *pb)
             tmp_desc = "Filter is not set";
             goto bail;
         }
+        slapi_filter_program_free(&sr->sr_filter_program);
         slapi_filter_free(sr->sr_norm_filter, 1);
         sr->sr_norm_filter = slapi_filter_dup(filter);
         /* step 1 - normalize all of the values used in the search filter */
@@ -956,6 +980,8 @@ ldbm_back_search(Slapi_PBlock *pb)
                 tmp_desc = "Could not compile regex for filter matching";
             }
         }
+        /* step 3 - resolve types and matching rules once for all candidates */
+        sr->sr_filter_program = slapi_filter_compile(sr->sr_norm_filter, be);
     }
 bail:
     /* Fix for bugid #394184, SD, 05 Jul 00 */
@@ -1422,6 +1448,7 @@ ldbm_back_next_search_entry(Slapi_PBlock *pb)
     int pr_idx = -1;
     Slapi_Connection *conn;
     Slapi_Operation *op;
+    Op_Profile *profile = NULL;
     int reverse_list = 0;
 
     slapi_pblock_get(pb, SLAPI_SEARCH_TARGET_SDN, &basesdn);
@@ -1448,6 +1475,7 @@ ldbm_back_next_search_entry(Slapi_PBlock *pb)
     slapi_pblock_get(pb, SLAPI_TXN, &txn.back_txn_txn);
     slapi_pblock_get(pb, SLAPI_CONNECTION, &conn);
     slapi_pblock_get(pb, SLAPI_OPERATION, &op);
+    profile = operation_get_profile(op);
 
     if ((reverse_list = operation_is_flag_set(op, OP_FLAG_REVERSE_CANDIDATE_ORDER))) {
         /*
@@ -1546,6 +1574,8 @@ ldbm_back_next_search_entry(Slapi_PBlock *pb)
             slapi_send_ldap_result(pb, LDAP_ADMINLIMIT_EXCEEDED, NULL, NULL, nentries, urls);
             goto bail;
         }
+        /* do not hold the entries found so far while looking for the next one */
+        slapi_op_flush_queued_results(pb);
 
         /*
          * Get the entry ID
@@ -1602,7 +1632,16 @@ ldbm_back_next_search_entry(Slapi_PBlock *pb)
             /* if the entry is not the target_entry (base search)
              * we need to fetch it from the entry cache (it was not
              * referenced in the operation) */
-            e = id2entry(be, id, &txn, &err);
+            int cache_hit = 0;
+
+            e = id2entry_ext(be, id, &txn, &err, &cache_hit);
+            if (profile && e) {
+                if (cache_hit) {
+                    profile->opp_cache_hits++;
+                } else {
+                    profile->opp_cache_misses++;
+                }
+            }
         }
         if (e == NULL) {
             if (err != 0 && err != DB_NOTFOUND) {
@@ -1681,13 +1720,20 @@ ldbm_back_next_search_entry(Slapi_PBlock *pb)
                  * might still lead to return an empty entry. */
                 filter_test = -1;
             } else {
+                struct timespec filter_start;
+                uint64_t filter_acl_usec = 0;
+
+                if (profile) {
+                    clock_gettime(CLOCK_MONOTONIC, &filter_start);
+                    filter_acl_usec = profile->opp_acl_usec;
+                }
                 /* it's a regular entry, check if it matches the filter, and passes the ACL check */
                 if (0 != (sr->sr_flags & SR_FLAG_CAN_SKIP_FILTER_TEST)) {
                     /* Since we do access control checking in the filter test (?Why?) we need to check access now */
                     slapi_log_err(SLAPI_LOG_FILTER, "ldbm_back_next_search_entry",
                                   "Bypassing filter test\n");
                     if (ACL_CHECK_FLAG) {
-                        filter_test = slapi_vattr_filter_test_ext(pb, e->ep_entry, filter, ACL_CHECK_FLAG, 1 /* Only perform access checking, thank you */);
+                        filter_test = ldbm_search_filter_test(pb, sr, e->ep_entry, filter, ACL_CHECK_FLAG, 1 /* Only perform access checking, thank you */);
                     } else {
                         filter_test = 0;
                     }
@@ -1695,8 +1741,8 @@ ldbm_back_next_search_entry(Slapi_PBlock *pb)
                         int ft_rc;
 
                         slapi_log_err(SLAPI_LOG_FILTER, "ldbm_back_next_search_entry", "Checking bypass\n");
-                        ft_rc = slapi_vattr_filter_test(pb, e->ep_entry, filter,
-                                                        ACL_CHECK_FLAG);
+                        ft_rc = ldbm_search_filter_test(pb, sr, e->ep_entry, filter,
+                                                        ACL_CHECK_FLAG, 0);
                         if (filter_test != ft_rc) {
                             /* Oops ! This means that we thought we could bypass the filter test, but noooo... */
                             slapi_log_err(SLAPI_LOG_ERR, "ldbm_back_next_search_entry",
@@ -1706,7 +1752,12 @@ ldbm_back_next_search_entry(Slapi_PBlock *pb)
                     }
                 } else {
                     /* Old-style case---we need to do a filter test */
-                    filter_test = slapi_vattr_filter_test(pb, e->ep_entry, filter, ACL_CHECK_FLAG);
+                    filter_test = ldbm_search_filter_test(pb, sr, e->ep_entry, filter, ACL_CHECK_FLAG, 0);
+                }
+                if (profile) {
+                    /* the access checks of the filter attributes are accounted as acl time */
+                    profile->opp_filter_usec += operation_profile_usec(&filter_start) -
+                                                (profile->opp_acl_usec - filter_acl_usec);
                 }
             }
             if ((filter_test == 0) || (sr->sr_virtuallistview && (filter_test != -1)))
@@ -1866,6 +1917,7 @@ delete_search_result_set(Slapi_PBlock *pb, back_search_result_set **sr)
                       "delete_search_result_set", "Could not free the pre-compiled regexes in the search filter - error %d %d\n",
                       rc, filt_errs);
     }
+    slapi_filter_program_free(&(*sr)->sr_filter_program);
     slapi_filter_free((*sr)->sr_norm_filter, 1);
     memset(*sr, 0, sizeof(back_search_result_set));
     slapi_ch_free((void **)sr);
@@ -195,6 +195,7 @@ int id2entry_add(backend *be, struct backentry *e, back_txn *txn);
 int id2entry_add_ext(backend *be, struct backentry *e, back_txn *txn, int encrypt, int *cache_res);
 int id2entry_delete(backend *be, struct backentry *e, back_txn *txn);
 struct backentry *id2entry(backend *be, ID id, back_txn *txn, int *err);
+struct backentry *id2entry_ext(backend *be, ID id, back_txn *txn, int *err, int *cache_hit);
 
 /*
  * idl.c
@@ -260,6 +261,7 @@ void idl_set_insert_idl(IDListSet *idl_set, IDList *idl);
 void idl_set_insert_complement_idl(IDListSet *idl_set, IDList *idl);
 int64_t idl_set_union_shortcut(IDListSet *idl_set);
 int64_t idl_set_intersection_shortcut(IDListSet *idl_set);
+int64_t idl_set_minimum_size(IDListSet *idl_set);
 IDList *idl_set_union(IDListSet *idl_set, backend *be);
 IDList *idl_set_intersect(IDListSet *idl_set, backend *be);
 
@@ -295,6 +297,21 @@ int set_suffix_key(Slapi_Backend *be, struct _back_info_index_key *info);
 char *index_index2prefix(const char *indextype);
 void index_free_prefix(char *);
 
+/*
+ * index_stats.c
+ */
+void index_stats_init(struct attrinfo *a);
+void index_stats_destroy(struct attrinfo *a);
+void index_stats_reset(struct attrinfo *a);
+int index_stats_slot(const char *indextype);
+void index_stats_update(struct attrinfo *a, const char *indextype, int add, uint64_t count);
+void index_stats_update_keys(struct attrinfo *a, const DBT *key, int add);
+void index_stats_get(struct attrinfo *a, int slot, uint64_t *keys, uint64_t *ids);
+int index_stats_refresh(ldbm_instance *inst, Slapi_Task *task);
+int index_stats_save(ldbm_instance *inst);
+int index_stats_load(ldbm_instance *inst);
+int ldbm_index_stats_task_add(Slapi_PBlock *pb, Slapi_Entry *e, Slapi_Entry *eAfter, int *returncode, char *returntext, void *arg);
+
 /*
  * instance.c
  */
@@ -176,6 +176,7 @@ ldbm_back_start(Slapi_PBlock *pb)
     /* dynamically created. Code below should only be called once */
     if (!initialized) {
         ldbm_compute_init();
+        slapi_plugin_task_register_handler("index statistics", ldbm_index_stats_task_add, pb);
 
         initialized = 1;
     }
@@ -108,6 +108,7 @@ be_done(Slapi_Backend *be)
         slapi_counter_destroy(&be->be_usn_counter);
     }
     slapi_counter_destroy(&be->be_suffixcounter);
+    histogram_destroy(&be->be_latency);
     PR_DestroyLock(be->be_suffixlock);
     PR_DestroyLock(be->be_state_lock);
     if (be->be_lock != NULL) {
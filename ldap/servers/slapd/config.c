@@ -190,6 +190,7 @@ slapd_bootstrap_config(const char *configdir)
         buf[nr] = '\0';
 
         if (!done) {
+            char journalfile[MAXPATHLEN + 1];
             char workpath[MAXPATHLEN + 1];
             char loglevel[BUFSIZ];
             char maxdescriptors[BUFSIZ];
@@ -209,6 +210,10 @@ slapd_bootstrap_config(const char *configdir)
             syntaxlogging[0] = _localuser[0] = '\0';
             plugintracking[0] = dn_validate_strict[0] = moddn_aci[0] = '\0';
 
+            /* with the changes journaled since the file was written */
+            PR_snprintf(journalfile, sizeof(journalfile), "%s/%s", configdir, DSE_JOURNALFILE);
+            buf = dse_journal_apply(journalfile, buf);
+
             /* Convert LDIF to entry structures */
             slapi_sdn_init_ndn_byref(&plug_dn, PLUGIN_BASE_DN);
             while ((entrystr = dse_read_next_entry(buf, &lastp)) != NULL) {
@@ -37,6 +37,9 @@ static const char *requires_restart[] = {
     "cn=config:nsslapd-secureport",
     "cn=config:" CONFIG_LDAPI_FILENAME_ATTRIBUTE,
     "cn=config:" CONFIG_LDAPI_SWITCH_ATTRIBUTE,
+    "cn=config:" CONFIG_METRICS_PORT,
+    "cn=config:" CONFIG_METRICS_LISTENHOST,
+    "cn=config:" CONFIG_METRICS_SOCKET,
     "cn=config:nsslapd-workingdir",
     "cn=config:nsslapd-plugin",
     "cn=config:nsslapd-sslclientauth",
@@ -220,6 +220,8 @@ connection_cleanup(Connection *conn)
     conn->c_ssl_ssf = 0;
     conn->c_local_ssf = 0;
     conn->c_unix_local = 0;
+    /* c_connid is 0 now, cn=monitor no longer lists the slot */
+    connection_stats_update(conn);
     /* destroy any sasl context */
     sasl_dispose((sasl_conn_t **)&conn->c_sasl_conn);
     /* PAGED_RESULTS */
@@ -418,6 +420,7 @@ connection_reset(Connection *conn, int ns, PRNetAddr *from, int fromLen __attrib
     conn->c_ssl_ssf = 0;
     conn->c_local_ssf = 0;
     conn->c_ipaddr = slapi_ch_strdup(str_ip);
+    connection_stats_update(conn);
 }
 
 /* Create a pool of threads for handling the operations */
@@ -1751,6 +1754,7 @@ connection_threadmain()
          * Call the do_<operation> function to process this request.
          */
         connection_dispatch_operation(conn, op, pb);
+        latency_record_operation(pb, op);
 
     done:
         if (doshutdown) {
@@ -1957,6 +1961,18 @@ get_work_q(struct Slapi_op_stack **op_stack_obj)
     return (wqitem);
 }
 
+/*
+ * The operations waiting for a worker thread, the most there have been, and
+ * the operations kept for reuse.
+ */
+void
+connection_get_work_q_stats(int32_t *size, int32_t *size_max, int32_t *op_stack)
+{
+    *size = PR_AtomicAdd(&work_q_size, 0);
+    *size_max = PR_AtomicAdd(&work_q_size_max, 0);
+    *op_stack = PR_AtomicAdd(&op_stack_size, 0);
+}
+
 /* Helper functions common to both varieties of connection code: */
 
 /* op_thread_cleanup() : This function is called by daemon thread when it gets
@@ -485,6 +485,27 @@ connection_table_move_connection_on_to_active_list(Connection_Table *ct, Connect
 #endif
 }
 
+/*
+ * Copy the c_stats of a connection to cs without taking c_mutex.
+ * Returns 0 if the slot is free.
+ */
+static int
+connection_stats_read(Connection *c, conn_stats *cs)
+{
+    uint64_t seq;
+
+    do {
+        /* an odd sequence means connection_stats_update() is running */
+        while ((seq = slapi_atomic_load_64(&c->c_stats.cs_seq, __ATOMIC_ACQUIRE)) & 1) {
+            ;
+        }
+        memcpy(cs, &c->c_stats, sizeof(*cs));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while (slapi_atomic_load_64(&c->c_stats.cs_seq, __ATOMIC_RELAXED) != seq);
+
+    return cs->cs_connid != 0;
+}
+
 /*
  * Replace the following attributes within the entry 'e' with
  * information about the connection table:
@@ -493,12 +514,16 @@ connection_table_move_connection_on_to_active_list(Connection_Table *ct, Connect
  *    totalconnections        // single valued; an integer count
  *    dtablesize            // single valued; an integer size
  *    readwaiters            // single valued; an integer count
+ *
+ * Neither the table lock nor the connection locks are taken, so polling
+ * cn=monitor does not stall the connections. The connection values are
+ * only built when with_list is set, they are by far the most expensive part
+ * on a server with many connections.
  */
 void
-connection_table_as_entry(Connection_Table *ct, Slapi_Entry *e)
+connection_table_as_entry(Connection_Table *ct, Slapi_Entry *e, int with_list)
 {
     char buf[BUFSIZ];
-    char maxthreadbuf[BUFSIZ];
     struct berval val;
     struct berval *vals[2];
     int i, nconns, nreadwaiters;
@@ -511,89 +536,68 @@ connection_table_as_entry(Connection_Table *ct, Slapi_Entry *e)
     nconns = 0;
     nreadwaiters = 0;
     for (i = 0; i < (ct != NULL ? ct->size : 0); i++) {
-        PR_Lock(ct->table_mutex);
-        if (ct->c[i].c_state == CONN_STATE_FREE) {
-            PR_Unlock(ct->table_mutex);
+        Connection *c = &ct->c[i];
+        char buf2[SLAPI_TIMESTAMP_BUFSIZE + 1];
+        char *longdn = NULL;
+        conn_stats cs;
+        int gettingber;
+        int maxthreadstate;
+
+        if (!connection_stats_read(c, &cs)) {
+            continue;
+        }
+        /*
+         * The counters are read after the snapshot, if the slot was reused in
+         * between they belong to the new connection. That is as accurate as
+         * a monitoring poll needs.
+         */
+        gettingber = slapi_atomic_load_32((int32_t *)&c->c_gettingber, __ATOMIC_RELAXED);
+        nconns++;
+        if (gettingber) {
+            nreadwaiters++;
+        }
+        if (!with_list) {
             continue;
         }
-        /* Can't take c_mutex if holding table_mutex; temporarily unlock */
-        PR_Unlock(ct->table_mutex);
-
-        pthread_mutex_lock(&(ct->c[i].c_mutex));
-        if (ct->c[i].c_sd != SLAPD_INVALID_SOCKET) {
-            char buf2[SLAPI_TIMESTAMP_BUFSIZE+1];
-            size_t lendn = ct->c[i].c_dn ? strlen(ct->c[i].c_dn) : 6; /* "NULLDN" */
-            size_t lenip = ct->c[i].c_ipaddr ? strlen(ct->c[i].c_ipaddr) : 0;
-            size_t lenconn = 1;
-            uint64_t connid = ct->c[i].c_connid;
-            char *bufptr = &buf[0];
-            char *newbuf = NULL;
-            int maxthreadstate = 0;
-
-            /* Get the connid length */
-            while (connid > 9) {
-                lenconn++;
-                connid /= 10;
-            }
-
-            if (ct->c[i].c_flags & CONN_FLAG_MAX_THREADS) {
-                maxthreadstate = 1;
-            }
 
-            nconns++;
-            if (ct->c[i].c_gettingber) {
-                nreadwaiters++;
+        if (cs.cs_dn_truncated) {
+            /* rare enough to take the lock for */
+            pthread_mutex_lock(&(c->c_mutex));
+            if (c->c_connid == cs.cs_connid && c->c_dn) {
+                longdn = slapi_ch_strdup(c->c_dn);
             }
+            pthread_mutex_unlock(&(c->c_mutex));
+        }
 
-            gmtime_r(&ct->c[i].c_starttime, &utm);
-            strftime(buf2, SLAPI_TIMESTAMP_BUFSIZE, "%Y%m%d%H%M%SZ", &utm);
-
-            /*
-             * Max threads per connection stats
-             *
-             * Appended output "1:2:3"
-             *
-             * 1 = Connection max threads state:  1 is in max threads, 0 is not
-             * 2 = The number of times this thread has hit max threads
-             * 3 = The number of operations attempted that were blocked
-             *     by max threads.
-             */
-            snprintf(maxthreadbuf, sizeof(maxthreadbuf), "%d:%" PRIu64 ":%" PRIu64 "",
-                     maxthreadstate, ct->c[i].c_maxthreadscount,
-                     ct->c[i].c_maxthreadsblocked);
-
-            if ((lenconn + lenip + lendn + strlen(maxthreadbuf)) > (BUFSIZ - 54)) {
-                /*
-                 * 54 =  8 for the colon separators +
-                 *       6 for the "i" counter +
-                 *      15 for buf2 (date) +
-                 *      10 for c_opsinitiated +
-                 *      10 for c_opscompleted +
-                 *       1 for c_gettingber +
-                 *       3 for "ip=" +
-                 *       1 for NULL terminator
-                 */
-                newbuf = (char *)slapi_ch_malloc(lenconn + lendn + lenip + strlen(maxthreadbuf) + 54);
-                bufptr = newbuf;
-            }
+        gmtime_r(&cs.cs_starttime, &utm);
+        strftime(buf2, SLAPI_TIMESTAMP_BUFSIZE, "%Y%m%d%H%M%SZ", &utm);
+        maxthreadstate = (slapi_atomic_load_32((int32_t *)&c->c_flags, __ATOMIC_RELAXED) & CONN_FLAG_MAX_THREADS) ? 1 : 0;
 
-            sprintf(bufptr, "%d:%s:%d:%d:%s%s:%s:%s:%" PRIu64 ":ip=%s",
-                    i,
-                    buf2,
-                    ct->c[i].c_opsinitiated,
-                    ct->c[i].c_opscompleted,
-                    ct->c[i].c_gettingber ? "r" : "-",
-                    "",
-                    ct->c[i].c_dn ? ct->c[i].c_dn : "NULLDN",
-                    maxthreadbuf,
-                    ct->c[i].c_connid,
-                    ct->c[i].c_ipaddr);
-            val.bv_val = bufptr;
-            val.bv_len = strlen(bufptr);
-            attrlist_merge(&e->e_attrs, "connection", vals);
-            slapi_ch_free_string(&newbuf);
-        }
-        pthread_mutex_unlock(&(ct->c[i].c_mutex));
+        /*
+         * Max threads per connection stats are the "1:2:3" after the DN
+         *
+         * 1 = Connection max threads state:  1 is in max threads, 0 is not
+         * 2 = The number of times this thread has hit max threads
+         * 3 = The number of operations attempted that were blocked
+         *     by max threads.
+         */
+        val.bv_val = slapi_ch_smprintf("%d:%s:%d:%d:%s%s:%s:%d:%" PRIu64 ":%" PRIu64 ":%" PRIu64 ":ip=%s",
+                                       i,
+                                       buf2,
+                                       slapi_atomic_load_32((int32_t *)&c->c_opsinitiated, __ATOMIC_RELAXED),
+                                       slapi_atomic_load_32((int32_t *)&c->c_opscompleted, __ATOMIC_RELAXED),
+                                       gettingber ? "r" : "-",
+                                       "",
+                                       longdn ? longdn : (cs.cs_dn[0] ? cs.cs_dn : "NULLDN"),
+                                       maxthreadstate,
+                                       slapi_atomic_load_64((uint64_t *)&c->c_maxthreadscount, __ATOMIC_RELAXED),
+                                       slapi_atomic_load_64((uint64_t *)&c->c_maxthreadsblocked, __ATOMIC_RELAXED),
+                                       cs.cs_connid,
+                                       cs.cs_ipaddr);
+        val.bv_len = strlen(val.bv_val);
+        attrlist_merge(&e->e_attrs, "connection", vals);
+        slapi_ch_free_string(&val.bv_val);
+        slapi_ch_free_string(&longdn);
     }
 
     snprintf(buf, sizeof(buf), "%d", nconns);
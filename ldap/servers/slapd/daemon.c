@@ -182,6 +182,17 @@ daemon_pre_setuid_init(daemon_ports_t *ports)
     }
 #endif /* ENABLE_LDAPI */
 
+    /* metrics exporter */
+    if (0 != ports->m_port) {
+        ports->m_socket = createprlistensockets((unsigned short)ports->m_port,
+                                                ports->m_listenaddr, 0, 0);
+    }
+#if defined(ENABLE_LDAPI)
+    if (NULL != ports->m_local_listenaddr) {
+        ports->m_local_socket = createprlistensockets(1, ports->m_local_listenaddr, 0, 1);
+    }
+#endif /* ENABLE_LDAPI */
+
     return (rc);
 }
 
@@ -904,6 +915,16 @@ slapd_sockets_ports_free(daemon_ports_t *ports_info)
     }
     slapi_ch_free((void **)&ports_info->i_socket);
 #endif /* ENABLE_LDAPI */
+    for (fdesp = ports_info->m_socket; fdesp && *fdesp; fdesp++) {
+        PR_Close(*fdesp);
+    }
+    slapi_ch_free((void **)&ports_info->m_socket);
+#if defined(ENABLE_LDAPI)
+    for (fdesp = ports_info->m_local_socket; fdesp && *fdesp; fdesp++) {
+        PR_Close(*fdesp);
+    }
+    slapi_ch_free((void **)&ports_info->m_local_socket);
+#endif /* ENABLE_LDAPI */
 
     /* freeing NetAddrs */
     PRNetAddr **nap;
@@ -921,6 +942,16 @@ slapd_sockets_ports_free(daemon_ports_t *ports_info)
         slapi_ch_free((void **)nap);
     }
     slapi_ch_free((void **)&ports_info->i_listenaddr);
+#endif
+    for (nap = ports_info->m_listenaddr; nap && *nap; nap++) {
+        slapi_ch_free((void **)nap);
+    }
+    slapi_ch_free((void **)&ports_info->m_listenaddr);
+#if defined(ENABLE_LDAPI)
+    for (nap = ports_info->m_local_listenaddr; nap && *nap; nap++) {
+        slapi_ch_free((void **)nap);
+    }
+    slapi_ch_free((void **)&ports_info->m_local_listenaddr);
 #endif
 }
 
@@ -990,6 +1021,7 @@ slapd_daemon(daemon_ports_t *ports)
     }
 
     init_op_threads();
+    pw_crypto_start();
 
     /*
      *  If we are monitoring disk space, then create the mutex, the cvar,
@@ -1080,6 +1112,32 @@ slapd_daemon(daemon_ports_t *ports)
     }
 #endif /* ENABLE_LDAPI */
 
+    /* The metrics exporter sockets are not listeners of the connection
+     * table, the exporter thread polls them itself. */
+    for (fdesp = ports->m_socket; fdesp && *fdesp; fdesp++) {
+        if (PR_Listen(*fdesp, config_get_listen_backlog_size()) == PR_FAILURE) {
+            PRErrorCode prerr = PR_GetError();
+            slapi_log_err(SLAPI_LOG_EMERG, "slapd_daemon",
+                          "PR_Listen() on metrics port %d failed: %s error %d (%s)\n",
+                          ports->m_port, SLAPI_COMPONENT_NAME_NSPR, prerr,
+                          slapd_pr_strerror(prerr));
+            g_set_shutdown(SLAPI_SHUTDOWN_EXIT);
+        }
+    }
+#if defined(ENABLE_LDAPI)
+    for (fdesp = ports->m_local_socket; fdesp && *fdesp; fdesp++) {
+        if (PR_Listen(*fdesp, config_get_listen_backlog_size()) == PR_FAILURE) {
+            PRErrorCode prerr = PR_GetError();
+            slapi_log_err(SLAPI_LOG_EMERG, "slapd_daemon",
+                          "listen() on %s failed: error %d (%s)\n",
+                          (*ports->m_local_listenaddr)->local.path,
+                          prerr,
+                          slapd_pr_strerror(prerr));
+            g_set_shutdown(SLAPI_SHUTDOWN_EXIT);
+        }
+    }
+#endif /* ENABLE_LDAPI */
+
     listener_idxs = (listener_info *)slapi_ch_calloc(listeners, sizeof(*listener_idxs));
     /*
      * Convert old DES encoded passwords to AES
@@ -1092,6 +1150,12 @@ slapd_daemon(daemon_ports_t *ports)
     /* The server is ready and listening for connections. Logging "slapd started" message. */
     unfurl_banners(the_connection_table, ports, n_tcps, s_tcps, i_unix);
 
+#if defined(ENABLE_LDAPI)
+    metrics_start(ports->m_socket, ports->m_local_socket);
+#else
+    metrics_start(ports->m_socket, NULL);
+#endif
+
 #ifdef WITH_SYSTEMD
     sd_notifyf(0, "READY=1\n"
                   "STATUS=slapd started: Ready to process requests\n"
@@ -1139,9 +1203,11 @@ slapd_daemon(daemon_ports_t *ports)
     /* free the listener indexes */
     slapi_ch_free((void **)&listener_idxs);
 
+    metrics_stop(); /* before its sockets are closed and the backends go away */
     slapd_sockets_ports_free(ports);
 
     op_thread_cleanup();
+    pw_crypto_stop(); /* releases the workers waiting for a password compare */
     housekeeping_stop(); /* Run this after op_thread_cleanup() logged sth */
     disk_monitoring_stop();
 
@@ -2273,6 +2339,24 @@ unfurl_banners(Connection_Table *ct, daemon_ports_t *ports, PRFileDesc **n_tcps,
                       (*iap)->local.path);
     }
 #endif /* ENABLE_LDAPI */
+
+    if (ports->m_socket != NULL) { /* metrics exporter */
+        PRNetAddr **map = NULL;
+
+        for (map = ports->m_listenaddr; map && *map; map++) {
+            slapi_log_err(SLAPI_LOG_INFO, "slapd_daemon",
+                          "Listening on %s port %d for metrics requests\n",
+                          netaddr2string(*map, addrbuf, sizeof(addrbuf)),
+                          ports->m_port);
+        }
+    }
+#if defined(ENABLE_LDAPI)
+    if (ports->m_local_socket != NULL) {
+        slapi_log_err(SLAPI_LOG_INFO, "slapd_daemon",
+                      "Listening on %s for metrics requests\n",
+                      (*ports->m_local_listenaddr)->local.path);
+    }
+#endif /* ENABLE_LDAPI */
 }
 
 /* On UNIX, we create a file with our PID in it */
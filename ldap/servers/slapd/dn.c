@@ -510,6 +510,74 @@ ISEOV(char *s, char *ends)
     return 1;
 }
 
+/*
+ * Returns 1 if slapi_dn_normalize_ext would return src unchanged, which is
+ * the case of most DNs: type=value RDNs separated by ',' with no escapes,
+ * quotes, multivalued RDNs or spaces other than single spaces inside values.
+ * Such DNs skip the state machine, and with it the schema lookups of the
+ * RDN types, as well as the ndn cache.
+ */
+static int
+dn_is_normalized(const char *src, size_t src_len)
+{
+    const char *s = src;
+    const char *ends = src + src_len;
+    size_t i = 0;
+
+    /* bytes the state machine may rewrite, or that end the string early */
+    for (; i + sizeof(uint64_t) <= src_len; i += sizeof(uint64_t)) {
+        uint64_t w = swar_load(src + i);
+        if (swar_has_zero(w) | swar_has_byte(w, '\\') | swar_has_byte(w, '"') |
+            swar_has_byte(w, '+') | swar_has_byte(w, ';') |
+            swar_has_byte(w, '\n') | swar_has_byte(w, '\r') |
+            swar_has_byte(w, ')') | swar_has_byte(w, ']')) {
+            return 0;
+        }
+    }
+    for (; i < src_len; i++) {
+        switch (src[i]) {
+        case '\0':
+        case '\\':
+        case '"':
+        case '+':
+        case ';':
+        case '\n':
+        case '\r':
+        case ')':
+        case ']':
+            return 0;
+        }
+    }
+
+    /* type=value[,type=value]... */
+    while (s < ends) {
+        const char *sep = memchr(s, ',', ends - s);
+        const char *eq;
+
+        if (sep == NULL) {
+            sep = ends;
+        }
+        eq = memchr(s, '=', sep - s);
+        if (eq == NULL || eq == s || eq + 1 == sep || memchr(s, ' ', eq - s)) {
+            return 0;
+        }
+        /* leading, trailing and repeated spaces of a value are removed */
+        for (const char *sp = eq + 1; (sp = memchr(sp, ' ', sep - sp)) != NULL; sp++) {
+            if (sp == eq + 1 || sp + 1 == sep || sp[1] == ' ') {
+                return 0;
+            }
+        }
+        if (sep == ends) {
+            break;
+        }
+        s = sep + 1;
+        if (s == ends) {
+            return 0; /* trailing separator */
+        }
+    }
+    return 1;
+}
+
 /*
  * 1) Escaped NEEDSESCAPE chars (e.g., ',', '<', '=', etc.) are converted to
  * ESC HEX HEX (e.g., \2C, \3C, \3D, etc.)
@@ -570,6 +638,11 @@ slapi_dn_normalize_ext(char *src, size_t src_len, char **dest, size_t *dest_len)
     if (0 == src_len) {
         src_len = strlen(src);
     }
+    if (src_len > 0 && dn_is_normalized(src, src_len)) {
+        *dest = src;
+        *dest_len = src_len;
+        return 0;
+    }
     /*
      *  Check the normalized dn cache
      */
@@ -1455,12 +1528,23 @@ slapi_dn_normalize_to_end(char *dn, char *end)
  * which also need to be converted to the lower case.
  */
 char *
-slapi_dn_ignore_case(char *dn)
+dn_ignore_case_to_end(char *dn, char *end)
 {
     unsigned char *s = NULL, *d = NULL;
     int ssz, dsz;
     /* normalize case (including UTF-8 multi-byte chars) */
-    for (s = d = (unsigned char *)dn; s && *s; s += ssz, d += dsz) {
+    for (s = d = (unsigned char *)dn; s && s < (unsigned char *)end && *s;
+         s += ssz, d += dsz) {
+        if ((unsigned char *)end - s >= (ptrdiff_t)sizeof(uint64_t)) {
+            /* eight ASCII bytes at once, utf8ToLower keeps their length */
+            uint64_t w = swar_load(s);
+            if (!swar_has_nonascii(w) && !swar_has_zero(w)) {
+                w = swar_ascii_tolower(w);
+                memcpy(d, &w, sizeof(w));
+                ssz = dsz = sizeof(w);
+                continue;
+            }
+        }
         slapi_utf8ToLower(s, d, &ssz, &dsz);
     }
     if (d) {
@@ -1470,19 +1554,12 @@ slapi_dn_ignore_case(char *dn)
 }
 
 char *
-dn_ignore_case_to_end(char *dn, char *end)
+slapi_dn_ignore_case(char *dn)
 {
-    unsigned char *s = NULL, *d = NULL;
-    int ssz, dsz;
-    /* normalize case (including UTF-8 multi-byte chars) */
-    for (s = d = (unsigned char *)dn; s && s < (unsigned char *)end && *s;
-         s += ssz, d += dsz) {
-        slapi_utf8ToLower(s, d, &ssz, &dsz);
-    }
-    if (d) {
-        *d = '\0'; /* utf8ToLower result may be shorter than the original */
+    if (dn == NULL) {
+        return (dn);
     }
-    return (dn);
+    return (dn_ignore_case_to_end(dn, dn + strlen(dn)));
 }
 
 /*
@@ -29,6 +29,12 @@
  * the entire contents on every modification will
  * be insufficient.
  *
+ * So a DSE may have a journal (dse.ldif.journal for the config DSE): each
+ * modified entry, or a delete record for a removed one, is appended to it
+ * instead, and the whole file is only rewritten once the journal holds
+ * nsslapd-dse-journal-size changes, at startup and at shutdown. Reading
+ * the DSE replays the journal over the file.
+ *
  */
 
 #include <sys/types.h>
@@ -101,8 +107,35 @@ struct dse
                                      /* initialize the dse */
     int dse_is_updateable;           /* if non-zero, this DSE can be written to */
     int dse_readonly_error_reported; /* used to ensure that read-only errors are logged only once */
+    char *dse_journal;               /* changes not yet written to dse_filename, may be NULL */
+    PRFileDesc *dse_journal_fd;
+    int32_t dse_journal_records;     /* changes in dse_journal */
+    /* search indexes, see dse_index_node() */
+    PLHashTable *dse_children_index;    /* parent ndn -> entries right below it */
+    PLHashTable *dse_subtree_index;     /* ancestor ndn -> entries below it */
+    PLHashTable *dse_objectclass_index; /* lower case objectclass -> entries */
+    int32_t dse_entries;
 };
 
+/* the entries of an index key, in no particular order */
+typedef struct dse_index_list
+{
+    char *dil_key;
+    struct dse_node **dil_nodes;
+    int32_t dil_count;
+    int32_t dil_size;
+} dse_index_list;
+
+/* the journal read back by dse_read_one_file() */
+typedef struct dse_journal_replay
+{
+    PLHashTable *djr_ht;         /* ndn -> index + 1 in djr_entries */
+    Slapi_Entry **djr_entries;   /* last version of each entry, NULL once replayed */
+    char *djr_deleted;           /* the last record of the entry is a delete */
+    char **djr_ndns;             /* keys of djr_ht */
+    int32_t djr_count;
+} dse_journal_replay;
+
 struct dse_node
 {
     Slapi_Entry *entry;
@@ -117,6 +150,7 @@ typedef struct dse_search_set
 
 static int dse_permission_to_write(struct dse *pdse, int loglevel);
 static int dse_write_file_nolock(struct dse *pdse);
+static int dse_persist_entry_nolock(struct dse *pdse, const Slapi_DN *sdn);
 static int dse_apply_nolock(struct dse *pdse, IFP fp, caddr_t arg);
 static int dse_replace_entry(struct dse *pdse, Slapi_Entry *e, int write_file, int use_lock);
 static dse_search_set *dse_search_set_new(void);
@@ -288,6 +322,137 @@ dse_node_delete(struct dse_node **pp)
     PR_DECREMENT_COUNTER(dse_entries_exist);
 }
 
+static PLHashTable *
+dse_index_new(void)
+{
+    return PL_NewHashTable(64, PL_HashString, PL_CompareStrings, PL_CompareValues, NULL, NULL);
+}
+
+static void
+dse_index_add(PLHashTable *index, const char *key, struct dse_node *n)
+{
+    dse_index_list *list = (dse_index_list *)PL_HashTableLookup(index, key);
+
+    if (list == NULL) {
+        list = (dse_index_list *)slapi_ch_calloc(1, sizeof(dse_index_list));
+        list->dil_key = slapi_ch_strdup(key);
+        PL_HashTableAdd(index, list->dil_key, list);
+    }
+    if (list->dil_count == list->dil_size) {
+        list->dil_size = list->dil_size ? list->dil_size * 2 : 4;
+        list->dil_nodes = (struct dse_node **)slapi_ch_realloc((char *)list->dil_nodes,
+                                                               list->dil_size * sizeof(struct dse_node *));
+    }
+    list->dil_nodes[list->dil_count++] = n;
+}
+
+static void
+dse_index_remove(PLHashTable *index, const char *key, struct dse_node *n)
+{
+    dse_index_list *list = (dse_index_list *)PL_HashTableLookup(index, key);
+
+    if (list == NULL) {
+        return;
+    }
+    for (int32_t i = 0; i < list->dil_count; i++) {
+        if (list->dil_nodes[i] == n) {
+            list->dil_nodes[i] = list->dil_nodes[--list->dil_count];
+            break;
+        }
+    }
+    if (list->dil_count == 0) {
+        PL_HashTableRemove(index, list->dil_key);
+        slapi_ch_free_string(&list->dil_key);
+        slapi_ch_free((void **)&list->dil_nodes);
+        slapi_ch_free((void **)&list);
+    }
+}
+
+static PRIntn
+dse_index_free_list(PLHashEntry *he, PRIntn i __attribute__((unused)), void *arg __attribute__((unused)))
+{
+    dse_index_list *list = (dse_index_list *)he->value;
+
+    slapi_ch_free_string(&list->dil_key);
+    slapi_ch_free((void **)&list->dil_nodes);
+    slapi_ch_free((void **)&list);
+    return HT_ENUMERATE_REMOVE;
+}
+
+static void
+dse_index_free(PLHashTable **index)
+{
+    if (*index) {
+        PL_HashTableEnumerateEntries(*index, dse_index_free_list, NULL);
+        PL_HashTableDestroy(*index);
+        *index = NULL;
+    }
+}
+
+/* objectclass values are compared case insensitively */
+static char *
+dse_index_objectclass_key(const char *oc)
+{
+    char *key = slapi_ch_strdup(oc);
+
+    for (char *p = key; *p; p++) {
+        *p = TOLOWER(*p);
+    }
+    return key;
+}
+
+static void
+dse_index_objectclasses(struct dse *pdse, struct dse_node *n, int add)
+{
+    Slapi_Attr *attr = NULL;
+    Slapi_Value *v = NULL;
+
+    if (slapi_entry_attr_find(n->entry, SLAPI_ATTR_OBJECTCLASS, &attr) != 0) {
+        return;
+    }
+    for (int i = slapi_attr_first_value(attr, &v); i != -1; i = slapi_attr_next_value(attr, i, &v)) {
+        char *key = dse_index_objectclass_key(slapi_value_get_string(v));
+        if (add) {
+            dse_index_add(pdse->dse_objectclass_index, key, n);
+        } else {
+            dse_index_remove(pdse->dse_objectclass_index, key, n);
+        }
+        slapi_ch_free_string(&key);
+    }
+}
+
+/*
+ * Add n to, or remove it from, the search indexes: under its parent in the
+ * children index, under each of its ancestors in the subtree index, and under
+ * its objectclasses. The nodes stay in the AVL tree, which gives the order of
+ * the results. Called with the write lock held, whenever a node enters or
+ * leaves the tree; a replaced or merged entry keeps its node, only its
+ * objectclasses are indexed again.
+ */
+static void
+dse_index_node(struct dse *pdse, struct dse_node *n, int add)
+{
+    const char *ndn = slapi_entry_get_ndn(n->entry);
+    const char *parent = slapi_dn_find_parent(ndn);
+
+    if (ndn != NULL && *ndn != '\0') {
+        if (add) {
+            dse_index_add(pdse->dse_children_index, parent ? parent : "", n);
+        } else {
+            dse_index_remove(pdse->dse_children_index, parent ? parent : "", n);
+        }
+        for (; parent != NULL; parent = slapi_dn_find_parent(parent)) {
+            if (add) {
+                dse_index_add(pdse->dse_subtree_index, parent, n);
+            } else {
+                dse_index_remove(pdse->dse_subtree_index, parent, n);
+            }
+        }
+    }
+    dse_index_objectclasses(pdse, n, add);
+    pdse->dse_entries += add ? 1 : -1;
+}
+
 static void
 dse_callback_addtolist(struct dse_callback **pplist, struct dse_callback *p)
 {
@@ -387,6 +552,9 @@ dse_new(char *filename, char *tmpfilename, char *backfilename, char *startokfile
 
             pdse->dse_tree = NULL;
             pdse->dse_callback = NULL;
+            pdse->dse_children_index = dse_index_new();
+            pdse->dse_subtree_index = dse_index_new();
+            pdse->dse_objectclass_index = dse_index_new();
             pdse->dse_is_updateable = dse_permission_to_write(pdse,
                                                               SLAPI_LOG_TRACE);
         }
@@ -406,6 +574,39 @@ dse_new_with_filelist(char *filename, char *tmpfilename, char *backfilename, cha
     return newdse;
 }
 
+/*
+ * Journal the changes of the dse to journalfile, in the config directory,
+ * rather than rewriting the whole file each time. Must be called before
+ * dse_read_file().
+ */
+void
+dse_set_journal(struct dse *pdse, const char *journalfile)
+{
+    slapi_ch_free_string(&pdse->dse_journal);
+    if (!strstr(journalfile, pdse->dse_configdir)) {
+        pdse->dse_journal = slapi_ch_smprintf("%s/%s", pdse->dse_configdir, journalfile);
+    } else {
+        pdse->dse_journal = slapi_ch_strdup(journalfile);
+    }
+}
+
+/*
+ * Write the journaled changes to the file, if there are any.
+ */
+void
+dse_compact(struct dse *pdse)
+{
+    if (pdse->dse_rwlock)
+        slapi_rwlock_wrlock(pdse->dse_rwlock);
+    if (pdse->dse_journal_records > 0) {
+        slapi_log_err(SLAPI_LOG_INFO, "dse_compact", "Writing %d journaled changes to %s\n",
+                      pdse->dse_journal_records, pdse->dse_filename);
+        dse_write_file_nolock(pdse);
+    }
+    if (pdse->dse_rwlock)
+        slapi_rwlock_unlock(pdse->dse_rwlock);
+}
+
 static int
 dse_internal_delete_entry(caddr_t data, caddr_t arg __attribute__((unused)))
 {
@@ -427,6 +628,14 @@ dse_destroy(struct dse *pdse)
     }
     if (pdse->dse_rwlock)
         slapi_rwlock_wrlock(pdse->dse_rwlock);
+    if (pdse->dse_journal_records > 0) {
+        /* leave a complete dse.ldif for the offline tools */
+        dse_write_file_nolock(pdse);
+    }
+    if (pdse->dse_journal_fd) {
+        PR_Close(pdse->dse_journal_fd);
+    }
+    slapi_ch_free_string(&pdse->dse_journal);
     slapi_ch_free((void **)&(pdse->dse_filename));
     slapi_ch_free((void **)&(pdse->dse_tmpfile));
     slapi_ch_free((void **)&(pdse->dse_fileback));
@@ -434,6 +643,9 @@ dse_destroy(struct dse *pdse)
     slapi_ch_free((void **)&(pdse->dse_configdir));
     dse_callback_deletelist(&pdse->dse_callback);
     charray_free(pdse->dse_filelist);
+    dse_index_free(&pdse->dse_children_index);
+    dse_index_free(&pdse->dse_subtree_index);
+    dse_index_free(&pdse->dse_objectclass_index);
     nentries = avl_free(pdse->dse_tree, dse_internal_delete_entry);
     if (pdse->dse_rwlock) {
         slapi_rwlock_unlock(pdse->dse_rwlock);
@@ -656,6 +868,265 @@ dse_check_file(char *filename, char *backupname)
     }
 }
 
+/*
+ * Read the journal journalfile. Only the last record of an entry is kept, at
+ * the position of its first record, so that parents still come before their
+ * children. An incomplete last record, left by a crash or a failed write, is
+ * cut off the file so that the next change is not appended to it. Returns
+ * NULL if there is no journal, else the number of records is set in records_out.
+ */
+static dse_journal_replay *
+dse_journal_load_file(const char *journalfile, int str2entry_flags, int32_t *records_out)
+{
+    dse_journal_replay *journal;
+    PRFileInfo64 prfinfo;
+    PRFileDesc *prfd;
+    char *buf, *p, *entrystr;
+    char *lastp = NULL;
+    int32_t size = 0;
+    int32_t records = 0;
+    PRInt32 nr;
+
+    if (PR_GetFileInfo64(journalfile, &prfinfo) != PR_SUCCESS) {
+        return NULL;
+    }
+    if ((prfd = PR_Open(journalfile, PR_RDONLY, SLAPD_DEFAULT_FILE_MODE)) == NULL) {
+        slapi_log_err(SLAPI_LOG_ERR, "dse_journal_load",
+                      "The configuration journal %s could not be read. " SLAPI_COMPONENT_NAME_NSPR " %d (%s)\n",
+                      journalfile, PR_GetError(), slapd_pr_strerror(PR_GetError()));
+        return NULL;
+    }
+    buf = slapi_ch_malloc(prfinfo.size + 1);
+    if ((nr = slapi_read_buffer(prfd, buf, prfinfo.size)) < 0) {
+        nr = 0;
+    }
+    (void)PR_Close(prfd);
+
+    /* a record is complete once it is followed by its empty line */
+    for (p = buf + nr; p > buf + 1 && !(p[-1] == '\n' && p[-2] == '\n'); p--)
+        ;
+    if (p == buf + 1) {
+        p = buf;
+    }
+    if (p != buf + nr) {
+        slapi_log_err(SLAPI_LOG_WARNING, "dse_journal_load",
+                      "Ignoring the incomplete last change in %s\n", journalfile);
+        if (truncate(journalfile, p - buf) != 0) {
+            slapi_log_err(SLAPI_LOG_ERR, "dse_journal_load",
+                          "Cannot truncate %s: OS error %d (%s)\n",
+                          journalfile, errno, slapd_system_strerror(errno));
+        }
+    }
+    *p = '\0';
+
+    journal = (dse_journal_replay *)slapi_ch_calloc(1, sizeof(dse_journal_replay));
+    journal->djr_ht = PL_NewHashTable(64, PL_HashString, PL_CompareStrings, PL_CompareValues, NULL, NULL);
+    while ((entrystr = dse_read_next_entry(buf, &lastp)) != NULL) {
+        Slapi_Entry *e = slapi_str2entry(entrystr, str2entry_flags);
+        intptr_t idx;
+
+        if (e == NULL) {
+            slapi_log_err(SLAPI_LOG_ERR, "dse_journal_load",
+                          "Ignoring unreadable change %d in %s\n", records + 1, journalfile);
+            continue;
+        }
+        records++;
+        idx = (intptr_t)PL_HashTableLookup(journal->djr_ht, slapi_entry_get_ndn(e));
+        if (idx == 0) {
+            if (journal->djr_count == size) {
+                size = size ? size * 2 : 16;
+                journal->djr_entries = (Slapi_Entry **)slapi_ch_realloc((char *)journal->djr_entries,
+                                                                         size * sizeof(Slapi_Entry *));
+                journal->djr_ndns = (char **)slapi_ch_realloc((char *)journal->djr_ndns, size * sizeof(char *));
+                journal->djr_deleted = slapi_ch_realloc(journal->djr_deleted, size);
+            }
+            idx = ++journal->djr_count;
+            journal->djr_ndns[idx - 1] = slapi_ch_strdup(slapi_entry_get_ndn(e));
+            PL_HashTableAdd(journal->djr_ht, journal->djr_ndns[idx - 1], (void *)idx);
+        } else {
+            slapi_entry_free(journal->djr_entries[idx - 1]);
+        }
+        journal->djr_entries[idx - 1] = e;
+        journal->djr_deleted[idx - 1] = slapi_entry_attr_hasvalue(e, "changetype", "delete");
+    }
+    slapi_ch_free_string(&buf);
+
+    slapi_log_err(SLAPI_LOG_INFO, "dse_journal_load", "Replaying %d changes from %s\n",
+                  records, journalfile);
+    *records_out = records;
+
+    return journal;
+}
+
+static dse_journal_replay *
+dse_journal_load(struct dse *pdse, int str2entry_flags)
+{
+    /* written out with the file at the next compaction */
+    return dse_journal_load_file(pdse->dse_journal, str2entry_flags, &pdse->dse_journal_records);
+}
+
+/*
+ * Replace e, read from the file, by its journaled version. Returns 1 if the
+ * entry was deleted since the file was written, e is then freed.
+ */
+static int
+dse_journal_replay_entry(dse_journal_replay *journal, Slapi_Entry **e)
+{
+    intptr_t idx = (intptr_t)PL_HashTableLookup(journal->djr_ht, slapi_entry_get_ndn(*e));
+
+    if (idx == 0 || journal->djr_entries[idx - 1] == NULL) {
+        return 0;
+    }
+    slapi_entry_free(*e);
+    *e = journal->djr_entries[idx - 1];
+    journal->djr_entries[idx - 1] = NULL;
+    if (journal->djr_deleted[idx - 1]) {
+        slapi_entry_free(*e);
+        *e = NULL;
+        return 1;
+    }
+    return 0;
+}
+
+static void
+dse_journal_replay_free(dse_journal_replay **journal)
+{
+    for (int32_t i = 0; i < (*journal)->djr_count; i++) {
+        slapi_entry_free((*journal)->djr_entries[i]);
+        slapi_ch_free_string(&(*journal)->djr_ndns[i]);
+    }
+    PL_HashTableDestroy((*journal)->djr_ht);
+    slapi_ch_free((void **)&(*journal)->djr_entries);
+    slapi_ch_free((void **)&(*journal)->djr_ndns);
+    slapi_ch_free_string(&(*journal)->djr_deleted);
+    slapi_ch_free((void **)journal);
+}
+
+/* Append the record s and its empty line to the string *out of length *len */
+static void
+dse_journal_append_record(char **out, size_t *len, size_t *size, const char *s)
+{
+    size_t slen = strlen(s);
+
+    if (*len + slen + 3 > *size) {
+        *size = (*len + slen + 3) * 2;
+        *out = slapi_ch_realloc(*out, *size);
+    }
+    memcpy(*out + *len, s, slen);
+    *len += slen;
+    if (slen == 0 || s[slen - 1] != '\n') {
+        (*out)[(*len)++] = '\n';
+    }
+    (*out)[(*len)++] = '\n';
+    (*out)[*len] = '\0';
+}
+
+/*
+ * Apply journalfile to buf, the contents of the file it journals, for the
+ * readers of that file which run before dse_read_file() replays the journal,
+ * i.e. slapd_bootstrap_config(). buf is consumed. Returns the contents with
+ * the journaled changes, or buf itself if there is no journal.
+ */
+char *
+dse_journal_apply(const char *journalfile, char *buf)
+{
+    dse_journal_replay *journal;
+    char *entrystr, *lastp = NULL;
+    char *out = NULL;
+    size_t len = 0, size = 0;
+    int32_t records = 0;
+
+    journal = dse_journal_load_file(journalfile, SLAPI_STR2ENTRY_NOT_WELL_FORMED_LDIF, &records);
+    if (journal == NULL) {
+        return buf;
+    }
+    while ((entrystr = dse_read_next_entry(buf, &lastp)) != NULL) {
+        /* slapi_str2entry() parses the string in place */
+        char *copy = slapi_ch_strdup(entrystr);
+        Slapi_Entry *e = slapi_str2entry(copy, SLAPI_STR2ENTRY_NOT_WELL_FORMED_LDIF);
+        Slapi_Entry *orig = e;
+
+        slapi_ch_free_string(&copy);
+        if (e == NULL) {
+            /* left for the reader to report */
+            dse_journal_append_record(&out, &len, &size, entrystr);
+        } else if (dse_journal_replay_entry(journal, &e)) {
+            /* deleted since the file was written */
+        } else if (e == orig) {
+            dse_journal_append_record(&out, &len, &size, entrystr);
+            slapi_entry_free(e);
+        } else {
+            char *s = slapi_entry2str(e, NULL);
+            dse_journal_append_record(&out, &len, &size, s);
+            slapi_ch_free_string(&s);
+            slapi_entry_free(e);
+        }
+    }
+    /* then the entries added since the file was written */
+    for (int32_t i = 0; i < journal->djr_count; i++) {
+        if (journal->djr_entries[i] != NULL && !journal->djr_deleted[i]) {
+            char *s = slapi_entry2str(journal->djr_entries[i], NULL);
+            dse_journal_append_record(&out, &len, &size, s);
+            slapi_ch_free_string(&s);
+        }
+    }
+    dse_journal_replay_free(&journal);
+    slapi_ch_free_string(&buf);
+
+    return out ? out : slapi_ch_strdup("");
+}
+
+/*
+ * Pass an entry read from filename to the read callbacks and add it to the
+ * tree. The entry is consumed. Returns 0 if the entry is invalid.
+ */
+static int
+dse_read_add_entry(struct dse *pdse, Slapi_PBlock *pb, Slapi_Entry *e, const char *filename, int primary_file, int lineno)
+{
+    int returncode = 0;
+    char returntext[SLAPI_DSE_RETURNTEXT_SIZE] = {0};
+    int rc = 1;
+
+    slapi_log_err(SLAPI_LOG_TRACE, "dse_read_one_file",
+                  " processing entry \"%s\" in file %s%s "
+                  "(lineno: %d)\n",
+                  slapi_entry_get_dn_const(e), filename,
+                  primary_file ? " (primary file)" : "",
+                  lineno);
+
+    /* remove the numsubordinates attr, which may be bogus */
+    slapi_entry_attr_delete(e, subordinatecount);
+
+    /* set the "primary file" flag if appropriate */
+    slapi_pblock_set(pb, SLAPI_DSE_IS_PRIMARY_FILE, &primary_file);
+    if (dse_call_callback(pdse, pb, DSE_OPERATION_READ,
+                          DSE_FLAG_PREOP, e, NULL, &returncode,
+                          returntext) == SLAPI_DSE_CALLBACK_OK) {
+        /*
+         * This will free the entry if not added, so it is
+         * definitely consumed by this call
+         */
+        if (dse_add_entry_pb(pdse, e, pb) == SCHEMA_VIOLATION) {
+            /* schema violation, return failure */
+            rc = 0;
+        }
+    } else /* free entry if not used */
+    {
+        slapi_log_err(SLAPI_LOG_FATAL,
+                      "dse_read_one_file",
+                      "The entry %s in file %s "
+                      "(lineno: %d) is invalid, "
+                      "error code %d (%s) - %s\n",
+                      slapi_entry_get_dn_const(e),
+                      filename, lineno, returncode,
+                      ldap_err2string(returncode),
+                      returntext);
+        slapi_entry_free(e);
+        rc = 0; /* failure */
+    }
+    return rc;
+}
+
 static int
 dse_read_one_file(struct dse *pdse, const char *filename, Slapi_PBlock *pb, int primary_file)
 {
@@ -668,6 +1139,7 @@ dse_read_one_file(struct dse *pdse, const char *filename, Slapi_PBlock *pb, int
     PRFileInfo64 prfinfo;
     PRFileDesc *prfd = 0;
     int schema_flags = 0;
+    dse_journal_replay *journal = NULL;
 
     slapi_pblock_get(pb, SLAPI_SCHEMA_FLAGS, &schema_flags);
 
@@ -718,6 +1190,9 @@ dse_read_one_file(struct dse *pdse, const char *filename, Slapi_PBlock *pb, int
                 if (!dont_check_dups) {
                     str2entry_flags |= SLAPI_STR2ENTRY_REMOVEDUPVALS;
                 }
+                if (primary_file && pdse->dse_journal != NULL) {
+                    journal = dse_journal_load(pdse, str2entry_flags);
+                }
 
                 /* Convert LDIF to entry structures */
                 rc = 1; /* assume we will succeed */
@@ -739,45 +1214,10 @@ dse_read_one_file(struct dse *pdse, const char *filename, Slapi_PBlock *pb, int
                     }
 
                     e = slapi_str2entry(entrystr, str2entry_flags);
-                    if (e != NULL) {
-                        int returncode = 0;
-                        char returntext[SLAPI_DSE_RETURNTEXT_SIZE] = {0};
-
-                        slapi_log_err(SLAPI_LOG_TRACE, "dse_read_one_file",
-                                      " processing entry \"%s\" in file %s%s "
-                                      "(lineno: %d)\n",
-                                      slapi_entry_get_dn_const(e), filename,
-                                      primary_file ? " (primary file)" : "",
-                                      lineno);
-
-                        /* remove the numsubordinates attr, which may be bogus */
-                        slapi_entry_attr_delete(e, subordinatecount);
-
-                        /* set the "primary file" flag if appropriate */
-                        slapi_pblock_set(pb, SLAPI_DSE_IS_PRIMARY_FILE, &primary_file);
-                        if (dse_call_callback(pdse, pb, DSE_OPERATION_READ,
-                                              DSE_FLAG_PREOP, e, NULL, &returncode,
-                                              returntext) == SLAPI_DSE_CALLBACK_OK) {
-                            /*
-                             * This will free the entry if not added, so it is
-                             * definitely consumed by this call
-                             */
-                            if (dse_add_entry_pb(pdse, e, pb) == SCHEMA_VIOLATION) {
-                                /* schema violation, return failure */
-                                rc = 0;
-                            }
-                        } else /* free entry if not used */
-                        {
-                            slapi_log_err(SLAPI_LOG_FATAL,
-                                          "dse_read_one_file",
-                                          "The entry %s in file %s "
-                                          "(lineno: %d) is invalid, "
-                                          "error code %d (%s) - %s\n",
-                                          slapi_entry_get_dn_const(e),
-                                          filename, lineno, returncode,
-                                          ldap_err2string(returncode),
-                                          returntext);
-                            slapi_entry_free(e);
+                    if (e != NULL && journal != NULL && dse_journal_replay_entry(journal, &e)) {
+                        /* deleted since the file was written */
+                    } else if (e != NULL) {
+                        if (!dse_read_add_entry(pdse, pb, e, filename, primary_file, lineno)) {
                             rc = 0; /* failure */
                         }
                     } else {
@@ -792,6 +1232,20 @@ dse_read_one_file(struct dse *pdse, const char *filename, Slapi_PBlock *pb, int
                     }
                     lineno += lines + 1 /* 1 is for a blank line. */;
                 }
+
+                if (journal != NULL) {
+                    /* then the entries added since the file was written */
+                    for (int32_t i = 0; i < journal->djr_count; i++) {
+                        if ((e = journal->djr_entries[i]) == NULL || journal->djr_deleted[i]) {
+                            continue;
+                        }
+                        journal->djr_entries[i] = NULL;
+                        if (!dse_read_add_entry(pdse, pb, e, pdse->dse_journal, primary_file, 0)) {
+                            rc = 0; /* failure */
+                        }
+                    }
+                    dse_journal_replay_free(&journal);
+                }
             }
             slapi_ch_free((void **)&buf);
         }
@@ -953,6 +1407,120 @@ dse_check_for_readonly_error(Slapi_PBlock *pb, struct dse *pdse)
 }
 
 
+/*
+ * Drop the journal, once dse_filename was rewritten.
+ */
+static void
+dse_journal_reset_nolock(struct dse *pdse)
+{
+    if (pdse->dse_journal == NULL) {
+        return;
+    }
+    if (pdse->dse_journal_fd) {
+        (void)PR_Close(pdse->dse_journal_fd);
+        pdse->dse_journal_fd = NULL;
+    }
+    (void)PR_Delete(pdse->dse_journal);
+    pdse->dse_journal_records = 0;
+}
+
+/*
+ * Append the current version of the entry dn to the journal, or a delete
+ * record if it is no longer in the tree. Every record ends with an empty
+ * line, so a record torn by a crash can be told from a complete one.
+ * Returns 0 on success.
+ */
+static int
+dse_journal_write_nolock(struct dse *pdse, const Slapi_DN *dn)
+{
+    struct dse_node *n = dse_find_node(pdse, dn);
+    Slapi_Entry *ec;
+    PRFileInfo64 prfinfo;
+    char *s = NULL;
+    PRInt32 len = 0;
+    int rc = -1;
+
+    if (n != NULL) {
+        int returncode;
+        char returntext[SLAPI_DSE_RETURNTEXT_SIZE] = "";
+        /* same as dse_write_entry() */
+        ec = slapi_entry_dup(n->entry);
+        if (dse_call_callback(pdse, NULL, DSE_OPERATION_WRITE,
+                              DSE_FLAG_PREOP, ec, NULL, &returncode, returntext) == SLAPI_DSE_CALLBACK_OK) {
+            s = slapi_entry2str_with_options(ec, &len, 0);
+        }
+        slapi_entry_free(ec);
+    }
+    if (s == NULL) {
+        /* deleted, or not to be stored in the file */
+        ec = slapi_entry_alloc();
+        slapi_entry_init(ec, NULL, NULL);
+        slapi_entry_set_sdn(ec, dn);
+        slapi_entry_add_string(ec, "changetype", "delete");
+        s = slapi_entry2str(ec, &len);
+        slapi_entry_free(ec);
+    }
+
+    prfinfo.size = -1;
+    if (pdse->dse_journal_fd == NULL) {
+        pdse->dse_journal_fd = PR_Open(pdse->dse_journal, PR_WRONLY | PR_CREATE_FILE | PR_APPEND,
+                                       SLAPD_DEFAULT_FILE_MODE);
+    }
+    if (pdse->dse_journal_fd == NULL) {
+        rc = PR_GetOSError();
+        slapi_log_err(SLAPI_LOG_ERR, "dse_journal_write_nolock", "Cannot open "
+                                                                 "DSE journal \"%s\": OS error %d (%s)\n",
+                      pdse->dse_journal, rc, slapd_system_strerror(rc));
+    } else if (s == NULL ||
+               PR_GetOpenFileInfo64(pdse->dse_journal_fd, &prfinfo) != PR_SUCCESS ||
+               slapi_write_buffer(pdse->dse_journal_fd, s, len) != len ||
+               slapi_write_buffer(pdse->dse_journal_fd, "\n", 1) != 1 ||
+               PR_Sync(pdse->dse_journal_fd) != PR_SUCCESS) {
+        rc = PR_GetOSError();
+        slapi_log_err(SLAPI_LOG_ERR, "dse_journal_write_nolock", "Cannot write "
+                                                                 "DSE journal \"%s\": OS error %d (%s)\n",
+                      pdse->dse_journal, rc, slapd_system_strerror(rc));
+        /* the next record must not be appended to a partial one */
+        (void)PR_Close(pdse->dse_journal_fd);
+        pdse->dse_journal_fd = NULL;
+        if (prfinfo.size >= 0 && truncate(pdse->dse_journal, prfinfo.size) != 0) {
+            slapi_log_err(SLAPI_LOG_ERR, "dse_journal_write_nolock", "Cannot truncate "
+                                                                     "DSE journal \"%s\": OS error %d (%s)\n",
+                          pdse->dse_journal, errno, slapd_system_strerror(errno));
+        }
+        rc = -1;
+    } else {
+        pdse->dse_journal_records++;
+        rc = 0;
+    }
+    slapi_ch_free_string(&s);
+
+    return rc;
+}
+
+/*
+ * Store the change of the entry dn, made under the write lock. With a
+ * journal only that entry is written; the whole file is rewritten once the
+ * journal holds nsslapd-dse-journal-size changes, or if the journal cannot
+ * be written.
+ */
+static int
+dse_persist_entry_nolock(struct dse *pdse, const Slapi_DN *dn)
+{
+    int32_t journal_size;
+
+    if (dont_ever_write_dse_files) {
+        return 0;
+    }
+    journal_size = config_get_dse_journal_size();
+    if (pdse->dse_journal == NULL || journal_size == 0 ||
+        pdse->dse_journal_records >= journal_size ||
+        dse_journal_write_nolock(pdse, dn) != 0) {
+        return dse_write_file_nolock(pdse);
+    }
+    return 0;
+}
+
 /*
  * Write the AVL tree of entries back to the LDIF file.
  */
@@ -1019,6 +1587,10 @@ dse_write_file_nolock(struct dse *pdse)
                     fsync(fp_configdir);
                     close(fp_configdir);
                 }
+                if (rc == 0) {
+                    /* the file now holds every journaled change */
+                    dse_journal_reset_nolock(pdse);
+                }
             }
         }
         if (fpw.fpw_prfd)
@@ -1092,6 +1664,7 @@ dse_add_entry_pb(struct dse *pdse, Slapi_Entry *e, Slapi_PBlock *pb)
     int dont_write_file = 0, merge = 0; /* defaults */
     int rc = 0;
     struct dse_node *n = dse_node_new(e); /* copies e */
+    struct dse_node *old = NULL;
     Slapi_Entry *schemacheckentry = NULL; /* to use for schema checking */
 
     PR_ASSERT(pb);
@@ -1102,10 +1675,18 @@ dse_add_entry_pb(struct dse *pdse, Slapi_Entry *e, Slapi_PBlock *pb)
     if (pdse->dse_rwlock)
         slapi_rwlock_wrlock(pdse->dse_rwlock);
     if (merge) {
+        if ((old = dse_find_node(pdse, slapi_entry_get_sdn_const(e))) != NULL) {
+            dse_index_objectclasses(pdse, old, 0);
+        }
         rc = avl_insert(&(pdse->dse_tree), n, entry_dn_cmp, dupentry_merge);
     } else {
         rc = avl_insert(&(pdse->dse_tree), n, entry_dn_cmp, dupentry_disallow);
     }
+    if (old != NULL) {
+        dse_index_objectclasses(pdse, old, 1);
+    } else if (0 == rc) {
+        dse_index_node(pdse, n, 1);
+    }
     if (-1 != rc) {
         /* update num sub of parent with no lock; we already hold the write lock */
         if (0 == rc) { /* entry was added, not merged; update numsub */
@@ -1118,7 +1699,7 @@ dse_add_entry_pb(struct dse *pdse, Slapi_Entry *e, Slapi_PBlock *pb)
             dse_node_delete(&n);
         }
         if (!dont_write_file) {
-            dse_write_file_nolock(pdse);
+            dse_persist_entry_nolock(pdse, slapi_entry_get_sdn_const(e));
         }
     } else {                 /* duplicate entry ignored */
         dse_node_delete(&n); /* This also deletes the contained entry */
@@ -1291,11 +1872,20 @@ dse_replace_entry(struct dse *pdse, Slapi_Entry *e, int write_file, int use_lock
     int rc = -1;
     if (NULL != e) {
         struct dse_node *n = dse_node_new(e);
+        struct dse_node *old;
         if (use_lock && pdse->dse_rwlock)
             slapi_rwlock_wrlock(pdse->dse_rwlock);
+        if ((old = dse_find_node(pdse, slapi_entry_get_sdn_const(e))) != NULL) {
+            dse_index_objectclasses(pdse, old, 0);
+        }
         rc = avl_insert(&(pdse->dse_tree), n, entry_dn_cmp, dupentry_replace);
+        if (old != NULL) {
+            dse_index_objectclasses(pdse, old, 1);
+        } else if (0 == rc) {
+            dse_index_node(pdse, n, 1);
+        }
         if (write_file)
-            dse_write_file_nolock(pdse);
+            dse_persist_entry_nolock(pdse, slapi_entry_get_sdn_const(e));
         /* If the entry was replaced i.e. not added as a new entry, we need to
            free the old data, which is set in dupentry_replace */
         if (DSE_ENTRY_WAS_REPLACED == rc) {
@@ -1393,15 +1983,17 @@ dse_delete_entry(struct dse *pdse, Slapi_PBlock *pb, const Slapi_Entry *e)
     if (pdse->dse_rwlock)
         slapi_rwlock_wrlock(pdse->dse_rwlock);
     if ((deleted_node = (struct dse_node *)avl_delete(&pdse->dse_tree,
-                                                      n, entry_dn_cmp)))
+                                                      n, entry_dn_cmp))) {
+        dse_index_node(pdse, deleted_node, 0);
         dse_node_delete(&deleted_node);
+    }
     dse_node_delete(&n);
 
     if (!dont_write_file) {
         /* Decrement the numsubordinate count of the parent entry */
         dse_updateNumSubOfParent(pdse, slapi_entry_get_sdn_const(e),
                                  SLAPI_OPERATION_DELETE);
-        dse_write_file_nolock(pdse);
+        dse_persist_entry_nolock(pdse, slapi_entry_get_sdn_const(e));
     }
     if (pdse->dse_rwlock)
         slapi_rwlock_unlock(pdse->dse_rwlock);
@@ -1537,11 +2129,109 @@ dse_search_filter_entry(caddr_t data, caddr_t arg)
 }
 
 /*
- * The function which kicks off the traversal of the AVL tree.
+ * The objectclass a filter requires, (objectclass=x) on its own or in an
+ * and, as an objectclass index key; NULL if it has none.
+ */
+static char *
+dse_filter_objectclass(Slapi_Filter *filter)
+{
+    char *type = NULL;
+    struct berval *bval = NULL;
+
+    switch (slapi_filter_get_choice(filter)) {
+    case LDAP_FILTER_EQUALITY:
+        if (slapi_filter_get_ava(filter, &type, &bval) == 0 &&
+            strcasecmp(type, SLAPI_ATTR_OBJECTCLASS) == 0 && bval->bv_val != NULL &&
+            strlen(bval->bv_val) == bval->bv_len) {
+            return dse_index_objectclass_key(bval->bv_val);
+        }
+        break;
+    case LDAP_FILTER_AND:
+        for (Slapi_Filter *f = slapi_filter_list_first(filter); f; f = slapi_filter_list_next(filter, f)) {
+            char *key = dse_filter_objectclass(f);
+            if (key) {
+                return key;
+            }
+        }
+        break;
+    }
+    return NULL;
+}
+
+static int
+dse_node_cmp(const void *n1, const void *n2)
+{
+    return entry_dn_cmp(*(caddr_t *)n1, *(caddr_t *)n2);
+}
+
+/*
+ * Pass to dse_search_filter_entry() only the entries that can match: those
+ * in the children or subtree index under the base, or those with the
+ * objectclass the filter requires, whichever are fewer. The candidates are
+ * sorted in tree order, so the results come in the same order as from a
+ * walk of the whole tree, which is still done when most of the tree is in
+ * scope anyway.
+ */
+static void
+dse_search_nolock(struct dse *pdse, struct magicSearchStuff *stuff)
+{
+    const char *basendn = slapi_sdn_get_ndn(stuff->basedn);
+    dse_index_list *list = NULL;
+    dse_index_list *oclist = NULL;
+    struct dse_node *base = NULL;
+    struct dse_node **nodes;
+    char *oc = dse_filter_objectclass(stuff->filter);
+    int32_t count = 0;
+
+    if (stuff->scope == LDAP_SCOPE_ONELEVEL) {
+        list = (dse_index_list *)PL_HashTableLookup(pdse->dse_children_index, basendn);
+        count = list ? list->dil_count : 0;
+    } else if (*basendn == '\0') {
+        /* the root DSE is nobody's ancestor, the whole tree is in scope */
+        count = pdse->dse_entries;
+    } else {
+        list = (dse_index_list *)PL_HashTableLookup(pdse->dse_subtree_index, basendn);
+        base = dse_find_node(pdse, stuff->basedn);
+        count = (list ? list->dil_count : 0) + (base ? 1 : 0);
+    }
+    if (oc != NULL) {
+        oclist = (dse_index_list *)PL_HashTableLookup(pdse->dse_objectclass_index, oc);
+        slapi_ch_free_string(&oc);
+        if (oclist == NULL) {
+            return; /* no entry has it */
+        }
+        if (oclist->dil_count < count) {
+            list = oclist;
+            base = NULL;
+            count = oclist->dil_count;
+        }
+    }
+    if (count == 0) {
+        return;
+    }
+    if (count > pdse->dse_entries / 2) {
+        dse_apply_nolock(pdse, dse_search_filter_entry, (caddr_t)stuff);
+        return;
+    }
+
+    nodes = (struct dse_node **)slapi_ch_malloc(count * sizeof(struct dse_node *));
+    if (list) {
+        memcpy(nodes, list->dil_nodes, list->dil_count * sizeof(struct dse_node *));
+    }
+    if (base) {
+        nodes[count - 1] = base;
+    }
+    qsort(nodes, count, sizeof(struct dse_node *), dse_node_cmp);
+    for (int32_t i = 0; i < count; i++) {
+        dse_search_filter_entry((caddr_t)nodes[i], (caddr_t)stuff);
+    }
+    slapi_ch_free((void **)&nodes);
+}
+
+/*
+ * The function which kicks off the search of the DSE.
  * Returns the number of entries returned.
  */
-/* jcm: Not very efficient if there are many DSE entries. */
-/* jcm: It applies the filter to every node in the tree regardless */
 static int
 do_dse_search(struct dse *pdse, Slapi_PBlock *pb, int scope, const Slapi_DN *basedn, Slapi_Filter *filter, char **attrs, int attrsonly)
 {
@@ -1565,7 +2255,7 @@ do_dse_search(struct dse *pdse, Slapi_PBlock *pb, int scope, const Slapi_DN *bas
     if (pb_op == NULL || !operation_is_flag_set(pb_op, OP_FLAG_PS_CHANGESONLY)) {
         if (pdse->dse_rwlock)
             slapi_rwlock_rdlock(pdse->dse_rwlock);
-        dse_apply_nolock(pdse, dse_search_filter_entry, (caddr_t)&stuff);
+        dse_search_nolock(pdse, &stuff);
         if (pdse->dse_rwlock)
             slapi_rwlock_unlock(pdse->dse_rwlock);
     }
@@ -41,6 +41,8 @@ static size_t entry_vattr_size(Slapi_Entry *e);
 static struct _entry_vattr *entry_vattr_lookup_nolock(const Slapi_Entry *e, const char *attr_name);
 static void entry_vattr_add_nolock(Slapi_Entry *e, const char *type, Slapi_Attr *attr);
 static void entry_vattr_free_nolock(Slapi_Entry *e);
+static size_t entry_encoding_size(Slapi_Entry *e);
+static void entry_encoding_free_nolock(Slapi_Entry *e);
 
 /* protected attributes which are not included in the flattened entry,
  * which will be stored in the db. */
@@ -1876,6 +1878,7 @@ slapi_entry_init(Slapi_Entry *e, char *dn, Slapi_Attr *a)
     e->e_virtual_attrs = NULL;
     e->e_virtual_watermark = 0;
     e->e_virtual_lock = slapi_new_rwlock();
+    e->e_encoding = NULL;
     e->e_flags = 0;
 }
 
@@ -1891,6 +1894,7 @@ slapi_entry_init_ext(Slapi_Entry *e, Slapi_DN *sdn, Slapi_Attr *a)
     e->e_virtual_attrs = NULL;
     e->e_virtual_watermark = 0;
     e->e_virtual_lock = slapi_new_rwlock();
+    e->e_encoding = NULL;
     e->e_flags = 0;
 }
 
@@ -1910,6 +1914,7 @@ slapi_entry_free(Slapi_Entry *e) /* JCM - Should be ** so that we can NULL the p
         attrlist_free(e->e_deleted_attrs);
         VATTR_WRITE_LOCK(e);
         entry_vattr_free_nolock(e);
+        entry_encoding_free_nolock(e);
         VATTR_WRITE_UNLOCK(e);
         if (e->e_virtual_lock)
             slapi_destroy_rwlock(e->e_virtual_lock);
@@ -1966,6 +1971,7 @@ slapi_entry_size(Slapi_Entry *e)
     size += slapi_attrlist_size(e->e_deleted_attrs);
     size += slapi_attrlist_size(e->e_aux_attrs);
     size += entry_vattr_size(e);
+    size += entry_encoding_size(e);
     if (e->e_extension) {
         struct attrs_in_extension *aiep;
         int cnt;
@@ -2045,8 +2051,8 @@ slapi_entry_dup(const Slapi_Entry *e)
         lastattr = newattr;
     }
 
-    /* Copy flags as well */
-    ec->e_flags = e->e_flags;
+    /* Copy flags as well, the copy is not the one in the entry cache */
+    ec->e_flags = e->e_flags & ~SLAPI_ENTRY_CACHE_ENCODING;
 
     /* Copy extension */
     for (aiep = attrs_in_extension; aiep && aiep->ext_type; aiep++) {
@@ -2278,6 +2284,107 @@ slapi_entrycache_vattrcache_watermark_invalidate()
     }
 }
 
+/* The following functions control the cached encoding of the user
+ * attributes of an entry (e_encoding), i.e. the attribute list of the
+ * SearchResultEntry send_all_attrs() builds for a client asking for all
+ * the user attributes.
+ *
+ * Only entries held by a backend entry cache (SLAPI_ENTRY_CACHE_ENCODING)
+ * keep one.  Those entries are not modified in place: a modify replaces
+ * them in the cache with a modified copy, which starts without an encoding.
+ * What else the attribute list depends on is either recorded with the
+ * encoding (the options it was built with) or covered by the virtual
+ * attribute watermark.  Access to the encoding requires holding
+ * e_virtual_lock, like the virtual attribute cache.
+ */
+struct slapi_entry_encoding
+{
+    struct berval *ee_attrs; /* encoded PartialAttribute sequence */
+    int ee_flags;            /* options the encoding was built with */
+    int32_t ee_watermark;    /* virtual attribute watermark it was built with */
+};
+
+int
+entry_encoding_enabled(const Slapi_Entry *e)
+{
+    return (e->e_flags & SLAPI_ENTRY_CACHE_ENCODING) && config_get_search_entry_encoding_cache();
+}
+
+/*
+ * To be read before building an encoding, and passed to entry_encoding_set(),
+ * so that an encoding built while the virtual attributes changed is stale.
+ */
+int32_t
+entry_encoding_watermark(void)
+{
+    return slapi_atomic_load_32(&g_virtual_watermark, __ATOMIC_ACQUIRE);
+}
+
+/*
+ * Append the cached encoding of e built with flags to ber.
+ * Returns 0 if it was appended, 1 if there is no such encoding, and -1 if
+ * it could not be written to ber.
+ */
+int
+entry_encoding_append(Slapi_Entry *e, int flags, BerElement *ber)
+{
+    struct slapi_entry_encoding *enc;
+    int rc = 1;
+
+    VATTR_READ_LOCK(e);
+    enc = e->e_encoding;
+    if (enc && enc->ee_flags == flags && enc->ee_watermark == entry_encoding_watermark()) {
+        if (ber_write(ber, enc->ee_attrs->bv_val, enc->ee_attrs->bv_len, 0) == (ber_slen_t)enc->ee_attrs->bv_len) {
+            rc = 0;
+        } else {
+            rc = -1;
+        }
+    }
+    VATTR_READ_UNLOCK(e);
+    return rc;
+}
+
+/* Set the encoding of e, attrs is passed in */
+void
+entry_encoding_set(Slapi_Entry *e, int flags, int32_t watermark, struct berval *attrs)
+{
+    struct slapi_entry_encoding *enc;
+
+    enc = (struct slapi_entry_encoding *)slapi_ch_malloc(sizeof(struct slapi_entry_encoding));
+    enc->ee_attrs = attrs;
+    enc->ee_flags = flags;
+    enc->ee_watermark = watermark;
+
+    VATTR_WRITE_LOCK(e);
+    entry_encoding_free_nolock(e);
+    e->e_encoding = enc;
+    VATTR_WRITE_UNLOCK(e);
+}
+
+static size_t
+entry_encoding_size(Slapi_Entry *e)
+{
+    size_t size = 0;
+
+    VATTR_READ_LOCK(e);
+    if (e->e_encoding) {
+        size = sizeof(struct slapi_entry_encoding) + sizeof(struct berval) +
+               e->e_encoding->ee_attrs->bv_len;
+    }
+    VATTR_READ_UNLOCK(e);
+    return size;
+}
+
+/* The caller must hold e_virtual_lock in write mode */
+static void
+entry_encoding_free_nolock(Slapi_Entry *e)
+{
+    if (e->e_encoding) {
+        ber_bvfree(e->e_encoding->ee_attrs);
+        slapi_ch_free((void **)&e->e_encoding);
+    }
+}
+
 /* The following functions control the virtual attribute cache
  * stored in each entry (e_virtual_attrs). Access to that cache
  * requires holding a lock (e_virtual_lock)
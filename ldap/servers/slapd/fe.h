@@ -50,6 +50,7 @@ int handle_bad_certificate(void *clientData, PRFileDesc *prfd);
  * connection.c
  */
 void op_thread_cleanup(void);
+void connection_get_work_q_stats(int32_t *size, int32_t *size_max, int32_t *op_stack);
 /* do this after all worker threads have terminated */
 void connection_post_shutdown_cleanup(void);
 
@@ -108,7 +109,7 @@ void connection_table_disconnect_all(Connection_Table *ct);
 Connection *connection_table_get_connection(Connection_Table *ct, int sd);
 int connection_table_move_connection_out_of_active_list(Connection_Table *ct, Connection *c);
 void connection_table_move_connection_on_to_active_list(Connection_Table *ct, Connection *c);
-void connection_table_as_entry(Connection_Table *ct, Slapi_Entry *e);
+void connection_table_as_entry(Connection_Table *ct, Slapi_Entry *e, int with_list);
 void connection_table_dump_activity_to_errors_log(Connection_Table *ct);
 Connection *connection_table_get_first_active_connection(Connection_Table *ct);
 Connection *connection_table_get_next_active_connection(Connection_Table *ct, Connection *c);
@@ -129,6 +130,12 @@ PRFileDesc *get_ssl_listener_fd(void);
 int configure_pr_socket(PRFileDesc **pr_socket, int secure, int local);
 void configure_ns_socket(int *ns);
 
+/*
+ * metrics.c
+ */
+void metrics_start(PRFileDesc **tcps, PRFileDesc **local);
+void metrics_stop(void);
+
 /*
  * sasl_io.c
  */
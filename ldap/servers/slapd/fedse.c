@@ -103,6 +103,11 @@ static const char *internal_entries[] =
         "objectclass:extensibleObject\n"
         "cn:counters\n",
 
+        "dn:cn=latency,cn=monitor\n"
+        "objectclass:top\n"
+        "objectclass:extensibleObject\n"
+        "cn:latency\n",
+
         "dn:cn=sasl,cn=config\n"
         "objectclass:top\n"
         "objectclass:nsContainer\n"
@@ -2572,6 +2577,9 @@ init_dse_file(const char *configdir, Slapi_DN *config)
     if (pfedse == NULL) {
         pfedse = dse_new(DSE_FILENAME, DSE_TMPFILE, DSE_BACKFILE, DSE_STARTOKFILE, configdir);
         rc = (pfedse != NULL);
+        if (rc) {
+            dse_set_journal(pfedse, DSE_JOURNALFILE);
+        }
     }
     if (rc) {
         Slapi_PBlock *pb = slapi_pblock_new();
@@ -2813,6 +2821,18 @@ search_snmp(Slapi_PBlock *pb __attribute__((unused)),
     return SLAPI_DSE_CALLBACK_OK;
 }
 
+static int
+search_latency(Slapi_PBlock *pb __attribute__((unused)),
+               Slapi_Entry *entryBefore,
+               Slapi_Entry *e __attribute__((unused)),
+               int *returncode __attribute__((unused)),
+               char *returntext __attribute__((unused)),
+               void *arg __attribute__((unused)))
+{
+    latency_as_entry(entryBefore);
+    return SLAPI_DSE_CALLBACK_OK;
+}
+
 /*
  * Called from config.c to install the internal backends
  */
@@ -2832,6 +2852,7 @@ setup_internal_backends(char *configdir)
         Slapi_DN monitor;
         Slapi_DN counters;
         Slapi_DN snmp;
+        Slapi_DN latency;
         Slapi_DN root;
         Slapi_Backend *be;
         Slapi_DN encryption;
@@ -2842,6 +2863,7 @@ setup_internal_backends(char *configdir)
         slapi_sdn_init_ndn_byref(&monitor, "cn=monitor");
         slapi_sdn_init_ndn_byref(&counters, "cn=counters,cn=monitor");
         slapi_sdn_init_ndn_byref(&snmp, "cn=snmp,cn=monitor");
+        slapi_sdn_init_ndn_byref(&latency, "cn=latency,cn=monitor");
         slapi_sdn_init_ndn_byref(&diskspace, "cn=disk space,cn=monitor");
         slapi_sdn_init_ndn_byref(&root, "");
 
@@ -2857,6 +2879,7 @@ setup_internal_backends(char *configdir)
         dse_register_callback(pfedse, SLAPI_OPERATION_SEARCH, DSE_FLAG_PREOP, &monitor, LDAP_SCOPE_SUBTREE, EGG_FILTER, search_easter_egg, NULL, NULL); /* Egg */
         dse_register_callback(pfedse, SLAPI_OPERATION_SEARCH, DSE_FLAG_PREOP, &counters, LDAP_SCOPE_BASE, "(objectclass=*)", search_counters, NULL, NULL);
         dse_register_callback(pfedse, SLAPI_OPERATION_SEARCH, DSE_FLAG_PREOP, &snmp, LDAP_SCOPE_BASE, "(objectclass=*)", search_snmp, NULL, NULL);
+        dse_register_callback(pfedse, SLAPI_OPERATION_SEARCH, DSE_FLAG_PREOP, &latency, LDAP_SCOPE_BASE, "(objectclass=*)", search_latency, NULL, NULL);
         dse_register_callback(pfedse, SLAPI_OPERATION_SEARCH, DSE_FLAG_PREOP, &encryption, LDAP_SCOPE_BASE, "(objectclass=*)", search_encryption, NULL, NULL);
 
         /* Modify */
@@ -2871,6 +2894,7 @@ setup_internal_backends(char *configdir)
         dse_register_callback(pfedse, SLAPI_OPERATION_DELETE, DSE_FLAG_PREOP, &monitor, LDAP_SCOPE_BASE, "(objectclass=*)", dont_allow_that, NULL, NULL);
         dse_register_callback(pfedse, SLAPI_OPERATION_DELETE, DSE_FLAG_PREOP, &counters, LDAP_SCOPE_BASE, "(objectclass=*)", dont_allow_that, NULL, NULL);
         dse_register_callback(pfedse, SLAPI_OPERATION_DELETE, DSE_FLAG_PREOP, &snmp, LDAP_SCOPE_BASE, "(objectclass=*)", dont_allow_that, NULL, NULL);
+        dse_register_callback(pfedse, SLAPI_OPERATION_DELETE, DSE_FLAG_PREOP, &latency, LDAP_SCOPE_BASE, "(objectclass=*)", dont_allow_that, NULL, NULL);
         dse_register_callback(pfedse, SLAPI_OPERATION_DELETE, DSE_FLAG_PREOP, &root, LDAP_SCOPE_BASE, "(objectclass=*)", dont_allow_that, NULL, NULL);
         dse_register_callback(pfedse, SLAPI_OPERATION_DELETE, DSE_FLAG_PREOP, &encryption, LDAP_SCOPE_BASE, "(objectclass=*)", dont_allow_that, NULL, NULL);
         dse_register_callback(pfedse, SLAPI_OPERATION_DELETE, DSE_FLAG_PREOP, &saslmapping, LDAP_SCOPE_SUBTREE, "(objectclass=nsSaslMapping)", sasl_map_config_delete, NULL, NULL);
@@ -2904,6 +2928,7 @@ setup_internal_backends(char *configdir)
         slapi_sdn_done(&monitor);
         slapi_sdn_done(&counters);
         slapi_sdn_done(&snmp);
+        slapi_sdn_done(&latency);
         slapi_sdn_done(&root);
         slapi_sdn_done(&saslmapping);
         slapi_sdn_done(&plugins);
@@ -2926,6 +2951,10 @@ fedse_create_startOK(char *filename, char *startokfilename, const char *configdi
     char *dse_filestartOK = NULL;
     int rc = -1;
 
+    if (pfedse != NULL) {
+        /* so the copy holds the changes journaled by the last run */
+        dse_compact(pfedse);
+    }
     if (configdir != NULL) {
         realconfigdir = slapi_ch_strdup(configdir);
     } else {
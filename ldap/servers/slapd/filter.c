@@ -1601,3 +1601,55 @@ slapi_filter_changetype(Slapi_Filter *f, const char *newtype)
 bail:
     return (!target);
 }
+
+static int
+filter_type_is_virtual(Slapi_Filter *f, void *arg)
+{
+    char *type = NULL;
+
+    if (slapi_filter_get_attribute_type(f, &type) == 0 && type != NULL &&
+        vattr_type_is_virtual(NULL, type)) {
+        *(int *)arg = 1;
+        return SLAPI_FILTER_SCAN_STOP;
+    }
+    return SLAPI_FILTER_SCAN_CONTINUE;
+}
+
+/* slapi_filter_narrow
+ * -------------------
+ * turns the filter component f, in place, into (&(narrow)(f)); narrow must
+ * match at least the entries f matches, and is consumed. Handy for search
+ * rewriters that give the backend an indexed filter to take the candidates
+ * of a virtual attribute filter from. narrow is only used for the candidates:
+ * the entry tests skip it, so the attributes it holds are not subject to the
+ * search access checks and the results are those of f under any ACI.
+ * The candidates of a virtual attribute do not come from the index, so f is
+ * left alone if narrow holds one, e.g. a role filter on another role or CoS
+ * attribute. Returns 0 if f was narrowed.
+ */
+int
+slapi_filter_narrow(Slapi_Filter *f, Slapi_Filter *narrow)
+{
+    Slapi_Filter *orig;
+    int error = 0;
+    int virtual = 0;
+
+    (void)slapi_filter_apply(narrow, filter_type_is_virtual, &virtual, &error);
+    if (virtual) {
+        slapi_filter_free(narrow, 1);
+        return -1;
+    }
+
+    /* orig takes over the contents of f, f keeps its place in its list */
+    orig = (Slapi_Filter *)slapi_ch_malloc(sizeof(Slapi_Filter));
+    *orig = *f;
+    orig->f_next = NULL;
+    narrow->f_next = orig;
+    narrow->f_flags |= SLAPI_FILTER_NARROW;
+    f->f_flags = 0;
+    f->f_choice = LDAP_FILTER_AND;
+    f->assigned_decoder = NULL;
+    f->f_list = narrow;
+    filter_compute_hash(f);
+    return 0;
+}
@@ -554,6 +554,9 @@ test_filter_list(
 
     nomatch = 1;
     for (f = flist; f != NULL; f = f->f_next) {
+        if (f->f_flags & SLAPI_FILTER_NARROW) {
+            continue;
+        }
         if (slapi_filter_test_ext_internal(pb, e, f, verify_access, only_check_access, &access_check_tmp) != 0) {
             /* optimize AND evaluation */
             if (ftype == LDAP_FILTER_AND) {
@@ -977,6 +980,10 @@ vattr_test_filter_list_and(
     slapi_log_err(SLAPI_LOG_FILTER, "vattr_test_filter_list_and", "=>\n");
 
     for (f = flist; f != NULL; f = f->f_next) {
+        if (f->f_flags & SLAPI_FILTER_NARROW) {
+            /* candidate selection only, see slapi_filter_narrow() */
+            continue;
+        }
         rc = slapi_vattr_filter_test_ext_internal(pb, e, f, verify_access, only_check_access, access_check_done);
         if (rc > 0) {
             undefined = rc;
@@ -1052,3 +1059,667 @@ vattr_test_filter_list_or(
         return undefined;
     return (nomatch);
 }
+
+/*
+ * Compiled filter programs
+ *
+ * slapi_vattr_filter_test() resolves everything it needs from scratch for
+ * every entry it is applied to: the backend and virtual attribute service
+ * providers for each component type, the syntax and matching rule plugins,
+ * a fresh pblock to call them through, and a normalized copy of every value
+ * it compares.  For a search that tests thousands of candidates against the
+ * same filter that work is identical each time.
+ *
+ * slapi_filter_compile() does it once.  The filter tree is flattened in
+ * prefix order into an array of nodes where each node records the index of
+ * the node following its subtree, so the evaluator walks the children of a
+ * complex filter by skipping from one to the next.  Equality, ordering and
+ * approximate components on real attributes keep the matching function and a
+ * pblock to call it through.  For the most common equality matching rules a
+ * specialized matcher compares the raw entry values against the pre-normalized
+ * assertion without normalizing them first, as long as the value is one whose
+ * normalized form is known without doing the work (plain ASCII without
+ * redundant spaces, or a plain integer).  Any other value is handed to the
+ * matching rule plugin as before.  Substring and extensible components, and
+ * components on types a virtual attribute service provider is registered for,
+ * are delegated to slapi_vattr_filter_test_ext_internal().
+ *
+ * slapi_vattr_filter_test_program() evaluates a program with the same three
+ * valued logic and the same access control checks as
+ * slapi_vattr_filter_test_ext().
+ */
+
+typedef enum {
+    FILTER_PROG_AND,
+    FILTER_PROG_OR,
+    FILTER_PROG_NOT,
+    FILTER_PROG_AVA,
+    FILTER_PROG_PRESENT,
+    FILTER_PROG_GENERIC /* evaluate the original filter component */
+} filter_prog_op_t;
+
+typedef enum {
+    FILTER_PROG_MATCH_PLUGIN, /* always call the matching rule plugin */
+    FILTER_PROG_MATCH_CIS,    /* caseIgnoreMatch, caseIgnoreIA5Match */
+    FILTER_PROG_MATCH_CES,    /* caseExactMatch, caseExactIA5Match */
+    FILTER_PROG_MATCH_INT,    /* integerMatch */
+    FILTER_PROG_MATCH_DN      /* distinguishedNameMatch */
+} filter_prog_match_t;
+
+typedef struct filter_prog_node
+{
+    filter_prog_op_t fn_op;
+    size_t fn_next;                 /* index of the node following this subtree */
+    struct slapi_filter *fn_filter; /* the component this node was compiled from */
+    char *fn_type;                  /* attribute type, owned by fn_filter */
+    size_t fn_type_len;
+    int fn_type_has_options;
+    filter_prog_match_t fn_match;
+    const char *fn_key; /* normalized assertion value, owned by fn_filter */
+    size_t fn_key_len;
+    IFP fn_ava_fn;       /* matching rule or syntax filter_ava function */
+    Slapi_PBlock *fn_pb; /* pblock fn_ava_fn is called with */
+    int fn_filter_normalized;
+} filter_prog_node;
+
+struct slapi_filter_program
+{
+    filter_prog_node *fp_nodes;
+    size_t fp_count;
+};
+
+static int filter_program_test_node(Slapi_PBlock *pb, Slapi_Entry *e, Slapi_FilterProgram *prog, size_t idx, int verify_access, int only_check_access, int *access_check_done);
+
+static size_t
+filter_program_count(struct slapi_filter *f)
+{
+    struct slapi_filter *child;
+    size_t count = 1;
+
+    switch (f->f_choice) {
+    case LDAP_FILTER_AND:
+    case LDAP_FILTER_OR:
+        for (child = f->f_list; child != NULL; child = child->f_next) {
+            if (!(child->f_flags & SLAPI_FILTER_NARROW)) {
+                count += filter_program_count(child);
+            }
+        }
+        break;
+    case LDAP_FILTER_NOT:
+        if (f->f_not) {
+            count += filter_program_count(f->f_not);
+        }
+        break;
+    default:
+        break;
+    }
+    return count;
+}
+
+/*
+ * A value is "simple" when normalizing it for a case exact or case ignore
+ * string syntax can at most change the case of its characters: printable
+ * ASCII, no leading, trailing or consecutive spaces.
+ */
+static int
+filter_program_is_simple_string(const char *s, size_t len)
+{
+    size_t i;
+
+    if (len == 0 || s[0] == ' ' || s[len - 1] == ' ') {
+        return 0;
+    }
+    for (i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)s[i];
+        if (c < 0x20 || c > 0x7e || (c == ' ' && s[i + 1] == ' ')) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/*
+ * Split an integer value into its sign and significant digits the way the
+ * INTEGER syntax normalizes it ("-007" is "-7", "-000" is "0").
+ * Returns 0 on success, or -1 if the value is not a plain integer.
+ */
+static int
+filter_program_split_integer(const char *s, size_t len, int *negative, const char **digits, size_t *ndigits)
+{
+    const char *end = s + len;
+    const char *p = s;
+
+    *negative = 0;
+    if (p < end && *p == '-') {
+        *negative = 1;
+        p++;
+    }
+    if (p == end) {
+        return -1;
+    }
+    for (; p < end && *p == '0'; p++)
+        ;
+    *digits = p;
+    for (; p < end; p++) {
+        if (*p < '0' || *p > '9') {
+            return -1;
+        }
+    }
+    *ndigits = end - *digits;
+    if (*ndigits == 0) {
+        /* all zeros */
+        *negative = 0;
+        *digits = "0";
+        *ndigits = 1;
+    }
+    return 0;
+}
+
+/*
+ * Pick the specialized matcher for the equality matching rule of the
+ * attribute, if the assertion value lends itself to it.
+ */
+static filter_prog_match_t
+filter_program_select_match(Slapi_Attr *a, filter_prog_node *node)
+{
+    struct slapi_filter *f = node->fn_filter;
+    char **names;
+
+    if (f->f_choice != LDAP_FILTER_EQUALITY ||
+        !(f->f_flags & SLAPI_FILTER_NORMALIZED_VALUE) ||
+        (f->f_ava.ava_private == NULL) ||
+        (a->a_mr_eq_plugin == NULL) ||
+        (node->fn_key == NULL)) {
+        return FILTER_PROG_MATCH_PLUGIN;
+    }
+    names = a->a_mr_eq_plugin->plg_mr_names;
+    if (charray_utf8_inlist(names, "caseIgnoreMatch") ||
+        charray_utf8_inlist(names, "caseIgnoreIA5Match")) {
+        if (filter_program_is_simple_string(node->fn_key, node->fn_key_len)) {
+            return FILTER_PROG_MATCH_CIS;
+        }
+    } else if (charray_utf8_inlist(names, "caseExactMatch") ||
+               charray_utf8_inlist(names, "caseExactIA5Match")) {
+        if (filter_program_is_simple_string(node->fn_key, node->fn_key_len)) {
+            return FILTER_PROG_MATCH_CES;
+        }
+    } else if (charray_utf8_inlist(names, "integerMatch")) {
+        int negative;
+        const char *digits;
+        size_t ndigits;
+
+        /* the key must already be in its canonical form */
+        if (filter_program_split_integer(node->fn_key, node->fn_key_len, &negative, &digits, &ndigits) == 0 &&
+            (size_t)(negative + ndigits) == node->fn_key_len) {
+            return FILTER_PROG_MATCH_INT;
+        }
+    } else if (charray_utf8_inlist(names, "distinguishedNameMatch")) {
+        return FILTER_PROG_MATCH_DN;
+    }
+    return FILTER_PROG_MATCH_PLUGIN;
+}
+
+static void
+filter_program_compile_ava(filter_prog_node *node, Slapi_Backend *be)
+{
+    struct slapi_filter *f = node->fn_filter;
+    Slapi_Attr attr;
+
+    node->fn_type = f->f_ava.ava_type;
+    if (node->fn_type == NULL || vattr_type_is_virtual(be, node->fn_type)) {
+        node->fn_op = FILTER_PROG_GENERIC;
+        return;
+    }
+
+    /*
+     * Resolve the matching function the same way
+     * plugin_call_syntax_filter_ava_sv() does for every value it tests.
+     */
+    slapi_attr_init(&attr, node->fn_type);
+    slapi_attr_init_syntax(&attr);
+    if (f->f_choice == LDAP_FILTER_GE || f->f_choice == LDAP_FILTER_LE) {
+        if (attr.a_mr_ord_plugin) {
+            node->fn_pb = slapi_pblock_new();
+            slapi_pblock_set(node->fn_pb, SLAPI_PLUGIN, (void *)attr.a_mr_ord_plugin);
+            node->fn_ava_fn = attr.a_mr_ord_plugin->plg_mr_filter_ava;
+        } else if (attr.a_plugin &&
+                   (attr.a_plugin->plg_syntax_flags & SLAPI_PLUGIN_SYNTAX_FLAG_ORDERING)) {
+            node->fn_pb = slapi_pblock_new();
+            slapi_pblock_set(node->fn_pb, SLAPI_PLUGIN, (void *)attr.a_plugin);
+            node->fn_ava_fn = attr.a_plugin->plg_syntax_filter_ava;
+        }
+    } else if (attr.a_mr_eq_plugin) {
+        node->fn_pb = slapi_pblock_new();
+        slapi_pblock_set(node->fn_pb, SLAPI_PLUGIN, (void *)attr.a_mr_eq_plugin);
+        node->fn_ava_fn = attr.a_mr_eq_plugin->plg_mr_filter_ava;
+    } else if (attr.a_plugin) {
+        node->fn_pb = slapi_pblock_new();
+        slapi_pblock_set(node->fn_pb, SLAPI_PLUGIN, (void *)attr.a_plugin);
+        node->fn_ava_fn = attr.a_plugin->plg_syntax_filter_ava;
+    }
+    if (node->fn_ava_fn == NULL) {
+        /* let the regular code path report the problem */
+        slapi_pblock_destroy(node->fn_pb);
+        node->fn_pb = NULL;
+        attr_done(&attr);
+        node->fn_op = FILTER_PROG_GENERIC;
+        return;
+    }
+    if (f->f_ava.ava_private) {
+        node->fn_filter_normalized = *(int *)f->f_ava.ava_private | SLAPI_FILTER_NORMALIZED_VALUE;
+        slapi_pblock_set(node->fn_pb, SLAPI_PLUGIN_SYNTAX_FILTER_NORMALIZED, &node->fn_filter_normalized);
+    }
+
+    node->fn_op = FILTER_PROG_AVA;
+    node->fn_type_len = strlen(node->fn_type);
+    node->fn_type_has_options = (strchr(node->fn_type, ';') != NULL);
+    node->fn_key = f->f_ava.ava_value.bv_val;
+    /* bv_len is not updated when the value is normalized in place */
+    node->fn_key_len = node->fn_key ? strlen(node->fn_key) : 0;
+    node->fn_match = filter_program_select_match(&attr, node);
+    attr_done(&attr);
+}
+
+static void
+filter_program_compile_present(filter_prog_node *node, Slapi_Backend *be)
+{
+    node->fn_type = node->fn_filter->f_type;
+    if (node->fn_type == NULL || vattr_type_is_virtual(be, node->fn_type)) {
+        node->fn_op = FILTER_PROG_GENERIC;
+        return;
+    }
+    node->fn_op = FILTER_PROG_PRESENT;
+}
+
+static void
+filter_program_emit(Slapi_FilterProgram *prog, struct slapi_filter *f, Slapi_Backend *be)
+{
+    size_t idx = prog->fp_count++;
+    filter_prog_node *node = &prog->fp_nodes[idx];
+    struct slapi_filter *child;
+
+    node->fn_filter = f;
+    switch (f->f_choice) {
+    case LDAP_FILTER_AND:
+    case LDAP_FILTER_OR:
+        node->fn_op = (f->f_choice == LDAP_FILTER_AND) ? FILTER_PROG_AND : FILTER_PROG_OR;
+        for (child = f->f_list; child != NULL; child = child->f_next) {
+            if (!(child->f_flags & SLAPI_FILTER_NARROW)) {
+                filter_program_emit(prog, child, be);
+            }
+        }
+        break;
+    case LDAP_FILTER_NOT:
+        node->fn_op = FILTER_PROG_NOT;
+        if (f->f_not) {
+            filter_program_emit(prog, f->f_not, be);
+        } else {
+            node->fn_op = FILTER_PROG_GENERIC;
+        }
+        break;
+    case LDAP_FILTER_EQUALITY:
+    case LDAP_FILTER_GE:
+    case LDAP_FILTER_LE:
+    case LDAP_FILTER_APPROX:
+        filter_program_compile_ava(node, be);
+        break;
+    case LDAP_FILTER_PRESENT:
+        filter_program_compile_present(node, be);
+        break;
+    default:
+        node->fn_op = FILTER_PROG_GENERIC;
+        break;
+    }
+    node->fn_next = prog->fp_count;
+}
+
+/*
+ * slapi_filter_compile - compile f into a program for
+ * slapi_vattr_filter_test_program().  be is the backend the entries tested
+ * against the program belong to, used to resolve virtual attributes.
+ *
+ * The program keeps pointers into f: f must outlive the program and must not
+ * be modified while the program is in use.  For equality components the
+ * specialized matchers are only used when the values in f have been
+ * normalized and ava_private carries the filter flags, as done by the
+ * backend before the candidates are tested.
+ */
+Slapi_FilterProgram *
+slapi_filter_compile(Slapi_Filter *f, Slapi_Backend *be)
+{
+    Slapi_FilterProgram *prog;
+    size_t count;
+
+    if (f == NULL) {
+        return NULL;
+    }
+    count = filter_program_count(f);
+    prog = (Slapi_FilterProgram *)slapi_ch_calloc(1, sizeof(Slapi_FilterProgram));
+    prog->fp_nodes = (filter_prog_node *)slapi_ch_calloc(count, sizeof(filter_prog_node));
+    filter_program_emit(prog, f, be);
+    PR_ASSERT(prog->fp_count == count);
+
+    if (slapi_is_loglevel_set(SLAPI_LOG_FILTER)) {
+        size_t i, fast = 0, generic = 0;
+        for (i = 0; i < prog->fp_count; i++) {
+            if (prog->fp_nodes[i].fn_op == FILTER_PROG_GENERIC) {
+                generic++;
+            } else if (prog->fp_nodes[i].fn_match != FILTER_PROG_MATCH_PLUGIN) {
+                fast++;
+            }
+        }
+        slapi_log_err(SLAPI_LOG_FILTER, "slapi_filter_compile",
+                      "%lu nodes, %lu with a specialized matcher, %lu evaluated by the generic code\n",
+                      (unsigned long)prog->fp_count, (unsigned long)fast, (unsigned long)generic);
+    }
+    return prog;
+}
+
+void
+slapi_filter_program_free(Slapi_FilterProgram **prog)
+{
+    size_t i;
+
+    if (prog == NULL || *prog == NULL) {
+        return;
+    }
+    for (i = 0; i < (*prog)->fp_count; i++) {
+        slapi_pblock_destroy((*prog)->fp_nodes[i].fn_pb);
+    }
+    slapi_ch_free((void **)&(*prog)->fp_nodes);
+    slapi_ch_free((void **)prog);
+}
+
+/*
+ * Same as slapi_attr_type_cmp(node type, type, SLAPI_TYPE_CMP_SUBTYPE) == 0,
+ * without walking the options when the filter type has none.
+ */
+static int
+filter_program_type_match(const filter_prog_node *node, const char *type)
+{
+    if (node->fn_type_has_options) {
+        return slapi_attr_type_cmp(node->fn_type, type, SLAPI_TYPE_CMP_SUBTYPE) == 0;
+    }
+    return strncasecmp(node->fn_type, type, node->fn_type_len) == 0 &&
+           (type[node->fn_type_len] == '\0' || type[node->fn_type_len] == ';');
+}
+
+/*
+ * Compare one entry value with the specialized matcher of node.
+ * Returns 0 if it matches, -1 if it does not, and 1 if the matcher cannot
+ * tell and the value must go through the matching rule plugin.
+ */
+static int
+filter_program_match_value(const filter_prog_node *node, const struct berval *bv)
+{
+    switch (node->fn_match) {
+    case FILTER_PROG_MATCH_CIS:
+    case FILTER_PROG_MATCH_CES:
+        if (!filter_program_is_simple_string(bv->bv_val, bv->bv_len)) {
+            return 1;
+        }
+        if (bv->bv_len != node->fn_key_len) {
+            return -1;
+        }
+        if (node->fn_match == FILTER_PROG_MATCH_CIS) {
+            return strncasecmp(bv->bv_val, node->fn_key, bv->bv_len) ? -1 : 0;
+        }
+        return memcmp(bv->bv_val, node->fn_key, bv->bv_len) ? -1 : 0;
+
+    case FILTER_PROG_MATCH_INT: {
+        int negative;
+        const char *digits;
+        size_t ndigits;
+
+        if (filter_program_split_integer(bv->bv_val, bv->bv_len, &negative, &digits, &ndigits) != 0) {
+            return 1;
+        }
+        if ((size_t)(negative + ndigits) != node->fn_key_len ||
+            (negative != (node->fn_key[0] == '-'))) {
+            return -1;
+        }
+        return memcmp(digits, node->fn_key + negative, ndigits) ? -1 : 0;
+    }
+
+    case FILTER_PROG_MATCH_DN: {
+        char buf[BUFSIZ];
+        char *copy = buf;
+        char *dest = NULL;
+        size_t dlen = 0;
+        int rc, match;
+
+        if (bv->bv_len >= sizeof(buf)) {
+            copy = slapi_ch_malloc(bv->bv_len + 1);
+        }
+        memcpy(copy, bv->bv_val, bv->bv_len);
+        copy[bv->bv_len] = '\0';
+        rc = slapi_dn_normalize_case_ext(copy, bv->bv_len, &dest, &dlen);
+        if (rc < 0) {
+            match = 1;
+        } else {
+            if (rc == 0) {
+                /* normalized in place; not terminated */
+                dest[dlen] = '\0';
+            }
+            match = slapi_utf8casecmp((unsigned char *)dest, (unsigned char *)node->fn_key) ? -1 : 0;
+            if (rc > 0) {
+                slapi_ch_free_string(&dest);
+            }
+        }
+        if (copy != buf) {
+            slapi_ch_free_string(&copy);
+        }
+        return match;
+    }
+
+    default:
+        return 1;
+    }
+}
+
+static int
+filter_program_test_ava(const filter_prog_node *node, Slapi_Entry *e)
+{
+    struct slapi_filter *f = node->fn_filter;
+    Slapi_Attr *a;
+    int rc = -1;
+
+    for (a = e->e_attrs; a != NULL; a = a->a_next) {
+        Slapi_Value **va;
+        int fallback = 0;
+        size_t i;
+
+        if (!filter_program_type_match(node, a->a_type)) {
+            continue;
+        }
+        va = valueset_get_valuearray(&a->a_present_values);
+        if (va == NULL) {
+            rc = -1;
+            continue;
+        }
+        if (node->fn_match != FILTER_PROG_MATCH_PLUGIN) {
+            rc = -1;
+            for (i = 0; va[i] != NULL; i++) {
+                int vrc = filter_program_match_value(node, slapi_value_get_berval(va[i]));
+                if (vrc == 0) {
+                    return 0;
+                } else if (vrc > 0) {
+                    fallback = 1;
+                }
+            }
+            if (!fallback) {
+                continue;
+            }
+        }
+        rc = (*node->fn_ava_fn)(node->fn_pb, &f->f_ava.ava_value, va, f->f_choice, NULL);
+        if (rc == 0) {
+            break;
+        }
+    }
+    return rc;
+}
+
+static int
+filter_program_test_leaf(Slapi_PBlock *pb, Slapi_Entry *e, const filter_prog_node *node, int verify_access, int only_check_access, int *access_check_done)
+{
+    struct slapi_filter *f = node->fn_filter;
+    int rc = LDAP_SUCCESS;
+
+    if (node->fn_op == FILTER_PROG_GENERIC) {
+        return slapi_vattr_filter_test_ext_internal(pb, e, f, verify_access, only_check_access, access_check_done);
+    }
+
+    if (verify_access) {
+        rc = test_filter_access(pb, e, node->fn_type,
+                                (node->fn_op == FILTER_PROG_AVA) ? &f->f_ava.ava_value : NULL);
+        *access_check_done = 1;
+    }
+    if (only_check_access || rc != LDAP_SUCCESS) {
+        return (rc);
+    }
+
+    if (node->fn_op == FILTER_PROG_AVA) {
+        rc = filter_program_test_ava(node, e);
+    } else {
+        void *hint = NULL;
+        rc = attrlist_find_ex(e->e_attrs, node->fn_type, NULL, NULL, &hint) != NULL ? 0 : -1;
+    }
+    return rc;
+}
+
+/* Mirrors vattr_test_filter_list_and() */
+static int
+filter_program_test_and(Slapi_PBlock *pb, Slapi_Entry *e, Slapi_FilterProgram *prog, size_t idx, int verify_access, int only_check_access, int *access_check_done)
+{
+    int nomatch = -1;
+    int undefined = 0;
+    int rc = 0;
+    size_t child;
+
+    for (child = idx + 1; child < prog->fp_nodes[idx].fn_next; child = prog->fp_nodes[child].fn_next) {
+        rc = filter_program_test_node(pb, e, prog, child, verify_access, only_check_access, access_check_done);
+        if (rc > 0) {
+            undefined = rc;
+        } else if (rc < 0) {
+            undefined = 0;
+            nomatch = -1;
+            break;
+        } else {
+            if (!verify_access || (*access_check_done)) {
+                nomatch = 0;
+            } else {
+                /* check access */
+                rc = filter_program_test_node(pb, e, prog, child, verify_access, 1, access_check_done);
+                if (rc)
+                    undefined = rc;
+            }
+        }
+    }
+
+    if (undefined)
+        return undefined;
+    return (nomatch);
+}
+
+/* Mirrors vattr_test_filter_list_or() */
+static int
+filter_program_test_or(Slapi_PBlock *pb, Slapi_Entry *e, Slapi_FilterProgram *prog, size_t idx, int verify_access, int only_check_access, int *access_check_done)
+{
+    int nomatch = 1;
+    int undefined = 0;
+    int rc = 0;
+    size_t child;
+
+    for (child = idx + 1; child < prog->fp_nodes[idx].fn_next; child = prog->fp_nodes[child].fn_next) {
+        if (verify_access) {
+            /* we do access check first */
+            rc = filter_program_test_node(pb, e, prog, child, verify_access, -1, access_check_done);
+            if (rc != 0) {
+                /* no access to this component, ignore it */
+                undefined = rc;
+                continue;
+            }
+        }
+        if (only_check_access)
+            continue;
+        /* now check if filter matches */
+        undefined = 0;
+        rc = filter_program_test_node(pb, e, prog, child, 0, 0, access_check_done);
+        if (rc == 0) {
+            undefined = 0;
+            nomatch = 0;
+            break;
+        } else if (rc > 0) {
+            undefined = rc;
+        } else {
+            /* filter didn't match, but we have one or component evaluated */
+            nomatch = -1;
+        }
+    }
+
+    if (nomatch == 1)
+        return undefined;
+    return (nomatch);
+}
+
+/* Mirrors the LDAP_FILTER_NOT case of slapi_vattr_filter_test_ext_internal() */
+static int
+filter_program_test_not(Slapi_PBlock *pb, Slapi_Entry *e, Slapi_FilterProgram *prog, size_t idx, int verify_access, int only_check_access, int *access_check_done)
+{
+    int rc;
+
+    rc = filter_program_test_node(pb, e, prog, idx + 1, verify_access, only_check_access, access_check_done);
+    if (verify_access && only_check_access) {
+        /* dont play with access control return codes */
+        return rc;
+    }
+    if (rc > 0) {
+        /* an error occurred or access denied, don't negate */
+        return rc;
+    }
+    if (verify_access && !(*access_check_done)) {
+        /* the filter failed so access control was not checked, for NOT
+         * filters this is significant so make sure it is */
+        int rc2 = filter_program_test_node(pb, e, prog, idx + 1, verify_access, -1 /*only_check_access*/, access_check_done);
+        if (rc2) {
+            return rc2;
+        }
+    }
+    return (rc == 0) ? -1 : 0;
+}
+
+static int
+filter_program_test_node(Slapi_PBlock *pb, Slapi_Entry *e, Slapi_FilterProgram *prog, size_t idx, int verify_access, int only_check_access, int *access_check_done)
+{
+    switch (prog->fp_nodes[idx].fn_op) {
+    case FILTER_PROG_AND:
+        return filter_program_test_and(pb, e, prog, idx, verify_access, only_check_access, access_check_done);
+    case FILTER_PROG_OR:
+        return filter_program_test_or(pb, e, prog, idx, verify_access, only_check_access, access_check_done);
+    case FILTER_PROG_NOT:
+        return filter_program_test_not(pb, e, prog, idx, verify_access, only_check_access, access_check_done);
+    default:
+        return filter_program_test_leaf(pb, e, &prog->fp_nodes[idx], verify_access, only_check_access, access_check_done);
+    }
+}
+
+/*
+ * slapi_vattr_filter_test_program - test a compiled filter against an entry.
+ * Same arguments and return codes as slapi_vattr_filter_test_ext(), with the
+ * filter replaced by the program compiled from it.
+ */
+int
+slapi_vattr_filter_test_program(
+    Slapi_PBlock *pb,
+    Slapi_Entry *e,
+    Slapi_FilterProgram *prog,
+    int verify_access,
+    int only_check_access)
+{
+    int access_check_done = 0;
+
+    if (prog == NULL || prog->fp_count == 0) {
+        return (0);
+    }
+    return filter_program_test_node(pb, e, prog, 0, verify_access, only_check_access, &access_check_done);
+}
@@ -0,0 +1,255 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/*
+ * histogram.c
+ *
+ * Latency histograms, and the latencies of the operations by type, by
+ * backend and by plugin served from cn=latency,cn=monitor.
+ *
+ * A histogram is log-linear, in the manner of HdrHistogram: the values below
+ * 8 usec have a bucket each, above that every power of two is cut in 8
+ * buckets, so a percentile is within 12.5% of the value recorded. Recording
+ * is an atomic increment of the bucket, there is no lock: readers add up
+ * buckets that may move while they read, which only matters for the last
+ * few operations.
+ */
+
+#include "slap.h"
+
+#define HISTOGRAM_SUB_BITS 3
+#define HISTOGRAM_SUB (1 << HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_MAX_BIT 39 /* 2^40 usec, about 12 days */
+#define HISTOGRAM_BUCKETS ((HISTOGRAM_MAX_BIT - HISTOGRAM_SUB_BITS + 2) * HISTOGRAM_SUB)
+
+struct slapi_histogram
+{
+    uint64_t h_buckets[HISTOGRAM_BUCKETS];
+    uint64_t h_sum; /* usec */
+    uint64_t h_max; /* usec */
+};
+
+static size_t
+histogram_bucket(uint64_t usec)
+{
+    int msb;
+
+    if (usec < HISTOGRAM_SUB) {
+        return (size_t)usec;
+    }
+    msb = 63 - __builtin_clzll(usec);
+    if (msb > HISTOGRAM_MAX_BIT) {
+        return HISTOGRAM_BUCKETS - 1;
+    }
+    return (size_t)(msb - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB +
+           ((usec >> (msb - HISTOGRAM_SUB_BITS)) & (HISTOGRAM_SUB - 1));
+}
+
+/* the highest value that lands in the bucket */
+static uint64_t
+histogram_bucket_value(size_t bucket)
+{
+    size_t major = bucket / HISTOGRAM_SUB;
+    uint64_t shift;
+
+    if (major == 0) {
+        return (uint64_t)bucket;
+    }
+    shift = major - 1;
+    return (((uint64_t)HISTOGRAM_SUB + bucket % HISTOGRAM_SUB + 1) << shift) - 1;
+}
+
+Slapi_Histogram *
+histogram_new(void)
+{
+    return (Slapi_Histogram *)slapi_ch_calloc(1, sizeof(Slapi_Histogram));
+}
+
+void
+histogram_destroy(Slapi_Histogram **h)
+{
+    slapi_ch_free((void **)h);
+}
+
+/*
+ * Return the histogram *hp, allocating it on first use. Threads racing to
+ * allocate it agree on one of theirs.
+ */
+Slapi_Histogram *
+histogram_get(Slapi_Histogram **hp)
+{
+    Slapi_Histogram *h = __atomic_load_n(hp, __ATOMIC_ACQUIRE);
+
+    if (h == NULL) {
+        Slapi_Histogram *mine = histogram_new();
+        if (__atomic_compare_exchange_n(hp, &h, mine, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            h = mine;
+        } else {
+            histogram_destroy(&mine);
+        }
+    }
+    return h;
+}
+
+void
+histogram_record(Slapi_Histogram *h, uint64_t usec)
+{
+    uint64_t max = __atomic_load_n(&h->h_max, __ATOMIC_RELAXED);
+
+    __atomic_add_fetch(&h->h_buckets[histogram_bucket(usec)], 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&h->h_sum, usec, __ATOMIC_RELAXED);
+    while (usec > max &&
+           !__atomic_compare_exchange_n(&h->h_max, &max, usec, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        /* max was reloaded, retry while ours is still bigger */
+    }
+}
+
+/*
+ * Summarize h as "<name>: count=N avg=.. p50=.. p90=.. p99=.. p999=.. max=..",
+ * the times in usec, or return NULL if nothing was recorded.
+ */
+char *
+histogram_format(const char *name, Slapi_Histogram *h)
+{
+    static const double pcts[] = {0.50, 0.90, 0.99, 0.999};
+    uint64_t buckets[HISTOGRAM_BUCKETS];
+    uint64_t values[4] = {0};
+    uint64_t count = 0;
+    uint64_t seen = 0;
+    uint64_t max;
+    size_t p = 0;
+
+    if (h == NULL) {
+        return NULL;
+    }
+    for (size_t i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        buckets[i] = __atomic_load_n(&h->h_buckets[i], __ATOMIC_RELAXED);
+        count += buckets[i];
+    }
+    if (count == 0) {
+        return NULL;
+    }
+    max = __atomic_load_n(&h->h_max, __ATOMIC_RELAXED);
+    for (size_t i = 0; i < HISTOGRAM_BUCKETS && p < 4; i++) {
+        seen += buckets[i];
+        while (p < 4 && seen >= (uint64_t)(pcts[p] * count + 0.5) && seen > 0) {
+            /* the bucket bound can be above anything recorded */
+            values[p] = histogram_bucket_value(i) < max ? histogram_bucket_value(i) : max;
+            p++;
+        }
+    }
+
+    return slapi_ch_smprintf("%s: count=%" PRIu64 " avg=%" PRIu64 " p50=%" PRIu64 " p90=%" PRIu64
+                             " p99=%" PRIu64 " p999=%" PRIu64 " max=%" PRIu64,
+                             name, count, __atomic_load_n(&h->h_sum, __ATOMIC_RELAXED) / count,
+                             values[0], values[1], values[2], values[3], max);
+}
+
+/*
+ * Replace type in e with the summaries of the histograms, values is freed.
+ */
+void
+histogram_attr_replace(Slapi_Entry *e, const char *type, char **values)
+{
+    slapi_entry_attr_delete(e, type);
+    for (size_t i = 0; values && values[i]; i++) {
+        slapi_entry_add_string(e, type, values[i]);
+    }
+    charray_free(values);
+}
+
+/*
+ * Operation latencies, from the time the operation was read to the end of
+ * its processing: the etime of the access log.
+ */
+
+static const struct
+{
+    ber_tag_t tag;
+    const char *name;
+} latency_ops[] = {
+    {LDAP_REQ_BIND, "bind"},
+    {LDAP_REQ_SEARCH, "search"},
+    {LDAP_REQ_MODIFY, "modify"},
+    {LDAP_REQ_ADD, "add"},
+    {LDAP_REQ_DELETE, "delete"},
+    {LDAP_REQ_MODRDN, "modrdn"},
+    {LDAP_REQ_COMPARE, "compare"},
+    {LDAP_REQ_EXTENDED, "extended"},
+};
+
+#define LATENCY_OPS (sizeof(latency_ops) / sizeof(latency_ops[0]))
+
+static Slapi_Histogram latency_op_histograms[LATENCY_OPS];
+
+/*
+ * Called by the worker thread once the operation is done. The backend
+ * latency goes to the backend the operation was last sent to.
+ */
+void
+latency_record_operation(Slapi_PBlock *pb, Operation *op)
+{
+    struct timespec elapsed;
+    Slapi_Backend *be = NULL;
+    uint64_t usec;
+    size_t i;
+
+    if (op->o_flags & OP_FLAG_PS) {
+        /* a persistent search runs until the client abandons it */
+        return;
+    }
+    for (i = 0; i < LATENCY_OPS && latency_ops[i].tag != op->o_tag; i++)
+        ;
+    if (i == LATENCY_OPS) {
+        return;
+    }
+
+    slapi_operation_time_elapsed(op, &elapsed);
+    usec = (uint64_t)elapsed.tv_sec * 1000000 + (uint64_t)elapsed.tv_nsec / 1000;
+    histogram_record(&latency_op_histograms[i], usec);
+
+    slapi_pblock_get(pb, SLAPI_BACKEND, &be);
+    if (be) {
+        histogram_record(histogram_get(&be->be_latency), usec);
+    }
+}
+
+/*
+ * cn=latency,cn=monitor: one value per operation type in oplatency, per
+ * backend in backendlatency and per plugin in pluginlatency.
+ */
+void
+latency_as_entry(Slapi_Entry *e)
+{
+    char **values = NULL;
+    Slapi_Backend *be;
+    char *cookie = NULL;
+    char *value;
+
+    for (size_t i = 0; i < LATENCY_OPS; i++) {
+        if ((value = histogram_format(latency_ops[i].name, &latency_op_histograms[i]))) {
+            charray_add(&values, value);
+        }
+    }
+    histogram_attr_replace(e, "oplatency", values);
+
+    values = NULL;
+    for (be = slapi_get_first_backend(&cookie); be; be = slapi_get_next_backend(cookie)) {
+        if ((value = histogram_format(be->be_name, __atomic_load_n(&be->be_latency, __ATOMIC_ACQUIRE)))) {
+            charray_add(&values, value);
+        }
+    }
+    slapi_ch_free_string(&cookie);
+    histogram_attr_replace(e, "backendlatency", values);
+
+    plugin_latency_as_entry(e);
+}
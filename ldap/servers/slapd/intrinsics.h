@@ -84,3 +84,57 @@ strncasecmp_fast(const char *dst, const char *src, int n)
 #undef strncasecmp
 #endif
 #define strncasecmp(x, y, z) strncasecmp_fast(x, y, z)
+
+/*
+ * Word at a time helpers: eight bytes of a string are tested or case folded
+ * with a handful of integer operations instead of one branch per byte.
+ * Loads go through memcpy, so the pointers need no alignment, but the caller
+ * must make sure eight bytes are readable.
+ */
+#define SWAR_ONES 0x0101010101010101ULL
+#define SWAR_HIGHS 0x8080808080808080ULL
+
+INLINE_DIRECTIVE static uint64_t
+swar_load(const void *p)
+{
+    uint64_t w;
+    memcpy(&w, p, sizeof(w));
+    return w;
+}
+
+/* non zero if one of the bytes of w is 0 */
+INLINE_DIRECTIVE static uint64_t
+swar_has_zero(uint64_t w)
+{
+    return (w - SWAR_ONES) & ~w & SWAR_HIGHS;
+}
+
+/* non zero if one of the bytes of w is c */
+INLINE_DIRECTIVE static uint64_t
+swar_has_byte(uint64_t w, unsigned char c)
+{
+    return swar_has_zero(w ^ (SWAR_ONES * c));
+}
+
+/* non zero if one of the bytes of w is not 7 bit ASCII */
+INLINE_DIRECTIVE static uint64_t
+swar_has_nonascii(uint64_t w)
+{
+    return w & SWAR_HIGHS;
+}
+
+/* non zero if one of the bytes of w is less than n, n must be at most 128 */
+INLINE_DIRECTIVE static uint64_t
+swar_has_less(uint64_t w, unsigned char n)
+{
+    return (w - SWAR_ONES * n) & ~w & SWAR_HIGHS;
+}
+
+/* lower case the letters of w, all bytes of w must be 7 bit ASCII */
+INLINE_DIRECTIVE static uint64_t
+swar_ascii_tolower(uint64_t w)
+{
+    uint64_t ge_a = w + SWAR_ONES * (0x80 - 'A');
+    uint64_t gt_z = w + SWAR_ONES * (0x80 - 'Z' - 1);
+    return w | (((ge_a ^ gt_z) & SWAR_HIGHS) >> 2);
+}
@@ -257,6 +257,7 @@ slapi_int_t init_malloc_mmap_threshold;
 #endif
 slapi_onoff_t init_extract_pem;
 slapi_onoff_t init_ignore_vattrs;
+slapi_onoff_t init_search_entry_encoding_cache;
 slapi_onoff_t init_enable_upgrade_hash;
 slapi_special_filter_verify_t init_verify_filter_schema;
 slapi_onoff_t init_enable_ldapssotoken;
@@ -1089,6 +1090,50 @@ static struct config_get_and_set
      NULL, 0,
      (void **)&global_slapdFrontendConfig.ignore_vattrs,
      CONFIG_ON_OFF, (ConfigGetFunc)config_get_ignore_vattrs, &init_ignore_vattrs, NULL},
+    {CONFIG_SEARCH_ENTRY_ENCODING_CACHE, config_set_search_entry_encoding_cache,
+     NULL, 0,
+     (void **)&global_slapdFrontendConfig.search_entry_encoding_cache,
+     CONFIG_ON_OFF, (ConfigGetFunc)config_get_search_entry_encoding_cache, &init_search_entry_encoding_cache, NULL},
+    {CONFIG_SEARCH_OUTPUT_BUFFER_SIZE, config_set_search_output_buffer_size,
+     NULL, 0,
+     (void **)&global_slapdFrontendConfig.search_output_buffer_size,
+     CONFIG_INT, NULL, SLAPD_DEFAULT_SEARCH_OUTPUT_BUFFER_SIZE_STR, NULL},
+    {CONFIG_SEARCH_OUTPUT_BUFFER_DELAY, config_set_search_output_buffer_delay,
+     NULL, 0,
+     (void **)&global_slapdFrontendConfig.search_output_buffer_delay,
+     CONFIG_INT, NULL, SLAPD_DEFAULT_SEARCH_OUTPUT_BUFFER_DELAY_STR, NULL},
+    {CONFIG_PWD_CRYPTO_THREADS, config_set_pwd_crypto_threads,
+     NULL, 0,
+     (void **)&global_slapdFrontendConfig.pwd_crypto_threads,
+     CONFIG_INT, NULL, SLAPD_DEFAULT_PWD_CRYPTO_THREADS_STR, NULL},
+    {CONFIG_PWD_CRYPTO_QUEUE_SIZE, config_set_pwd_crypto_queue_size,
+     NULL, 0,
+     (void **)&global_slapdFrontendConfig.pwd_crypto_queue_size,
+     CONFIG_INT, NULL, SLAPD_DEFAULT_PWD_CRYPTO_QUEUE_SIZE_STR, NULL},
+    {CONFIG_PWD_CRYPTO_QUEUE_TIMEOUT, config_set_pwd_crypto_queue_timeout,
+     NULL, 0,
+     (void **)&global_slapdFrontendConfig.pwd_crypto_queue_timeout,
+     CONFIG_INT, NULL, SLAPD_DEFAULT_PWD_CRYPTO_QUEUE_TIMEOUT_STR, NULL},
+    {CONFIG_PWD_VERIFY_CACHE_TTL, config_set_pwd_verify_cache_ttl,
+     NULL, 0,
+     (void **)&global_slapdFrontendConfig.pwd_verify_cache_ttl,
+     CONFIG_INT, NULL, SLAPD_DEFAULT_PWD_VERIFY_CACHE_TTL_STR, NULL},
+    {CONFIG_DSE_JOURNAL_SIZE, config_set_dse_journal_size,
+     NULL, 0,
+     (void **)&global_slapdFrontendConfig.dse_journal_size,
+     CONFIG_INT, NULL, SLAPD_DEFAULT_DSE_JOURNAL_SIZE_STR, NULL},
+    {CONFIG_METRICS_PORT, config_set_metrics_port,
+     NULL, 0,
+     (void **)&global_slapdFrontendConfig.metrics_port,
+     CONFIG_INT, NULL, SLAPD_DEFAULT_METRICS_PORT_STR, NULL},
+    {CONFIG_METRICS_LISTENHOST, config_set_metrics_listenhost,
+     NULL, 0,
+     (void **)&global_slapdFrontendConfig.metrics_listenhost,
+     CONFIG_STRING, NULL, SLAPD_DEFAULT_METRICS_LISTENHOST, NULL /* Empty value is allowed */},
+    {CONFIG_METRICS_SOCKET, config_set_metrics_socket,
+     NULL, 0,
+     (void **)&global_slapdFrontendConfig.metrics_socket,
+     CONFIG_STRING, NULL, "", NULL /* Empty value is allowed */},
     {CONFIG_UNHASHED_PW_SWITCH_ATTRIBUTE, config_set_unhashed_pw_switch,
      NULL, 0,
      (void **)&global_slapdFrontendConfig.unhashed_pw_switch,
@@ -1615,6 +1660,16 @@ FrontendConfig_init(void)
     cfg->reservedescriptors = SLAPD_DEFAULT_RESERVE_FDS;
     cfg->idletimeout = SLAPD_DEFAULT_IDLE_TIMEOUT;
     cfg->ioblocktimeout = SLAPD_DEFAULT_IOBLOCK_TIMEOUT;
+    cfg->search_output_buffer_size = SLAPD_DEFAULT_SEARCH_OUTPUT_BUFFER_SIZE;
+    cfg->search_output_buffer_delay = SLAPD_DEFAULT_SEARCH_OUTPUT_BUFFER_DELAY;
+    cfg->pwd_crypto_threads = SLAPD_DEFAULT_PWD_CRYPTO_THREADS;
+    cfg->pwd_crypto_queue_size = SLAPD_DEFAULT_PWD_CRYPTO_QUEUE_SIZE;
+    cfg->pwd_crypto_queue_timeout = SLAPD_DEFAULT_PWD_CRYPTO_QUEUE_TIMEOUT;
+    cfg->pwd_verify_cache_ttl = SLAPD_DEFAULT_PWD_VERIFY_CACHE_TTL;
+    cfg->dse_journal_size = SLAPD_DEFAULT_DSE_JOURNAL_SIZE;
+    cfg->metrics_port = SLAPD_DEFAULT_METRICS_PORT;
+    cfg->metrics_listenhost = slapi_ch_strdup(SLAPD_DEFAULT_METRICS_LISTENHOST);
+    cfg->metrics_socket = slapi_ch_strdup("");
     cfg->outbound_ldap_io_timeout = SLAPD_DEFAULT_OUTBOUND_LDAP_IO_TIMEOUT;
     cfg->max_filter_nest_level = SLAPD_DEFAULT_MAX_FILTER_NEST_LEVEL;
     cfg->maxsasliosize = SLAPD_DEFAULT_MAX_SASLIO_SIZE;
@@ -1776,6 +1831,7 @@ FrontendConfig_init(void)
     cfg->ndn_cache_max_size = SLAPD_DEFAULT_NDN_SIZE;
     init_sasl_mapping_fallback = cfg->sasl_mapping_fallback = LDAP_OFF;
     init_ignore_vattrs = cfg->ignore_vattrs = LDAP_OFF;
+    init_search_entry_encoding_cache = cfg->search_entry_encoding_cache = LDAP_OFF;
     cfg->sasl_max_bufsize = SLAPD_DEFAULT_SASL_MAXBUFSIZE;
     cfg->unhashed_pw_switch = SLAPD_DEFAULT_UNHASHED_PW_SWITCH;
     init_return_orig_type = cfg->return_orig_type = LDAP_OFF;
@@ -1973,6 +2029,17 @@ config_set_ignore_vattrs(const char *attrname, char *value, char *errorbuf, int
     return retVal;
 }
 
+int32_t
+config_set_search_entry_encoding_cache(const char *attrname, char *value, char *errorbuf, int apply)
+{
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+    int32_t retVal = LDAP_SUCCESS;
+
+    retVal = config_set_onoff(attrname, value, &(slapdFrontendConfig->search_entry_encoding_cache), errorbuf, apply);
+
+    return retVal;
+}
+
 int32_t
 config_set_sasl_mapping_fallback(const char *attrname, char *value, char *errorbuf, int apply)
 {
@@ -4621,6 +4688,286 @@ config_set_ioblocktimeout(const char *attrname, char *value, char *errorbuf, int
     return retVal;
 }
 
+int
+config_set_search_output_buffer_size(const char *attrname, char *value, char *errorbuf, int apply)
+{
+    int retVal = LDAP_SUCCESS;
+    int32_t nValue = 0;
+    char *endp = NULL;
+
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+
+    if (config_value_is_null(attrname, value, errorbuf, 0)) {
+        return LDAP_OPERATIONS_ERROR;
+    }
+
+    errno = 0;
+    nValue = (int32_t)strtol(value, &endp, 10);
+
+    if (*endp != '\0' || errno == ERANGE || nValue < 0 || nValue > 16 * 1024 * 1024) {
+        slapi_create_errormsg(errorbuf, SLAPI_DSE_RETURNTEXT_SIZE, "%s: invalid value \"%s\", search output buffer size must range from 0 to %d",
+                              attrname, value, 16 * 1024 * 1024);
+        retVal = LDAP_OPERATIONS_ERROR;
+        return retVal;
+    }
+
+    if (apply) {
+        slapi_atomic_store_32(&(slapdFrontendConfig->search_output_buffer_size), nValue, __ATOMIC_RELEASE);
+    }
+    return retVal;
+}
+
+int
+config_set_search_output_buffer_delay(const char *attrname, char *value, char *errorbuf, int apply)
+{
+    int retVal = LDAP_SUCCESS;
+    int32_t nValue = 0;
+    char *endp = NULL;
+
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+
+    if (config_value_is_null(attrname, value, errorbuf, 0)) {
+        return LDAP_OPERATIONS_ERROR;
+    }
+
+    errno = 0;
+    nValue = (int32_t)strtol(value, &endp, 10);
+
+    if (*endp != '\0' || errno == ERANGE || nValue < 0 || nValue > 60000) {
+        slapi_create_errormsg(errorbuf, SLAPI_DSE_RETURNTEXT_SIZE, "%s: invalid value \"%s\", search output buffer delay must range from 0 to 60000 ms",
+                              attrname, value);
+        retVal = LDAP_OPERATIONS_ERROR;
+        return retVal;
+    }
+
+    if (apply) {
+        slapi_atomic_store_32(&(slapdFrontendConfig->search_output_buffer_delay), nValue, __ATOMIC_RELEASE);
+    }
+    return retVal;
+}
+
+int
+config_set_pwd_crypto_threads(const char *attrname, char *value, char *errorbuf, int apply)
+{
+    int retVal = LDAP_SUCCESS;
+    int32_t nValue = 0;
+    char *endp = NULL;
+
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+
+    if (config_value_is_null(attrname, value, errorbuf, 0)) {
+        return LDAP_OPERATIONS_ERROR;
+    }
+
+    errno = 0;
+    nValue = (int32_t)strtol(value, &endp, 10);
+
+    if (*endp != '\0' || errno == ERANGE || nValue < -1 || nValue > 512) {
+        slapi_create_errormsg(errorbuf, SLAPI_DSE_RETURNTEXT_SIZE, "%s: invalid value \"%s\", password compare threads must range from -1 to 512",
+                              attrname, value);
+        retVal = LDAP_OPERATIONS_ERROR;
+        return retVal;
+    }
+    if (pw_crypto_check_config(nValue, config_get_pwd_crypto_queue_size(), errorbuf) != 0) {
+        return LDAP_UNWILLING_TO_PERFORM;
+    }
+
+    if (apply) {
+        slapi_atomic_store_32(&(slapdFrontendConfig->pwd_crypto_threads), nValue, __ATOMIC_RELEASE);
+    }
+    return retVal;
+}
+
+int
+config_set_pwd_crypto_queue_size(const char *attrname, char *value, char *errorbuf, int apply)
+{
+    int retVal = LDAP_SUCCESS;
+    int32_t nValue = 0;
+    char *endp = NULL;
+
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+
+    if (config_value_is_null(attrname, value, errorbuf, 0)) {
+        return LDAP_OPERATIONS_ERROR;
+    }
+
+    errno = 0;
+    nValue = (int32_t)strtol(value, &endp, 10);
+
+    if (*endp != '\0' || errno == ERANGE || nValue < -1 || nValue == 0 || nValue > 65535) {
+        slapi_create_errormsg(errorbuf, SLAPI_DSE_RETURNTEXT_SIZE, "%s: invalid value \"%s\", password compare queue size must be -1 or range from 1 to 65535",
+                              attrname, value);
+        retVal = LDAP_OPERATIONS_ERROR;
+        return retVal;
+    }
+    if (pw_crypto_check_config(config_get_pwd_crypto_threads(), nValue, errorbuf) != 0) {
+        return LDAP_UNWILLING_TO_PERFORM;
+    }
+
+    if (apply) {
+        slapi_atomic_store_32(&(slapdFrontendConfig->pwd_crypto_queue_size), nValue, __ATOMIC_RELEASE);
+    }
+    return retVal;
+}
+
+int
+config_set_pwd_crypto_queue_timeout(const char *attrname, char *value, char *errorbuf, int apply)
+{
+    int retVal = LDAP_SUCCESS;
+    int32_t nValue = 0;
+    char *endp = NULL;
+
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+
+    if (config_value_is_null(attrname, value, errorbuf, 0)) {
+        return LDAP_OPERATIONS_ERROR;
+    }
+
+    errno = 0;
+    nValue = (int32_t)strtol(value, &endp, 10);
+
+    if (*endp != '\0' || errno == ERANGE || nValue < 0 || nValue > 3600000) {
+        slapi_create_errormsg(errorbuf, SLAPI_DSE_RETURNTEXT_SIZE, "%s: invalid value \"%s\", password compare queue timeout must range from 0 to 3600000",
+                              attrname, value);
+        retVal = LDAP_OPERATIONS_ERROR;
+        return retVal;
+    }
+
+    if (apply) {
+        slapi_atomic_store_32(&(slapdFrontendConfig->pwd_crypto_queue_timeout), nValue, __ATOMIC_RELEASE);
+    }
+    return retVal;
+}
+
+int
+config_set_pwd_verify_cache_ttl(const char *attrname, char *value, char *errorbuf, int apply)
+{
+    int retVal = LDAP_SUCCESS;
+    int32_t nValue = 0;
+    char *endp = NULL;
+
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+
+    if (config_value_is_null(attrname, value, errorbuf, 0)) {
+        return LDAP_OPERATIONS_ERROR;
+    }
+
+    errno = 0;
+    nValue = (int32_t)strtol(value, &endp, 10);
+
+    if (*endp != '\0' || errno == ERANGE || nValue < 0 || nValue > 86400) {
+        slapi_create_errormsg(errorbuf, SLAPI_DSE_RETURNTEXT_SIZE, "%s: invalid value \"%s\", password verification cache ttl must range from 0 to 86400",
+                              attrname, value);
+        retVal = LDAP_OPERATIONS_ERROR;
+        return retVal;
+    }
+
+    if (apply) {
+        slapi_atomic_store_32(&(slapdFrontendConfig->pwd_verify_cache_ttl), nValue, __ATOMIC_RELEASE);
+    }
+    return retVal;
+}
+
+int
+config_set_dse_journal_size(const char *attrname, char *value, char *errorbuf, int apply)
+{
+    int retVal = LDAP_SUCCESS;
+    int32_t nValue = 0;
+    char *endp = NULL;
+
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+
+    if (config_value_is_null(attrname, value, errorbuf, 0)) {
+        return LDAP_OPERATIONS_ERROR;
+    }
+
+    errno = 0;
+    nValue = (int32_t)strtol(value, &endp, 10);
+
+    if (*endp != '\0' || errno == ERANGE || nValue < 0 || nValue > 65536) {
+        slapi_create_errormsg(errorbuf, SLAPI_DSE_RETURNTEXT_SIZE, "%s: invalid value \"%s\", DSE journal size must range from 0 to 65536",
+                              attrname, value);
+        retVal = LDAP_OPERATIONS_ERROR;
+        return retVal;
+    }
+
+    if (apply) {
+        slapi_atomic_store_32(&(slapdFrontendConfig->dse_journal_size), nValue, __ATOMIC_RELEASE);
+    }
+    return retVal;
+}
+
+int
+config_set_metrics_port(const char *attrname, char *value, char *errorbuf, int apply)
+{
+    int retVal = LDAP_SUCCESS;
+    int32_t nValue = 0;
+    char *endp = NULL;
+
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+
+    if (config_value_is_null(attrname, value, errorbuf, 0)) {
+        return LDAP_OPERATIONS_ERROR;
+    }
+
+    errno = 0;
+    nValue = (int32_t)strtol(value, &endp, 10);
+
+    if (*endp != '\0' || errno == ERANGE || nValue < 0 || nValue > LDAP_PORT_MAX) {
+        slapi_create_errormsg(errorbuf, SLAPI_DSE_RETURNTEXT_SIZE, "%s: invalid value \"%s\", metrics port must range from 0 to %d",
+                              attrname, value, LDAP_PORT_MAX);
+        retVal = LDAP_OPERATIONS_ERROR;
+        return retVal;
+    }
+
+    if (apply) {
+        slapi_atomic_store_32(&(slapdFrontendConfig->metrics_port), nValue, __ATOMIC_RELEASE);
+    }
+    return retVal;
+}
+
+int
+config_set_metrics_listenhost(const char *attrname __attribute__((unused)), char *value, char *errorbuf __attribute__((unused)), int apply)
+{
+    int retVal = LDAP_SUCCESS;
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+
+    if (apply) {
+        CFG_LOCK_WRITE(slapdFrontendConfig);
+
+        slapi_ch_free((void **)&(slapdFrontendConfig->metrics_listenhost));
+        slapdFrontendConfig->metrics_listenhost = slapi_ch_strdup(value);
+
+        CFG_UNLOCK_WRITE(slapdFrontendConfig);
+    }
+    return retVal;
+}
+
+int
+config_set_metrics_socket(const char *attrname, char *value, char *errorbuf, int apply)
+{
+    int retVal = LDAP_SUCCESS;
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+    /* same limit as nsslapd-ldapifilepath */
+    size_t result_size = sizeof(PRNetAddr) - 8;
+
+    if (value && strlen(value) >= result_size) {
+        slapi_create_errormsg(errorbuf, SLAPI_DSE_RETURNTEXT_SIZE, "%s: \"%s\" is invalid, its length must be less than %zu",
+                              attrname, value, result_size);
+        return LDAP_OPERATIONS_ERROR;
+    }
+
+    if (apply) {
+        CFG_LOCK_WRITE(slapdFrontendConfig);
+
+        slapi_ch_free((void **)&(slapdFrontendConfig->metrics_socket));
+        slapdFrontendConfig->metrics_socket = slapi_ch_strdup(value);
+
+        CFG_UNLOCK_WRITE(slapdFrontendConfig);
+    }
+    return retVal;
+}
+
 
 int
 config_set_idletimeout(const char *attrname, char *value, char *errorbuf, int apply)
@@ -5122,6 +5469,14 @@ config_get_ignore_vattrs()
     return (int)slapdFrontendConfig->ignore_vattrs;
 }
 
+int
+config_get_search_entry_encoding_cache()
+{
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+
+    return (int)slapdFrontendConfig->search_entry_encoding_cache;
+}
+
 int32_t
 config_get_sasl_mapping_fallback()
 {
@@ -5979,6 +6334,88 @@ config_get_ioblocktimeout()
     return slapi_atomic_load_32(&(slapdFrontendConfig->ioblocktimeout), __ATOMIC_ACQUIRE);
 }
 
+int32_t
+config_get_search_output_buffer_size()
+{
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+    return slapi_atomic_load_32(&(slapdFrontendConfig->search_output_buffer_size), __ATOMIC_ACQUIRE);
+}
+
+int32_t
+config_get_search_output_buffer_delay()
+{
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+    return slapi_atomic_load_32(&(slapdFrontendConfig->search_output_buffer_delay), __ATOMIC_ACQUIRE);
+}
+
+int32_t
+config_get_pwd_crypto_threads()
+{
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+    return slapi_atomic_load_32(&(slapdFrontendConfig->pwd_crypto_threads), __ATOMIC_ACQUIRE);
+}
+
+int32_t
+config_get_pwd_crypto_queue_size()
+{
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+    return slapi_atomic_load_32(&(slapdFrontendConfig->pwd_crypto_queue_size), __ATOMIC_ACQUIRE);
+}
+
+int32_t
+config_get_pwd_crypto_queue_timeout()
+{
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+    return slapi_atomic_load_32(&(slapdFrontendConfig->pwd_crypto_queue_timeout), __ATOMIC_ACQUIRE);
+}
+
+int32_t
+config_get_pwd_verify_cache_ttl()
+{
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+    return slapi_atomic_load_32(&(slapdFrontendConfig->pwd_verify_cache_ttl), __ATOMIC_ACQUIRE);
+}
+
+int32_t
+config_get_dse_journal_size()
+{
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+    return slapi_atomic_load_32(&(slapdFrontendConfig->dse_journal_size), __ATOMIC_ACQUIRE);
+}
+
+int32_t
+config_get_metrics_port()
+{
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+    return slapi_atomic_load_32(&(slapdFrontendConfig->metrics_port), __ATOMIC_ACQUIRE);
+}
+
+char *
+config_get_metrics_listenhost(void)
+{
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+    char *retVal;
+
+    CFG_LOCK_READ(slapdFrontendConfig);
+    retVal = config_copy_strval(slapdFrontendConfig->metrics_listenhost);
+    CFG_UNLOCK_READ(slapdFrontendConfig);
+
+    return retVal;
+}
+
+char *
+config_get_metrics_socket(void)
+{
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+    char *retVal;
+
+    CFG_LOCK_READ(slapdFrontendConfig);
+    retVal = config_copy_strval(slapdFrontendConfig->metrics_socket);
+    CFG_UNLOCK_READ(slapdFrontendConfig);
+
+    return retVal;
+}
+
 int
 config_get_idletimeout()
 {
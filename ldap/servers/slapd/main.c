@@ -782,6 +782,37 @@ main(int argc, char **argv)
         }
 #endif /* ENABLE_LDAPI */
 
+        ports_info.m_port = config_get_metrics_port();
+        if (ports_info.m_port) {
+            char *metricshost = config_get_metrics_listenhost();
+            if (metricshost && *metricshost == '\0') {
+                /* listen on all interfaces */
+                slapi_ch_free_string(&metricshost);
+            }
+            if (slapd_listenhost2addr(metricshost,
+                                      &ports_info.m_listenaddr) != 0 ||
+                ports_info.m_listenaddr == NULL) {
+                slapi_ch_free_string(&metricshost);
+                return (1);
+            }
+            slapi_ch_free_string(&metricshost);
+        }
+#if defined(ENABLE_LDAPI)
+        {
+            char *metricssocket = config_get_metrics_socket();
+            if (metricssocket && *metricssocket) {
+                ports_info.m_local_listenaddr = (PRNetAddr **)slapi_ch_calloc(2, sizeof(PRNetAddr *));
+                *ports_info.m_local_listenaddr = (PRNetAddr *)slapi_ch_calloc(1, sizeof(PRNetAddr));
+                (*ports_info.m_local_listenaddr)->local.family = PR_AF_LOCAL;
+                PL_strncpyz((*ports_info.m_local_listenaddr)->local.path,
+                            metricssocket,
+                            sizeof((*ports_info.m_local_listenaddr)->local.path));
+                unlink((*ports_info.m_local_listenaddr)->local.path);
+            }
+            slapi_ch_free_string(&metricssocket);
+        }
+#endif /* ENABLE_LDAPI */
+
         return_value = daemon_pre_setuid_init(&ports_info);
         if (0 != return_value) {
             slapi_log_err(SLAPI_LOG_ERR, "main", "Failed to init daemon\n");
@@ -0,0 +1,447 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/*
+ * metrics.c
+ *
+ * The metrics exporter: a scraper sends "GET /metrics" over HTTP to
+ * nsslapd-metrics-port or nsslapd-metrics-socket, and is answered with the
+ * counters, the backend caches, the database cache and the work queue in
+ * the Prometheus text exposition format.
+ *
+ * The sockets are opened with the LDAP listeners (see daemon.c) but are not
+ * in the connection table: one thread accepts the scrapes and answers them
+ * itself, so a scrape costs no connection slot, no worker thread and no
+ * cn=monitor entry. The numbers are read the way the monitor entries read
+ * them, there is no authentication: the exporter listens on the loopback
+ * address by default.
+ */
+
+#include "slap.h"
+#include "fe.h"
+
+#define METRICS_POLL_MS 250      /* how soon metrics_stop() is noticed */
+#define METRICS_IO_TIMEOUT 5     /* seconds a scraper may take to send or read */
+#define METRICS_REQUEST_SIZE 1024 /* the request line is all we look at */
+
+static PRThread *metrics_thread_p = NULL;
+static PRPollDesc *metrics_pds = NULL;
+static PRIntn metrics_npds = 0;
+static int32_t metrics_shutdown = 0;
+
+typedef struct metrics_counter
+{
+    const char *name;
+    const char *type;
+    const char *help;
+    size_t offset; /* of the counter in struct snmp_ops_tbl_t */
+} metrics_counter;
+
+static const metrics_counter metrics_ops_counters[] = {
+    {"ds_anonymous_binds_total", "counter", "Anonymous binds", offsetof(struct snmp_ops_tbl_t, dsAnonymousBinds)},
+    {"ds_unauth_binds_total", "counter", "Unauthenticated binds", offsetof(struct snmp_ops_tbl_t, dsUnAuthBinds)},
+    {"ds_simple_auth_binds_total", "counter", "Simple binds", offsetof(struct snmp_ops_tbl_t, dsSimpleAuthBinds)},
+    {"ds_strong_auth_binds_total", "counter", "SASL and certificate binds", offsetof(struct snmp_ops_tbl_t, dsStrongAuthBinds)},
+    {"ds_bind_security_errors_total", "counter", "Binds rejected for invalid credentials", offsetof(struct snmp_ops_tbl_t, dsBindSecurityErrors)},
+    {"ds_in_ops_total", "counter", "Operations received", offsetof(struct snmp_ops_tbl_t, dsInOps)},
+    {"ds_read_ops_total", "counter", "Base searches", offsetof(struct snmp_ops_tbl_t, dsReadOps)},
+    {"ds_compare_ops_total", "counter", "Compare operations", offsetof(struct snmp_ops_tbl_t, dsCompareOps)},
+    {"ds_add_entry_ops_total", "counter", "Add operations", offsetof(struct snmp_ops_tbl_t, dsAddEntryOps)},
+    {"ds_remove_entry_ops_total", "counter", "Delete operations", offsetof(struct snmp_ops_tbl_t, dsRemoveEntryOps)},
+    {"ds_modify_entry_ops_total", "counter", "Modify operations", offsetof(struct snmp_ops_tbl_t, dsModifyEntryOps)},
+    {"ds_modify_rdn_ops_total", "counter", "Modrdn operations", offsetof(struct snmp_ops_tbl_t, dsModifyRDNOps)},
+    {"ds_list_ops_total", "counter", "One level searches", offsetof(struct snmp_ops_tbl_t, dsListOps)},
+    {"ds_search_ops_total", "counter", "Search operations", offsetof(struct snmp_ops_tbl_t, dsSearchOps)},
+    {"ds_onelevel_search_ops_total", "counter", "One level search operations", offsetof(struct snmp_ops_tbl_t, dsOneLevelSearchOps)},
+    {"ds_wholesubtree_search_ops_total", "counter", "Subtree search operations", offsetof(struct snmp_ops_tbl_t, dsWholeSubtreeSearchOps)},
+    {"ds_referrals_total", "counter", "Referrals returned", offsetof(struct snmp_ops_tbl_t, dsReferrals)},
+    {"ds_chainings_total", "counter", "Operations chained", offsetof(struct snmp_ops_tbl_t, dsChainings)},
+    {"ds_security_errors_total", "counter", "Operations failed for security reasons", offsetof(struct snmp_ops_tbl_t, dsSecurityErrors)},
+    {"ds_errors_total", "counter", "Operations failed", offsetof(struct snmp_ops_tbl_t, dsErrors)},
+    {"ds_connections", "gauge", "Connections open", offsetof(struct snmp_ops_tbl_t, dsConnections)},
+    {"ds_connections_total", "counter", "Connections accepted", offsetof(struct snmp_ops_tbl_t, dsConnectionSeq)},
+    {"ds_received_bytes_total", "counter", "Bytes read from clients", offsetof(struct snmp_ops_tbl_t, dsBytesRecv)},
+    {"ds_sent_bytes_total", "counter", "Bytes sent to clients", offsetof(struct snmp_ops_tbl_t, dsBytesSent)},
+    {"ds_entries_returned_total", "counter", "Entries returned by searches", offsetof(struct snmp_ops_tbl_t, dsEntriesReturned)},
+    {"ds_referrals_returned_total", "counter", "Search continuation references returned", offsetof(struct snmp_ops_tbl_t, dsReferralsReturned)},
+    {"ds_max_threads_hits_total", "counter", "Times a connection reached its maximum of threads", offsetof(struct snmp_ops_tbl_t, dsMaxThreadsHits)},
+    {"ds_connections_in_max_threads", "gauge", "Connections at their maximum of threads", offsetof(struct snmp_ops_tbl_t, dsConnectionsInMaxThreads)},
+};
+
+#define METRICS_OPS_COUNTERS (sizeof(metrics_ops_counters) / sizeof(metrics_ops_counters[0]))
+
+typedef struct metrics_backend
+{
+    const char *name;
+    back_info_metrics m;
+} metrics_backend;
+
+typedef struct metrics_dbenv
+{
+    const char *name;
+    back_info_dbenv_metrics m;
+} metrics_dbenv;
+
+static void
+metrics_family(lenstr *out, const char *name, const char *type, const char *help)
+{
+    char buf[512];
+
+    snprintf(buf, sizeof(buf), "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+    addlenstr(out, buf);
+}
+
+/* label values are escaped as the exposition format wants */
+static void
+metrics_label_escape(char *buf, size_t size, const char *value)
+{
+    size_t i = 0;
+
+    for (; *value && i + 2 < size; value++) {
+        if (*value == '\\' || *value == '"') {
+            buf[i++] = '\\';
+            buf[i++] = *value;
+        } else if (*value == '\n') {
+            buf[i++] = '\\';
+            buf[i++] = 'n';
+        } else {
+            buf[i++] = *value;
+        }
+    }
+    buf[i] = '\0';
+}
+
+static void
+metrics_value(lenstr *out, const char *name, const char *label, const char *label_value, uint64_t value)
+{
+    char buf[512];
+
+    if (label) {
+        char escaped[256];
+        metrics_label_escape(escaped, sizeof(escaped), label_value);
+        snprintf(buf, sizeof(buf), "%s{%s=\"%s\"} %" PRIu64 "\n", name, label, escaped, value);
+    } else {
+        snprintf(buf, sizeof(buf), "%s %" PRIu64 "\n", name, value);
+    }
+    addlenstr(out, buf);
+}
+
+static void
+metrics_scalar(lenstr *out, const char *name, const char *type, const char *help, uint64_t value)
+{
+    metrics_family(out, name, type, help);
+    metrics_value(out, name, NULL, NULL, value);
+}
+
+/*
+ * Render the families of one cache of the backends, cache is the offset of
+ * the back_info_cache_metrics in back_info_metrics.
+ */
+static void
+metrics_render_caches(lenstr *out, metrics_backend *backends, size_t nbackends, const char *prefix, size_t cache, PRBool dn)
+{
+    char name[128];
+
+#define CACHE_OF(_b) ((back_info_cache_metrics *)((char *)&(_b)->m + cache))
+#define CACHE_FAMILY(_suffix, _type, _help, _field)                        \
+    do {                                                                   \
+        snprintf(name, sizeof(name), "%s_%s", prefix, _suffix);            \
+        metrics_family(out, name, _type, _help);                           \
+        for (size_t i = 0; i < nbackends; i++) {                           \
+            if (!dn || backends[i].m.has_dn_cache) {                       \
+                metrics_value(out, name, "backend", backends[i].name,      \
+                              (uint64_t)CACHE_OF(&backends[i])->_field);   \
+            }                                                              \
+        }                                                                  \
+    } while (0)
+
+    CACHE_FAMILY("hits_total", "counter", "Lookups found in the cache", hits);
+    CACHE_FAMILY("tries_total", "counter", "Lookups in the cache", tries);
+    CACHE_FAMILY("entries", "gauge", "Entries in the cache", count);
+    CACHE_FAMILY("size_bytes", "gauge", "Bytes used by the cache", size);
+    CACHE_FAMILY("max_size_bytes", "gauge", "Maximum bytes of the cache", maxsize);
+
+#undef CACHE_FAMILY
+#undef CACHE_OF
+}
+
+/*
+ * Render the metrics into out. The counters are read without lock, as the
+ * monitor entries do; the caches and the database cache are asked to the
+ * backends through slapi_back_ctrl_info(), once per database environment
+ * for the latter.
+ */
+static void
+metrics_render(lenstr *out)
+{
+    struct snmp_vars_t *snmp_vars = g_get_global_snmp_vars();
+    metrics_backend *backends = NULL;
+    metrics_dbenv *dbenvs = NULL;
+    size_t nbackends = 0;
+    size_t ndbenvs = 0;
+    struct slapdplugin **databases = NULL;
+    Slapi_Backend *be;
+    char *cookie = NULL;
+    int32_t work_q_size, work_q_size_max, op_stack_size;
+
+    for (size_t i = 0; i < METRICS_OPS_COUNTERS; i++) {
+        Slapi_Counter *c = *(Slapi_Counter **)((char *)&snmp_vars->ops_tbl + metrics_ops_counters[i].offset);
+        if (c) {
+            metrics_scalar(out, metrics_ops_counters[i].name, metrics_ops_counters[i].type,
+                           metrics_ops_counters[i].help, slapi_counter_get_value(c));
+        }
+    }
+    metrics_scalar(out, "ds_ops_initiated_total", "counter", "Operations started",
+                   slapi_counter_get_value(ops_initiated));
+    metrics_scalar(out, "ds_ops_completed_total", "counter", "Operations completed",
+                   slapi_counter_get_value(ops_completed));
+    metrics_scalar(out, "ds_result_writes_total", "counter", "Writes of results to clients",
+                   g_get_num_result_writes());
+    metrics_scalar(out, "ds_threads", "gauge", "Threads of the server",
+                   g_get_active_threadcnt());
+
+    connection_get_work_q_stats(&work_q_size, &work_q_size_max, &op_stack_size);
+    metrics_scalar(out, "ds_work_queue_depth", "gauge", "Operations waiting for a worker thread",
+                   (uint64_t)work_q_size);
+    metrics_scalar(out, "ds_work_queue_depth_max", "gauge", "Most operations that waited for a worker thread",
+                   (uint64_t)work_q_size_max);
+    metrics_scalar(out, "ds_operation_stack_size", "gauge", "Operations kept for reuse",
+                   (uint64_t)op_stack_size);
+    metrics_scalar(out, "ds_start_time_seconds", "gauge", "Start time of the server since the epoch",
+                   (uint64_t)starttime);
+
+    for (be = slapi_get_first_backend(&cookie); be; be = slapi_get_next_backend(cookie)) {
+        back_info_metrics m = {0};
+        back_info_dbenv_metrics dm = {0};
+        size_t j;
+
+        if (be->be_private || slapi_back_ctrl_info(be, BACK_INFO_METRICS, &m) != 0) {
+            continue;
+        }
+        backends = (metrics_backend *)slapi_ch_realloc((char *)backends, (nbackends + 1) * sizeof(*backends));
+        backends[nbackends].name = be->be_name;
+        backends[nbackends].m = m;
+        nbackends++;
+
+        for (j = 0; j < ndbenvs && databases[j] != be->be_database; j++)
+            ;
+        if (j == ndbenvs && slapi_back_ctrl_info(be, BACK_INFO_DBENV_METRICS, &dm) == 0) {
+            databases = (struct slapdplugin **)slapi_ch_realloc((char *)databases, (ndbenvs + 1) * sizeof(*databases));
+            dbenvs = (metrics_dbenv *)slapi_ch_realloc((char *)dbenvs, (ndbenvs + 1) * sizeof(*dbenvs));
+            databases[ndbenvs] = be->be_database;
+            dbenvs[ndbenvs].name = be->be_database->plg_name;
+            dbenvs[ndbenvs].m = dm;
+            ndbenvs++;
+        }
+    }
+    slapi_ch_free_string(&cookie);
+
+    if (nbackends) {
+        metrics_render_caches(out, backends, nbackends, "ds_entry_cache",
+                              offsetof(back_info_metrics, entry_cache), PR_FALSE);
+        metrics_render_caches(out, backends, nbackends, "ds_dn_cache",
+                              offsetof(back_info_metrics, dn_cache), PR_TRUE);
+    }
+
+#define DBENV_FAMILY(_name, _type, _help, _field)                                                  \
+    do {                                                                                           \
+        metrics_family(out, _name, _type, _help);                                                  \
+        for (size_t i = 0; i < ndbenvs; i++) {                                                     \
+            metrics_value(out, _name, "database", dbenvs[i].name, dbenvs[i].m._field);           \
+        }                                                                                          \
+    } while (0)
+
+    if (ndbenvs) {
+        DBENV_FAMILY("ds_db_cache_hits_total", "counter", "Pages found in the database cache", cache_hits);
+        DBENV_FAMILY("ds_db_cache_misses_total", "counter", "Pages not found in the database cache", cache_misses);
+        DBENV_FAMILY("ds_db_cache_pages", "gauge", "Pages in the database cache", pages);
+        DBENV_FAMILY("ds_db_cache_dirty_pages", "gauge", "Dirty pages in the database cache", pages_dirty);
+        DBENV_FAMILY("ds_db_cache_page_in_total", "counter", "Pages read into the database cache", page_in);
+        DBENV_FAMILY("ds_db_cache_page_out_total", "counter", "Pages written from the database cache", page_out);
+        DBENV_FAMILY("ds_db_cache_clean_evictions_total", "counter", "Clean pages evicted from the database cache", ro_evict);
+        DBENV_FAMILY("ds_db_cache_dirty_evictions_total", "counter", "Dirty pages evicted from the database cache", rw_evict);
+    }
+
+#undef DBENV_FAMILY
+
+    slapi_ch_free((void **)&backends);
+    slapi_ch_free((void **)&dbenvs);
+    slapi_ch_free((void **)&databases);
+}
+
+static int
+metrics_send(PRFileDesc *fd, const char *buf, size_t len)
+{
+    PRIntervalTime timeout = PR_SecondsToInterval(METRICS_IO_TIMEOUT);
+
+    while (len > 0) {
+        PRInt32 n = PR_Send(fd, buf, (PRInt32)len, 0, timeout);
+        if (n <= 0) {
+            return -1;
+        }
+        buf += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+static void
+metrics_reply(PRFileDesc *fd, const char *status, const char *body, size_t len)
+{
+    char header[256];
+
+    snprintf(header, sizeof(header),
+             "HTTP/1.1 %s\r\n"
+             "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+             "Content-Length: %zu\r\n"
+             "Connection: close\r\n\r\n",
+             status, len);
+    if (metrics_send(fd, header, strlen(header)) == 0) {
+        metrics_send(fd, body, len);
+    }
+}
+
+/* Answer the request of one scraper */
+static void
+metrics_serve(PRFileDesc *fd)
+{
+    PRIntervalTime timeout = PR_SecondsToInterval(METRICS_IO_TIMEOUT);
+    char request[METRICS_REQUEST_SIZE];
+    size_t len = 0;
+    char *path;
+    char *end;
+
+    /* read up to the end of the headers, or as much as fits */
+    while (len < sizeof(request) - 1) {
+        PRInt32 n = PR_Recv(fd, request + len, (PRInt32)(sizeof(request) - 1 - len), 0, timeout);
+        if (n <= 0) {
+            return;
+        }
+        len += (size_t)n;
+        request[len] = '\0';
+        if (strstr(request, "\r\n\r\n") || strstr(request, "\n\n")) {
+            break;
+        }
+    }
+    request[len] = '\0';
+
+    if (strncmp(request, "GET ", 4) != 0) {
+        static const char *msg = "Only GET is supported\n";
+        metrics_reply(fd, "405 Method Not Allowed", msg, strlen(msg));
+        return;
+    }
+    path = request + 4;
+    end = strpbrk(path, " \r\n?");
+    if (end) {
+        *end = '\0';
+    }
+    if (strcmp(path, "/metrics") == 0 || strcmp(path, "/") == 0) {
+        lenstr *body = lenstr_new();
+        metrics_render(body);
+        metrics_reply(fd, "200 OK", body->ls_buf ? body->ls_buf : "", body->ls_len);
+        lenstr_free(&body);
+    } else {
+        static const char *msg = "Not found, the metrics are served at /metrics\n";
+        metrics_reply(fd, "404 Not Found", msg, strlen(msg));
+    }
+}
+
+static void
+metrics_thread(void *arg __attribute__((unused)))
+{
+    while (!slapi_atomic_load_32(&metrics_shutdown, __ATOMIC_ACQUIRE)) {
+        PRInt32 ready;
+
+        for (PRIntn i = 0; i < metrics_npds; i++) {
+            metrics_pds[i].in_flags = PR_POLL_READ;
+            metrics_pds[i].out_flags = 0;
+        }
+        ready = PR_Poll(metrics_pds, metrics_npds, PR_MillisecondsToInterval(METRICS_POLL_MS));
+        if (ready < 0) {
+            PRErrorCode prerr = PR_GetError();
+            slapi_log_err(SLAPI_LOG_TRACE, "metrics_thread", "PR_Poll() failed, " SLAPI_COMPONENT_NAME_NSPR " error %d (%s)\n",
+                          prerr, slapd_pr_strerror(prerr));
+            DS_Sleep(PR_MillisecondsToInterval(METRICS_POLL_MS));
+            continue;
+        }
+        for (PRIntn i = 0; ready > 0 && i < metrics_npds; i++) {
+            PRNetAddr from;
+            PRFileDesc *client;
+
+            if (!(metrics_pds[i].out_flags & PR_POLL_READ)) {
+                continue;
+            }
+            client = PR_Accept(metrics_pds[i].fd, &from, PR_INTERVAL_NO_WAIT);
+            if (client) {
+                metrics_serve(client);
+                PR_Close(client);
+            }
+        }
+    }
+}
+
+/*
+ * Start the exporter thread on the listening sockets tcps and local, both
+ * NULL terminated and either NULL, see daemon_pre_setuid_init().
+ */
+void
+metrics_start(PRFileDesc **tcps, PRFileDesc **local)
+{
+    PRFileDesc **fdesp;
+
+    for (fdesp = tcps; fdesp && *fdesp; fdesp++) {
+        metrics_npds++;
+    }
+    for (fdesp = local; fdesp && *fdesp; fdesp++) {
+        metrics_npds++;
+    }
+    if (metrics_npds == 0) {
+        return;
+    }
+
+    metrics_pds = (PRPollDesc *)slapi_ch_calloc(metrics_npds, sizeof(PRPollDesc));
+    metrics_npds = 0;
+    for (fdesp = tcps; fdesp && *fdesp; fdesp++) {
+        metrics_pds[metrics_npds++].fd = *fdesp;
+    }
+    for (fdesp = local; fdesp && *fdesp; fdesp++) {
+        metrics_pds[metrics_npds++].fd = *fdesp;
+    }
+
+    slapi_atomic_store_32(&metrics_shutdown, 0, __ATOMIC_RELEASE);
+    metrics_thread_p = PR_CreateThread(PR_SYSTEM_THREAD,
+                                       (VFP)(void *)metrics_thread, NULL,
+                                       PR_PRIORITY_NORMAL, PR_GLOBAL_THREAD,
+                                       PR_JOINABLE_THREAD,
+                                       SLAPD_DEFAULT_THREAD_STACKSIZE);
+    if (metrics_thread_p == NULL) {
+        PRErrorCode errorCode = PR_GetError();
+        slapi_log_err(SLAPI_LOG_ERR, "metrics_start",
+                      "Unable to create the metrics exporter thread (" SLAPI_COMPONENT_NAME_NSPR " error %d - %s)\n",
+                      errorCode, slapd_pr_strerror(errorCode));
+        slapi_ch_free((void **)&metrics_pds);
+        metrics_npds = 0;
+    }
+}
+
+void
+metrics_stop(void)
+{
+    if (metrics_thread_p == NULL) {
+        return;
+    }
+    slapi_atomic_store_32(&metrics_shutdown, 1, __ATOMIC_RELEASE);
+    (void)PR_JoinThread(metrics_thread_p);
+    metrics_thread_p = NULL;
+    slapi_ch_free((void **)&metrics_pds);
+    metrics_npds = 0;
+}
@@ -31,8 +31,33 @@
 #include "slap.h"
 #include "fe.h"
 
+/*
+ * Does the search need the "connection" values of cn=monitor? Agents that
+ * poll the counters ask for them by name and skip the per connection
+ * listing.
+ */
+static int
+monitor_wants_connections(Slapi_PBlock *pb)
+{
+    char **attrs = NULL;
+    char *fstr = NULL;
+
+    slapi_pblock_get(pb, SLAPI_SEARCH_ATTRS, &attrs);
+    slapi_pblock_get(pb, SLAPI_SEARCH_STRFILTER, &fstr);
+    if (attrs == NULL || (fstr && PL_strcasestr(fstr, "connection"))) {
+        return 1;
+    }
+    for (size_t i = 0; attrs[i]; i++) {
+        if (strcmp(attrs[i], "*") == 0 ||
+            slapi_attr_type_cmp(attrs[i], "connection", SLAPI_TYPE_CMP_BASE) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
 int32_t
-monitor_info(Slapi_PBlock *pb __attribute__((unused)),
+monitor_info(Slapi_PBlock *pb,
              Slapi_Entry *e,
              Slapi_Entry *entryAfter __attribute__((unused)),
              int *returncode,
@@ -60,7 +85,7 @@ monitor_info(Slapi_PBlock *pb __attribute__((unused)),
     val.bv_val = buf;
     attrlist_replace(&e->e_attrs, "threads", vals);
 
-    connection_table_as_entry(the_connection_table, e);
+    connection_table_as_entry(the_connection_table, e, monitor_wants_connections(pb));
 
     val.bv_len = snprintf(buf, sizeof(buf), "%" PRIu64, slapi_counter_get_value(ops_initiated));
     val.bv_val = buf;
@@ -78,6 +103,13 @@ monitor_info(Slapi_PBlock *pb __attribute__((unused)),
     val.bv_val = buf;
     attrlist_replace(&e->e_attrs, "bytessent", vals);
 
+    val.bv_len = snprintf(buf, sizeof(buf), "%" PRIu64, g_get_num_result_writes());
+    val.bv_val = buf;
+    attrlist_replace(&e->e_attrs, "resultwrites", vals);
+
+    pw_crypto_as_entry(e);
+    operation_arena_as_entry(e);
+
     gmtime_r(&curtime, &utm);
     strftime(buf, sizeof(buf), "%Y%m%d%H%M%SZ", &utm);
     val.bv_val = buf;
@@ -147,9 +147,11 @@ operation_init(Slapi_Operation *o, int flags)
 {
     if (NULL != o) {
         BerElement *ber = o->o_ber; /* may have already been set */
+        Slapi_Arena *arena = o->o_arena; /* kept when the op is reused */
         /* We can't get rid of this til we remove the operation stack. */
         memset(o, 0, sizeof(Slapi_Operation));
         o->o_ber = ber;
+        o->o_arena = arena;
         o->o_msgid = -1;         /* if changed please update start-tls that test this value */
         o->o_tag = LBER_DEFAULT; /* if changed please update start-tls that test this value */
         o->o_status = SLAPI_OP_STATUS_PROCESSING;
@@ -200,6 +202,110 @@ operation_new(int flags)
     return o;
 }
 
+/*
+ * Arena statistics, updated when an operation that used its arena is done.
+ * The bytes divided by the ops give the average arena use of an operation,
+ * chunks counts the mallocs the arena could not avoid.
+ */
+static Slapi_Counter *op_arena_ops;
+static Slapi_Counter *op_arena_bytes;
+static Slapi_Counter *op_arena_chunks;
+static uint64_t op_arena_max_bytes;
+static pthread_once_t op_arena_once = PTHREAD_ONCE_INIT;
+
+static void
+operation_arena_stats_init(void)
+{
+    op_arena_ops = slapi_counter_new_sharded();
+    op_arena_bytes = slapi_counter_new_sharded();
+    op_arena_chunks = slapi_counter_new_sharded();
+}
+
+static Slapi_Arena *
+operation_get_arena(Slapi_Operation *op)
+{
+    if (op->o_arena == NULL) {
+        op->o_arena = arena_new();
+    }
+    return op->o_arena;
+}
+
+/* Account for the arena use of op and release its allocations */
+static void
+operation_arena_done(Slapi_Operation *op)
+{
+    uint64_t bytes = arena_get_bytes(op->o_arena);
+    uint64_t max;
+
+    if (bytes == 0) {
+        return;
+    }
+    pthread_once(&op_arena_once, operation_arena_stats_init);
+    slapi_counter_increment(op_arena_ops);
+    slapi_counter_add(op_arena_bytes, bytes);
+    slapi_counter_add(op_arena_chunks, arena_get_chunks(op->o_arena));
+    max = __atomic_load_n(&op_arena_max_bytes, __ATOMIC_RELAXED);
+    while (bytes > max &&
+           !__atomic_compare_exchange_n(&op_arena_max_bytes, &max, bytes, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+    arena_reset(op->o_arena);
+}
+
+void *
+slapi_operation_arena_alloc(Slapi_Operation *op, size_t size)
+{
+    return arena_alloc(operation_get_arena(op), size);
+}
+
+void *
+slapi_operation_arena_calloc(Slapi_Operation *op, size_t nelem, size_t size)
+{
+    return arena_calloc(operation_get_arena(op), nelem, size);
+}
+
+char *
+slapi_operation_arena_strdup(Slapi_Operation *op, const char *s)
+{
+    return arena_strdup(operation_get_arena(op), s);
+}
+
+char *
+slapi_operation_arena_smprintf(Slapi_Operation *op, const char *fmt, ...)
+{
+    va_list ap;
+    char *p;
+
+    va_start(ap, fmt);
+    p = arena_vsmprintf(operation_get_arena(op), fmt, ap);
+    va_end(ap);
+    return p;
+}
+
+static void
+operation_arena_monitor_attr(Slapi_Entry *e, const char *type, uint64_t value)
+{
+    struct berval val;
+    struct berval *vals[2] = {&val, NULL};
+    char buf[32];
+
+    val.bv_len = snprintf(buf, sizeof(buf), "%" PRIu64, value);
+    val.bv_val = buf;
+    attrlist_replace(&e->e_attrs, type, vals);
+}
+
+/*
+ * Add the arena statistics to cn=monitor.
+ */
+void
+operation_arena_as_entry(Slapi_Entry *e)
+{
+    pthread_once(&op_arena_once, operation_arena_stats_init);
+    operation_arena_monitor_attr(e, "oparenaops", slapi_counter_get_value(op_arena_ops));
+    operation_arena_monitor_attr(e, "oparenabytes", slapi_counter_get_value(op_arena_bytes));
+    operation_arena_monitor_attr(e, "oparenamaxbytes", __atomic_load_n(&op_arena_max_bytes, __ATOMIC_RELAXED));
+    operation_arena_monitor_attr(e, "oparenachunks", slapi_counter_get_value(op_arena_chunks));
+}
+
 void
 operation_done(Slapi_Operation **op, Connection *conn)
 {
@@ -223,6 +329,11 @@ operation_done(Slapi_Operation **op, Connection *conn)
             (*op)->o_results.result_controls = NULL;
         }
         slapi_ch_free_string(&(*op)->o_results.result_matched);
+        (*op)->o_profile = NULL; /* in the arena */
+        if ((*op)->o_sendber) {
+            ber_free((*op)->o_sendber, 1);
+            (*op)->o_sendber = NULL;
+        }
         int options = 0;
         /* save the old options */
         if ((*op)->o_ber) {
@@ -232,6 +343,7 @@ operation_done(Slapi_Operation **op, Connection *conn)
             /* clear out the ber for the next operation */
             ber_init2((*op)->o_ber, NULL, options);
         }
+        operation_arena_done(*op);
     }
 }
 
@@ -240,6 +352,7 @@ operation_free(Slapi_Operation **op, Connection *conn)
 {
     operation_done(op, conn);
     if (op != NULL && *op != NULL) {
+        arena_destroy(&(*op)->o_arena);
         if (operation_is_flag_set(*op, OP_FLAG_INTERNAL)) {
             slapi_ch_free((void **)op);
         } else {
@@ -327,6 +440,94 @@ operation_set_type(Slapi_Operation *op, unsigned long type)
     op->o_params.operation_type = type;
 }
 
+/*
+ * Start collecting the execution profile of the operation.
+ */
+void
+operation_profile_init(Slapi_Operation *op)
+{
+    if (op->o_profile == NULL) {
+        op->o_profile = (Op_Profile *)slapi_operation_arena_calloc(op, 1, sizeof(Op_Profile));
+    }
+}
+
+Op_Profile *
+operation_get_profile(Slapi_Operation *op)
+{
+    return op ? op->o_profile : NULL;
+}
+
+/*
+ * Microseconds elapsed since start, which was set by
+ * clock_gettime(CLOCK_MONOTONIC).
+ */
+uint64_t
+operation_profile_usec(const struct timespec *start)
+{
+    struct timespec now;
+    struct timespec diff;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    slapi_timespec_diff(&now, (struct timespec *)start, &diff);
+    return (uint64_t)diff.tv_sec * 1000000 + (uint64_t)diff.tv_nsec / 1000;
+}
+
+void
+operation_profile_add_lookup(Op_Profile *profile, const Slapi_Filter *f, uint64_t nids, int allids, uint64_t usec)
+{
+    if (profile->opp_nlookups < OP_PROFILE_MAX_LOOKUPS) {
+        Op_Profile_Lookup *lookup = &profile->opp_lookups[profile->opp_nlookups];
+
+        slapi_filter_to_string(f, lookup->opl_filter, sizeof(lookup->opl_filter));
+        lookup->opl_nids = nids;
+        lookup->opl_allids = allids;
+        lookup->opl_usec = usec;
+    }
+    profile->opp_nlookups++;
+    profile->opp_lookup_usec += usec;
+}
+
+/*
+ * Log the execution profile in the access log, after the RESULT line.
+ */
+void
+operation_profile_log(Slapi_Operation *op)
+{
+    Op_Profile *p = op->o_profile;
+    char candidates[32];
+
+    if (p == NULL) {
+        return;
+    }
+    for (uint32_t i = 0; i < p->opp_nlookups && i < OP_PROFILE_MAX_LOOKUPS; i++) {
+        Op_Profile_Lookup *lookup = &p->opp_lookups[i];
+        if (lookup->opl_allids) {
+            PR_snprintf(candidates, sizeof(candidates), "allids");
+        } else {
+            PR_snprintf(candidates, sizeof(candidates), "%" PRIu64, lookup->opl_nids);
+        }
+        slapi_log_access(LDAP_DEBUG_PROFILE,
+                         "conn=%" PRIu64 " op=%d PROFILE INDEX filter=\"%s\" nids=%s usec=%" PRIu64 "\n",
+                         op->o_connid, op->o_opid, lookup->opl_filter, candidates, lookup->opl_usec);
+    }
+    if (p->opp_candidates_allids) {
+        PR_snprintf(candidates, sizeof(candidates), "allids");
+    } else {
+        PR_snprintf(candidates, sizeof(candidates), "%" PRIu64, p->opp_candidates);
+    }
+    slapi_log_access(LDAP_DEBUG_PROFILE,
+                     "conn=%" PRIu64 " op=%d PROFILE candidates=%s lookups=%u lookup_usec=%" PRIu64
+                     " intersect_in=%" PRIu64 " intersect_out=%" PRIu64
+                     " cache_hits=%" PRIu64 " cache_misses=%" PRIu64
+                     " filter_usec=%" PRIu64 " acl_usec=%" PRIu64 " encode_usec=%" PRIu64
+                     " pdus=%" PRIu64 " writes=%" PRIu64 " arena_bytes=%" PRIu64 "\n",
+                     op->o_connid, op->o_opid, candidates, p->opp_nlookups, p->opp_lookup_usec,
+                     p->opp_intersect_in, p->opp_intersect_out,
+                     p->opp_cache_hits, p->opp_cache_misses,
+                     p->opp_filter_usec, p->opp_acl_usec, p->opp_encode_usec,
+                     op->o_pdus_sent, op->o_writes, arena_get_bytes(op->o_arena));
+}
+
 void
 operation_set_flag(Slapi_Operation *op, int flag)
 {
@@ -270,7 +270,6 @@ op_shared_search(Slapi_PBlock *pb, int send_result)
     int pr_idx = -1;
     Slapi_DN *orig_sdn = NULL;
     int free_sdn = 0;
-    PRBool vattr_lock_acquired = PR_FALSE;
 
     be_list[0] = NULL;
     referral_list[0] = NULL;
@@ -346,7 +345,7 @@ op_shared_search(Slapi_PBlock *pb, int send_result)
         }
 
         if (proxydn) {
-            proxystr = slapi_ch_smprintf(" authzid=\"%s\"", proxydn);
+            proxystr = slapi_operation_arena_smprintf(operation, " authzid=\"%s\"", proxydn);
         }
 
 #define SLAPD_SEARCH_FMTSTR_CONN_OP "conn=%" PRIu64 " op=%d"
@@ -564,8 +563,6 @@ op_shared_search(Slapi_PBlock *pb, int send_result)
     }
 
     slapi_pblock_set(pb, SLAPI_BACKEND_COUNT, &index);
-    vattr_rdlock();
-    vattr_lock_acquired = PR_TRUE;
 
     if (be) {
         slapi_pblock_set(pb, SLAPI_BACKEND, be);
@@ -1037,9 +1034,6 @@ free_and_return:
     } else if (be_single) {
         slapi_be_Unlock(be_single);
     }
-    if (vattr_lock_acquired) {
-        vattr_rd_unlock();
-    }
 
 free_and_return_nolock:
     slapi_pblock_set(pb, SLAPI_PLUGIN_OPRETURN, &rc);
@@ -1052,7 +1046,6 @@ free_and_return_nolock:
     slapi_pblock_set(pb, SLAPI_SEARCH_TARGET_SDN, orig_sdn);
 
     slapi_ch_free_string(&proxydn);
-    slapi_ch_free_string(&proxystr);
 
 #ifdef SYSTEMTAP
     STAP_PROBE(ns-slapd, op_shared_search__return);
@@ -1166,6 +1159,7 @@ iterate(Slapi_PBlock *pb, Slapi_Backend *be, int send_result, int *pnentries, in
     char **attrs = NULL;
     unsigned int pr_stat = 0;
     int pr_idx = -1;
+    Slapi_Operation *op = NULL;
 
     if (NULL == pb) {
         return rval;
@@ -1173,8 +1167,11 @@ iterate(Slapi_PBlock *pb, Slapi_Backend *be, int send_result, int *pnentries, in
     slapi_pblock_get(pb, SLAPI_SEARCH_ATTRS, &attrs);
     slapi_pblock_get(pb, SLAPI_SEARCH_ATTRSONLY, &attrsonly);
     slapi_pblock_get(pb, SLAPI_PAGED_RESULTS_INDEX, &pr_idx);
+    slapi_pblock_get(pb, SLAPI_OPERATION, &op);
 
     *pnentries = 0;
+    /* a result follows the entries returned here, they can be queued */
+    operation_set_flag(op, OP_FLAG_QUEUE_RESULTS);
 
     while (!done) {
         Slapi_Entry *ger_template_entry = NULL;
@@ -1336,6 +1333,7 @@ iterate(Slapi_PBlock *pb, Slapi_Backend *be, int send_result, int *pnentries, in
             pr_stat = PAGEDRESULTS_SEARCH_END;
         }
     }
+    operation_clear_flag(op, OP_FLAG_QUEUE_RESULTS);
 
     if (pr_statp) {
         *pr_statp = pr_stat;
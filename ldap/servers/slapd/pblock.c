@@ -4217,12 +4217,43 @@ bind_credentials_clear(Connection *conn, PRBool lock_conn, PRBool clear_external
             conn->c_client_cert = NULL;
         }
     }
+    connection_stats_update(conn);
 
     if (lock_conn) {
         pthread_mutex_unlock(&(conn->c_mutex));
     }
 }
 
+/*
+ * Copy the identity of the connection to conn->c_stats for cn=monitor.
+ * Called with c_mutex held, or by the thread that owns a connection that
+ * is being set up or torn down, whenever c_connid, c_starttime, c_dn or
+ * c_ipaddr change.
+ */
+void
+connection_stats_update(Connection *conn)
+{
+    conn_stats *cs = &conn->c_stats;
+    uint64_t seq = cs->cs_seq;
+    size_t len;
+
+    slapi_atomic_store_64(&cs->cs_seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    cs->cs_connid = conn->c_connid;
+    cs->cs_starttime = conn->c_starttime;
+    len = conn->c_dn ? strlen(conn->c_dn) : 0;
+    cs->cs_dn_truncated = len >= sizeof(cs->cs_dn);
+    if (cs->cs_dn_truncated) {
+        len = sizeof(cs->cs_dn) - 1;
+    }
+    memcpy(cs->cs_dn, conn->c_dn ? conn->c_dn : "", len);
+    cs->cs_dn[len] = '\0';
+    PL_strncpyz(cs->cs_ipaddr, conn->c_ipaddr ? conn->c_ipaddr : "", sizeof(cs->cs_ipaddr));
+
+    slapi_atomic_store_64(&cs->cs_seq, seq + 2, __ATOMIC_RELEASE);
+}
+
 struct slapi_entry *
 slapi_pblock_get_pw_entry(Slapi_PBlock *pb)
 {
@@ -4434,6 +4465,7 @@ bind_credentials_set_nolock(Connection *conn, char *authtype, char *normdn, char
     conn->c_authtype = slapi_ch_strdup(authtype);
     conn->c_dn = normdn;
     conn->c_isroot = slapi_dn_isroot(normdn);
+    connection_stats_update(conn);
 
     /* Set the thread data with the normalized dn */
     slapi_td_set_dn(slapi_ch_strdup(normdn));
@@ -1952,6 +1952,36 @@ plugin_call_one(struct slapdplugin *list, int operation, Slapi_PBlock *pb)
 }
 
 
+static int
+plugin_is_operation_type(int type)
+{
+    return type == SLAPI_PLUGIN_PREOPERATION || type == SLAPI_PLUGIN_POSTOPERATION ||
+           type == SLAPI_PLUGIN_INTERNAL_PREOPERATION || type == SLAPI_PLUGIN_INTERNAL_POSTOPERATION ||
+           type == SLAPI_PLUGIN_BEPREOPERATION || type == SLAPI_PLUGIN_BEPOSTOPERATION ||
+           type == SLAPI_PLUGIN_BETXNPREOPERATION || type == SLAPI_PLUGIN_BETXNPOSTOPERATION;
+}
+
+/*
+ * Call func, recording its time in the latency histogram of the plugin when
+ * it is an operation callback. A callback that runs internal operations
+ * includes the time of the plugins those call.
+ */
+static int
+plugin_call_timed(struct slapdplugin *plugin, int operation, IFP func, Slapi_PBlock *pb)
+{
+    struct timespec start;
+    int rc;
+
+    if (!plugin_is_operation_type(plugin->plg_type) || operation == SLAPI_PLUGIN_START_FN ||
+        operation == SLAPI_PLUGIN_POSTSTART_FN || operation == SLAPI_PLUGIN_CLOSE_FN) {
+        return func(pb);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    rc = func(pb);
+    histogram_record(histogram_get(&plugin->plg_latency), operation_profile_usec(&start));
+    return rc;
+}
+
 /*
  * Return codes:
  * - For preoperation plugins, returns the return code passed back from the first
@@ -1999,7 +2029,7 @@ plugin_call_func(struct slapdplugin *list, int operation, Slapi_PBlock *pb, int
             if (((SLAPI_PLUGIN_START_FN == operation && !list->plg_started) || /* Starting it up for the first time */
                  (SLAPI_PLUGIN_CLOSE_FN == operation && !list->plg_stopped) || /* Shutting down, plugin has been stopped */
                  (SLAPI_PLUGIN_START_FN != operation && list->plg_started)) && /* Started, and not trying to start again */
-                (rc = func(pb)) != 0) {
+                (rc = plugin_call_timed(list, operation, func, pb)) != 0) {
                 slapi_plugin_op_finished(list);
                 if (SLAPI_PLUGIN_PREOPERATION == list->plg_type ||
                     SLAPI_PLUGIN_INTERNAL_PREOPERATION == list->plg_type ||
@@ -2675,6 +2705,7 @@ plugin_free(struct slapdplugin *plugin)
     }
     release_componentid(plugin->plg_identity);
     slapi_counter_destroy(&plugin->plg_op_counter);
+    histogram_destroy(&plugin->plg_latency);
     if (!plugin->plg_group) {
         plugin_config_cleanup(&plugin->plg_conf);
     }
@@ -3990,6 +4021,47 @@ plugin_get_by_name(char *name)
     return NULL;
 }
 
+/*
+ * The pluginlatency values of cn=latency,cn=monitor, named
+ * "<plugin> (<type>)".
+ */
+void
+plugin_latency_as_entry(Slapi_Entry *e)
+{
+    static const int lists[] = {
+        PLUGIN_LIST_PREOPERATION, PLUGIN_LIST_POSTOPERATION,
+        PLUGIN_LIST_INTERNAL_PREOPERATION, PLUGIN_LIST_INTERNAL_POSTOPERATION,
+        PLUGIN_LIST_BEPREOPERATION, PLUGIN_LIST_BEPOSTOPERATION,
+        PLUGIN_LIST_BETXNPREOPERATION, PLUGIN_LIST_BETXNPOSTOPERATION};
+    struct slapdplugin *plugin;
+    char **values = NULL;
+    int locked = slapi_td_get_plugin_locked();
+
+    if (!locked) {
+        slapi_rwlock_rdlock(global_rwlock);
+    }
+    for (size_t i = 0; i < sizeof(lists) / sizeof(lists[0]); i++) {
+        for (plugin = global_plugin_list[lists[i]]; plugin; plugin = plugin->plg_next) {
+            Slapi_Histogram *h = __atomic_load_n(&plugin->plg_latency, __ATOMIC_ACQUIRE);
+            char *name;
+            char *value;
+
+            if (h == NULL) {
+                continue;
+            }
+            name = slapi_ch_smprintf("%s (%s)", plugin->plg_name, plugin_get_type_str(plugin->plg_type));
+            if ((value = histogram_format(name, h))) {
+                charray_add(&values, value);
+            }
+            slapi_ch_free_string(&name);
+        }
+    }
+    if (!locked) {
+        slapi_rwlock_unlock(global_rwlock);
+    }
+    histogram_attr_replace(e, "pluginlatency", values);
+}
+
 struct slapi_componentid *
 generate_componentid(struct slapdplugin *pp, char *name)
 {
@@ -47,6 +47,8 @@ plugin_call_acl_plugin(Slapi_PBlock *pb, Slapi_Entry *e, char **attrs, struct be
     int rc = LDAP_INSUFFICIENT_ACCESS;
     int aclplugin_initialized = 0;
     Operation *operation;
+    Op_Profile *profile;
+    struct timespec start;
 
     slapi_pblock_get(pb, SLAPI_OPERATION, &operation);
 
@@ -54,6 +56,10 @@ plugin_call_acl_plugin(Slapi_PBlock *pb, Slapi_Entry *e, char **attrs, struct be
     if (operation_is_flag_set(operation, SLAPI_OP_FLAG_NO_ACCESS_CHECK | OP_FLAG_INTERNAL | OP_FLAG_REPLICATED))
         return LDAP_SUCCESS;
 
+    if ((profile = operation_get_profile(operation))) {
+        clock_gettime(CLOCK_MONOTONIC, &start);
+    }
+
     /* call the global plugins first and then the backend specific */
     for (p = get_plugin_list(PLUGIN_LIST_ACL); p != NULL; p = p->plg_next) {
         if (plugin_invoke_plugin_sdn(p, SLAPI_PLUGIN_ACL_ALLOW_ACCESS, pb,
@@ -68,6 +74,9 @@ plugin_call_acl_plugin(Slapi_PBlock *pb, Slapi_Entry *e, char **attrs, struct be
     if (!aclplugin_initialized) {
         rc = acl_default_access(pb, e, access);
     }
+    if (profile) {
+        profile->opp_acl_usec += operation_profile_usec(&start);
+    }
     return rc;
 }
 
@@ -559,6 +559,28 @@ int config_set_allowed_sasl_mechs(const char *attrname, char *value, char *error
 int config_get_schemamod(void);
 int config_set_ignore_vattrs(const char *attrname, char *value, char *errorbuf, int apply);
 int config_get_ignore_vattrs(void);
+int config_set_search_entry_encoding_cache(const char *attrname, char *value, char *errorbuf, int apply);
+int config_get_search_entry_encoding_cache(void);
+int config_set_search_output_buffer_size(const char *attrname, char *value, char *errorbuf, int apply);
+int32_t config_get_search_output_buffer_size(void);
+int config_set_search_output_buffer_delay(const char *attrname, char *value, char *errorbuf, int apply);
+int32_t config_get_search_output_buffer_delay(void);
+int config_set_pwd_crypto_threads(const char *attrname, char *value, char *errorbuf, int apply);
+int32_t config_get_pwd_crypto_threads(void);
+int config_set_pwd_crypto_queue_size(const char *attrname, char *value, char *errorbuf, int apply);
+int32_t config_get_pwd_crypto_queue_size(void);
+int config_set_pwd_crypto_queue_timeout(const char *attrname, char *value, char *errorbuf, int apply);
+int32_t config_get_pwd_crypto_queue_timeout(void);
+int config_set_pwd_verify_cache_ttl(const char *attrname, char *value, char *errorbuf, int apply);
+int32_t config_get_pwd_verify_cache_ttl(void);
+int config_set_dse_journal_size(const char *attrname, char *value, char *errorbuf, int apply);
+int32_t config_get_dse_journal_size(void);
+int config_set_metrics_port(const char *attrname, char *value, char *errorbuf, int apply);
+int32_t config_get_metrics_port(void);
+int config_set_metrics_listenhost(const char *attrname, char *value, char *errorbuf, int apply);
+char *config_get_metrics_listenhost(void);
+int config_set_metrics_socket(const char *attrname, char *value, char *errorbuf, int apply);
+char *config_get_metrics_socket(void);
 int config_set_sasl_mapping_fallback(const char *attrname, char *value, char *errorbuf, int apply);
 int config_get_sasl_mapping_fallback(void);
 int config_get_unhashed_pw_switch(void);
@@ -703,6 +725,10 @@ int is_rootdse(const char *dn);
 int get_entry_object_type(void);
 int entry_computed_attr_init(void);
 void send_referrals_from_entry(Slapi_PBlock *pb, Slapi_Entry *referral);
+int entry_encoding_enabled(const Slapi_Entry *e);
+int32_t entry_encoding_watermark(void);
+int entry_encoding_append(Slapi_Entry *e, int flags, BerElement *ber);
+void entry_encoding_set(Slapi_Entry *e, int flags, int32_t watermark, struct berval *attrs);
 
 /*
  * dse.c
@@ -717,6 +743,9 @@ struct dse *dse_new(char *filename, char *tmpfilename, char *backfilename, char
 struct dse *dse_new_with_filelist(char *filename, char *tmpfilename, char *backfilename, char *startokfilename, const char *configdir, char **filelist);
 int dse_deletedse(Slapi_PBlock *pb);
 int dse_destroy(struct dse *pdse);
+void dse_set_journal(struct dse *pdse, const char *journalfile);
+void dse_compact(struct dse *pdse);
+char *dse_journal_apply(const char *journalfile, char *buf);
 int dse_check_file(char *filename, char *backupname);
 int dse_read_file(struct dse *pdse, Slapi_PBlock *pb);
 int dse_bind(Slapi_PBlock *pb);
@@ -796,6 +825,7 @@ int lock_fclose(FILE *fp, FILE *lfp);
 #define LDAP_DEBUG_NOTICE     0x04000000  /*  67108864 */
 #define LDAP_DEBUG_INFO       0x08000000  /* 134217728 */
 #define LDAP_DEBUG_DEBUG      0x10000000  /* 268435456 */
+#define LDAP_DEBUG_PROFILE    0x20000000  /* 536870912 access log only: search profiles */
 #define LDAP_DEBUG_ALL_LEVELS 0xFFFFFF
 extern int slapd_ldap_debug;
 
@@ -917,6 +947,37 @@ void operation_set_target_spec_str(Slapi_Operation *op, const char *target_spec)
 unsigned long operation_get_abandoned_op(const Slapi_Operation *op);
 void operation_set_abandoned_op(Slapi_Operation *op, unsigned long abndoned_op);
 void operation_set_type(Slapi_Operation *op, unsigned long type);
+void operation_profile_init(Slapi_Operation *op);
+Op_Profile *operation_get_profile(Slapi_Operation *op);
+uint64_t operation_profile_usec(const struct timespec *start);
+void operation_profile_add_lookup(Op_Profile *profile, const Slapi_Filter *f, uint64_t nids, int allids, uint64_t usec);
+void operation_profile_log(Slapi_Operation *op);
+void operation_arena_as_entry(Slapi_Entry *e);
+
+/*
+ * arena.c
+ */
+Slapi_Arena *arena_new(void);
+void *arena_alloc(Slapi_Arena *arena, size_t size);
+void *arena_calloc(Slapi_Arena *arena, size_t nelem, size_t size);
+char *arena_strdup(Slapi_Arena *arena, const char *s);
+char *arena_vsmprintf(Slapi_Arena *arena, const char *fmt, va_list ap);
+uint64_t arena_get_bytes(const Slapi_Arena *arena);
+uint64_t arena_get_chunks(const Slapi_Arena *arena);
+void arena_reset(Slapi_Arena *arena);
+void arena_destroy(Slapi_Arena **arena);
+
+/*
+ * histogram.c
+ */
+Slapi_Histogram *histogram_new(void);
+void histogram_destroy(Slapi_Histogram **h);
+Slapi_Histogram *histogram_get(Slapi_Histogram **hp);
+void histogram_record(Slapi_Histogram *h, uint64_t usec);
+char *histogram_format(const char *name, Slapi_Histogram *h);
+void histogram_attr_replace(Slapi_Entry *e, const char *type, char **values);
+void latency_record_operation(Slapi_PBlock *pb, Operation *op);
+void latency_as_entry(Slapi_Entry *e);
 
 
 /*
@@ -936,6 +997,7 @@ void plugin_get_plugin_dependencies(char *plugin_name, char ***names);
 struct slapdplugin *get_plugin_list(int plugin_list_index);
 PRBool plugin_invoke_plugin_sdn(struct slapdplugin *plugin, int operation, Slapi_PBlock *pb, Slapi_DN *target_spec);
 struct slapdplugin *plugin_get_by_name(char *name);
+void plugin_latency_as_entry(Slapi_Entry *e);
 struct slapdplugin *plugin_get_pwd_storage_scheme(char *name, int len, int index);
 char *plugin_get_pwd_storage_scheme_list(int index);
 int plugin_add_descriptive_attributes(Slapi_Entry *e,
@@ -1002,6 +1064,15 @@ void add_password_attrs(Slapi_PBlock *pb, Operation *op, Slapi_Entry *e);
 
 int add_shadow_ext_password_attrs(Slapi_PBlock *pb, Slapi_Entry **e);
 
+/*
+ * pw_crypto.c
+ */
+int pw_crypto_start(void);
+int pw_crypto_check_sizes(int32_t threads, int32_t queue, char *errorbuf);
+int pw_crypto_check_config(int32_t threads, int32_t queue, char *errorbuf);
+void pw_crypto_stop(void);
+void pw_crypto_as_entry(Slapi_Entry *e);
+
 /*
  * pw_retry.c
  */
@@ -1033,6 +1104,8 @@ void g_set_num_entries_sent(Slapi_Counter *counter);
 PRUint64 g_get_num_entries_sent(void);
 void g_set_num_bytes_sent(Slapi_Counter *counter);
 PRUint64 g_get_num_bytes_sent(void);
+void g_set_num_result_writes(Slapi_Counter *counter);
+PRUint64 g_get_num_result_writes(void);
 void g_set_default_referral(struct berval **ldap_url);
 struct berval **g_get_default_referral(void);
 void disconnect_server(Connection *conn, PRUint64 opconnid, int opid, PRErrorCode reason, PRInt32 error);
@@ -1241,6 +1314,7 @@ void bind_credentials_set_nolock(Connection *conn,
                                  CERTCertificate *clientcert,
                                  Slapi_Entry *binded);
 void bind_credentials_clear(Connection *conn, PRBool lock_conn, PRBool clear_externalcreds);
+void connection_stats_update(Connection *conn);
 
 
 /*
@@ -1448,11 +1522,6 @@ void subentry_create_filter(Slapi_Filter **filter);
  * vattr.c
  */
 void vattr_init(void);
-void vattr_global_lock_create(void);
-void vattr_rdlock();
-void vattr_rd_unlock();
-void vattr_wrlock();
-void vattr_wr_unlock();
 void vattr_cleanup(void);
 
 /*
@@ -670,6 +670,7 @@ update_pw_info(Slapi_PBlock *pb, char *old_pw)
 
     internal_op = slapi_operation_is_flag_set(operation, SLAPI_OP_FLAG_INTERNAL);
     target_dn = slapi_sdn_get_ndn(sdn);
+    pw_verify_cache_invalidate(target_dn);
     pwpolicy = new_passwdPolicy(pb, target_dn);
     cur_time = slapi_current_utc_time();
     slapi_mods_init(&smods, 0);
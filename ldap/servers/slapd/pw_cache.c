@@ -0,0 +1,251 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/*
+ * pw_cache.c
+ *
+ * Cache of successful database bind password verifications, so clients that
+ * rebind with the same DN and password every few seconds do not pay a full
+ * PBKDF2 compare each time. Enabled with nsslapd-pwd-verify-cache-ttl.
+ *
+ * Neither the clear text password nor anything derived from it alone is kept:
+ * an entry is the bind DN and an HMAC-SHA256, under a key generated at
+ * startup, of the DN, the presented password and the stored userPassword
+ * values. A stored value that changes no longer produces the same MAC, so
+ * a modified password never hits, even without the explicit invalidation done
+ * by password changes and account lockout.
+ */
+
+#include "slap.h"
+#include <pk11pub.h>
+#include <sds.h>
+
+#define PW_CACHE_BUCKETS 2048
+#define PW_CACHE_WAYS 8 /* entries per bucket, bounds the cache to 16384 DNs */
+#define PW_CACHE_MAC_LEN 32
+#define PW_CACHE_BLOCK_LEN 64 /* SHA-256 block size */
+
+typedef struct pw_cache_slot
+{
+    char *pcs_ndn;
+    unsigned char pcs_mac[PW_CACHE_MAC_LEN];
+    time_t pcs_expire; /* relative time, see slapi_current_rel_time_hr() */
+} pw_cache_slot;
+
+typedef struct pw_cache_bucket
+{
+    pthread_mutex_t pcb_lock;
+    pw_cache_slot pcb_slots[PW_CACHE_WAYS];
+} pw_cache_bucket;
+
+static pw_cache_bucket *pw_cache_buckets;
+static unsigned char pw_cache_key[PW_CACHE_MAC_LEN];
+static char pw_cache_hash_key[16];
+static pthread_once_t pw_cache_once = PTHREAD_ONCE_INIT;
+
+static void
+pw_cache_init(void)
+{
+    slapi_rand_array(pw_cache_key, sizeof(pw_cache_key));
+    slapi_rand_array(pw_cache_hash_key, sizeof(pw_cache_hash_key));
+    pw_cache_buckets = (pw_cache_bucket *)slapi_ch_calloc(PW_CACHE_BUCKETS, sizeof(pw_cache_bucket));
+    for (size_t i = 0; i < PW_CACHE_BUCKETS; i++) {
+        pthread_mutex_init(&pw_cache_buckets[i].pcb_lock, NULL);
+    }
+}
+
+static pw_cache_bucket *
+pw_cache_get_bucket(const char *ndn)
+{
+    pthread_once(&pw_cache_once, pw_cache_init);
+    return &pw_cache_buckets[sds_siphash13(ndn, strlen(ndn), pw_cache_hash_key) % PW_CACHE_BUCKETS];
+}
+
+static void
+pw_cache_digest_bytes(PK11Context *c, const void *data, uint32_t len)
+{
+    uint32_t nlen = PR_htonl(len);
+
+    /* length prefixed, so the concatenation of the fields is unambiguous */
+    PK11_DigestOp(c, (unsigned char *)&nlen, sizeof(nlen));
+    PK11_DigestOp(c, (unsigned char *)data, len);
+}
+
+/*
+ * HMAC-SHA256(key, ndn | cred | vals). Returns 0 on success.
+ */
+static int
+pw_cache_mac(const char *ndn, Slapi_Value **vals, const Slapi_Value *cred, unsigned char *mac)
+{
+    unsigned char pad[PW_CACHE_BLOCK_LEN];
+    unsigned char inner[PW_CACHE_MAC_LEN];
+    unsigned int len = 0;
+    PK11Context *c;
+    const struct berval *bv;
+
+    if ((c = PK11_CreateDigestContext(SEC_OID_SHA256)) == NULL) {
+        return -1;
+    }
+
+    memset(pad, 0x36, sizeof(pad));
+    for (size_t i = 0; i < sizeof(pw_cache_key); i++) {
+        pad[i] ^= pw_cache_key[i];
+    }
+    PK11_DigestBegin(c);
+    PK11_DigestOp(c, pad, sizeof(pad));
+    pw_cache_digest_bytes(c, ndn, strlen(ndn));
+    bv = slapi_value_get_berval(cred);
+    pw_cache_digest_bytes(c, bv->bv_val, bv->bv_len);
+    for (size_t i = 0; vals && vals[i]; i++) {
+        bv = slapi_value_get_berval(vals[i]);
+        pw_cache_digest_bytes(c, bv->bv_val, bv->bv_len);
+    }
+    PK11_DigestFinal(c, inner, &len, sizeof(inner));
+
+    memset(pad, 0x5c, sizeof(pad));
+    for (size_t i = 0; i < sizeof(pw_cache_key); i++) {
+        pad[i] ^= pw_cache_key[i];
+    }
+    PK11_DigestBegin(c);
+    PK11_DigestOp(c, pad, sizeof(pad));
+    PK11_DigestOp(c, inner, sizeof(inner));
+    PK11_DigestFinal(c, mac, &len, PW_CACHE_MAC_LEN);
+    PK11_DestroyContext(c, PR_TRUE);
+
+    memset(inner, 0, sizeof(inner));
+    return len == PW_CACHE_MAC_LEN ? 0 : -1;
+}
+
+static int
+pw_cache_mac_equal(const unsigned char *a, const unsigned char *b)
+{
+    unsigned char diff = 0;
+
+    for (size_t i = 0; i < PW_CACHE_MAC_LEN; i++) {
+        diff |= a[i] ^ b[i];
+    }
+    return diff == 0;
+}
+
+static void
+pw_cache_slot_clear(pw_cache_slot *slot)
+{
+    slapi_ch_free_string(&slot->pcs_ndn);
+    memset(slot, 0, sizeof(*slot));
+}
+
+/*
+ * Returns 1 if cred was verified against vals for ndn within the configured
+ * ttl, 0 otherwise (including when the cache is disabled).
+ */
+int
+pw_verify_cache_check(const char *ndn, Slapi_Value **vals, const Slapi_Value *cred)
+{
+    unsigned char mac[PW_CACHE_MAC_LEN];
+    pw_cache_bucket *bucket;
+    time_t now;
+    int found = 0;
+
+    if (ndn == NULL || config_get_pwd_verify_cache_ttl() == 0) {
+        return 0;
+    }
+    bucket = pw_cache_get_bucket(ndn);
+    if (pw_cache_mac(ndn, vals, cred, mac) != 0) {
+        return 0;
+    }
+
+    now = slapi_current_rel_time_hr().tv_sec;
+    pthread_mutex_lock(&bucket->pcb_lock);
+    for (size_t i = 0; i < PW_CACHE_WAYS; i++) {
+        pw_cache_slot *slot = &bucket->pcb_slots[i];
+        if (slot->pcs_ndn == NULL || strcmp(slot->pcs_ndn, ndn) != 0) {
+            continue;
+        }
+        if (slot->pcs_expire <= now) {
+            pw_cache_slot_clear(slot);
+        } else {
+            /* a wrong password leaves the slot alone, it must not evict the right one */
+            found = pw_cache_mac_equal(slot->pcs_mac, mac);
+        }
+        break;
+    }
+    pthread_mutex_unlock(&bucket->pcb_lock);
+
+    return found;
+}
+
+/*
+ * Remember that cred matched vals for ndn. Replaces the entry of ndn, else a
+ * free slot, else the slot that expires first.
+ */
+void
+pw_verify_cache_add(const char *ndn, Slapi_Value **vals, const Slapi_Value *cred)
+{
+    unsigned char mac[PW_CACHE_MAC_LEN];
+    pw_cache_bucket *bucket;
+    pw_cache_slot *victim = NULL;
+    int32_t ttl = config_get_pwd_verify_cache_ttl();
+    time_t now;
+
+    if (ndn == NULL || ttl == 0) {
+        return;
+    }
+    bucket = pw_cache_get_bucket(ndn);
+    if (pw_cache_mac(ndn, vals, cred, mac) != 0) {
+        return;
+    }
+
+    now = slapi_current_rel_time_hr().tv_sec;
+    pthread_mutex_lock(&bucket->pcb_lock);
+    for (size_t i = 0; i < PW_CACHE_WAYS; i++) {
+        pw_cache_slot *slot = &bucket->pcb_slots[i];
+        if (slot->pcs_ndn && strcmp(slot->pcs_ndn, ndn) == 0) {
+            victim = slot;
+            break;
+        }
+        /* free slots have pcs_expire 0, so they are taken first */
+        if (victim == NULL || slot->pcs_expire < victim->pcs_expire) {
+            victim = slot;
+        }
+    }
+    if (victim->pcs_ndn == NULL || strcmp(victim->pcs_ndn, ndn) != 0) {
+        pw_cache_slot_clear(victim);
+        victim->pcs_ndn = slapi_ch_strdup(ndn);
+    }
+    memcpy(victim->pcs_mac, mac, sizeof(mac));
+    victim->pcs_expire = now + ttl;
+    pthread_mutex_unlock(&bucket->pcb_lock);
+}
+
+/*
+ * Forget the verification of ndn, called when its password changes or the
+ * account gets locked.
+ */
+void
+pw_verify_cache_invalidate(const char *ndn)
+{
+    pw_cache_bucket *bucket;
+
+    if (ndn == NULL) {
+        return;
+    }
+    bucket = pw_cache_get_bucket(ndn);
+    pthread_mutex_lock(&bucket->pcb_lock);
+    for (size_t i = 0; i < PW_CACHE_WAYS; i++) {
+        pw_cache_slot *slot = &bucket->pcb_slots[i];
+        if (slot->pcs_ndn && strcmp(slot->pcs_ndn, ndn) == 0) {
+            pw_cache_slot_clear(slot);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&bucket->pcb_lock);
+}
@@ -0,0 +1,351 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/*
+ * pw_crypto.c
+ *
+ * A small pool of threads that run the password storage scheme comparisons of
+ * database binds. Schemes such as PBKDF2-SHA256 are tuned to take milliseconds
+ * per compare, so a bind storm run inline would hold every worker thread and
+ * starve all other operations. With the pool the number of concurrent compares
+ * is bounded by nsslapd-pwd-crypto-threads, and at most
+ * nsslapd-pwd-crypto-queue-size binds wait for one. Binds beyond that, or binds
+ * that waited longer than nsslapd-pwd-crypto-queue-timeout ms, are answered with
+ * LDAP_BUSY without hashing anything.
+ *
+ * The worker thread still waits for its compare: it is the hashing that is
+ * bounded, and the number of workers a bind storm can hold is threads plus
+ * queue size instead of nsslapd-threadnumber. Both default to -1, derived
+ * from nsslapd-threadnumber so that binds hold at most half of the workers,
+ * and a pool that could hold all of them is rejected.
+ */
+
+#include <unistd.h>
+#include "slap.h"
+
+typedef struct pw_crypto_job
+{
+    Slapi_Value **pcj_vals;
+    const Slapi_Value *pcj_cred;
+    struct timespec pcj_queued; /* when the job was queued */
+    int pcj_rc;                 /* slapi_pw_find_sv() result, or PW_CRYPTO_BUSY */
+    int pcj_done;
+    pthread_cond_t pcj_cv; /* signalled when pcj_done is set */
+    struct pw_crypto_job *pcj_next;
+} pw_crypto_job;
+
+static struct
+{
+    pthread_mutex_t pc_lock;
+    pthread_cond_t pc_cv; /* signalled when a job is queued or on shutdown */
+    PRThread **pc_threads;
+    int32_t pc_nthreads;
+    int32_t pc_queue_size; /* derived queue size, when nsslapd-pwd-crypto-queue-size is -1 */
+    int pc_started;
+    int pc_shutdown;
+    pw_crypto_job *pc_head;
+    pw_crypto_job *pc_tail;
+    uint64_t pc_queued;   /* jobs waiting for a thread */
+    uint64_t pc_running;  /* jobs being hashed */
+    uint64_t pc_compares; /* compares done by the pool */
+    uint64_t pc_rejected; /* binds answered with LDAP_BUSY */
+    uint64_t pc_queue_usec;
+    uint64_t pc_hash_usec;
+} pw_crypto = {.pc_lock = PTHREAD_MUTEX_INITIALIZER, .pc_cv = PTHREAD_COND_INITIALIZER};
+
+static void
+pw_crypto_job_done(pw_crypto_job *job, int rc)
+{
+    job->pcj_rc = rc;
+    job->pcj_done = 1;
+    pthread_cond_signal(&job->pcj_cv);
+}
+
+static void
+pw_crypto_thread(void *arg __attribute__((unused)))
+{
+    pthread_mutex_lock(&pw_crypto.pc_lock);
+    while (!pw_crypto.pc_shutdown) {
+        pw_crypto_job *job = pw_crypto.pc_head;
+        struct timespec start;
+        uint64_t waited;
+        int32_t timeout;
+        int rc;
+
+        if (job == NULL) {
+            pthread_cond_wait(&pw_crypto.pc_cv, &pw_crypto.pc_lock);
+            continue;
+        }
+        if ((pw_crypto.pc_head = job->pcj_next) == NULL) {
+            pw_crypto.pc_tail = NULL;
+        }
+        pw_crypto.pc_queued--;
+
+        waited = operation_profile_usec(&job->pcj_queued);
+        timeout = config_get_pwd_crypto_queue_timeout();
+        if (timeout > 0 && waited > (uint64_t)timeout * 1000) {
+            /* the client has likely given up, don't spend the cpu on it */
+            pw_crypto.pc_rejected++;
+            pw_crypto_job_done(job, PW_CRYPTO_BUSY);
+            continue;
+        }
+        pw_crypto.pc_queue_usec += waited;
+        pw_crypto.pc_running++;
+        pthread_mutex_unlock(&pw_crypto.pc_lock);
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        rc = slapi_pw_find_sv(job->pcj_vals, job->pcj_cred);
+
+        pthread_mutex_lock(&pw_crypto.pc_lock);
+        pw_crypto.pc_hash_usec += operation_profile_usec(&start);
+        pw_crypto.pc_running--;
+        pw_crypto.pc_compares++;
+        pw_crypto_job_done(job, rc);
+    }
+    pthread_mutex_unlock(&pw_crypto.pc_lock);
+}
+
+/*
+ * Resolve the configured number of compare threads and queue size, -1 for
+ * the defaults: binds may hold half of the workers, a quarter of them
+ * comparing (at most one per cpu) and the others waiting in the queue.
+ */
+static void
+pw_crypto_sizes(int32_t workers, int32_t threads, int32_t queue, int32_t *nthreads, int32_t *queue_size)
+{
+    int32_t bound = workers / 2;
+
+    if (threads < 0) {
+        long hw_threads = sysconf(_SC_NPROCESSORS_ONLN);
+
+        threads = bound / 2;
+        if (hw_threads > 0 && threads > hw_threads) {
+            threads = (int32_t)hw_threads;
+        }
+        if (threads < 1) {
+            threads = 1;
+        }
+    }
+    if (queue < 0) {
+        queue = bound - threads;
+        if (queue < 1) {
+            queue = 1;
+        }
+    }
+    *nthreads = threads;
+    *queue_size = queue;
+}
+
+/*
+ * Check that a pool of threads compare threads and queue binds waiting
+ * leaves at least one worker thread free for the other operations.
+ * Returns 0, or -1 with the reason in errorbuf.
+ */
+int
+pw_crypto_check_sizes(int32_t threads, int32_t queue, char *errorbuf)
+{
+    int32_t workers = config_get_threadnumber();
+    int32_t nthreads, queue_size;
+
+    if (threads == 0) {
+        return 0;
+    }
+    pw_crypto_sizes(workers, threads, queue, &nthreads, &queue_size);
+    if (nthreads + queue_size >= workers) {
+        slapi_create_errormsg(errorbuf, SLAPI_DSE_RETURNTEXT_SIZE,
+                              "%d password compare threads and %d queued binds would hold all "
+                              "the %d worker threads (nsslapd-threadnumber)",
+                              nthreads, queue_size, workers);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Check a new nsslapd-pwd-crypto-threads or nsslapd-pwd-crypto-queue-size
+ * against the worker threads. The configuration is read before the pool is
+ * started, and nsslapd-threadnumber may come after these attributes, so at
+ * startup the check is done by pw_crypto_start on the whole configuration.
+ */
+int
+pw_crypto_check_config(int32_t threads, int32_t queue, char *errorbuf)
+{
+    if (!pw_crypto.pc_started) {
+        return 0;
+    }
+    return pw_crypto_check_sizes(threads, queue, errorbuf);
+}
+
+/*
+ * Start the pool. Called once at startup, nsslapd-pwd-crypto-threads is not
+ * dynamic.
+ */
+int
+pw_crypto_start(void)
+{
+    int32_t threads = config_get_pwd_crypto_threads();
+    int32_t queue = config_get_pwd_crypto_queue_size();
+    char errorbuf[SLAPI_DSE_RETURNTEXT_SIZE] = {0};
+    int32_t nthreads;
+
+    pw_crypto.pc_started = 1;
+    if (threads == 0) {
+        slapi_log_err(SLAPI_LOG_INFO, "pw_crypto_start",
+                      "Password compares run on the worker threads\n");
+        return 0;
+    }
+    if (pw_crypto_check_sizes(threads, queue, errorbuf) != 0) {
+        /* the defaults only fail with very few worker threads */
+        slapi_log_err((threads < 0 && queue < 0) ? SLAPI_LOG_INFO : SLAPI_LOG_ERR, "pw_crypto_start",
+                      "%s, password compares run on the worker threads\n", errorbuf);
+        return -1;
+    }
+    pw_crypto_sizes(config_get_threadnumber(), threads, queue, &nthreads, &pw_crypto.pc_queue_size);
+
+    pw_crypto.pc_threads = (PRThread **)slapi_ch_calloc(nthreads, sizeof(PRThread *));
+    for (int32_t i = 0; i < nthreads; i++) {
+        pw_crypto.pc_threads[i] = PR_CreateThread(PR_USER_THREAD,
+                                                  (VFP)pw_crypto_thread, NULL,
+                                                  PR_PRIORITY_NORMAL, PR_GLOBAL_THREAD, PR_JOINABLE_THREAD,
+                                                  SLAPD_DEFAULT_THREAD_STACKSIZE);
+        if (pw_crypto.pc_threads[i] == NULL) {
+            slapi_log_err(SLAPI_LOG_ERR, "pw_crypto_start",
+                          "PR_CreateThread failed. " SLAPI_COMPONENT_NAME_NSPR " error %d (%s)\n",
+                          PR_GetError(), slapd_pr_strerror(PR_GetError()));
+            break;
+        }
+        pw_crypto.pc_nthreads++;
+    }
+    slapi_log_err(SLAPI_LOG_INFO, "pw_crypto_start",
+                  "Started %d password compare threads, queue size %d\n",
+                  pw_crypto.pc_nthreads, pw_crypto.pc_queue_size);
+
+    return pw_crypto.pc_nthreads ? 0 : -1;
+}
+
+/*
+ * Stop the pool. Queued binds are answered with LDAP_BUSY, running compares
+ * are finished first.
+ */
+void
+pw_crypto_stop(void)
+{
+    pw_crypto_job *job;
+
+    pthread_mutex_lock(&pw_crypto.pc_lock);
+    pw_crypto.pc_shutdown = 1;
+    while ((job = pw_crypto.pc_head) != NULL) {
+        pw_crypto.pc_head = job->pcj_next;
+        pw_crypto.pc_queued--;
+        pw_crypto_job_done(job, PW_CRYPTO_BUSY);
+    }
+    pw_crypto.pc_tail = NULL;
+    pthread_cond_broadcast(&pw_crypto.pc_cv);
+    pthread_mutex_unlock(&pw_crypto.pc_lock);
+
+    for (int32_t i = 0; i < pw_crypto.pc_nthreads; i++) {
+        (void)PR_JoinThread(pw_crypto.pc_threads[i]);
+    }
+    slapi_ch_free((void **)&pw_crypto.pc_threads);
+    pw_crypto.pc_nthreads = 0;
+}
+
+/*
+ * slapi_pw_find_sv() run on the password compare threads.
+ *
+ * Returns 0 if cred matches one of vals, 1 if it does not, and
+ * PW_CRYPTO_BUSY if the queue is full or the bind waited too long; the caller
+ * should then answer LDAP_BUSY. Without a pool the compare runs inline.
+ */
+int
+pw_crypto_find_sv(Slapi_Value **vals, const Slapi_Value *cred)
+{
+    pw_crypto_job job = {0};
+    int32_t queue_size = config_get_pwd_crypto_queue_size();
+
+    if (queue_size < 0) {
+        queue_size = pw_crypto.pc_queue_size;
+    }
+    pthread_mutex_lock(&pw_crypto.pc_lock);
+    if (pw_crypto.pc_nthreads == 0 || pw_crypto.pc_shutdown) {
+        pthread_mutex_unlock(&pw_crypto.pc_lock);
+        return slapi_pw_find_sv(vals, cred);
+    }
+    if (pw_crypto.pc_queued >= (uint64_t)queue_size) {
+        pw_crypto.pc_rejected++;
+        pthread_mutex_unlock(&pw_crypto.pc_lock);
+        slapi_log_err(SLAPI_LOG_TRACE, "pw_crypto_find_sv",
+                      "Password compare queue is full, rejecting the bind\n");
+        return PW_CRYPTO_BUSY;
+    }
+
+    job.pcj_vals = vals;
+    job.pcj_cred = cred;
+    clock_gettime(CLOCK_MONOTONIC, &job.pcj_queued);
+    pthread_cond_init(&job.pcj_cv, NULL);
+    if (pw_crypto.pc_tail) {
+        pw_crypto.pc_tail->pcj_next = &job;
+    } else {
+        pw_crypto.pc_head = &job;
+    }
+    pw_crypto.pc_tail = &job;
+    pw_crypto.pc_queued++;
+    pthread_cond_signal(&pw_crypto.pc_cv);
+
+    while (!job.pcj_done) {
+        pthread_cond_wait(&job.pcj_cv, &pw_crypto.pc_lock);
+    }
+    pthread_mutex_unlock(&pw_crypto.pc_lock);
+    pthread_cond_destroy(&job.pcj_cv);
+
+    return job.pcj_rc;
+}
+
+static void
+pw_crypto_monitor_attr(Slapi_Entry *e, const char *type, uint64_t value)
+{
+    struct berval val;
+    struct berval *vals[2] = {&val, NULL};
+    char buf[32];
+
+    val.bv_len = snprintf(buf, sizeof(buf), "%" PRIu64, value);
+    val.bv_val = buf;
+    attrlist_replace(&e->e_attrs, type, vals);
+}
+
+/*
+ * Add the pool counters to cn=monitor. The usec totals divided by
+ * pwdcryptocompares give the average queue and hash time of a bind.
+ */
+void
+pw_crypto_as_entry(Slapi_Entry *e)
+{
+    uint64_t threads, queued, running, compares, rejected, queue_usec, hash_usec;
+
+    pthread_mutex_lock(&pw_crypto.pc_lock);
+    threads = pw_crypto.pc_nthreads;
+    queued = pw_crypto.pc_queued;
+    running = pw_crypto.pc_running;
+    compares = pw_crypto.pc_compares;
+    rejected = pw_crypto.pc_rejected;
+    queue_usec = pw_crypto.pc_queue_usec;
+    hash_usec = pw_crypto.pc_hash_usec;
+    pthread_mutex_unlock(&pw_crypto.pc_lock);
+
+    pw_crypto_monitor_attr(e, "pwdcryptothreads", threads);
+    pw_crypto_monitor_attr(e, "pwdcryptoqueued", queued);
+    pw_crypto_monitor_attr(e, "pwdcryptorunning", running);
+    pw_crypto_monitor_attr(e, "pwdcryptocompares", compares);
+    pw_crypto_monitor_attr(e, "pwdcryptorejected", rejected);
+    pw_crypto_monitor_attr(e, "pwdcryptoqueueusec", queue_usec);
+    pw_crypto_monitor_attr(e, "pwdcryptohashusec", hash_usec);
+}
@@ -153,6 +153,7 @@ set_retry_cnt_mods(Slapi_PBlock *pb, Slapi_Mods *smods, int count)
             timestr = format_genTime(unlock_time);
             slapi_mods_add_string(smods, LDAP_MOD_REPLACE, "accountUnlockTime", timestr);
             slapi_ch_free((void **)&timestr);
+            pw_verify_cache_invalidate(slapi_sdn_get_ndn(sdn));
             rc = LDAP_CONSTRAINT_VIOLATION;
         }
     }
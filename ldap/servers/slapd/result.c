@@ -32,6 +32,7 @@
 
 static Slapi_Counter *num_entries_sent;
 static Slapi_Counter *num_bytes_sent;
+static Slapi_Counter *num_result_writes;
 
 static long current_conn_count;
 static PRLock *current_conn_count_mutex;
@@ -77,6 +78,18 @@ g_get_num_bytes_sent()
     return (slapi_counter_get_value(num_bytes_sent));
 }
 
+void
+g_set_num_result_writes(Slapi_Counter *counter)
+{
+    num_result_writes = counter;
+}
+
+PRUint64
+g_get_num_result_writes()
+{
+    return (slapi_counter_get_value(num_result_writes));
+}
+
 static void
 delete_default_referral(struct berval **referrals)
 {
@@ -1115,6 +1128,38 @@ idds_map_attrt_v3(
 
 /* Helper functions */
 
+/* options of the encoded user attributes kept in the entry */
+#define ENTRY_ENCODING_RFC1274 0x1 /* attributes also returned with their RFC1274 name */
+
+/*
+ * Check whether the bound user may read every user attribute send_all_attrs()
+ * would return from e, without encoding anything.
+ * Returns 1 if so, 0 otherwise.
+ */
+static int
+send_all_attrs_readable(Slapi_PBlock *pb, Slapi_Entry *e, vattr_type_thang *typelist)
+{
+#if !defined(DISABLE_ACL_CHECK)
+    vattr_type_thang *current_type = NULL;
+    char *attrs[2] = {NULL, NULL};
+
+    for (current_type = vattr_typethang_first(typelist); current_type; current_type = vattr_typethang_next(current_type)) {
+        Slapi_ValueSet *values = vattr_typethang_get_values(current_type);
+
+        if ((vattr_typethang_get_flags(current_type) & SLAPI_ATTR_FLAG_OPATTR) ||
+            values == NULL || slapi_valueset_count(values) == 0) {
+            continue;
+        }
+        attrs[0] = vattr_typethang_get_name(current_type);
+        if (plugin_call_acl_plugin(pb, e, attrs, NULL, SLAPI_ACL_READ,
+                                   ACLPLUGIN_ACCESS_READ_ON_ATTR, NULL) != LDAP_SUCCESS) {
+            return 0;
+        }
+    }
+#endif
+    return 1;
+}
+
 static int
 send_all_attrs(Slapi_Entry *e, char **attrs, Slapi_Operation *op, Slapi_PBlock *pb, BerElement *ber, int attrsonly, int ldapversion, int real_attrs_only, int some_named_attrs, int alloperationalattrs, int alluserattrs)
 {
@@ -1129,6 +1174,10 @@ send_all_attrs(Slapi_Entry *e, char **attrs, Slapi_Operation *op, Slapi_PBlock *
     int vattr_flags = 0;
     const char *dn = NULL;
     char **default_attrs = NULL;
+    BerElement *out = ber;     /* where the attributes are encoded */
+    BerElement *scratch = NULL; /* set when the encoding is to be kept in the entry */
+    int encoding_flags = 0;
+    int32_t encoding_watermark = 0;
 
     if (real_attrs_only == SLAPI_SEND_VATTR_FLAG_REALONLY)
         vattr_flags = SLAPI_REALATTRS_ONLY;
@@ -1168,6 +1217,37 @@ send_all_attrs(Slapi_Entry *e, char **attrs, Slapi_Operation *op, Slapi_PBlock *
     if (dn == NULL || *dn == '\0') {
         default_attrs = slapi_entry_attr_get_charray(e, CONFIG_RETURN_DEFAULT_OPATTR);
     }
+
+    /*
+     * When exactly the real user attributes of an entry held by the entry
+     * cache are returned, and the client may read all of them, the encoded
+     * attributes are the same for every search: reuse the encoding kept in
+     * the entry, or keep the one about to be built.
+     */
+    if (alluserattrs && !alloperationalattrs && !some_named_attrs && !attrsonly &&
+        ldapversion >= LDAP_VERSION3 && default_attrs == NULL &&
+        real_attrs_only != SLAPI_SEND_VATTR_FLAG_VIRTUALONLY &&
+        (typelist_flags & SLAPI_VIRTUALATTRS_REALATTRS_ONLY) &&
+        entry_encoding_enabled(e)) {
+        encoding_flags = rewrite_rfc1274 ? ENTRY_ENCODING_RFC1274 : 0;
+        encoding_watermark = entry_encoding_watermark();
+        if (send_all_attrs_readable(pb, e, typelist)) {
+            rc = entry_encoding_append(e, encoding_flags, ber);
+            if (rc == 0) {
+                goto exit;
+            } else if (rc < 0) {
+                slapi_log_err(SLAPI_LOG_ERR, "send_all_attrs", "ber_write failed\n");
+                send_ldap_result(pb, LDAP_OPERATIONS_ERROR, NULL,
+                                 "ber_write attributes", 0, NULL);
+                goto exit;
+            }
+            rc = 0;
+            if ((scratch = der_alloc()) != NULL) {
+                out = scratch;
+            }
+        }
+    }
+
     /* Send the attrs back to the client */
     for (current_type = vattr_typethang_first(typelist); current_type; current_type = vattr_typethang_next(current_type)) {
 
@@ -1266,14 +1346,14 @@ send_all_attrs(Slapi_Entry *e, char **attrs, Slapi_Operation *op, Slapi_PBlock *
                     }
 
                     if (!skipit) {
-                        rc = encode_attr_2(pb, ber, e, values[iter], attrsonly,
+                        rc = encode_attr_2(pb, out, e, values[iter], attrsonly,
                                            current_type_name, name_to_return);
 
                         if (rewrite_rfc1274 != 0) {
                             v2name = idds_map_attrt_v3(current_type_name);
                             if (v2name != NULL) {
                                 /* also return values with RFC1274 attr name */
-                                rc = encode_attr_2(pb, ber, e, values[iter],
+                                rc = encode_attr_2(pb, out, e, values[iter],
                                                    attrsonly,
                                                    current_type_name,
                                                    v2name);
@@ -1301,6 +1381,22 @@ send_all_attrs(Slapi_Entry *e, char **attrs, Slapi_Operation *op, Slapi_PBlock *
             }
         }
     }
+    if (scratch) {
+        /* encode_attr_2() frees scratch when it fails */
+        struct berval *attrs_bv = NULL;
+
+        if (ber_flatten(scratch, &attrs_bv) != 0 ||
+            ber_write(ber, attrs_bv->bv_val, attrs_bv->bv_len, 0) != (ber_slen_t)attrs_bv->bv_len) {
+            slapi_log_err(SLAPI_LOG_ERR, "send_all_attrs", "ber_write failed\n");
+            send_ldap_result(pb, LDAP_OPERATIONS_ERROR, NULL,
+                             "ber_write attributes", 0, NULL);
+            ber_bvfree(attrs_bv);
+            rc = -1;
+        } else {
+            entry_encoding_set(e, encoding_flags, encoding_watermark, attrs_bv);
+        }
+        ber_free(scratch, 1);
+    }
 exit:
     if (NULL != typelist) {
         slapi_vattr_attrs_free(&typelist, typelist_flags);
@@ -1471,6 +1567,9 @@ send_ldap_search_entry_ext(
     Slapi_Entry *gerentry = NULL;
     Slapi_Entry *ecopy = NULL;
     LDAPControl **searchctrlp = NULL;
+    Op_Profile *profile = NULL;
+    struct timespec encode_start;
+    uint64_t encode_acl_usec = 0;
 
 
     slapi_pblock_get(pb, SLAPI_CONNECTION, &conn);
@@ -1529,6 +1628,11 @@ send_ldap_search_entry_ext(
         goto cleanup;
     }
 
+    if ((profile = operation_get_profile(operation))) {
+        clock_gettime(CLOCK_MONOTONIC, &encode_start);
+        encode_acl_usec = profile->opp_acl_usec;
+    }
+
     if ((ber = der_alloc()) == NULL) {
         slapi_log_err(SLAPI_LOG_ERR, "send_ldap_search_entry_ext", "ber_alloc failed\n");
         send_ldap_result(pb, LDAP_OPERATIONS_ERROR, NULL,
@@ -1669,6 +1773,12 @@ send_ldap_search_entry_ext(
         send_ldap_result_ext(pb, LDAP_SUCCESS, NULL, NULL, nentries, urls, ber);
     }
 
+    if (profile) {
+        /* the attribute access checks are accounted as acl time */
+        profile->opp_encode_usec += operation_profile_usec(&encode_start) -
+                                    (profile->opp_acl_usec - encode_acl_usec);
+    }
+
     /* write only one pdu at a time - wait til it's our turn */
     if ((rc = flush_ber(pb, conn, operation, ber, _LDAP_SEND_ENTRY)) == 0) {
         logit = 1;
@@ -1728,6 +1838,163 @@ cleanup:
 }
 
 
+/*
+ * Search entries and referrals are not written one by one: they are appended
+ * to op->o_sendber and written together once nsslapd-search-output-buffer-size
+ * bytes are queued, once the first queued PDU is older than
+ * nsslapd-search-output-buffer-delay (checked when a PDU is sent and by
+ * slapi_op_flush_queued_results), or with the next PDU that cannot be
+ * queued (the search result). The whole queue is one ber_flush() through the
+ * connection Sockbuf, so SASL and TLS see one large buffer instead of a
+ * record per entry.
+ *
+ * Only the entries returned while the search iterates on the backend
+ * (OP_FLAG_QUEUE_RESULTS) are queued: the entries of persistent searches,
+ * including the persist phase of a sync repl search (the sync plugin
+ * OP_FLAG_SYNC_PERSIST is OP_FLAG_PS), are sent later by other threads
+ * with no result to carry them, so they are always written at once.
+ *
+ * Returns 1 if ber was queued and nothing has to be written yet, 0 if *ber
+ * must be written, and -1 if the PDU could not be queued (both are freed).
+ */
+static int
+flush_ber_queue(Operation *op, BerElement **ber, int type, uint32_t *npdus)
+{
+    int32_t bufsize = config_get_search_output_buffer_size();
+    int queue = (type == _LDAP_SEND_ENTRY || type == _LDAP_SEND_REFERRAL) &&
+                bufsize > 0 &&
+                op->o_tag == LDAP_REQ_SEARCH &&
+                (op->o_flags & OP_FLAG_QUEUE_RESULTS) &&
+                !(op->o_flags & OP_FLAG_PS);
+    struct berval bv = {0};
+    ber_len_t queued = 0;
+
+    *npdus = 1;
+    if (op->o_sendber == NULL) {
+        if (!queue) {
+            return 0;
+        }
+        if ((op->o_sendber = der_alloc()) == NULL) {
+            return 0;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &op->o_sendber_time);
+        op->o_sendber_pdus = 0;
+    }
+
+    if (ber_flatten2(*ber, &bv, 0) != 0 ||
+        ber_write(op->o_sendber, bv.bv_val, bv.bv_len, 0) != (ber_slen_t)bv.bv_len) {
+        slapi_log_err(SLAPI_LOG_ERR, "flush_ber_queue",
+                      "conn=%" PRIu64 " op=%d Failed to queue a result PDU\n",
+                      op->o_connid, op->o_opid);
+        ber_free(*ber, 1);
+        ber_free(op->o_sendber, 1);
+        *ber = NULL;
+        op->o_sendber = NULL;
+        op->o_sendber_pdus = 0;
+        return -1;
+    }
+    ber_free(*ber, 1);
+    op->o_sendber_pdus++;
+
+    ber_get_option(op->o_sendber, LBER_OPT_BYTES_TO_WRITE, &queued);
+    if (queue && queued < (ber_len_t)bufsize &&
+        operation_profile_usec(&op->o_sendber_time) < (uint64_t)config_get_search_output_buffer_delay() * 1000) {
+        *ber = NULL;
+        return 1;
+    }
+
+    *ber = op->o_sendber;
+    *npdus = op->o_sendber_pdus;
+    op->o_sendber = NULL;
+    op->o_sendber_pdus = 0;
+    return 0;
+}
+
+/*
+ * Write npdus result PDUs to the client, always frees the ber
+ */
+static int
+flush_ber_write(Connection *conn, Operation *op, BerElement *ber, uint32_t npdus)
+{
+    ber_len_t bytes;
+    int rc;
+
+    ber_get_option(ber, LBER_OPT_BYTES_TO_WRITE, &bytes);
+
+    PR_Lock(conn->c_pdumutex);
+    rc = ber_flush(conn->c_sb, ber, 1);
+    PR_Unlock(conn->c_pdumutex);
+
+    if (rc != 0) {
+        int oserr = errno;
+        /* One of the failure can be because the client has reset the connection ( closed )
+         * and the status needs to be updated to reflect it */
+        op->o_status = SLAPI_OP_STATUS_ABANDONED;
+
+        slapi_log_err(SLAPI_LOG_CONNS, "flush_ber", "Failed, error %d (%s)\n",
+                      oserr, slapd_system_strerror(oserr));
+        if (op->o_flags & OP_FLAG_PS) {
+            /* We need to tell disconnect_server() not to ding
+             * all the psearches if one if them disconnected
+             * But we do need to terminate all persistent searches that are using
+             * this connection
+             *    op->o_flags |= OP_FLAG_PS_SEND_FAILED;
+             */
+        }
+        do_disconnect_server(conn, op->o_connid, op->o_opid);
+        ber_free(ber, 1);
+    } else {
+        PRUint64 b;
+        slapi_log_err(SLAPI_LOG_BER, "flush_ber",
+                      "Wrote %lu bytes (%u PDUs) to socket %d\n", bytes, npdus, conn->c_sd);
+        LL_I2L(b, bytes);
+        slapi_counter_add(num_bytes_sent, b);
+        slapi_counter_increment(num_result_writes);
+        op->o_writes++;
+        op->o_pdus_sent += npdus;
+
+        if (!config_check_referral_mode())
+            slapi_counter_add(g_get_global_snmp_vars()->ops_tbl.dsBytesSent, bytes);
+    }
+    return rc;
+}
+
+/*
+ * Write the search results queued for an operation once they are older than
+ * nsslapd-search-output-buffer-delay. The queue is otherwise only written
+ * when a PDU is sent: the backend calls this while it looks through
+ * candidates that do not match, so that the entries already found are not
+ * held until the next one, or the result, is found.
+ */
+void
+slapi_op_flush_queued_results(Slapi_PBlock *pb)
+{
+    Operation *op = NULL;
+    Connection *conn = NULL;
+    BerElement *ber;
+    uint32_t npdus;
+
+    slapi_pblock_get(pb, SLAPI_OPERATION, &op);
+    if (op == NULL || op->o_sendber == NULL ||
+        operation_profile_usec(&op->o_sendber_time) < (uint64_t)config_get_search_output_buffer_delay() * 1000) {
+        return;
+    }
+    slapi_pblock_get(pb, SLAPI_CONNECTION, &conn);
+    if (conn == NULL) {
+        return;
+    }
+
+    ber = op->o_sendber;
+    npdus = op->o_sendber_pdus;
+    op->o_sendber = NULL;
+    op->o_sendber_pdus = 0;
+    if ((conn->c_flags & CONN_FLAG_CLOSING) || slapi_op_abandoned(pb)) {
+        ber_free(ber, 1);
+        return;
+    }
+    flush_ber_write(conn, op, ber, npdus);
+}
+
 /*
  * always frees the ber
  */
@@ -1739,7 +2006,7 @@ flush_ber(
     BerElement *ber,
     int type)
 {
-    ber_len_t bytes;
+    uint32_t npdus = 1;
     int rc = 0;
 
     switch (type) {
@@ -1762,47 +2029,28 @@ flush_ber(
         slapi_log_err(SLAPI_LOG_CONNS, "flush_ber",
                       "Skipped because the connection was marked to be closed or abandoned\n");
         ber_free(ber, 1);
+        if (op->o_sendber) {
+            ber_free(op->o_sendber, 1);
+            op->o_sendber = NULL;
+            op->o_sendber_pdus = 0;
+        }
         /* One of the failure can be because the client has reset the connection ( closed )
              * and the status needs to be updated to reflect it */
         op->o_status = SLAPI_OP_STATUS_ABANDONED;
         rc = -1;
-    } else {
-        ber_get_option(ber, LBER_OPT_BYTES_TO_WRITE, &bytes);
-
-        PR_Lock(conn->c_pdumutex);
-        rc = ber_flush(conn->c_sb, ber, 1);
-        PR_Unlock(conn->c_pdumutex);
-
-        if (rc != 0) {
-            int oserr = errno;
-            /* One of the failure can be because the client has reset the connection ( closed )
-             * and the status needs to be updated to reflect it */
-            op->o_status = SLAPI_OP_STATUS_ABANDONED;
-
-            slapi_log_err(SLAPI_LOG_CONNS, "flush_ber", "Failed, error %d (%s)\n",
-                          oserr, slapd_system_strerror(oserr));
-            if (op->o_flags & OP_FLAG_PS) {
-                /* We need to tell disconnect_server() not to ding
-            * all the psearches if one if them disconnected
-            * But we do need to terminate all persistent searches that are using
-            * this connection
-            *    op->o_flags |= OP_FLAG_PS_SEND_FAILED;
-            */
-            }
-            do_disconnect_server(conn, op->o_connid, op->o_opid);
-            ber_free(ber, 1);
-        } else {
-            PRUint64 b;
-            slapi_log_err(SLAPI_LOG_BER, "flush_ber",
-                          "Wrote %lu bytes to socket %d\n", bytes, conn->c_sd);
-            LL_I2L(b, bytes);
-            slapi_counter_add(num_bytes_sent, b);
-
-            if (type == _LDAP_SEND_ENTRY) {
-                slapi_counter_increment(num_entries_sent);
-            }
-            if (!config_check_referral_mode())
-                slapi_counter_add(g_get_global_snmp_vars()->ops_tbl.dsBytesSent, bytes);
+    } else if ((rc = flush_ber_queue(op, &ber, type, &npdus)) < 0) {
+        /* the client would miss PDUs in the middle of the search */
+        op->o_status = SLAPI_OP_STATUS_ABANDONED;
+        do_disconnect_server(conn, op->o_connid, op->o_opid);
+    } else if (rc > 0) {
+        /* queued, written with a later PDU */
+        rc = 0;
+        if (type == _LDAP_SEND_ENTRY) {
+            slapi_counter_increment(num_entries_sent);
+        }
+    } else if ((rc = flush_ber_write(conn, op, ber, npdus)) == 0) {
+        if (type == _LDAP_SEND_ENTRY) {
+            slapi_counter_increment(num_entries_sent);
         }
     }
 
@@ -1859,6 +2107,7 @@ static struct slapi_note_map notemap[] = {
     {SLAPI_OP_NOTE_SIMPLEPAGED, "P", "Paged Search"},
     {SLAPI_OP_NOTE_FULL_UNINDEXED, "A", "Fully Unindexed Filter"},
     {SLAPI_OP_NOTE_FILTER_INVALID, "F", "Filter Element Missing From Schema"},
+    {SLAPI_OP_NOTE_INDEX_SKIPPED, "S", "Unselective Index Lookup Skipped"},
 };
 
 #define SLAPI_NOTEMAP_COUNT (sizeof(notemap) / sizeof(struct slapi_note_map))
@@ -2117,7 +2366,7 @@ log_result(Slapi_PBlock *pb, Operation *op, int err, ber_tag_t tag, int nentries
             char *ext_str = NULL;
             slapi_pblock_get(pb, SLAPI_PB_RESULT_TEXT, &pbtxt);
             if (pbtxt) {
-                ext_str = slapi_ch_smprintf(" - %s", pbtxt);
+                ext_str = slapi_operation_arena_smprintf(op, " - %s", pbtxt);
             } else {
                 ext_str = "";
             }
@@ -2129,10 +2378,6 @@ log_result(Slapi_PBlock *pb, Operation *op, int err, ber_tag_t tag, int nentries
                              err, tag, nentries,
                              wtime, optime, etime,
                              notes_str, csn_str, ext_str);
-            if (pbtxt) {
-                /* if !pbtxt ==> ext_str == "".  Don't free ext_str. */
-                slapi_ch_free_string(&ext_str);
-            }
         } else {
             int optype;
 #define LOG_MSG_FMT " tag=%" BERTAG_T " nentries=%d wtime=%s optime=%s etime=%s%s%s\n"
@@ -2180,6 +2425,9 @@ log_result(Slapi_PBlock *pb, Operation *op, int err, ber_tag_t tag, int nentries
             }
         }
     }
+    if (!internal_op && op->o_profile) {
+        operation_profile_log(op);
+    }
 }
 
 
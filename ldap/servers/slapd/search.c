@@ -381,6 +381,10 @@ do_search(Slapi_PBlock *pb)
     slapi_pblock_set(pb, SLAPI_SEARCH_TIMELIMIT, &timelimit);
 
 
+    if (config_get_accesslog_level() & LDAP_DEBUG_PROFILE) {
+        operation_profile_init(operation);
+    }
+
     /*
      * op_shared_search defines STAP_PROBE for __entry and __return,
      * so these can be used to delineate the start and end here.
@@ -254,6 +254,23 @@ typedef void (*VFPV)(); /* takes undefined arguments */
 #define SLAPD_DEFAULT_MAX_SASLIO_SIZE_STR "2097152"
 #define SLAPD_DEFAULT_IOBLOCK_TIMEOUT 10000 /* 10 second in ms */
 #define SLAPD_DEFAULT_IOBLOCK_TIMEOUT_STR "10000"
+#define SLAPD_DEFAULT_SEARCH_OUTPUT_BUFFER_SIZE 65536 /* bytes, 0 writes every result PDU at once */
+#define SLAPD_DEFAULT_SEARCH_OUTPUT_BUFFER_SIZE_STR "65536"
+#define SLAPD_DEFAULT_SEARCH_OUTPUT_BUFFER_DELAY 50 /* ms */
+#define SLAPD_DEFAULT_SEARCH_OUTPUT_BUFFER_DELAY_STR "50"
+#define SLAPD_DEFAULT_PWD_CRYPTO_THREADS -1 /* from nsslapd-threadnumber, 0 compares on the worker threads */
+#define SLAPD_DEFAULT_PWD_CRYPTO_THREADS_STR "-1"
+#define SLAPD_DEFAULT_PWD_CRYPTO_QUEUE_SIZE -1 /* from nsslapd-threadnumber */
+#define SLAPD_DEFAULT_PWD_CRYPTO_QUEUE_SIZE_STR "-1"
+#define SLAPD_DEFAULT_PWD_CRYPTO_QUEUE_TIMEOUT 5000 /* ms, 0 waits forever */
+#define SLAPD_DEFAULT_PWD_CRYPTO_QUEUE_TIMEOUT_STR "5000"
+#define SLAPD_DEFAULT_PWD_VERIFY_CACHE_TTL 0 /* seconds, 0 disables the cache */
+#define SLAPD_DEFAULT_PWD_VERIFY_CACHE_TTL_STR "0"
+#define SLAPD_DEFAULT_DSE_JOURNAL_SIZE 256 /* changes, 0 rewrites dse.ldif on every change */
+#define SLAPD_DEFAULT_DSE_JOURNAL_SIZE_STR "256"
+#define SLAPD_DEFAULT_METRICS_PORT 0 /* no metrics exporter */
+#define SLAPD_DEFAULT_METRICS_PORT_STR "0"
+#define SLAPD_DEFAULT_METRICS_LISTENHOST "127.0.0.1"
 #define SLAPD_DEFAULT_OUTBOUND_LDAP_IO_TIMEOUT 300000 /* 5 minutes in ms */
 #define SLAPD_DEFAULT_OUTBOUND_LDAP_IO_TIMEOUT_STR "300000"
 #define SLAPD_DEFAULT_RESERVE_FDS 64
@@ -432,6 +449,7 @@ typedef void (*VFPV)(); /* takes undefined arguments */
 #define DSE_TMPFILE "dse.ldif.tmp"
 #define DSE_BACKFILE "dse.ldif.bak"
 #define DSE_STARTOKFILE "dse.ldif.startOK"
+#define DSE_JOURNALFILE "dse.ldif.journal"
 #define DSE_LDBM_FILENAME "ldbm.ldif"
 #define DSE_LDBM_TMPFILE "ldbm.ldif.tmp"
 /* for now, we are using the dse file for the base config file */
@@ -811,6 +829,8 @@ struct slapi_entry
     void *e_extension;            /* A list of entry object extensions */
     unsigned char e_flags;
     Slapi_Attr *e_aux_attrs; /* Attr list used for upgrade */
+    struct slapi_entry_encoding *e_encoding; /* cached encoding of the user attributes,
+                                                protected by e_virtual_lock */
 };
 
 struct attrs_in_extension
@@ -972,6 +992,9 @@ struct pluginconfig
     PRBool plgc_invoke_for_replop;                  /* indicates that plugin should be invoked for internal operations */
 };
 
+/* latency histogram, see histogram.c */
+typedef struct slapi_histogram Slapi_Histogram;
+
 struct slapdplugin
 {
     void *plg_private;                      /* data private to plugin */
@@ -999,6 +1022,7 @@ struct slapdplugin
     PRUint64 plg_started;                   /* plugin is started/running */
     PRUint64 plg_stopped;                   /* plugin has been fully shutdown */
     Slapi_Counter *plg_op_counter;          /* operation counter, used for shutdown */
+    Slapi_Histogram *plg_latency;           /* time spent in the operation callbacks */
 
     /* NOTE: These LDIF2DB and DB2LDIF fn pointers are internal only for now.
    I don't believe you can get these functions from a plug-in and
@@ -1468,6 +1492,7 @@ typedef struct backend
     void *vlvSearchList;
     Slapi_Counter *be_usn_counter; /* USN counter; one counter per backend */
     int be_pagedsizelimit;         /* size limit for this backend for simple paged result searches */
+    Slapi_Histogram *be_latency;   /* latency of the operations sent to this backend */
 } backend;
 
 enum
@@ -1538,6 +1563,42 @@ typedef struct slapi_operation_results
     } r;
 } slapi_operation_results;
 
+/*
+ * Execution profile of a search, collected when the access log level
+ * includes LDAP_DEBUG_PROFILE (536870912) and logged after the RESULT line.
+ * Times are in microseconds. The filter test and encoding times do not
+ * include the access control time spent in them.
+ */
+#define OP_PROFILE_MAX_LOOKUPS 16
+#define OP_PROFILE_FILTER_LEN  128
+
+typedef struct op_profile_lookup
+{
+    char opl_filter[OP_PROFILE_FILTER_LEN]; /* filter component, truncated */
+    uint64_t opl_nids;                      /* ids returned, 0 for allids */
+    uint64_t opl_usec;                      /* time spent reading the index */
+    int opl_allids;
+} Op_Profile_Lookup;
+
+typedef struct op_profile
+{
+    Op_Profile_Lookup opp_lookups[OP_PROFILE_MAX_LOOKUPS];
+    uint32_t opp_nlookups;      /* may exceed OP_PROFILE_MAX_LOOKUPS */
+    uint64_t opp_lookup_usec;
+    uint64_t opp_intersect_in;  /* ids fed to the AND intersections */
+    uint64_t opp_intersect_out; /* ids left by the AND intersections */
+    uint64_t opp_candidates;    /* size of the final candidate list */
+    int opp_candidates_allids;
+    uint64_t opp_cache_hits;    /* candidates found in the entry cache */
+    uint64_t opp_cache_misses;  /* candidates read from id2entry */
+    uint64_t opp_filter_usec;
+    uint64_t opp_acl_usec;
+    uint64_t opp_encode_usec;
+} Op_Profile;
+
+/* per operation allocator, see arena.c */
+typedef struct slapi_arena Slapi_Arena;
+
 /*
  * represents an operation pending from an ldap client
  */
@@ -1581,6 +1642,13 @@ typedef struct op
     struct slapi_operation_results o_results;
     int o_pagedresults_sizelimit;
     int o_reverse_search_state;
+    Op_Profile *o_profile; /* search execution profile, NULL unless enabled */
+    Slapi_Arena *o_arena;  /* reset when the op is done, created on first use */
+    BerElement *o_sendber;          /* result PDUs queued for a single write, see flush_ber() */
+    struct timespec o_sendber_time; /* when the first queued PDU was queued */
+    uint32_t o_sendber_pdus;        /* PDUs in o_sendber */
+    uint64_t o_pdus_sent;           /* PDUs sent to the client for this operation */
+    uint64_t o_writes;              /* writes to the client socket for this operation */
 } Operation;
 
 /*
@@ -1632,6 +1700,26 @@ typedef enum _conn_state {
     CONN_STATE_INIT = 1,
 } conn_state;
 
+#define CONN_STATS_DN_LEN 256
+#define CONN_STATS_IPADDR_LEN 64
+
+/*
+ * What cn=monitor lists of a connection, readable without c_mutex. It is
+ * written under c_mutex by connection_stats_update(), which makes cs_seq odd
+ * for the duration; readers retry until they see the same even cs_seq before
+ * and after their copy. The counters of the listing are read from the
+ * connection itself with atomic loads.
+ */
+typedef struct conn_stats
+{
+    uint64_t cs_seq;
+    uint64_t cs_connid;            /* 0 when the slot is free */
+    time_t cs_starttime;
+    int32_t cs_dn_truncated;       /* c_dn did not fit in cs_dn */
+    char cs_dn[CONN_STATS_DN_LEN]; /* "" when anonymous */
+    char cs_ipaddr[CONN_STATS_IPADDR_LEN];
+} conn_stats;
+
 typedef struct conn
 {
     Sockbuf *c_sb;                   /* ber connection stuff          */
@@ -1692,6 +1780,7 @@ typedef struct conn
     struct connection_table *c_ct;   /* connection table that this connection belongs to */
     int c_ns_close_jobs;             /* number of current close jobs */
     char *c_ipaddr;                  /* ip address str - used by monitor */
+    conn_stats c_stats;              /* lock free copy of the above for cn=monitor */
     /* per conn static config */
     ber_len_t c_maxbersize;
     int32_t c_ioblocktimeout;
@@ -1912,6 +2001,14 @@ typedef struct daemon_ports_s
     PRFileDesc **i_socket;
 #endif
     PRFileDesc **s_socket;
+    /* metrics exporter, served outside of the connection table */
+    int m_port;
+    PRNetAddr **m_listenaddr;
+    PRFileDesc **m_socket;
+#if defined(ENABLE_LDAPI)
+    PRNetAddr **m_local_listenaddr;
+    PRFileDesc **m_local_socket;
+#endif
 } daemon_ports_t;
 
 
@@ -2249,6 +2346,17 @@ typedef struct _slapdEntryPoints
 #define CONFIG_NDN_CACHE_SIZE "nsslapd-ndn-cache-max-size"
 #define CONFIG_ALLOWED_SASL_MECHS "nsslapd-allowed-sasl-mechanisms"
 #define CONFIG_IGNORE_VATTRS "nsslapd-ignore-virtual-attrs"
+#define CONFIG_SEARCH_ENTRY_ENCODING_CACHE "nsslapd-search-entry-encoding-cache"
+#define CONFIG_SEARCH_OUTPUT_BUFFER_SIZE "nsslapd-search-output-buffer-size"
+#define CONFIG_SEARCH_OUTPUT_BUFFER_DELAY "nsslapd-search-output-buffer-delay"
+#define CONFIG_PWD_CRYPTO_THREADS "nsslapd-pwd-crypto-threads"
+#define CONFIG_PWD_CRYPTO_QUEUE_SIZE "nsslapd-pwd-crypto-queue-size"
+#define CONFIG_PWD_CRYPTO_QUEUE_TIMEOUT "nsslapd-pwd-crypto-queue-timeout"
+#define CONFIG_PWD_VERIFY_CACHE_TTL "nsslapd-pwd-verify-cache-ttl"
+#define CONFIG_DSE_JOURNAL_SIZE "nsslapd-dse-journal-size"
+#define CONFIG_METRICS_PORT "nsslapd-metrics-port"
+#define CONFIG_METRICS_LISTENHOST "nsslapd-metrics-listenhost"
+#define CONFIG_METRICS_SOCKET "nsslapd-metrics-socket"
 #define CONFIG_SASL_MAPPING_FALLBACK "nsslapd-sasl-mapping-fallback"
 #define CONFIG_SASL_MAXBUFSIZE "nsslapd-sasl-max-buffer-size"
 #define CONFIG_SEARCH_RETURN_ORIGINAL_TYPE "nsslapd-search-return-original-type-switch"
@@ -2544,6 +2652,17 @@ typedef struct _slapdFrontendConfig
     slapi_onoff_t return_orig_type; /* if on, search returns original type set in attr list */
     slapi_onoff_t sasl_mapping_fallback;
     slapi_onoff_t ignore_vattrs;
+    slapi_onoff_t search_entry_encoding_cache;
+    slapi_int_t search_output_buffer_size;  /* bytes of search results queued before a write */
+    slapi_int_t search_output_buffer_delay; /* ms search results may stay queued */
+    slapi_int_t pwd_crypto_threads;         /* password compare threads, read at startup */
+    slapi_int_t pwd_crypto_queue_size;      /* binds waiting for a compare thread */
+    slapi_int_t pwd_crypto_queue_timeout;   /* ms a bind may wait for a compare thread */
+    slapi_int_t pwd_verify_cache_ttl;       /* seconds a verified bind password is remembered */
+    slapi_int_t dse_journal_size;           /* changes journaled before dse.ldif is rewritten */
+    slapi_int_t metrics_port;               /* metrics exporter port, read at startup */
+    char *metrics_listenhost;               /* metrics exporter address, read at startup */
+    char *metrics_socket;                   /* metrics exporter unix socket, read at startup */
     slapi_onoff_t unhashed_pw_switch; /* switch to on/off/nolog unhashed pw */
     slapi_onoff_t enable_turbo_mode;
     slapi_int_t connection_buffer;    /* values are CONNECTION_BUFFER_* below */
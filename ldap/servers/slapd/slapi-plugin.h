@@ -5170,6 +5170,50 @@ char *slapi_op_type_to_string(unsigned long type);
 int slapi_op_internal(Slapi_PBlock *pb);
 Slapi_Operation *slapi_operation_new(int flags);
 
+/**
+ * Allocates memory that is released when the operation is done.
+ *
+ * The memory must not be freed with slapi_ch_free() or kept past the
+ * operation, for example in a cache or in the result entries of a persistent
+ * search. It is meant for the temporary allocations of a plugin while it
+ * processes the operation, which then cost a pointer increment instead of a
+ * malloc() and a free().
+ *
+ * \param op The operation the memory belongs to.
+ * \param size Number of bytes, the memory is aligned for any type.
+ * \return Pointer to the memory, never \c NULL.
+ * \see slapi_operation_arena_calloc()
+ * \see slapi_operation_arena_strdup()
+ * \see slapi_operation_arena_smprintf()
+ */
+void *slapi_operation_arena_alloc(Slapi_Operation *op, size_t size);
+
+/**
+ * Like slapi_operation_arena_alloc(), for \c nelem zeroed elements of
+ * \c size bytes.
+ */
+void *slapi_operation_arena_calloc(Slapi_Operation *op, size_t nelem, size_t size);
+
+/**
+ * Copies a string into memory released when the operation is done.
+ *
+ * \return The copy, or \c NULL if \c s is \c NULL.
+ * \see slapi_operation_arena_alloc()
+ */
+char *slapi_operation_arena_strdup(Slapi_Operation *op, const char *s);
+
+/**
+ * slapi_ch_smprintf() into memory released when the operation is done.
+ *
+ * \see slapi_operation_arena_alloc()
+ */
+char *slapi_operation_arena_smprintf(Slapi_Operation *op, const char *fmt, ...)
+#ifdef __GNUC__
+    __attribute__((format(printf, 2, 3)));
+#else
+    ;
+#endif
+
 /*
  * connection routines
  */
@@ -5264,6 +5308,7 @@ int slapi_vattr_filter_test_ext(Slapi_PBlock *pb, Slapi_Entry *e, Slapi_Filter *
 int slapi_filter_compare(struct slapi_filter *f1, struct slapi_filter *f2);
 Slapi_Filter *slapi_filter_dup(Slapi_Filter *f);
 int slapi_filter_changetype(Slapi_Filter *f, const char *newtype);
+int slapi_filter_narrow(Slapi_Filter *f, Slapi_Filter *narrow);
 
 int slapi_attr_is_last_mod(char *attr);
 
@@ -6703,6 +6748,7 @@ void slapi_destroy_task(void *arg);
 
 /* Slapi_Counter Interface */
 Slapi_Counter *slapi_counter_new(void);
+Slapi_Counter *slapi_counter_new_sharded(void);
 void slapi_counter_init(Slapi_Counter *counter);
 void slapi_counter_destroy(Slapi_Counter **counter);
 uint64_t slapi_counter_increment(Slapi_Counter *counter);
@@ -7281,6 +7327,7 @@ typedef enum _slapi_op_note_t {
     SLAPI_OP_NOTE_SIMPLEPAGED = 0x02,
     SLAPI_OP_NOTE_FULL_UNINDEXED = 0x04,
     SLAPI_OP_NOTE_FILTER_INVALID = 0x08,
+    SLAPI_OP_NOTE_INDEX_SKIPPED = 0x10,
 } slapi_op_note_t;
 
 
@@ -7761,6 +7808,8 @@ int slapi_back_set_info(Slapi_Backend *be, int cmd, void *info);
  * BACK_INFO_CRYPT_DESTROY - Free allocated during init data (info: back_info_crypt_destroy)
  * BACK_INFO_CRYPT_ENCRYPT_VALUE - Encrypt the given value (info: back_info_crypt_value)
  * BACK_INFO_CRYPT_DECRYPT_VALUE - Decrypt the given value (info: back_info_crypt_value)
+ * BACK_INFO_METRICS - Get the cache statistics of the backend (info: back_info_metrics)
+ * BACK_INFO_DBENV_METRICS - Get the statistics of the database environment (info: back_info_dbenv_metrics)
  */
 int slapi_back_ctrl_info(Slapi_Backend *be, int cmd, void *info);
 
@@ -7788,7 +7837,9 @@ enum
     BACK_INFO_DB_DIRECTORY,        /* Get the db directory */
     BACK_INFO_DBHOME_DIRECTORY,    /* Get the dbhome directory */
     BACK_INFO_IS_ENTRYRDN,         /* Get the flag for entryrdn */
-    BACK_INFO_CLDB_FILENAME        /* Get the backend replication changelog name */
+    BACK_INFO_CLDB_FILENAME,       /* Get the backend replication changelog name */
+    BACK_INFO_METRICS,             /* Ctrl: entry and dn cache statistics */
+    BACK_INFO_DBENV_METRICS        /* Ctrl: database environment statistics */
 };
 
 struct _back_info_index_key
@@ -7828,6 +7879,38 @@ struct _back_info_config_entry
 };
 typedef struct _back_info_config_entry back_info_config_entry;
 
+struct _back_info_cache_metrics
+{
+    uint64_t hits;       /* output */
+    uint64_t tries;      /* output */
+    uint64_t count;      /* output -- entries in the cache */
+    int64_t maxcount;    /* output -- -1 if unlimited */
+    uint64_t size;       /* output -- bytes */
+    uint64_t maxsize;    /* output -- bytes */
+};
+typedef struct _back_info_cache_metrics back_info_cache_metrics;
+
+struct _back_info_metrics
+{
+    back_info_cache_metrics entry_cache; /* output */
+    back_info_cache_metrics dn_cache;    /* output */
+    PRBool has_dn_cache;                 /* output -- FALSE if dn_cache is not set */
+};
+typedef struct _back_info_metrics back_info_metrics;
+
+struct _back_info_dbenv_metrics
+{
+    uint64_t cache_hits;     /* output -- pages found in the database cache */
+    uint64_t cache_misses;   /* output */
+    uint64_t pages;          /* output -- pages in the cache */
+    uint64_t pages_dirty;    /* output */
+    uint64_t page_in;        /* output -- pages read into the cache */
+    uint64_t page_out;       /* output -- pages written from the cache */
+    uint64_t ro_evict;       /* output -- clean pages evicted */
+    uint64_t rw_evict;       /* output -- dirty pages evicted */
+};
+typedef struct _back_info_dbenv_metrics back_info_dbenv_metrics;
+
 #define BACK_CRYPT_OUTBUFF_EXTLEN 16
 
 /**
@@ -59,9 +59,11 @@ typedef enum _slapi_filter_flags_t {
     SLAPI_FILTER_NORMALIZED_VALUE = 16,
     SLAPI_FILTER_INVALID_ATTR_UNDEFINE = 32,
     SLAPI_FILTER_INVALID_ATTR_WARN = 64,
+    SLAPI_FILTER_NARROW = 128, /* only selects candidates, see slapi_filter_narrow() */
 } slapi_filter_flags;
 
 #define SLAPI_ENTRY_LDAPSUBENTRY 2
+#define SLAPI_ENTRY_CACHE_ENCODING 4 /* entry is shared through a backend entry cache and may keep its encoding */
 
 
 /*
@@ -439,6 +441,8 @@ char *slapi_filter_to_string_internal(const struct slapi_filter *f, char *buf, s
 #define OP_FLAG_ACTION_SKIP_PWDPOLICY 0x02000000 /* Skip applying pw policy rules to the password
                                                   * change operation, as it's from an upgrade on
                                                   * bind rather than a normal password change */
+#define OP_FLAG_QUEUE_RESULTS 0x04000000         /* the search is iterating on the backend: its
+                                                  * entries may be queued, see flush_ber() */
 
 /* reverse search states */
 #define REV_STARTED 1
@@ -449,6 +453,7 @@ void operation_set_csn(Slapi_Operation *op, CSN *csn);
 void operation_set_flag(Slapi_Operation *op, int flag);
 void operation_clear_flag(Slapi_Operation *op, int flag);
 int operation_is_flag_set(Slapi_Operation *op, int flag);
+void slapi_op_flush_queued_results(Slapi_PBlock *pb);
 unsigned long operation_get_type(Slapi_Operation *op);
 LDAPMod **copy_mods(LDAPMod **orig_mods);
 
@@ -524,6 +529,8 @@ int vattr_test_filter(Slapi_PBlock *pb,
                       Slapi_Filter *f,
                       filter_type_t filter_type,
                       char *type);
+int vattr_type_is_virtual(Slapi_Backend *be, const char *type);
+Slapi_ValueSet *vattr_typethang_get_values(vattr_type_thang *t);
 
 /* filter routines */
 
@@ -531,6 +538,18 @@ int test_substring_filter(Slapi_PBlock *pb, Slapi_Entry *e, struct slapi_filter
 int test_ava_filter(Slapi_PBlock *pb, Slapi_Entry *e, Slapi_Attr *a, struct ava *ava, int ftype, int verify_access, int only_check_access, int *access_check_done);
 int test_presence_filter(Slapi_PBlock *pb, Slapi_Entry *e, char *type, int verify_access, int only_check_access, int *access_check_done);
 
+/*
+ * A filter program is a search filter flattened into an array of nodes, with
+ * the attribute types, matching functions and virtual attribute lookups
+ * resolved once so that it can be evaluated cheaply against many entries.
+ * The program references the filter it was compiled from, which must stay
+ * alive (and unchanged) until the program is freed.
+ */
+typedef struct slapi_filter_program Slapi_FilterProgram;
+Slapi_FilterProgram *slapi_filter_compile(Slapi_Filter *f, Slapi_Backend *be);
+void slapi_filter_program_free(Slapi_FilterProgram **prog);
+int slapi_vattr_filter_test_program(Slapi_PBlock *pb, Slapi_Entry *e, Slapi_FilterProgram *prog, int verify_access, int only_check_access);
+
 /* this structure allows to address entry by dn or uniqueid */
 typedef struct entry_address
 {
@@ -815,6 +834,11 @@ void task_cleanup(void);
 #define SLAPI_MB_CREDENTIALS "nsmultiplexorcredentials"
 #define SLAPI_REP_CREDENTIALS "nsds5ReplicaCredentials"
 int pw_rever_encode(Slapi_Value **vals, char *attr_name);
+#define PW_CRYPTO_BUSY -1
+int pw_crypto_find_sv(Slapi_Value **vals, const Slapi_Value *cred);
+int pw_verify_cache_check(const char *ndn, Slapi_Value **vals, const Slapi_Value *cred);
+void pw_verify_cache_add(const char *ndn, Slapi_Value **vals, const Slapi_Value *cred);
+void pw_verify_cache_invalidate(const char *ndn);
 int pw_rever_decode(char *cipher, char **plain, const char *attr_name);
 
 int32_t update_pw_encoding(Slapi_PBlock *orig_pb, Slapi_Entry *e, Slapi_DN *sdn, char *cleartextpassword);
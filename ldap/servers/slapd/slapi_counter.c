@@ -25,17 +25,40 @@
 #include <machine/sys/inline.h>
 #endif
 
+/*
+ * Sharded counters spread their adds over SLAPI_COUNTER_SHARDS values, one
+ * cache line apart, so that threads bumping the same counter do not bounce
+ * that line between their cpus. Each thread always uses the same shard.
+ */
+#define SLAPI_COUNTER_SHARDS 64
+#define SLAPI_COUNTER_SHARD_STRIDE (64 / sizeof(uint64_t)) /* one cache line */
+
 /*
  * Counter Structure
  */
 typedef struct slapi_counter
 {
     uint64_t value;
+    uint64_t *shards; /* sharded counters only */
 #ifndef ATOMIC_64BIT_OPERATIONS
     pthread_mutex_t _lock;
 #endif
 } slapi_counter;
 
+#ifdef ATOMIC_64BIT_OPERATIONS
+static uint32_t counter_next_shard;
+static __thread uint32_t counter_shard = SLAPI_COUNTER_SHARDS;
+
+static uint64_t *
+counter_get_shard(Slapi_Counter *counter)
+{
+    if (counter_shard == SLAPI_COUNTER_SHARDS) {
+        counter_shard = __atomic_fetch_add(&counter_next_shard, 1, __ATOMIC_RELAXED) % SLAPI_COUNTER_SHARDS;
+    }
+    return &counter->shards[counter_shard * SLAPI_COUNTER_SHARD_STRIDE];
+}
+#endif
+
 /*
  * slapi_counter_new()
  *
@@ -55,6 +78,28 @@ slapi_counter_new()
     return counter;
 }
 
+/*
+ * slapi_counter_new_sharded()
+ *
+ * Allocates and initializes a new Slapi_Counter for statistics that many
+ * threads update and few read. Adds are cheaper than with a plain counter
+ * under contention, reads sum all the shards. The add, subtract and
+ * increment functions return 0 for such counters, the total is only known
+ * to slapi_counter_get_value(). Without 64 bit atomics this is a plain
+ * counter.
+ */
+Slapi_Counter *
+slapi_counter_new_sharded()
+{
+    Slapi_Counter *counter = slapi_counter_new();
+
+#ifdef ATOMIC_64BIT_OPERATIONS
+    counter->shards = (uint64_t *)slapi_ch_calloc(SLAPI_COUNTER_SHARDS * SLAPI_COUNTER_SHARD_STRIDE, sizeof(uint64_t));
+#endif
+
+    return counter;
+}
+
 /*
  * slapi_counter_init()
  *
@@ -85,6 +130,7 @@ slapi_counter_destroy(Slapi_Counter **counter)
 #ifndef ATOMIC_64BIT_OPERATIONS
         pthread_mutex_destroy(&((*counter)->_lock));
 #endif
+        slapi_ch_free((void **)&((*counter)->shards));
         slapi_ch_free((void **)counter);
     }
 }
@@ -127,6 +173,10 @@ slapi_counter_add(Slapi_Counter *counter, uint64_t addvalue)
         return newvalue;
     }
 #ifdef ATOMIC_64BIT_OPERATIONS
+    if (counter->shards) {
+        __atomic_add_fetch_8(counter_get_shard(counter), addvalue, __ATOMIC_RELAXED);
+        return newvalue;
+    }
     newvalue = __atomic_add_fetch_8(&(counter->value), addvalue, __ATOMIC_RELAXED);
 #else
 #ifdef HPUX
@@ -181,6 +231,10 @@ slapi_counter_subtract(Slapi_Counter *counter, uint64_t subvalue)
     }
 
 #ifdef ATOMIC_64BIT_OPERATIONS
+    if (counter->shards) {
+        __atomic_sub_fetch_8(counter_get_shard(counter), subvalue, __ATOMIC_RELAXED);
+        return newvalue;
+    }
     newvalue = __atomic_sub_fetch_8(&(counter->value), subvalue, __ATOMIC_RELAXED);
 #else
 #ifdef HPUX
@@ -222,7 +276,8 @@ slapi_counter_subtract(Slapi_Counter *counter, uint64_t subvalue)
 /*
  * slapi_counter_set_value()
  *
- * Atomically sets the value of a Slapi_Counter.
+ * Atomically sets the value of a Slapi_Counter. For sharded counters adds
+ * that run at the same time may or may not be lost.
  */
 uint64_t
 slapi_counter_set_value(Slapi_Counter *counter, uint64_t newvalue)
@@ -234,6 +289,11 @@ slapi_counter_set_value(Slapi_Counter *counter, uint64_t newvalue)
     }
 
 #ifdef ATOMIC_64BIT_OPERATIONS
+    if (counter->shards) {
+        for (size_t i = 0; i < SLAPI_COUNTER_SHARDS; i++) {
+            __atomic_store_8(&counter->shards[i * SLAPI_COUNTER_SHARD_STRIDE], 0, __ATOMIC_RELAXED);
+        }
+    }
     __atomic_store_8(&(counter->value), newvalue, __ATOMIC_RELAXED);
 #else /* HPUX */
 #ifdef HPUX
@@ -267,6 +327,11 @@ slapi_counter_get_value(Slapi_Counter *counter)
 
 #ifdef ATOMIC_64BIT_OPERATIONS
     value = __atomic_load_8(&(counter->value), __ATOMIC_RELAXED);
+    if (counter->shards) {
+        for (size_t i = 0; i < SLAPI_COUNTER_SHARDS; i++) {
+            value += __atomic_load_8(&counter->shards[i * SLAPI_COUNTER_SHARD_STRIDE], __ATOMIC_RELAXED);
+        }
+    }
 #else /* HPUX */
 #ifdef HPUX
     do {
@@ -93,34 +93,35 @@ snmp_collator_init(void)
     int i;
 
     /*
-     * Create the global SNMP counters
+     * Create the global SNMP counters. The ones bumped by every operation
+     * are sharded, the workers would otherwise contend on them.
      */
-    g_get_global_snmp_vars()->ops_tbl.dsAnonymousBinds = slapi_counter_new();
-    g_get_global_snmp_vars()->ops_tbl.dsUnAuthBinds = slapi_counter_new();
-    g_get_global_snmp_vars()->ops_tbl.dsSimpleAuthBinds = slapi_counter_new();
-    g_get_global_snmp_vars()->ops_tbl.dsStrongAuthBinds = slapi_counter_new();
-    g_get_global_snmp_vars()->ops_tbl.dsBindSecurityErrors = slapi_counter_new();
-    g_get_global_snmp_vars()->ops_tbl.dsInOps = slapi_counter_new();
-    g_get_global_snmp_vars()->ops_tbl.dsReadOps = slapi_counter_new();
-    g_get_global_snmp_vars()->ops_tbl.dsCompareOps = slapi_counter_new();
-    g_get_global_snmp_vars()->ops_tbl.dsAddEntryOps = slapi_counter_new();
-    g_get_global_snmp_vars()->ops_tbl.dsRemoveEntryOps = slapi_counter_new();
-    g_get_global_snmp_vars()->ops_tbl.dsModifyEntryOps = slapi_counter_new();
-    g_get_global_snmp_vars()->ops_tbl.dsModifyRDNOps = slapi_counter_new();
-    g_get_global_snmp_vars()->ops_tbl.dsListOps = slapi_counter_new();
-    g_get_global_snmp_vars()->ops_tbl.dsSearchOps = slapi_counter_new();
-    g_get_global_snmp_vars()->ops_tbl.dsOneLevelSearchOps = slapi_counter_new();
-    g_get_global_snmp_vars()->ops_tbl.dsWholeSubtreeSearchOps = slapi_counter_new();
-    g_get_global_snmp_vars()->ops_tbl.dsReferrals = slapi_counter_new();
-    g_get_global_snmp_vars()->ops_tbl.dsChainings = slapi_counter_new();
-    g_get_global_snmp_vars()->ops_tbl.dsSecurityErrors = slapi_counter_new();
-    g_get_global_snmp_vars()->ops_tbl.dsErrors = slapi_counter_new();
+    g_get_global_snmp_vars()->ops_tbl.dsAnonymousBinds = slapi_counter_new_sharded();
+    g_get_global_snmp_vars()->ops_tbl.dsUnAuthBinds = slapi_counter_new_sharded();
+    g_get_global_snmp_vars()->ops_tbl.dsSimpleAuthBinds = slapi_counter_new_sharded();
+    g_get_global_snmp_vars()->ops_tbl.dsStrongAuthBinds = slapi_counter_new_sharded();
+    g_get_global_snmp_vars()->ops_tbl.dsBindSecurityErrors = slapi_counter_new_sharded();
+    g_get_global_snmp_vars()->ops_tbl.dsInOps = slapi_counter_new_sharded();
+    g_get_global_snmp_vars()->ops_tbl.dsReadOps = slapi_counter_new_sharded();
+    g_get_global_snmp_vars()->ops_tbl.dsCompareOps = slapi_counter_new_sharded();
+    g_get_global_snmp_vars()->ops_tbl.dsAddEntryOps = slapi_counter_new_sharded();
+    g_get_global_snmp_vars()->ops_tbl.dsRemoveEntryOps = slapi_counter_new_sharded();
+    g_get_global_snmp_vars()->ops_tbl.dsModifyEntryOps = slapi_counter_new_sharded();
+    g_get_global_snmp_vars()->ops_tbl.dsModifyRDNOps = slapi_counter_new_sharded();
+    g_get_global_snmp_vars()->ops_tbl.dsListOps = slapi_counter_new_sharded();
+    g_get_global_snmp_vars()->ops_tbl.dsSearchOps = slapi_counter_new_sharded();
+    g_get_global_snmp_vars()->ops_tbl.dsOneLevelSearchOps = slapi_counter_new_sharded();
+    g_get_global_snmp_vars()->ops_tbl.dsWholeSubtreeSearchOps = slapi_counter_new_sharded();
+    g_get_global_snmp_vars()->ops_tbl.dsReferrals = slapi_counter_new_sharded();
+    g_get_global_snmp_vars()->ops_tbl.dsChainings = slapi_counter_new_sharded();
+    g_get_global_snmp_vars()->ops_tbl.dsSecurityErrors = slapi_counter_new_sharded();
+    g_get_global_snmp_vars()->ops_tbl.dsErrors = slapi_counter_new_sharded();
     g_get_global_snmp_vars()->ops_tbl.dsConnections = slapi_counter_new();
     g_get_global_snmp_vars()->ops_tbl.dsConnectionSeq = slapi_counter_new();
-    g_get_global_snmp_vars()->ops_tbl.dsBytesRecv = slapi_counter_new();
-    g_get_global_snmp_vars()->ops_tbl.dsBytesSent = slapi_counter_new();
-    g_get_global_snmp_vars()->ops_tbl.dsEntriesReturned = slapi_counter_new();
-    g_get_global_snmp_vars()->ops_tbl.dsReferralsReturned = slapi_counter_new();
+    g_get_global_snmp_vars()->ops_tbl.dsBytesRecv = slapi_counter_new_sharded();
+    g_get_global_snmp_vars()->ops_tbl.dsBytesSent = slapi_counter_new_sharded();
+    g_get_global_snmp_vars()->ops_tbl.dsEntriesReturned = slapi_counter_new_sharded();
+    g_get_global_snmp_vars()->ops_tbl.dsReferralsReturned = slapi_counter_new_sharded();
     g_get_global_snmp_vars()->ops_tbl.dsConnectionsInMaxThreads = slapi_counter_new();
     g_get_global_snmp_vars()->ops_tbl.dsMaxThreadsHits = slapi_counter_new();
     g_get_global_snmp_vars()->entries_tbl.dsMasterEntries = slapi_counter_new();
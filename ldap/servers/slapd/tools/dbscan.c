@@ -342,6 +342,89 @@ print_attr(char *attrname, char **buff)
     }
 }
 
+/*** Copied from cl5_api.c: s_cl5AttrDict ***/
+/* Attribute types written as a one byte index in V6 records. This table
+   must be kept identical to the one of the server. */
+static const char *cl5_attr_dict[] = {
+    NULL,
+    "objectclass",
+    "objectClass",
+    "modifiersname",
+    "modifytimestamp",
+    "internalModifiersName",
+    "internalModifiersname",
+    "internalmodifiersname",
+    "internalModifyTimestamp",
+    "internalmodifytimestamp",
+    "creatorsname",
+    "createtimestamp",
+    "internalCreatorsName",
+    "internalCreatorsname",
+    "nsuniqueid",
+    "unhashed#user#password",
+    "userPassword",
+    "userpassword",
+    "cn",
+    "sn",
+    "uid",
+    "givenName",
+    "mail",
+    "description",
+    "member",
+    "uniqueMember",
+    "memberOf",
+    "telephoneNumber",
+    "passwordRetryCount",
+    "retryCountResetTime",
+    "accountUnlockTime",
+    "passwordExpirationTime",
+    "passwordHistory",
+    "passwordAllowChangeTime",
+    "pwdUpdateTime",
+    "lastLoginTime",
+    "nsAccountLock",
+    "nsds5ReplConflict",
+};
+#define CL5_ATTR_DICT_SIZE (sizeof(cl5_attr_dict) / sizeof(cl5_attr_dict[0]))
+#define CL5_ATTR_DICT_MAX '0'
+#define CL5_VARINT_MAXLEN 5
+
+/*** Copied from cl5_api.c: _cl5ReadVarint ***/
+static uint32_t
+_cl5ReadVarint(char **buff)
+{
+    unsigned char *pos = (unsigned char *)*buff;
+    uint32_t value = 0;
+    int shift;
+
+    for (shift = 0; shift < 7 * CL5_VARINT_MAXLEN; shift += 7) {
+        value |= (uint32_t)(*pos & 0x7f) << shift;
+        if ((*pos++ & 0x80) == 0) {
+            break;
+        }
+    }
+    (*buff) = (char *)pos;
+
+    return value;
+}
+
+/* read a 4 byte count or size (V5) or a varint (V6) */
+static uint32_t
+_cl5ReadCount(char **buff, uint8_t version)
+{
+    uint32_t count;
+
+    if (version >= 6) {
+        return _cl5ReadVarint(buff);
+    }
+    /* need to copy first, to skirt around alignment problems on certain
+       architectures */
+    memcpy((char *)&count, *buff, sizeof(count));
+    *buff += sizeof(count);
+
+    return ntohl(count);
+}
+
 /*** Copied from cl5_api.c: _cl5ReadMods ***/
 /* mods format:
    -----------
@@ -352,25 +435,23 @@ print_attr(char *attrname, char **buff)
    <1 byte modop><null terminated attr name><4 byte count>
    {<4 byte size><value1><4 byte size><value2>... ||
         <null terminated str1> <null terminated str2>...}
+
+   In V6 records, the counts and sizes are varints and the attr name may be
+   a one byte index in cl5_attr_dict.
  */
-void _cl5ReadMod(char **buff);
+void _cl5ReadMod(char **buff, uint8_t version);
 
 void
-_cl5ReadMods(char **buff)
+_cl5ReadMods(char **buff, uint8_t version)
 {
     char *pos = *buff;
     ID i;
     uint32_t mod_count;
 
-    /* need to copy first, to skirt around alignment problems on certain
-       architectures */
-    memcpy((char *)&mod_count, *buff, sizeof(mod_count));
-    mod_count = ntohl(mod_count);
-    pos += sizeof(mod_count);
-
+    mod_count = _cl5ReadCount(&pos, version);
 
     for (i = 0; i < mod_count; i++) {
-        _cl5ReadMod(&pos);
+        _cl5ReadMod(&pos, version);
     }
 
     *buff = pos;
@@ -381,14 +462,12 @@ _cl5ReadMods(char **buff)
                      in ber format, length followed by string.
 */
 void
-print_ber_attr(char *attrname, char **buff)
+print_ber_attr(char *attrname, char **buff, uint8_t version)
 {
     char *val = NULL;
     uint32_t bv_len;
 
-    memcpy((char *)&bv_len, *buff, sizeof(bv_len));
-    bv_len = ntohl(bv_len);
-    *buff += sizeof(uint32);
+    bv_len = _cl5ReadCount(buff, version);
     if (bv_len > 0) {
 
         db_printf("\t\t");
@@ -444,24 +523,29 @@ sizeushort_stored_to_internal(char *b)
 }
 
 void
-_cl5ReadMod(char **buff)
+_cl5ReadMod(char **buff, uint8_t version)
 {
     char *pos = *buff;
     uint32_t i;
     uint32_t val_count;
+    uint8_t index;
     char *type = NULL;
 
     pos++;
-    _cl5ReadString(&type, &pos);
+    index = *(uint8_t *)pos;
+    if (version >= 6 && index != 0 && index < CL5_ATTR_DICT_MAX) {
+        if (index < CL5_ATTR_DICT_SIZE) {
+            type = strdup(cl5_attr_dict[index]);
+        }
+        pos++;
+    } else {
+        _cl5ReadString(&type, &pos);
+    }
 
-    /* need to do the copy first, to skirt around alignment problems on
-       certain architectures */
-    memcpy((char *)&val_count, pos, sizeof(val_count));
-    val_count = ntohl(val_count);
-    pos += sizeof(uint32_t);
+    val_count = _cl5ReadCount(&pos, version);
 
     for (i = 0; i < val_count; i++) {
-        print_ber_attr(type, &pos);
+        print_ber_attr(type, &pos, version);
     }
 
     (*buff) = pos;
@@ -483,7 +567,7 @@ print_ruv(unsigned char *buff)
     pos += sizeof(uint32_t);
 
     for (i = 0; i < val_count; i++) {
-        print_ber_attr(NULL, &pos);
+        print_ber_attr(NULL, &pos, 5);
     }
 }
 
@@ -502,6 +586,9 @@ width of long (32-bit or 64-bit), it's stored using 4bytes by the server [153306
    -----------
    <0 byte modop><null terminated attr name><4 byte value count>
    <4 byte value size><value1><4 byte value size><value2>
+
+   V6 records have a 1 byte flags field after the time, and use the V6 mods
+   format described with _cl5ReadMods.
 */
 void
 print_changelog(unsigned char *data, int len __attribute__((unused)))
@@ -515,8 +602,8 @@ print_changelog(unsigned char *data, int len __attribute__((unused)))
 
     /* read byte of version */
     version = *((uint8_t *)pos);
-    if (version != 5) {
-        db_printf("Invalid changelog db version %i\nWorks for version 5 only.\n", version);
+    if (version != 5 && version != 6) {
+        db_printf("Invalid changelog db version %i\nWorks for versions 5 and 6 only.\n", version);
         exit(1);
     }
     pos += sizeof(version);
@@ -534,6 +621,14 @@ print_changelog(unsigned char *data, int len __attribute__((unused)))
     thetime = (time_t)replgen;
     db_printf("\treplgen: %u %s", replgen, ctime((time_t *)&thetime));
 
+    if (version >= 6) {
+        /* read flags */
+        if (*pos != 0) {
+            db_printf("\tflags: 0x%x\n", *(uint8_t *)pos);
+        }
+        pos++;
+    }
+
     /* read csn */
     print_attr("csn", &pos);
     /* read UniqueID */
@@ -546,13 +641,13 @@ print_changelog(unsigned char *data, int len __attribute__((unused)))
         print_attr("dn", &pos);
         /* convert mods to entry */
         db_printf("\toperation: add\n");
-        _cl5ReadMods(&pos);
+        _cl5ReadMods(&pos, version);
         break;
 
     case SLAPI_OPERATION_MODIFY:
         print_attr("dn", &pos);
         db_printf("\toperation: modify\n");
-        _cl5ReadMods(&pos);
+        _cl5ReadMods(&pos, version);
         break;
 
     case SLAPI_OPERATION_MODRDN: {
@@ -561,7 +656,7 @@ print_changelog(unsigned char *data, int len __attribute__((unused)))
         print_attr("newrdn", &pos);
         db_printf("\tdeleteoldrdn: %d\n", (int)(*pos++));
         print_attr("newsuperior", &pos);
-        _cl5ReadMods(&pos);
+        _cl5ReadMods(&pos, version);
         break;
     }
     case SLAPI_OPERATION_DELETE:
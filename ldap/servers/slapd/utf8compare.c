@@ -32,29 +32,15 @@ typedef struct sUpperLowerTbl
 int
 slapi_has8thBit(unsigned char *s)
 {
-#if (defined(CPU_x86) || defined(CPU_x86_64))
-#define MY8THBITWIDTH 4 /* sizeof(PRUint32) */
-#define MY8THBITFILTER 0x80808080
-    unsigned char *p, *stail, *ltail;
-    PRUint32 *uip;
-    size_t len = strlen((const char *)s);
-    ltail = s + len;
-    stail = ltail - (len % MY8THBITWIDTH);
-    for (p = s; p < stail; p += MY8THBITWIDTH) {
-        uip = (PRUint32 *)p;
-        if (MY8THBITFILTER & *uip) {
+    unsigned char *p = s;
+    unsigned char *tail = s + strlen((char *)s);
+
+    for (; tail - p >= 8; p += 8) {
+        if (swar_has_nonascii(swar_load(p))) {
             return 1;
         }
     }
-#undef MY8THBITWIDTH
-#undef MY8THBITFILTER
-    for (; p < ltail; p++)
-#else
-    unsigned char *p, *tail;
-    tail = s + strlen((char *)s);
-    for (p = s; p < tail; p++)
-#endif
-    {
+    for (; p < tail; p++) {
         if (0x80 & *p) {
             return 1;
         }
@@ -2069,8 +2055,8 @@ slapi_UTF8CASECMP(char *s0, char *s1)
     return slapi_utf8casecmp((unsigned char *)s0, (unsigned char *)s1);
 }
 
-int
-slapi_utf8casecmp(unsigned char *s0, unsigned char *s1)
+static int
+utf8casecmp_tail(unsigned char *s0, unsigned char *s1)
 {
     unsigned char *d0, *d1; /* store lower-case strings */
     unsigned char *p0, *p1; /* current UTF-8 char */
@@ -2162,6 +2148,38 @@ end:
     return rval;
 }
 
+int
+slapi_utf8casecmp(unsigned char *s0, unsigned char *s1)
+{
+    size_t len, len1, off = 0;
+
+    if (s0 == NULL || s1 == NULL) {
+        return utf8casecmp_tail(s0, s1);
+    }
+
+    /*
+     * Skip the leading words that are ASCII and equal but for case, eight
+     * bytes at a time. Lower casing ASCII gives the same bytes as the UTF-8
+     * tables and keeps the characters aligned, so comparing what follows gives
+     * the same result as comparing the whole strings. At least one byte is
+     * left in both, the empty string cases of utf8casecmp_tail() do not apply.
+     */
+    len = strlen((char *)s0);
+    len1 = strlen((char *)s1);
+    if (len > len1) {
+        len = len1;
+    }
+    while (off + 8 < len) {
+        uint64_t w0 = swar_load(s0 + off);
+        uint64_t w1 = swar_load(s1 + off);
+        if (swar_has_nonascii(w0 | w1) || swar_ascii_tolower(w0) != swar_ascii_tolower(w1)) {
+            break;
+        }
+        off += 8;
+    }
+    return utf8casecmp_tail(s0 + off, s1 + off);
+}
+
 /*
  * slapi_utf8ncasecmp: case-insensitive string compare (n chars) for UTF-8
  *                    strings
@@ -102,15 +102,22 @@ int vattr_basic_sp_init();
 
 void **statechange_api;
 
+/*
+ * The map is never modified once published: adding a type builds a new
+ * snapshot and swaps the_map, so readers only need an acquire load and no
+ * lock. Snapshots, map entries and sp handles are not freed before shutdown,
+ * a reader may still be walking them. retired chains the older snapshots.
+ */
 struct _vattr_map
 {
-    Slapi_RWLock *lock;
     PLHashTable *hashtable; /* Hash table */
+    struct _vattr_map *retired;
 };
 typedef struct _vattr_map vattr_map;
 
 static vattr_map *the_map = NULL;
-static PRUintn thread_private_global_vattr_lock;
+/* serializes the writers of the map, the sp lists and the objectclass lists */
+static pthread_mutex_t vattr_map_writer_lock = PTHREAD_MUTEX_INITIALIZER;
 
 /* Housekeeping Functions, called by server startup/shutdown code */
 
@@ -125,136 +132,6 @@ vattr_init()
     vattr_basic_sp_init();
 #endif
 }
-/*
- * https://developer.mozilla.org/en-US/docs/Mozilla/Projects/NSPR/Reference/PR_NewThreadPrivateIndex
- * It is called each time:
- *  - PR_SetThreadPrivate is call with a not NULL private value
- *  - on thread exit
- */
-static void
-vattr_global_lock_free(void *ptr)
-{
-    int *nb_acquired = ptr;
-    if (nb_acquired) {
-        slapi_ch_free((void **)&nb_acquired);
-    }
-}
-/* Create a private variable for each individual thread of the current process */
-void
-vattr_global_lock_create()
-{
-    if (PR_NewThreadPrivateIndex(&thread_private_global_vattr_lock, vattr_global_lock_free) != PR_SUCCESS) {
-        slapi_log_err(SLAPI_LOG_ALERT,
-              "vattr_global_lock_create", "Failure to create global lock for virtual attribute !\n");
-        PR_ASSERT(0);
-    }
-}
-static int
-global_vattr_lock_get_acquired_count()
-{
-    int *nb_acquired;
-    nb_acquired = (int *) PR_GetThreadPrivate(thread_private_global_vattr_lock);
-    if (nb_acquired == NULL) {
-        /* if it was not initialized set it to zero */
-        nb_acquired = (int *) slapi_ch_calloc(1, sizeof(int));
-        PR_SetThreadPrivate(thread_private_global_vattr_lock, (void *) nb_acquired);
-    }
-    return *nb_acquired;
-}
-static void
-global_vattr_lock_set_acquired_count(int nb_acquired)
-{
-    int *val;
-    val = (int *) PR_GetThreadPrivate(thread_private_global_vattr_lock);
-    if (val == NULL) {
-        /* if it was not initialized set it to zero */
-        val = (int *) slapi_ch_calloc(1, sizeof(int));
-        PR_SetThreadPrivate(thread_private_global_vattr_lock, (void *) val);
-    }
-    *val = nb_acquired;
-}
-/* The map lock can be acquired recursively. So only the first rdlock
- * will acquire the lock.
- * A optimization acquires it at high level (op_shared_search), so that
- * later calls during the operation processing will just increase/decrease a counter.
- */
-void
-vattr_rdlock()
-{
-    int nb_acquire = global_vattr_lock_get_acquired_count();
-
-    if (nb_acquire == 0) {
-        /* The lock was not held just acquire it */
-        slapi_rwlock_rdlock(the_map->lock);
-    }
-    nb_acquire++;
-    global_vattr_lock_set_acquired_count(nb_acquire);
-
-}
-/* The map lock can be acquired recursively. So only the last unlock
- * will release the lock.
- * A optimization acquires it at high level (op_shared_search), so that
- * later calls during the operation processing will just increase/decrease a counter.
- */
-void
-vattr_rd_unlock()
-{
-    int nb_acquire = global_vattr_lock_get_acquired_count();
-
-    if (nb_acquire >= 1) {
-        nb_acquire--;
-        if (nb_acquire == 0) {
-            slapi_rwlock_unlock(the_map->lock);
-        }
-        global_vattr_lock_set_acquired_count(nb_acquire);
-    } else {
-        /* this is likely the consequence of lock acquire in read during an internal search
-         * but the search callback updated the map and release the readlock and acquired
-         * it in write.
-         * So after the update the lock was no longer held but when completing the internal
-         * search we release the global read lock, that now has nothing to do
-         */
-        slapi_log_err(SLAPI_LOG_DEBUG,
-          "vattr_rd_unlock", "vattr lock no longer acquired in read.\n");
-    }
-}
-
-/* The map lock is acquired in write (updating the map)
- * It exists a possibility that lock is acquired in write while it is already
- * hold in read by this thread (internal search with updating callback)
- * In such situation, the we must abandon the read global lock and acquire in write
- */
-void
-vattr_wrlock()
-{
-    int nb_read_acquire = global_vattr_lock_get_acquired_count();
-
-    if (nb_read_acquire) {
-        /* The lock was acquired in read but we need it in write
-         * release it and set the global vattr_lock counter to 0
-         */
-        slapi_rwlock_unlock(the_map->lock);
-        global_vattr_lock_set_acquired_count(0);
-    }
-    slapi_rwlock_wrlock(the_map->lock);
-}
-/* The map lock is release from a write write (updating the map)
- */
-void
-vattr_wr_unlock()
-{
-    int nb_read_acquire = global_vattr_lock_get_acquired_count();
-
-    if (nb_read_acquire) {
-        /* The lock being acquired in write, the private thread counter
-         * (that count the number of time it was acquired in read) should be 0
-         */
-        slapi_log_err(SLAPI_LOG_INFO,
-          "vattr_unlock", "The lock was acquired in write. We should not be here\n");
-        PR_ASSERT(nb_read_acquire == 0);
-    }
-    slapi_rwlock_unlock(the_map->lock);
-}
 /* Called on server shutdown, free all structures, inform service providers that we're going down etc */
 void
 vattr_cleanup()
@@ -758,6 +635,27 @@ vattr_test_filter(Slapi_PBlock *pb,
     }
     return rc;
 }
+
+/*
+ * vattr_type_is_virtual:
+ *
+ * . tells whether a service provider is registered for type in the
+ * . namespace of be, i.e. whether vattr_test_filter could consult an SP
+ * . for it rather than the entry itself.
+ *
+ * returns: 1    type may be virtual
+ *            0    type is only ever read from the entry
+*/
+int
+vattr_type_is_virtual(Slapi_Backend *be, const char *type)
+{
+    Slapi_DN *namespace_dn = NULL;
+
+    if (be) {
+        namespace_dn = (Slapi_DN *)slapi_be_getsuffix(be, 0);
+    }
+    return vattr_map_namespace_sp_getlist(namespace_dn, type) ? 1 : 0;
+}
 /*
  * deprecated in favour of slapi_vattr_values_get_sp_ex() which
  * returns subtypes too.
@@ -1741,8 +1639,10 @@ slapi_vattrspi_register_internal(vattr_sp_handle **h, vattr_get_fn_type get_fn,
     /* Make a handle for the list */
     list_handle = (vattr_sp_handle *)slapi_ch_calloc(1, sizeof(vattr_sp_handle));
     *list_handle = *return_to_caller;
+    pthread_mutex_lock(&vattr_map_writer_lock);
     list_handle->next = vattr_sp_list;
-    vattr_sp_list = list_handle;
+    __atomic_store_n(&vattr_sp_list, list_handle, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&vattr_map_writer_lock);
 
     /* Return the handle to the caller */
     *h = return_to_caller;
@@ -1752,7 +1652,7 @@ slapi_vattrspi_register_internal(vattr_sp_handle **h, vattr_get_fn_type get_fn,
 vattr_sp_handle_list *
 vattr_map_sp_get_complete_list(void)
 {
-    return vattr_sp_list;
+    return __atomic_load_n(&vattr_sp_list, __ATOMIC_ACQUIRE);
 }
 
 int
@@ -1929,7 +1829,7 @@ is a separate thing in the insterests of stability.
         The type name,
         other stuff ?
 
-   Access to the entire map will be controlled via a single RW lock.
+   Readers take no lock, see struct _vattr_map.
  */
 
 struct _objAttrValue
@@ -1939,6 +1839,21 @@ struct _objAttrValue
 };
 typedef struct _objAttrValue objAttrValue;
 
+/*
+ * objectclass lists replaced by a schema change. slapi_vattr_schema_check_type()
+ * counts itself in vattr_schema_readers while it walks a list. A schema change
+ * that finds no reader after swapping in the new lists frees the retired ones;
+ * otherwise they wait for a later change or for vattr_cleanup().
+ */
+typedef struct _vattr_retired_attrvals
+{
+    objAttrValue *attrvals;
+    struct _vattr_retired_attrvals *next;
+} vattr_retired_attrvals;
+
+static vattr_retired_attrvals *vattr_retired_objectclasses = NULL;
+static uint64_t vattr_schema_readers = 0;
+
 struct _vattr_map_entry
 {
     char * /* currect ? */ type_name;
@@ -1978,27 +1893,26 @@ vattr_hash_fn(const void *type_name)
     return result;
 }
 
-static int
-vattr_map_create(void)
+static vattr_map *
+vattr_map_new(void)
 {
-    the_map = (vattr_map *)slapi_ch_calloc(1, sizeof(vattr_map));
-    if (NULL == the_map) {
-        slapd_nasty(sourcefile, 1, 0);
-        return ENOMEM;
-    }
-
-    the_map->hashtable = PL_NewHashTable(VARRT_MAP_HASHTABLE_SIZE,
-                                         vattr_hash_fn, vattr_hash_compare_keys,
-                                         vattr_hash_compare_values, NULL, NULL);
+    vattr_map *map = (vattr_map *)slapi_ch_calloc(1, sizeof(vattr_map));
 
-    if (NULL == the_map->hashtable) {
-        slapd_nasty(sourcefile, 2, 0);
-        return ENOMEM;
+    map->hashtable = PL_NewHashTable(VARRT_MAP_HASHTABLE_SIZE,
+                                     vattr_hash_fn, vattr_hash_compare_keys,
+                                     vattr_hash_compare_values, NULL, NULL);
+    if (NULL == map->hashtable) {
+        slapi_ch_free((void **)&map);
     }
+    return map;
+}
 
-    the_map->lock = slapi_new_rwlock_prio(1 /* priority on writers */);
+static int
+vattr_map_create(void)
+{
+    the_map = vattr_map_new();
     if (NULL == the_map) {
-        slapd_nasty(sourcefile, 3, 0);
+        slapd_nasty(sourcefile, 2, 0);
         return ENOMEM;
     }
     return 0;
@@ -2022,6 +1936,17 @@ vattr_delete_attrvals(objAttrValue **attrval)
     }
 }
 
+static void
+vattr_retired_objectclasses_free(vattr_retired_attrvals **list)
+{
+    while (*list) {
+        vattr_retired_attrvals *next = (*list)->next;
+        vattr_delete_attrvals(&((*list)->attrvals));
+        slapi_ch_free((void **)list);
+        *list = next;
+    }
+}
+
 void
 vattr_map_entry_free(vattr_map_entry *vae)
 {
@@ -2052,16 +1977,21 @@ vattr_he_cleanup_fn(PLHashEntry *he, PRIntn index __attribute__((unused)), void
 static void
 vattr_map_destroy(void)
 {
-    if (the_map) {
-        PL_HashTableEnumerateEntries(the_map->hashtable, vattr_he_cleanup_fn, NULL);
-        if (the_map->hashtable) {
-            PL_HashTableDestroy(the_map->hashtable);
-        }
-        if (the_map->lock) {
-            slapi_destroy_rwlock(the_map->lock);
-        }
+    vattr_map *map = the_map;
+
+    /* the current snapshot holds every entry, the retired ones only share them */
+    if (map) {
+        PL_HashTableEnumerateEntries(map->hashtable, vattr_he_cleanup_fn, NULL);
+    }
+    while (map) {
+        vattr_map *retired = map->retired;
+        PL_HashTableDestroy(map->hashtable);
+        slapi_ch_free((void **)&map);
+        map = retired;
     }
-    slapi_ch_free((void **)&the_map);
+    the_map = NULL;
+
+    vattr_retired_objectclasses_free(&vattr_retired_objectclasses);
 }
 
 /* Returns 0 if present, entry returned in result. Returns SLAPI_VIRTUALATTRS_NOT_FOUND if not found */
@@ -2089,12 +2019,8 @@ vattr_map_lookup(const char *type_to_find, vattr_map_entry **result)
         basetype = buf;
     }
 
-    /* Get the reader lock */
-    vattr_rdlock();
-    *result = (vattr_map_entry *)PL_HashTableLookupConst(the_map->hashtable,
+    *result = (vattr_map_entry *)PL_HashTableLookupConst(__atomic_load_n(&the_map, __ATOMIC_ACQUIRE)->hashtable,
                                                          (void *)basetype);
-    /* Release ze lock */
-    vattr_rd_unlock();
 
     if (tmp) {
         slapi_ch_free_string(&tmp);
@@ -2107,19 +2033,33 @@ vattr_map_lookup(const char *type_to_find, vattr_map_entry **result)
     }
 }
 
-/* Insert an entry into the attribute map */
-int
-vattr_map_insert(vattr_map_entry *vae)
+static PRIntn
+vattr_map_copy_fn(PLHashEntry *he, PRIntn index __attribute__((unused)), void *arg)
 {
+    PL_HashTableAdd((PLHashTable *)arg, he->key, he->value);
+    return HT_ENUMERATE_NEXT;
+}
+
+/*
+ * Insert an entry into the attribute map: publish a copy of the current
+ * snapshot with the entry added. Called with vattr_map_writer_lock held.
+ */
+static int
+vattr_map_insert_nolock(vattr_map_entry *vae)
+{
+    vattr_map *map;
+
     PR_ASSERT(the_map);
-    /* Get the writer lock */
-    vattr_wrlock();
-    /* Insert the thing */
     /* It's illegal to call this function if the entry is already there */
     PR_ASSERT(NULL == PL_HashTableLookupConst(the_map->hashtable, (void *)vae->type_name));
-    PL_HashTableAdd(the_map->hashtable, (void *)vae->type_name, (void *)vae);
-    /* Unlock and we're done */
-    vattr_wr_unlock();
+    map = vattr_map_new();
+    if (NULL == map) {
+        return ENOMEM;
+    }
+    PL_HashTableEnumerateEntries(the_map->hashtable, vattr_map_copy_fn, map->hashtable);
+    PL_HashTableAdd(map->hashtable, (void *)vae->type_name, (void *)vae);
+    map->retired = the_map;
+    __atomic_store_n(&the_map, map, __ATOMIC_RELEASE);
     return 0;
 }
 
@@ -2221,11 +2161,17 @@ static PRIntn
 vattr_map_entry_rebuild_schema(PLHashEntry *he, PRIntn i __attribute__((unused)), void *arg __attribute__((unused)))
 {
     vattr_map_entry *entry = (vattr_map_entry *)(he->value);
+    objAttrValue *old;
 
-    if (entry->objectclasses)
-        vattr_delete_attrvals(&(entry->objectclasses));
-
-    entry->objectclasses = vattr_map_entry_build_schema(entry->type_name);
+    /* slapi_vattr_schema_check_type() may be walking the old list */
+    old = __atomic_exchange_n(&entry->objectclasses, vattr_map_entry_build_schema(entry->type_name),
+                              __ATOMIC_SEQ_CST);
+    if (old) {
+        vattr_retired_attrvals *retired = (vattr_retired_attrvals *)slapi_ch_malloc(sizeof(vattr_retired_attrvals));
+        retired->attrvals = old;
+        retired->next = vattr_retired_objectclasses;
+        vattr_retired_objectclasses = retired;
+    }
 
     return HT_ENUMERATE_NEXT;
 }
@@ -2237,14 +2183,17 @@ schema_changed_callback(Slapi_Entry *e __attribute__((unused)),
                         Slapi_PBlock *pb __attribute__((unused)),
                         void *caller_data __attribute__((unused)))
 {
-    /* Get the writer lock */
-    vattr_wrlock();
+    pthread_mutex_lock(&vattr_map_writer_lock);
 
     /* go through the list */
     PL_HashTableEnumerateEntries(the_map->hashtable, vattr_map_entry_rebuild_schema, 0);
 
-    /* Unlock and we're done */
-    vattr_wr_unlock();
+    /* a reader counted after this point can only load the new lists */
+    if (__atomic_load_n(&vattr_schema_readers, __ATOMIC_SEQ_CST) == 0) {
+        vattr_retired_objectclasses_free(&vattr_retired_objectclasses);
+    }
+
+    pthread_mutex_unlock(&vattr_map_writer_lock);
 }
 
 
@@ -2264,9 +2213,9 @@ slapi_vattr_schema_check_type(Slapi_Entry *e, char *type)
                 objAttrValue *obj;
 
                 if (0 == vattr_map_lookup(type, &map_entry)) {
-                    vattr_rdlock();
-
-                    obj = map_entry->objectclasses;
+                    /* keeps schema_changed_callback() from freeing the list we walk */
+                    __atomic_add_fetch(&vattr_schema_readers, 1, __ATOMIC_SEQ_CST);
+                    obj = __atomic_load_n(&map_entry->objectclasses, __ATOMIC_SEQ_CST);
 
                     while (obj) {
                         if (slapi_valueset_find(attr, vs, obj->val)) {
@@ -2280,8 +2229,7 @@ slapi_vattr_schema_check_type(Slapi_Entry *e, char *type)
 
                         obj = obj->pNext;
                     }
-
-                    vattr_rd_unlock();
+                    __atomic_sub_fetch(&vattr_schema_readers, 1, __ATOMIC_RELEASE);
                 }
 
                 slapi_valueset_free(vs);
@@ -2318,7 +2266,7 @@ vattr_map_sp_getlist(char *type_to_find)
     vattr_map_entry *result = NULL;
     ret = vattr_map_lookup(type_to_find, &result);
     if (0 == ret) {
-        return (vattr_sp_handle_list *)result->sp_list;
+        return (vattr_sp_handle_list *)__atomic_load_n(&result->sp_list, __ATOMIC_ACQUIRE);
     } else {
         return NULL;
     }
@@ -2343,7 +2291,7 @@ vattr_map_namespace_sp_getlist(Slapi_DN *dn, const char *type_to_find)
 
     ret = vattr_map_lookup(type_to_find, &result);
     if (0 == ret) {
-        return_list = (vattr_sp_handle_list *)result->sp_list;
+        return_list = (vattr_sp_handle_list *)__atomic_load_n(&result->sp_list, __ATOMIC_ACQUIRE);
     } else {
         /* we have allowed the global namespace provider a shot
          * now it is time to query for split namespace providers
@@ -2356,7 +2304,7 @@ vattr_map_namespace_sp_getlist(Slapi_DN *dn, const char *type_to_find)
             if (split_type_to_find) {
                 ret = vattr_map_lookup(split_type_to_find, &result);
                 if (0 == ret) {
-                    return_list = (vattr_sp_handle_list *)result->sp_list;
+                    return_list = (vattr_sp_handle_list *)__atomic_load_n(&result->sp_list, __ATOMIC_ACQUIRE);
                 }
 
                 slapi_ch_free((void **)&split_type_to_find);
@@ -2447,39 +2395,57 @@ vattr_map_sp_insert(char *type_to_add, vattr_sp_handle *sp, void *hint)
 {
     int result = 0;
     vattr_map_entry *map_entry = NULL;
-    /* Is this type already there ? */
+    vattr_map_entry *new_entry = NULL;
+
+    /* Is this type already there ? If not, build its entry outside of the
+     * writer lock, that reads the schema */
+    if (vattr_map_lookup(type_to_add, &map_entry)) {
+        new_entry = vattr_map_entry_new(type_to_add, NULL, hint);
+    }
+
+    pthread_mutex_lock(&vattr_map_writer_lock);
     result = vattr_map_lookup(type_to_add, &map_entry);
     /* If it is, add this SP to the list, safely even if readers are traversing the list at the same time */
     if (0 == result) {
-        int found = 0;
         vattr_sp_handle *list_entry = NULL;
         /* Walk the list checking that the daft SP isn't already here */
         for (list_entry = map_entry->sp_list; list_entry; list_entry = list_entry->next) {
             if (list_entry == sp) {
-                found = 1;
                 break;
             }
         }
         /* If it is, we do nothing */
-        if (found) {
-            return 0;
+        if (NULL == list_entry) {
+            /* Increase the ref count of the sphandle */
+            slapi_atomic_incr_64(&(sp->rc), __ATOMIC_RELAXED);
+            /* We insert the SP handle into the linked list at the head */
+            sp->next = map_entry->sp_list;
+            __atomic_store_n(&map_entry->sp_list, sp, __ATOMIC_RELEASE);
         }
-        /* Increase the ref count of the sphandle */
-        slapi_atomic_incr_64(&(sp->rc), __ATOMIC_RELAXED);
-        /* We insert the SP handle into the linked list at the head */
-        sp->next = map_entry->sp_list;
-        map_entry->sp_list = sp;
+    } else if (NULL == new_entry) {
+        /* found before taking the lock, but entries are never removed */
+        PR_ASSERT(0);
+        result = ENOMEM;
     } else {
         /* If not, add it */
         /* Claim a reference on the sp ... */
         slapi_atomic_incr_64(&(sp->rc), __ATOMIC_RELAXED);
-        map_entry = vattr_map_entry_new(type_to_add, sp, hint);
-        if (NULL == map_entry) {
-            return ENOMEM;
+        new_entry->sp_list = sp;
+        result = vattr_map_insert_nolock(new_entry);
+        if (result) {
+            slapi_atomic_decr_64(&(sp->rc), __ATOMIC_RELAXED);
+            new_entry->sp_list = NULL;
+        } else {
+            new_entry = NULL;
         }
-        return vattr_map_insert(map_entry);
     }
-    return 0;
+    pthread_mutex_unlock(&vattr_map_writer_lock);
+
+    if (new_entry) {
+        /* raced with another thread adding the type */
+        vattr_map_entry_free(new_entry);
+    }
+    return result;
 }
 
 /*
@@ -277,6 +277,7 @@ class AccessLog(IntEnum):
     DEFAULT = 256  # Default log level
     ENTRY = 512
     MICROSECONDS = 131072
+    SEARCH_PROFILE = 536870912
 
 #
 # Constants for individual tests
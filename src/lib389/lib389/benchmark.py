@@ -0,0 +1,457 @@
+# --- BEGIN COPYRIGHT BLOCK ---
+# Copyright (C) 2026 Red Hat, Inc.
+# All rights reserved.
+#
+# License: GPL (version 3 or any later version).
+# See LICENSE for details.
+# --- END COPYRIGHT BLOCK ---
+
+"""
+Reproducible load benchmark of an instance.
+
+Provisions a suffix with users, groups, nested groups and ACIs from a seeded
+LDIF, then runs a fixed set of scenarios and reports for each of them the
+throughput and the latency percentiles as JSON, so that two runs (two builds,
+two configurations) can be compared with compare_results().
+
+The bind, search and modify storms are driven by ldclt, which only reports a
+rate: their latencies are the etimes the server logged for the operations of
+the run. The sorted, paged, VLV and memberOf scenarios need controls or
+sequences ldclt does not have and run on python-ldap threads, their latencies
+are measured on the client.
+
+Like Ldclt, this will overwrite the backend of the instance: never run it
+against a production server.
+"""
+
+import json
+import os
+import random
+import threading
+import time
+import ldap
+from ldap.controls import SimplePagedResultsControl
+from ldap.controls.vlv import VLVRequestControl
+from lib389._constants import DEFAULT_SUFFIX
+from lib389._controls import SSSRequestControl
+from lib389.backend import Backends, DatabaseConfig
+from lib389.dbgen import (get_node, get_index, write_generic_user, finalize_ldif_file, DBGEN_OU_TEMPLATE)
+from lib389.ldclt import Ldclt
+from lib389.plugins import MemberOfPlugin
+
+BENCHMARK_ACI = ('aci: (targetattr="telephoneNumber || mobile || pager || roomNumber")'
+                 '(version 3.0; acl "Benchmark {IDX}"; allow(write) '
+                 'groupdn = "ldap:///cn=group-{IDX},ou=groups,{SUFFIX}";)\n')
+
+BENCHMARK_GROUP_TEMPLATE = """dn: cn={NAME},ou=groups,{SUFFIX}
+objectClass: top
+objectClass: groupOfNames
+cn: {NAME}
+"""
+
+# ldclt reports one rate sample every 10 seconds
+LDCLT_SAMPLE_SECONDS = 10
+
+# result tags of the access log, see the RESULT lines
+TAG_BIND = 97
+TAG_SEARCH = 101
+TAG_MODIFY = 103
+
+
+def dbgen_benchmark(instance, ldif_file, suffix, users, groups, members, nesting, acis, seed=None):
+    """
+    Write the LDIF of the benchmark suffix:
+        - users uid=user<N>,ou=people with userPassword user<N>, the naming
+          the ldclt bind and search load tests expect
+        - groups cn=group-<N>,ou=groups of members random users each
+        - for every group a chain of nesting groups cn=nested-<N>-<depth>,
+          nested-<N>-1 member of group-<N>, nested-<N>-2 of nested-<N>-1 ...
+        - acis ACIs on the suffix granting write to the groups
+    """
+    rand = random.Random(seed)
+    with open(ldif_file, 'w') as LDIF:
+        node = get_node(suffix)
+        # get_node() ends the entry with a blank line, the ACIs go before it
+        LDIF.write(node.rstrip('\n') + '\n')
+        for i in range(1, acis + 1):
+            LDIF.write(BENCHMARK_ACI.format(IDX=(i - 1) % max(groups, 1) + 1, SUFFIX=suffix))
+        LDIF.write('\n')
+        for ou in ('people', 'groups'):
+            LDIF.write(DBGEN_OU_TEMPLATE.format(SUFFIX=suffix, OU=ou))
+
+        # write_generic_user() uses the module random, seed it as well
+        random.seed(seed)
+        people = f"ou=people,{suffix}"
+        for i in range(1, users + 1):
+            write_generic_user(LDIF, i, users, people)
+
+        for g in range(1, groups + 1):
+            LDIF.write(BENCHMARK_GROUP_TEMPLATE.format(NAME=f"group-{g}", SUFFIX=suffix))
+            for i in rand.sample(range(1, users + 1), min(members, users)):
+                LDIF.write(f"member: uid=user{get_index(i, users)},{people}\n")
+            if nesting:
+                LDIF.write(f"member: cn=nested-{g}-1,ou=groups,{suffix}\n")
+            LDIF.write('\n')
+            # memberOf of a user of the last group walks the whole chain
+            for depth in range(1, nesting + 1):
+                LDIF.write(BENCHMARK_GROUP_TEMPLATE.format(NAME=f"nested-{g}-{depth}", SUFFIX=suffix))
+                LDIF.write(f"member: uid=user{get_index(rand.randint(1, users), users)},{people}\n")
+                if depth < nesting:
+                    LDIF.write(f"member: cn=nested-{g}-{depth + 1},ou=groups,{suffix}\n")
+                LDIF.write('\n')
+
+    finalize_ldif_file(instance, ldif_file)
+
+
+def percentiles(latencies):
+    """
+    Return the latency percentiles in ms of a list of latencies in seconds
+    """
+    if not latencies:
+        return {'p50': None, 'p90': None, 'p99': None, 'p999': None, 'max': None}
+    values = sorted(latencies)
+    count = len(values)
+
+    def pick(q):
+        return round(values[min(count - 1, int(q * count))] * 1000, 3)
+
+    return {
+        'p50': pick(0.50),
+        'p90': pick(0.90),
+        'p99': pick(0.99),
+        'p999': pick(0.999),
+        'max': round(values[-1] * 1000, 3),
+    }
+
+
+def compare_results(baseline, current, tolerance=0.05):
+    """
+    Compare two result documents written by Benchmark.write_json().
+
+    Returns the list of regressions, a scenario regresses when its throughput
+    dropped or its p99 latency grew by more than tolerance.
+    """
+    regressions = []
+    base = {r['scenario']: r for r in baseline['results']}
+    for result in current['results']:
+        old = base.get(result['scenario'])
+        if old is None:
+            continue
+        if old['throughput'] and result['throughput'] < old['throughput'] * (1 - tolerance):
+            regressions.append("%s: throughput %.1f -> %.1f ops/s" %
+                               (result['scenario'], old['throughput'], result['throughput']))
+        old_p99 = old['latency_ms']['p99']
+        new_p99 = result['latency_ms']['p99']
+        if old_p99 and new_p99 and new_p99 > old_p99 * (1 + tolerance):
+            regressions.append("%s: p99 latency %.3f -> %.3f ms" % (result['scenario'], old_p99, new_p99))
+    return regressions
+
+
+class Benchmark(object):
+    """
+    Provision the benchmark data set on an instance and run the scenarios.
+
+    :param instance: An instance
+    :type instance: lib389.DirSrv
+    :param users: Number of users
+    :param groups: Number of groups, default users / 1000
+    :param members: Number of users in each group
+    :param nesting: Depth of the nested group chain of each group
+    :param acis: Number of ACIs on the suffix
+    :param threads: Client threads of each scenario
+    :param duration: Seconds each load scenario runs
+    :param seed: Seed of the data set, the same seed gives the same LDIF
+    """
+
+    SCENARIOS = [
+        'import',
+        'reindex',
+        'bind_storm',
+        'indexed_search',
+        'unindexed_search',
+        'sorted_search',
+        'paged_search',
+        'vlv_search',
+        'modify_heavy',
+        'memberof_churn',
+    ]
+
+    def __init__(self, instance, users=1000000, groups=None, members=100, nesting=5, acis=50,
+                 threads=16, duration=60, suffix=DEFAULT_SUFFIX, backend='userRoot', seed=1):
+        self._instance = instance
+        self.log = instance.log
+        self.users = users
+        self.groups = groups if groups is not None else max(users // 1000, 1)
+        self.members = members
+        self.nesting = nesting
+        self.acis = acis
+        self.threads = threads
+        self.duration = duration
+        self.suffix = suffix
+        self.backend = backend
+        self.seed = seed
+        self.ldif_file = os.path.join(instance.get_ldif_dir(), 'benchmark-%s-%s.ldif' % (users, seed))
+        self.people = f"ou=people,{suffix}"
+        self.results = []
+
+    def provision(self):
+        """
+        Configure the backend, memberOf and the VLV index, then generate the
+        data set (once per size and seed) and import it. Returns the import
+        result, the memberOf fixup that follows the import is not timed.
+        """
+        inst = self._instance
+        bes = Backends(inst)
+        if not bes.exists(self.backend):
+            bes.create(properties={'cn': self.backend, 'nsslapd-suffix': self.suffix})
+        be = bes.get(self.backend)
+
+        MemberOfPlugin(inst).enable()
+        # let the unindexed searches of ldclt, anonymous, scan the suffix
+        # instead of failing with adminlimit exceeded
+        DatabaseConfig(inst).set('nsslapd-lookthroughlimit', '-1')
+        if not be.get_vlv_searches():
+            be.add_vlv_search('benchmark', {
+                'cn': 'benchmark',
+                'vlvbase': self.people,
+                'vlvscope': '1',
+                'vlvfilter': '(uid=*)',
+            })
+            be.get_vlv_searches()[0].add_sort('benchmark-sn', 'sn')
+
+        inst.stop()
+        if not os.path.exists(self.ldif_file):
+            self.log.info("benchmark: generating %s", self.ldif_file)
+            dbgen_benchmark(inst, self.ldif_file, self.suffix, self.users, self.groups,
+                            self.members, self.nesting, self.acis, self.seed)
+        start = time.time()
+        if not inst.ldif2db(self.backend, None, None, None, self.ldif_file):
+            raise ValueError("benchmark: import of %s failed" % self.ldif_file)
+        seconds = time.time() - start
+        inst.start()
+        # the import does not run the plugins, memberOf needs a fixup
+        task = MemberOfPlugin(inst).fixup(self.suffix)
+        task.wait(timeout=self.users)
+        return self._record('import', self.users, seconds, None, 'none')
+
+    def _connect(self):
+        conn = ldap.initialize(self._instance.toLDAPURL())
+        conn.set_option(ldap.OPT_PROTOCOL_VERSION, 3)
+        conn.simple_bind_s(self._instance.binddn, self._instance.bindpw)
+        return conn
+
+    def _record(self, scenario, ops, seconds, latencies, source):
+        result = {
+            'scenario': scenario,
+            'ops': ops,
+            'seconds': round(seconds, 3),
+            'throughput': round(ops / seconds, 1) if seconds else 0.0,
+            'latency_ms': percentiles(latencies or []),
+            'latency_source': source,
+        }
+        self.log.info("benchmark: %s", result)
+        self.results.append(result)
+        return result
+
+    def _access_log_offset(self):
+        try:
+            return os.path.getsize(self._instance.ds_paths.access_log)
+        except OSError:
+            return 0
+
+    def _server_etimes(self, offset, tag):
+        # The access log is buffered, give it time to reach the disk
+        time.sleep(2)
+        needle = ' tag=%d ' % tag
+        etimes = []
+        with open(self._instance.ds_paths.access_log, 'r') as log:
+            log.seek(offset)
+            for line in log:
+                if ' RESULT ' not in line or needle not in line or ' etime=' not in line:
+                    continue
+                etime = line.split(' etime=', 1)[1].split(' ', 1)[0]
+                try:
+                    etimes.append(float(etime))
+                except ValueError:
+                    pass
+        return etimes
+
+    def _run_ldclt(self, scenario, tag, load):
+        rounds = max(self.duration // LDCLT_SAMPLE_SECONDS, 1)
+        offset = self._access_log_offset()
+        start = time.time()
+        rate = load(rounds)
+        seconds = time.time() - start
+        etimes = self._server_etimes(offset, tag)
+        result = self._record(scenario, len(etimes), seconds, etimes, 'server etime')
+        if rate is not None:
+            # ldclt's own average leaves out the connection setup
+            result['throughput'] = float(rate)
+        return result
+
+    def _run_threads(self, scenario, operation):
+        """
+        Run operation(conn, rand) in a loop on self.threads connections for
+        self.duration seconds, timing each call.
+        """
+        latencies = []
+        lock = threading.Lock()
+        deadline = time.time() + self.duration
+
+        def worker(idx):
+            conn = self._connect()
+            rand = random.Random((self.seed or 0) + idx)
+            mine = []
+            while time.time() < deadline:
+                begin = time.perf_counter()
+                operation(conn, rand)
+                mine.append(time.perf_counter() - begin)
+            conn.unbind_s()
+            with lock:
+                latencies.extend(mine)
+
+        workers = [threading.Thread(target=worker, args=(i,)) for i in range(self.threads)]
+        start = time.time()
+        for w in workers:
+            w.start()
+        for w in workers:
+            w.join()
+        return self._record(scenario, len(latencies), time.time() - start, latencies, 'client')
+
+    def _random_user(self, rand):
+        return "user%s" % get_index(rand.randint(1, self.users), self.users)
+
+    def reindex(self):
+        inst = self._instance
+        inst.stop()
+        start = time.time()
+        if not inst.db2index(self.backend, attrs=['uid', 'cn', 'sn', 'member', 'memberOf']):
+            raise ValueError("benchmark: reindex of %s failed" % self.backend)
+        seconds = time.time() - start
+        inst.start()
+        return self._record('reindex', self.users, seconds, None, 'none')
+
+    def bind_storm(self):
+        ldclt = Ldclt(self._instance)
+        return self._run_ldclt('bind_storm', TAG_BIND, lambda rounds: ldclt.bind_loadtest(
+            self.people, min=1, max=self.users, rounds=rounds, threads=self.threads))
+
+    def indexed_search(self):
+        ldclt = Ldclt(self._instance)
+        digits = len('%s' % self.users)
+        return self._run_ldclt('indexed_search', TAG_SEARCH, lambda rounds: ldclt.search_loadtest(
+            self.people, '(uid=user%s)' % ('X' * digits), min=1, max=self.users, rounds=rounds,
+            threads=self.threads))
+
+    def unindexed_search(self):
+        # carLicense is not indexed: every search is a full scan of the
+        # suffix, as long as the lookthrough limit allows it
+        ldclt = Ldclt(self._instance)
+        digits = len('%s' % self.users)
+        return self._run_ldclt('unindexed_search', TAG_SEARCH, lambda rounds: ldclt.search_loadtest(
+            self.people, '(carLicense=%s)' % ('X' * digits), min=1, max=self.users, rounds=rounds,
+            threads=self.threads))
+
+    def sorted_search(self):
+        sss = SSSRequestControl(True, ['sn'])
+
+        def search(conn, rand):
+            # about a hundred entries, sorted by the server
+            prefix = self._random_user(rand)[:-2]
+            conn.search_ext_s(self.people, ldap.SCOPE_ONELEVEL, '(uid=%s*)' % prefix,
+                              ['uid', 'sn'], serverctrls=[sss])
+
+        return self._run_threads('sorted_search', search)
+
+    def paged_search(self):
+        def search(conn, rand):
+            prefix = self._random_user(rand)[:-3]
+            page = SimplePagedResultsControl(True, size=500, cookie='')
+            while True:
+                msgid = conn.search_ext(self.people, ldap.SCOPE_ONELEVEL, '(uid=%s*)' % prefix,
+                                        ['uid'], serverctrls=[page])
+                rtype, rdata, rmsgid, rctrls = conn.result3(msgid)
+                cookies = [c.cookie for c in rctrls
+                           if c.controlType == SimplePagedResultsControl.controlType]
+                if not cookies or not cookies[0]:
+                    break
+                page.cookie = cookies[0]
+
+        return self._run_threads('paged_search', search)
+
+    def vlv_search(self):
+        sss = SSSRequestControl(True, ['sn'])
+
+        def search(conn, rand):
+            # a window of 20 entries at a random offset of the index
+            vlv = VLVRequestControl(True, before_count=0, after_count=19,
+                                    offset=rand.randint(1, self.users), content_count=self.users)
+            conn.search_ext_s(self.people, ldap.SCOPE_ONELEVEL, '(uid=*)', ['uid', 'sn'],
+                              serverctrls=[sss, vlv])
+
+        return self._run_threads('vlv_search', search)
+
+    def modify_heavy(self):
+        ldclt = Ldclt(self._instance)
+        digits = len('%s' % self.users)
+        return self._run_ldclt('modify_heavy', TAG_MODIFY, lambda rounds: ldclt.modify_loadtest(
+            self.people, 'uid=user%s' % ('X' * digits), min=1, max=self.users, rounds=rounds,
+            threads=self.threads))
+
+    def memberof_churn(self):
+        groups = f"ou=groups,{self.suffix}"
+
+        def churn(conn, rand):
+            # add a user to a group and take it out again, two memberOf
+            # updates of the user and of the chain of nested groups
+            group = "cn=nested-%d-%d,%s" % (rand.randint(1, self.groups), self.nesting, groups) \
+                if self.nesting else "cn=group-%d,%s" % (rand.randint(1, self.groups), groups)
+            user = ("uid=%s,%s" % (self._random_user(rand), self.people)).encode()
+            try:
+                conn.modify_s(group, [(ldap.MOD_ADD, 'member', user)])
+                conn.modify_s(group, [(ldap.MOD_DELETE, 'member', user)])
+            except (ldap.TYPE_OR_VALUE_EXISTS, ldap.NO_SUCH_ATTRIBUTE):
+                # picked a user that was a member already, or a concurrent
+                # thread picked the same pair
+                pass
+
+        return self._run_threads('memberof_churn', churn)
+
+    def run(self, scenarios=None):
+        """
+        Run the scenarios, by default all of SCENARIOS, in that order. The
+        import scenario provisions the instance, without it the data set must
+        be loaded already.
+        """
+        if scenarios is None:
+            scenarios = self.SCENARIOS
+        for scenario in scenarios:
+            if scenario not in self.SCENARIOS:
+                raise ValueError("benchmark: unknown scenario %s" % scenario)
+            if scenario == 'import':
+                self.provision()
+            else:
+                getattr(self, scenario)()
+        return self.results
+
+    def as_dict(self):
+        return {
+            'metadata': {
+                'version': self._instance.ds_paths.version,
+                'date': time.strftime('%Y-%m-%dT%H:%M:%S%z'),
+                'cpus': os.cpu_count(),
+                'users': self.users,
+                'groups': self.groups,
+                'members': self.members,
+                'nesting': self.nesting,
+                'acis': self.acis,
+                'threads': self.threads,
+                'duration': self.duration,
+                'seed': self.seed,
+            },
+            'results': self.results,
+        }
+
+    def write_json(self, path):
+        with open(path, 'w') as f:
+            json.dump(self.as_dict(), f, indent=4, sort_keys=True)
@@ -47,19 +47,90 @@ class DSEldif(DSLint):
             ds_paths = Paths(self._instance.serverid, self._instance)
             self.path = os.path.join(ds_paths.config_dir, 'dse.ldif')
 
+        self.journal_path = self.path + '.journal'
+
         with open(self.path, 'r') as file_dse:
-            processed_line = ""
-            for line in file_dse.readlines():
-                if not line.startswith(' '):
-                    if processed_line:
-                        self._contents.append(processed_line)
-
-                    if line.startswith('dn:'):
-                        processed_line = line.lower()
-                    else:
-                        processed_line = line
+            self._contents = self._unfold(file_dse.readlines())
+        self._replay_journal()
+
+    @staticmethod
+    def _unfold(lines):
+        """Join the continuation lines, the dn lines are lowercased"""
+
+        contents = []
+        processed_line = ""
+        for line in lines:
+            if not line.startswith(' '):
+                if processed_line:
+                    contents.append(processed_line)
+
+                if line.startswith('dn:'):
+                    processed_line = line.lower()
                 else:
-                    processed_line = processed_line[:-1] + line[1:]
+                    processed_line = line
+            else:
+                processed_line = processed_line[:-1] + line[1:]
+        return contents
+
+    @staticmethod
+    def _split_entries(contents):
+        """Split the contents on the empty lines
+
+        Returns a list of (dn line, lines) tuples, dn line is None for a block
+        without an entry (e.g. comments only)
+        """
+
+        blocks = []
+        block = []
+        for line in contents + ["\n"]:
+            if line != "\n":
+                block.append(line)
+            elif block:
+                dn = next((l for l in block if l.startswith('dn:')), None)
+                blocks.append((dn, block))
+                block = []
+        return blocks
+
+    def _replay_journal(self):
+        """Apply dse.ldif.journal over the contents, as the server does at startup
+
+        The server appends the changed entries to the journal and only rewrites
+        dse.ldif every nsslapd-dse-journal-size changes. A record is the whole
+        entry, or a "changetype: delete" record; only the last record of an
+        entry counts and an incomplete last record is ignored.
+        """
+
+        if not os.path.exists(self.journal_path):
+            return
+        with open(self.journal_path, 'r') as file_journal:
+            journal = file_journal.read()
+        end = journal.rfind("\n\n")
+        journal = journal[:end + 2] if end >= 0 else ""
+
+        changes = {}
+        for dn, record in self._split_entries(self._unfold(journal.splitlines(True))):
+            if dn is not None:
+                changes[dn] = record
+        if not changes:
+            return
+
+        contents = []
+        for dn, block in self._split_entries(self._contents):
+            if dn in changes:
+                # Keep the comments in front of the entry
+                block = block[:block.index(dn)] + changes.pop(dn)
+            contents.append((dn, block))
+        # Entries added since dse.ldif was written
+        contents.extend(changes.items())
+
+        self._contents = []
+        for dn, block in contents:
+            if "changetype: delete\n" in block:
+                block = block[:block.index(dn)]
+            if block:
+                self._contents.extend(block + ["\n"])
+        # As read from the file, without the last empty line
+        self._contents = self._contents[:-1]
 
     @classmethod
     def lint_uid(cls):
@@ -92,6 +163,10 @@ class DSEldif(DSLint):
 
         with open(self.path, "w") as file_dse:
             file_dse.write("".join(self._contents))
+        # The journal was replayed into the contents, the server must not
+        # apply it again over the new file
+        if os.path.exists(self.journal_path):
+            os.remove(self.journal_path)
 
     def _find_attr(self, entry_dn, attr):
         """Find all attribute values and indexes under a given entry
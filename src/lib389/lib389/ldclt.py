@@ -120,7 +120,13 @@ loginShell: /bin/false
                 section = line.split('(')[1].split(')')[0].split('/')[0]
         return section
 
-    def bind_loadtest(self, subtree, min=1000, max=9999, rounds=10):
+    def _threads(self, threads):
+        # ldclt defaults to 10 threads
+        if threads is None:
+            return []
+        return ['-n', '%s' % threads]
+
+    def bind_loadtest(self, subtree, min=1000, max=9999, rounds=10, threads=None):
         # The bind users will be uid=userXXXX
         digits = len('%s' % max)
         cmd = [
@@ -139,10 +145,10 @@ loginShell: /bin/false
             "randombinddn,randombinddnlow=%s,randombinddnhigh=%s" % (min, max),
             '-e',
             'bindonly',
-        ]
+        ] + self._threads(threads)
         return self._run_ldclt(cmd)
 
-    def search_loadtest(self, subtree, fpattern, min=1000, max=9999, rounds=10):
+    def search_loadtest(self, subtree, fpattern, min=1000, max=9999, rounds=10, threads=None):
         # digits = len('%s' % max)
         cmd = [
             '%s/ldclt' % self.ds.get_bin_dir(),
@@ -150,6 +156,8 @@ loginShell: /bin/false
             self.ds.host,
             '-p',
             '%s' % self.ds.port,
+            '-b',
+            subtree,
             '-N',
             '%s' % rounds,
             '-f',
@@ -162,5 +170,37 @@ loginShell: /bin/false
             '32',
             '-e',
             'randomattrlist=cn:uid:ou',
-        ]
+        ] + self._threads(threads)
+        return self._run_ldclt(cmd)
+
+    def modify_loadtest(self, subtree, fpattern, attr='description', min=1000, max=9999, rounds=10, threads=None):
+        """
+        Replace attr with a random value on random entries matching the rdn
+        pattern fpattern (uid=userXXXX), as the directory manager.
+        """
+        cmd = [
+            '%s/ldclt' % self.ds.get_bin_dir(),
+            '-h',
+            self.ds.host,
+            '-p',
+            '%s' % self.ds.port,
+            '-D',
+            self.ds.binddn,
+            '-w',
+            self.ds.bindpw,
+            '-b',
+            subtree,
+            '-N',
+            '%s' % rounds,
+            '-f',
+            fpattern,
+            '-e',
+            'attreplace=%s:benchmark XXXXXXXX' % attr,
+            '-e',
+            'random',
+            '-r%s' % min,
+            '-R%s' % max,
+            '-I',
+            '32',
+        ] + self._threads(threads)
         return self._run_ldclt(cmd)
@@ -100,6 +100,7 @@ class Monitor(DSLdapObject):
             'opscompleted',
             'entriessent',
             'bytessent',
+            'resultwrites',
             'currenttime',
             'starttime',
             'nbackends',
@@ -0,0 +1,420 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+/*
+ * Time the back-ldbm primitives of the search and update paths on synthetic
+ * data, without a server or a database: IDL set intersection and union, entry
+ * cache lookups, str2entry, DN normalization and the index keys generated for
+ * index_addordel_values_sv(). Each line reports the time and the number of
+ * allocations per operation.
+ *
+ *     ./benchmark_slapd_backldbm [iterations]
+ */
+
+#include "back-ldbm.h"
+#include "syntax.h"
+#include <stdio.h>
+#include <inttypes.h>
+
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__) && !defined(__SANITIZE_THREAD__)
+/*
+ * Count the allocations by replacing malloc: glibc sends its own allocations
+ * (strdup() ...) through the replacement as well.
+ */
+#define BENCH_COUNT_ALLOCS 1
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+static uint64_t bench_allocs;
+
+void *
+malloc(size_t size)
+{
+    __atomic_add_fetch(&bench_allocs, 1, __ATOMIC_RELAXED);
+    return __libc_malloc(size);
+}
+
+void *
+calloc(size_t nmemb, size_t size)
+{
+    __atomic_add_fetch(&bench_allocs, 1, __ATOMIC_RELAXED);
+    return __libc_calloc(nmemb, size);
+}
+
+void *
+realloc(void *ptr, size_t size)
+{
+    __atomic_add_fetch(&bench_allocs, 1, __ATOMIC_RELAXED);
+    return __libc_realloc(ptr, size);
+}
+
+void
+free(void *ptr)
+{
+    __libc_free(ptr);
+}
+#endif
+
+#define IDL_UNIVERSE 1000000
+#define CACHE_ENTRIES 20000
+
+typedef struct bench_timer
+{
+    uint64_t ns;
+    uint64_t allocs;
+    struct timespec start;
+    uint64_t start_allocs;
+} bench_timer;
+
+static void
+timer_start(bench_timer *t)
+{
+#ifdef BENCH_COUNT_ALLOCS
+    t->start_allocs = __atomic_load_n(&bench_allocs, __ATOMIC_RELAXED);
+#endif
+    clock_gettime(CLOCK_MONOTONIC, &t->start);
+}
+
+/* accumulate the time and allocations since timer_start() */
+static void
+timer_stop(bench_timer *t)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+#ifdef BENCH_COUNT_ALLOCS
+    t->allocs += __atomic_load_n(&bench_allocs, __ATOMIC_RELAXED) - t->start_allocs;
+#endif
+    t->ns += (now.tv_sec - t->start.tv_sec) * 1000000000ULL + now.tv_nsec - t->start.tv_nsec;
+}
+
+static void
+report(const char *bench, uint64_t ops, bench_timer *t)
+{
+#ifdef BENCH_COUNT_ALLOCS
+    printf("BENCH: %s ops %" PRIu64 " ns/op %.1f allocs/op %.2f\n",
+           bench, ops, (double)t->ns / ops, (double)t->allocs / ops);
+#else
+    printf("BENCH: %s ops %" PRIu64 " ns/op %.1f allocs/op n/a\n", bench, ops, (double)t->ns / ops);
+#endif
+}
+
+/*
+ * IDL set operations, on id lists of the sizes an AND or an OR of three
+ * equality filters gets from the index of a million entries suffix.
+ */
+
+static IDList *
+idl_random(NIDS want, unsigned int *seed)
+{
+    IDList *idl = idl_alloc(want * 2);
+
+    for (ID id = 1; id <= IDL_UNIVERSE && idl->b_nids < idl->b_nmax; id++) {
+        if ((uint64_t)rand_r(seed) * IDL_UNIVERSE < (uint64_t)want * RAND_MAX) {
+            idl_append(idl, id);
+        }
+    }
+    return idl;
+}
+
+static IDList *
+idl_copy(IDList *idl)
+{
+    IDList *copy = idl_alloc(idl->b_nids);
+
+    memcpy(copy->b_ids, idl->b_ids, idl->b_nids * sizeof(ID));
+    copy->b_nids = idl->b_nids;
+    return copy;
+}
+
+static IDList *
+idl_set_run(backend *be, IDList **idls, size_t count, int do_union, bench_timer *t)
+{
+    IDListSet *idl_set = idl_set_create();
+    IDList *result;
+
+    for (size_t i = 0; i < count; i++) {
+        idl_set_insert_idl(idl_set, idl_copy(idls[i]));
+    }
+    if (t) {
+        timer_start(t);
+    }
+    result = do_union ? idl_set_union(idl_set, be) : idl_set_intersect(idl_set, be);
+    if (t) {
+        timer_stop(t);
+    }
+    idl_set_destroy(idl_set);
+    return result;
+}
+
+static int
+idl_equal(IDList *a, IDList *b)
+{
+    return a->b_nids == b->b_nids && memcmp(a->b_ids, b->b_ids, a->b_nids * sizeof(ID)) == 0;
+}
+
+static int
+bench_idl(uint64_t iter)
+{
+    backend *be = (backend *)slapi_ch_calloc(1, sizeof(backend));
+    NIDS sizes[] = {200000, 50000, 5000};
+    IDList *idls[3];
+    IDList *result, *expect, *tmp;
+    bench_timer t;
+    unsigned int seed = 1;
+    int rc = 0;
+
+    for (size_t i = 0; i < 3; i++) {
+        idls[i] = idl_random(sizes[i], &seed);
+    }
+
+    /* the k-way versions must agree with the pairwise ones */
+    tmp = idl_intersection(be, idls[0], idls[1]);
+    expect = idl_intersection(be, tmp, idls[2]);
+    idl_free(&tmp);
+    result = idl_set_run(be, idls, 3, 0, NULL);
+    if (!idl_equal(result, expect)) {
+        printf("FAIL: idl_set_intersect differs from idl_intersection\n");
+        rc = 1;
+    }
+    idl_free(&result);
+    idl_free(&expect);
+    tmp = idl_union(be, idls[0], idls[1]);
+    expect = idl_union(be, tmp, idls[2]);
+    idl_free(&tmp);
+    result = idl_set_run(be, idls, 3, 1, NULL);
+    if (!idl_equal(result, expect)) {
+        printf("FAIL: idl_set_union differs from idl_union\n");
+        rc = 1;
+    }
+    idl_free(&result);
+    idl_free(&expect);
+
+    iter = iter / 1000 ? iter / 1000 : 1;
+    memset(&t, 0, sizeof(t));
+    for (uint64_t n = 0; n < iter; n++) {
+        result = idl_set_run(be, idls, 3, 0, &t);
+        idl_free(&result);
+    }
+    report("idl_set_intersect 200000/50000/5000", iter, &t);
+
+    memset(&t, 0, sizeof(t));
+    for (uint64_t n = 0; n < iter; n++) {
+        result = idl_set_run(be, idls, 2, 0, &t);
+        idl_free(&result);
+    }
+    report("idl_set_intersect 200000/50000", iter, &t);
+
+    memset(&t, 0, sizeof(t));
+    for (uint64_t n = 0; n < iter; n++) {
+        result = idl_set_run(be, idls, 3, 1, &t);
+        idl_free(&result);
+    }
+    report("idl_set_union 200000/50000/5000", iter, &t);
+
+    for (size_t i = 0; i < 3; i++) {
+        idl_free(&idls[i]);
+    }
+    slapi_ch_free((void **)&be);
+    return rc;
+}
+
+/*
+ * Entries, from the dbgen person template.
+ */
+
+static const char *entry_template =
+    "dn: uid=user%05d,ou=people,dc=example,dc=com\n"
+    "objectClass: top\n"
+    "objectClass: person\n"
+    "objectClass: organizationalPerson\n"
+    "objectClass: inetOrgPerson\n"
+    "cn: User%05d Smith\n"
+    "sn: Smith\n"
+    "uid: user%05d\n"
+    "givenName: User%05d\n"
+    "description: This is User%05d Smith's description.\n"
+    "userPassword: {PBKDF2_SHA256}AAAIAHCpJ2ieZ2Wlq5dnb1G1OLHXCAs6\n"
+    "departmentNumber: 1230\n"
+    "employeeType: Manager\n"
+    "homePhone: +1 303 937-6482\n"
+    "telephoneNumber: +1 303 573-9570\n"
+    "mobile: +1 818 618-1671\n"
+    "roomNumber: 5164\n"
+    "l: Mountain View\n"
+    "ou: Product Development\n"
+    "mail: user%05d@example.com\n"
+    "title: Senior Engineer\n"
+    "memberOf: cn=group-1,ou=groups,dc=example,dc=com\n"
+    "memberOf: cn=group-7,ou=groups,dc=example,dc=com\n"
+    "nsUniqueId: 6a3c1e02-1dd211b2-8058c2a6-%08x\n";
+
+static void
+entry_ldif(char *buf, size_t len, int i)
+{
+    snprintf(buf, len, entry_template, i, i, i, i, i, i, i);
+}
+
+static int
+bench_str2entry(uint64_t iter)
+{
+    char ldif[2048];
+    char buf[2048];
+    Slapi_Entry *e;
+    bench_timer t = {0};
+
+    entry_ldif(ldif, sizeof(ldif), 1);
+    for (uint64_t n = 0; n < iter; n++) {
+        /* str2entry parses in place */
+        memcpy(buf, ldif, sizeof(buf));
+        timer_start(&t);
+        e = slapi_str2entry(buf, 0);
+        timer_stop(&t);
+        if (e == NULL) {
+            printf("FAIL: slapi_str2entry\n");
+            return 1;
+        }
+        slapi_entry_free(e);
+    }
+    report("str2entry_fast", iter, &t);
+    return 0;
+}
+
+static int
+bench_cache(uint64_t iter)
+{
+    struct cache cache = {0};
+    char ldif[2048];
+    struct backentry *ep;
+    bench_timer t = {0};
+    unsigned int seed = 1;
+    int rc = 0;
+
+    if (!cache_init(&cache, 512 * 1024 * 1024, -1, CACHE_TYPE_ENTRY)) {
+        printf("FAIL: cache_init\n");
+        return 1;
+    }
+    for (int i = 1; i <= CACHE_ENTRIES; i++) {
+        entry_ldif(ldif, sizeof(ldif), i);
+        ep = backentry_init(slapi_str2entry(ldif, 0));
+        ep->ep_id = i;
+        if (cache_add(&cache, ep, NULL) != 0) {
+            printf("FAIL: cache_add %d\n", i);
+            backentry_free(&ep);
+            rc = 1;
+            continue;
+        }
+        cache_return(&cache, (void **)&ep);
+    }
+
+    timer_start(&t);
+    for (uint64_t n = 0; n < iter; n++) {
+        ID id = 1 + rand_r(&seed) % CACHE_ENTRIES;
+        ep = cache_find_id(&cache, id);
+        if (ep == NULL || ep->ep_id != id) {
+            printf("FAIL: cache_find_id %u\n", id);
+            rc = 1;
+            break;
+        }
+        cache_return(&cache, (void **)&ep);
+    }
+    timer_stop(&t);
+    report("cache_find_id + cache_return", iter, &t);
+
+    cache_clear(&cache, CACHE_TYPE_ENTRY);
+    cache_destroy_please(&cache, CACHE_TYPE_ENTRY);
+    return rc;
+}
+
+static const char *dns[] = {
+    "uid=user00042,ou=people,dc=example,dc=com",
+    "UID=User00042, OU=People, DC=Example, DC=Com",
+    "cn=Smith\\, John,ou=Product Development,dc=example,dc=com",
+    "cn=\"Smith, John\",ou=people,dc=example,dc=com",
+    "cn=\xc3\x89lodie Durand+uid=edurand,ou=people,dc=example,dc=com",
+    "nsuniqueid=6a3c1e02-1dd211b2-8058c2a6-00000042+uid=user00042,ou=people,dc=example,dc=com",
+    NULL,
+};
+
+static int
+bench_dn_normalize(uint64_t iter)
+{
+    char buf[256];
+    char *dest;
+    size_t dest_len;
+    bench_timer t = {0};
+    uint64_t ops = 0;
+
+    for (uint64_t n = 0; n < iter; n++) {
+        for (size_t i = 0; dns[i]; i++) {
+            /* the normalization works in place */
+            strcpy(buf, dns[i]);
+            timer_start(&t);
+            if (slapi_dn_normalize_ext(buf, 0, &dest, &dest_len) > 0) {
+                slapi_ch_free_string(&dest);
+            }
+            timer_stop(&t);
+            ops++;
+        }
+    }
+    report("slapi_dn_normalize_ext", ops, &t);
+    return 0;
+}
+
+/*
+ * The equality and substring keys of a cn value, what
+ * index_addordel_values_sv() computes before it updates the index files.
+ */
+static int
+bench_index_keys(uint64_t iter)
+{
+    Slapi_PBlock *pb = slapi_pblock_new();
+    Slapi_Value *vals[2] = {NULL, NULL};
+    Slapi_Value **ivals = NULL;
+    char cn[64];
+    bench_timer eq = {0};
+    bench_timer sub = {0};
+
+    for (uint64_t n = 0; n < iter; n++) {
+        snprintf(cn, sizeof(cn), "User%05" PRIu64 " Smith", n % 100000);
+        vals[0] = slapi_value_new_string(cn);
+
+        timer_start(&eq);
+        string_values2keys(pb, vals, &ivals, SYNTAX_CIS, LDAP_FILTER_EQUALITY);
+        timer_stop(&eq);
+        valuearray_free(&ivals);
+
+        timer_start(&sub);
+        string_values2keys(pb, vals, &ivals, SYNTAX_CIS, LDAP_FILTER_SUBSTRINGS);
+        timer_stop(&sub);
+        valuearray_free(&ivals);
+
+        slapi_value_free(&vals[0]);
+    }
+    report("index keys equality", iter, &eq);
+    report("index keys substring", iter, &sub);
+    slapi_pblock_destroy(pb);
+    return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+    uint64_t iter = argc > 1 ? strtoull(argv[1], NULL, 10) : 100000;
+    int rc = 0;
+
+    rc |= bench_idl(iter);
+    rc |= bench_cache(iter * 10);
+    rc |= bench_str2entry(iter);
+    rc |= bench_dn_normalize(iter);
+    rc |= bench_index_keys(iter);
+    return rc;
+}
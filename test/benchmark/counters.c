@@ -0,0 +1,94 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+/*
+ * Compare plain and sharded Slapi_Counters when many threads bump the same
+ * counters, the way workers bump the global operation statistics.
+ *
+ *     ./benchmark_slapd_counters [threads] [increments per thread]
+ */
+
+#include "slap.h"
+#include <stdio.h>
+#include <inttypes.h>
+
+/* ops initiated, ops completed, entries sent and bytes sent */
+#define BENCH_COUNTERS 4
+
+typedef struct bench_arg
+{
+    Slapi_Counter **counters;
+    uint64_t iter;
+} bench_arg;
+
+static void *
+bench_thread(void *arg)
+{
+    bench_arg *ba = (bench_arg *)arg;
+
+    for (uint64_t n = 0; n < ba->iter; n++) {
+        slapi_counter_increment(ba->counters[0]);
+        slapi_counter_increment(ba->counters[1]);
+        slapi_counter_increment(ba->counters[2]);
+        slapi_counter_add(ba->counters[3], 64);
+    }
+    return NULL;
+}
+
+static int
+bench_run(const char *name, Slapi_Counter *(*counter_new)(void), int nthreads, uint64_t iter)
+{
+    Slapi_Counter *counters[BENCH_COUNTERS];
+    pthread_t *threads = (pthread_t *)slapi_ch_calloc(nthreads, sizeof(pthread_t));
+    bench_arg ba = {counters, iter};
+    struct timespec start_time;
+    struct timespec finish_time;
+    int rc = 0;
+
+    for (size_t i = 0; i < BENCH_COUNTERS; i++) {
+        counters[i] = counter_new();
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+    for (int i = 0; i < nthreads; i++) {
+        pthread_create(&threads[i], NULL, bench_thread, &ba);
+    }
+    for (int i = 0; i < nthreads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &finish_time);
+
+    if (slapi_counter_get_value(counters[0]) != (uint64_t)nthreads * iter ||
+        slapi_counter_get_value(counters[3]) != (uint64_t)nthreads * iter * 64) {
+        printf("FAIL: %s counters lost updates\n", name);
+        rc = 1;
+    }
+
+    printf("BENCH: %s threads %d increments %" PRIu64 " time %.6f\n", name, nthreads, iter,
+           (finish_time.tv_sec - start_time.tv_sec) + (finish_time.tv_nsec - start_time.tv_nsec) / 1e9);
+
+    for (size_t i = 0; i < BENCH_COUNTERS; i++) {
+        slapi_counter_destroy(&counters[i]);
+    }
+    slapi_ch_free((void **)&threads);
+    return rc;
+}
+
+int
+main(int argc, char **argv)
+{
+    int nthreads = argc > 1 ? atoi(argv[1]) : 8;
+    uint64_t iter = argc > 2 ? strtoull(argv[2], NULL, 10) : 1000000;
+    int rc = 0;
+
+    for (int t = 1; t <= nthreads; t *= 2) {
+        rc |= bench_run("plain", slapi_counter_new, t, iter);
+        rc |= bench_run("sharded", slapi_counter_new_sharded, t, iter);
+    }
+    return rc;
+}
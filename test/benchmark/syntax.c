@@ -0,0 +1,284 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+/*
+ * Compare the string syntax helpers with the code point at a time versions
+ * they replaced. Each reference below is a copy of the previous code, the
+ * results of both are checked to be the same before anything is timed.
+ *
+ *     ./benchmark_slapd_syntax [iterations]
+ */
+
+#include "syntax.h"
+#include <stdio.h>
+#include <inttypes.h>
+
+static const char *values[] = {
+    "cn=Directory Manager",
+    "John Smith Example User 0000001",
+    "   Leading  and   trailing   blanks   ",
+    "john.smith@example.com",
+    "+1 555-0100 ext 42",
+    "Ünïcödé Straße München Österreich",
+    "Mostly ASCII value with one é near the end of it",
+    NULL,
+};
+
+static int
+ref_isspace(char *s)
+{
+    unsigned char c = *(unsigned char *)s;
+    if (0x80 & c)
+        return (ldap_utf8isspace(s));
+    return c == ' ' || (c >= 0x09 && c <= 0x0D);
+}
+
+/* value_normalize_ext() main loop before the word at a time copy */
+static void
+ref_normalize(char *s, int syntax)
+{
+    char *head = s;
+    char *d = s;
+    int prevspace = 0, curspace;
+
+    while (ref_isspace(s)) {
+        LDAP_UTF8INC(s);
+    }
+    if (*s == '\0' && s != d) {
+        *d++ = ' ';
+        *d = '\0';
+        return;
+    }
+    while (*s) {
+        curspace = ref_isspace(s);
+        if ((syntax & SYNTAX_TEL) && (curspace || *s == '-')) {
+            LDAP_UTF8INC(s);
+            continue;
+        }
+        if (prevspace && curspace) {
+            LDAP_UTF8INC(s);
+            continue;
+        }
+        prevspace = curspace;
+        if (syntax & SYNTAX_CIS) {
+            int ssz, dsz;
+            slapi_utf8ToLower((unsigned char *)s, (unsigned char *)d, &ssz, &dsz);
+            s += ssz;
+            d += dsz;
+        } else {
+            char *np = ldap_utf8next(s);
+            if (np == NULL || np == s)
+                break;
+            memmove(d, s, np - s);
+            d += np - s;
+            s = np;
+        }
+    }
+    *d = '\0';
+    if (prevspace) {
+        char *nd = ldap_utf8prev(d);
+        while (nd && nd >= head && ref_isspace(nd)) {
+            d = nd;
+            nd = ldap_utf8prev(d);
+            *d = '\0';
+        }
+    }
+}
+
+/* utf8string_validate() before the ASCII skip */
+static int
+ref_validate(const char *begin, const char *end)
+{
+    const char *p;
+    int rc;
+
+    for (p = begin; p <= end; p++) {
+        if ((rc = utf8char_validate(p, end, &p)) != 0) {
+            return rc;
+        }
+    }
+    return 0;
+}
+
+static int
+ref_has8thbit(unsigned char *s)
+{
+    for (; *s; s++) {
+        if (0x80 & *s) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* slapi_utf8casecmp() before the ASCII prefix skip */
+static int
+ref_casecmp(unsigned char *s0, unsigned char *s1)
+{
+    unsigned char *d0 = NULL, *d1 = NULL;
+    unsigned char *p0, *p1, *n0 = NULL, *n1 = NULL, *t0, *t1;
+    int rval = 0;
+
+    if (*s0 == '\0' || *s1 == '\0') {
+        return *s0 == *s1 ? 0 : (*s0 == '\0' ? -1 : 1);
+    }
+    if (!ref_has8thbit(s0) || !ref_has8thbit(s1)) {
+        return strcasecmp((char *)s0, (char *)s1);
+    }
+    d0 = slapi_utf8StrToLower(s0);
+    d1 = slapi_utf8StrToLower(s1);
+    if (d0 == NULL || d1 == NULL || *d0 == '\0' || *d1 == '\0') {
+        rval = strcasecmp((char *)s0, (char *)s1);
+        goto end;
+    }
+    t0 = d0 + strlen((char *)d0);
+    t1 = d1 + strlen((char *)d1);
+    for (p0 = d0, p1 = d1;; p0 = n0, p1 = n1) {
+        n0 = (unsigned char *)ldap_utf8next((char *)p0);
+        n1 = (unsigned char *)ldap_utf8next((char *)p1);
+        if (n0 > t0 || n1 > t1) {
+            break;
+        }
+        if ((rval = (n0 - p0) - (n1 - p1)) != 0 || (rval = memcmp(p0, p1, n0 - p0)) != 0) {
+            goto end;
+        }
+    }
+    rval = (t0 - n0) - (t1 - n1);
+end:
+    slapi_ch_free((void **)&d0);
+    slapi_ch_free((void **)&d1);
+    return rval;
+}
+
+static int
+sign(int v)
+{
+    return (v > 0) - (v < 0);
+}
+
+static double
+elapsed(struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static void
+report(const char *bench, double ref, double cur, uint64_t iter)
+{
+    printf("BENCH: %s %" PRIu64 " reference %.6f current %.6f speedup %.2fx\n",
+           bench, iter, ref, cur, cur > 0 ? ref / cur : 0.0);
+}
+
+static int
+check(void)
+{
+    int failed = 0;
+
+    for (size_t i = 0; values[i]; i++) {
+        const char *v = values[i];
+        const char *last = NULL;
+        int syntaxes[] = {SYNTAX_CIS, SYNTAX_CES, SYNTAX_CIS | SYNTAX_TEL};
+
+        for (size_t j = 0; j < sizeof(syntaxes) / sizeof(syntaxes[0]); j++) {
+            char *a = slapi_ch_strdup(v);
+            char *b = slapi_ch_strdup(v);
+            char *alt = NULL;
+            ref_normalize(a, syntaxes[j]);
+            value_normalize_ext(b, syntaxes[j], 1, &alt);
+            if (strcmp(a, b) != 0) {
+                printf("FAIL: normalize \"%s\" syntax %d: \"%s\" != \"%s\"\n", v, syntaxes[j], a, b);
+                failed = 1;
+            }
+            slapi_ch_free_string(&a);
+            slapi_ch_free_string(&b);
+        }
+        if (ref_validate(v, v + strlen(v) - 1) != utf8string_validate(v, v + strlen(v) - 1, &last) ||
+            last != v + strlen(v) - 1) {
+            printf("FAIL: validate \"%s\"\n", v);
+            failed = 1;
+        }
+        for (size_t j = 0; values[j]; j++) {
+            if (sign(ref_casecmp((unsigned char *)v, (unsigned char *)values[j])) !=
+                sign(slapi_utf8casecmp((unsigned char *)v, (unsigned char *)values[j]))) {
+                printf("FAIL: casecmp \"%s\" \"%s\"\n", v, values[j]);
+                failed = 1;
+            }
+        }
+    }
+    return failed;
+}
+
+int
+main(int argc, char **argv)
+{
+    uint64_t iter = argc > 1 ? strtoull(argv[1], NULL, 10) : 1000000;
+    struct timespec start;
+    double ref, cur;
+    char buf[256];
+    const char *last;
+    int sink = 0;
+
+    if (check()) {
+        return 1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint64_t n = 0; n < iter; n++) {
+        for (size_t i = 0; values[i]; i++) {
+            strcpy(buf, values[i]);
+            ref_normalize(buf, SYNTAX_CIS);
+        }
+    }
+    ref = elapsed(&start);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint64_t n = 0; n < iter; n++) {
+        for (size_t i = 0; values[i]; i++) {
+            char *alt = NULL;
+            strcpy(buf, values[i]);
+            value_normalize_ext(buf, SYNTAX_CIS, 1, &alt);
+        }
+    }
+    cur = elapsed(&start);
+    report("value_normalize_ext", ref, cur, iter);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint64_t n = 0; n < iter; n++) {
+        for (size_t i = 0; values[i]; i++) {
+            sink += ref_validate(values[i], values[i] + strlen(values[i]) - 1);
+        }
+    }
+    ref = elapsed(&start);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint64_t n = 0; n < iter; n++) {
+        for (size_t i = 0; values[i]; i++) {
+            sink += utf8string_validate(values[i], values[i] + strlen(values[i]) - 1, &last);
+        }
+    }
+    cur = elapsed(&start);
+    report("utf8string_validate", ref, cur, iter);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint64_t n = 0; n < iter; n++) {
+        for (size_t i = 0; values[i]; i++) {
+            sink += ref_casecmp((unsigned char *)values[i], (unsigned char *)values[i]);
+        }
+    }
+    ref = elapsed(&start);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint64_t n = 0; n < iter; n++) {
+        for (size_t i = 0; values[i]; i++) {
+            sink += slapi_utf8casecmp((unsigned char *)values[i], (unsigned char *)values[i]);
+        }
+    }
+    cur = elapsed(&start);
+    report("slapi_utf8casecmp", ref, cur, iter);
+
+    return sink != 0;
+}
@@ -0,0 +1,60 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#include "../../test_slapd.h"
+
+void
+test_libslapd_counters_histogram_exact(void **state __attribute__((unused)))
+{
+    Slapi_Histogram *h = histogram_new();
+    char *s;
+
+    assert_null(histogram_format("empty", h));
+    /* values below 8 have a bucket each */
+    for (uint64_t i = 0; i < 8; i++) {
+        histogram_record(h, i);
+    }
+    s = histogram_format("exact", h);
+    assert_string_equal(s, "exact: count=8 avg=3 p50=3 p90=6 p99=7 p999=7 max=7");
+    slapi_ch_free_string(&s);
+
+    histogram_destroy(&h);
+    assert_null(h);
+}
+
+void
+test_libslapd_counters_histogram_percentiles(void **state __attribute__((unused)))
+{
+    Slapi_Histogram *h = NULL;
+    uint64_t p50, p90, p99, max;
+    char *s;
+
+    /* 1..10000 usec */
+    for (uint64_t i = 1; i <= 10000; i++) {
+        histogram_record(histogram_get(&h), i);
+    }
+    s = histogram_format("op", h);
+    assert_int_equal(sscanf(s, "op: count=10000 avg=5000 p50=%" SCNu64 " p90=%" SCNu64
+                               " p99=%" SCNu64 " p999=%*u max=%" SCNu64,
+                            &p50, &p90, &p99, &max),
+                     4);
+    /* a percentile is within one bucket, 12.5%, above the exact value */
+    assert_true(p50 >= 5000 && p50 <= 5000 * 9 / 8);
+    assert_true(p90 >= 9000 && p90 <= 9000 * 9 / 8);
+    assert_true(p99 >= 9900 && p99 <= 10000);
+    assert_int_equal(max, 10000);
+    slapi_ch_free_string(&s);
+
+    /* past the last bucket the values are only counted in max */
+    histogram_record(h, UINT64_MAX / 2);
+    s = histogram_format("op", h);
+    assert_non_null(strstr(s, "count=10001"));
+    slapi_ch_free_string(&s);
+
+    histogram_destroy(&h);
+}
@@ -0,0 +1,64 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#include "../../test_slapd.h"
+#include <pthread.h>
+
+#define SHARDED_THREADS 8
+#define SHARDED_ADDS 100000
+
+void
+test_libslapd_counters_sharded_usage(void **state __attribute__((unused)))
+{
+    Slapi_Counter *tc = slapi_counter_new_sharded();
+
+    assert_true(slapi_counter_get_value(tc) == 0);
+    slapi_counter_increment(tc);
+    assert_true(slapi_counter_get_value(tc) == 1);
+    slapi_counter_add(tc, 100);
+    assert_true(slapi_counter_get_value(tc) == 101);
+    slapi_counter_decrement(tc);
+    slapi_counter_subtract(tc, 50);
+    assert_true(slapi_counter_get_value(tc) == 50);
+    /* set drops what the shards hold */
+    slapi_counter_set_value(tc, 200);
+    assert_true(slapi_counter_get_value(tc) == 200);
+    slapi_counter_init(tc);
+    assert_true(slapi_counter_get_value(tc) == 0);
+
+    slapi_counter_destroy(&tc);
+}
+
+static void *
+sharded_adder(void *arg)
+{
+    Slapi_Counter *tc = (Slapi_Counter *)arg;
+
+    for (size_t i = 0; i < SHARDED_ADDS; i++) {
+        slapi_counter_increment(tc);
+    }
+    return NULL;
+}
+
+void
+test_libslapd_counters_sharded_threads(void **state __attribute__((unused)))
+{
+    Slapi_Counter *tc = slapi_counter_new_sharded();
+    pthread_t threads[SHARDED_THREADS];
+
+    for (size_t i = 0; i < SHARDED_THREADS; i++) {
+        assert_int_equal(pthread_create(&threads[i], NULL, sharded_adder, tc), 0);
+    }
+    for (size_t i = 0; i < SHARDED_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    /* no add may be lost, whatever shards the threads ended up on */
+    assert_true(slapi_counter_get_value(tc) == (uint64_t)SHARDED_THREADS * SHARDED_ADDS);
+
+    slapi_counter_destroy(&tc);
+}
@@ -0,0 +1,62 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#include "../../test_slapd.h"
+
+#include <string.h>
+
+static void
+normalize_check(const char *in, int expect_rc, const char *expect)
+{
+    char *src = slapi_ch_strdup(in);
+    char *dest = NULL;
+    size_t dest_len = 0;
+    int rc = slapi_dn_normalize_ext(src, strlen(src), &dest, &dest_len);
+
+    assert_int_equal(rc, expect_rc);
+    assert_int_equal(dest_len, strlen(expect));
+    assert_memory_equal(dest, expect, dest_len);
+    if (rc == 0) {
+        /* nothing allocated, dest points into src */
+        assert_ptr_equal(dest, src);
+    } else {
+        slapi_ch_free_string(&dest);
+    }
+    slapi_ch_free_string(&src);
+}
+
+void
+test_libslapd_dn_normalize_fast_path(void **state __attribute__((unused)))
+{
+    /* Already normalized, returned as is */
+    normalize_check("dc=com", 0, "dc=com");
+    normalize_check("cn=John Smith,ou=People,dc=example,dc=com", 0,
+                    "cn=John Smith,ou=People,dc=example,dc=com");
+    normalize_check("uid=a=b,dc=example,dc=com", 0, "uid=a=b,dc=example,dc=com");
+    normalize_check("CN=Ab\xc3\x89,DC=Example,DC=Com", 0, "CN=Ab\xc3\x89,DC=Example,DC=Com");
+    /* Spaces the state machine removes */
+    normalize_check(" cn = x , dc=com ", 0, "cn=x,dc=com");
+    normalize_check("cn=John  Smith,dc=com", 0, "cn=John Smith,dc=com");
+    normalize_check("cn=x, dc=com", 0, "cn=x,dc=com");
+    /* Escapes and other separators */
+    normalize_check("cn=a\\,b,dc=com", 1, "cn=a\\2Cb,dc=com");
+    normalize_check("cn=x;dc=com", 0, "cn=x,dc=com");
+}
+
+void
+test_libslapd_dn_ignore_case(void **state __attribute__((unused)))
+{
+    char dn[] = "CN=John Smith,OU=People,DC=Example,DC=Com";
+    char mixed[] = "CN=\xc3\x89LODIE Durand,OU=People,DC=Example";
+    char shortdn[] = "DC=X";
+
+    assert_string_equal(slapi_dn_ignore_case(dn), "cn=john smith,ou=people,dc=example,dc=com");
+    /* multi byte characters between ASCII words */
+    assert_string_equal(slapi_dn_ignore_case(mixed), "cn=\xc3\xa9lodie durand,ou=people,dc=example");
+    assert_string_equal(slapi_dn_ignore_case(shortdn), "dc=x");
+}
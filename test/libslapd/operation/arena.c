@@ -0,0 +1,70 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#include "../../test_slapd.h"
+
+#include <slap.h>
+
+void
+test_libslapd_operation_arena_alloc(void **state __attribute__((unused)))
+{
+    Slapi_Operation *op = slapi_operation_new(SLAPI_OP_FLAG_INTERNAL);
+    char *small[64];
+    char *big;
+    char *s;
+    uint64_t *zero;
+
+    /* enough small allocations to need more than the first chunk */
+    for (size_t i = 0; i < 64; i++) {
+        small[i] = slapi_operation_arena_alloc(op, 200);
+        assert_non_null(small[i]);
+        assert_int_equal((uintptr_t)small[i] % 16, 0);
+        memset(small[i], (int)i, 200);
+    }
+    big = slapi_operation_arena_alloc(op, 100000);
+    memset(big, 0xff, 100000);
+    /* nothing overlapped */
+    for (size_t i = 0; i < 64; i++) {
+        assert_int_equal((unsigned char)small[i][0], i);
+        assert_int_equal((unsigned char)small[i][199], i);
+    }
+
+    zero = slapi_operation_arena_calloc(op, 32, sizeof(uint64_t));
+    for (size_t i = 0; i < 32; i++) {
+        assert_true(zero[i] == 0);
+    }
+
+    s = slapi_operation_arena_strdup(op, "cn=arena");
+    assert_string_equal(s, "cn=arena");
+    assert_null(slapi_operation_arena_strdup(op, NULL));
+    s = slapi_operation_arena_smprintf(op, "%s=%d", "op", 42);
+    assert_string_equal(s, "op=42");
+
+    operation_free(&op, NULL);
+}
+
+void
+test_libslapd_operation_arena_reset(void **state __attribute__((unused)))
+{
+    Slapi_Operation *op = slapi_operation_new(SLAPI_OP_FLAG_INTERNAL);
+    char *first;
+    char *again;
+
+    first = slapi_operation_arena_alloc(op, 64);
+    assert_true(arena_get_bytes(op->o_arena) == 64);
+    operation_done(&op, NULL);
+    assert_true(arena_get_bytes(op->o_arena) == 0);
+
+    /* the op taken again from the stack reuses the first chunk */
+    operation_init(op, SLAPI_OP_FLAG_INTERNAL);
+    assert_non_null(op->o_arena);
+    again = slapi_operation_arena_alloc(op, 64);
+    assert_ptr_equal(first, again);
+
+    operation_free(&op, NULL);
+}
@@ -28,8 +28,16 @@ run_libslapd_tests(void)
         cmocka_unit_test(test_libslapd_pblock_v3c_target_uniqueid),
         cmocka_unit_test(test_libslapd_schema_filter_validate_simple),
         cmocka_unit_test(test_libslapd_operation_v3c_target_spec),
+        cmocka_unit_test(test_libslapd_operation_arena_alloc),
+        cmocka_unit_test(test_libslapd_operation_arena_reset),
         cmocka_unit_test(test_libslapd_counters_atomic_usage),
         cmocka_unit_test(test_libslapd_counters_atomic_overflow),
+        cmocka_unit_test(test_libslapd_counters_sharded_usage),
+        cmocka_unit_test(test_libslapd_counters_sharded_threads),
+        cmocka_unit_test(test_libslapd_counters_histogram_exact),
+        cmocka_unit_test(test_libslapd_counters_histogram_percentiles),
+        cmocka_unit_test(test_libslapd_dn_normalize_fast_path),
+        cmocka_unit_test(test_libslapd_dn_ignore_case),
         cmocka_unit_test(test_libslapd_pal_meminfo),
         cmocka_unit_test(test_libslapd_util_cachesane),
     };
@@ -42,11 +42,31 @@ void test_libslapd_schema_filter_validate_simple(void **state);
 /* libslapd-operation-v3_compat */
 void test_libslapd_operation_v3c_target_spec(void **state);
 
+/* libslapd-operation-arena */
+
+void test_libslapd_operation_arena_alloc(void **state);
+void test_libslapd_operation_arena_reset(void **state);
+
 /* libslapd-counters-atomic */
 
 void test_libslapd_counters_atomic_usage(void **state);
 void test_libslapd_counters_atomic_overflow(void **state);
 
+/* libslapd-counters-sharded */
+
+void test_libslapd_counters_sharded_usage(void **state);
+void test_libslapd_counters_sharded_threads(void **state);
+
+/* libslapd-counters-histogram */
+
+void test_libslapd_counters_histogram_exact(void **state);
+void test_libslapd_counters_histogram_percentiles(void **state);
+
+/* libslapd-dn-normalize */
+
+void test_libslapd_dn_normalize_fast_path(void **state);
+void test_libslapd_dn_ignore_case(void **state);
+
 /* libslapd-pal-meminfo */
 
 void test_libslapd_pal_meminfo(void **state);